@@ -55,6 +55,12 @@ std::string ACarlaRecorder::ShowFileActorsBlocked(std::string Name, double MinTi
   return Query.QueryBlocked(Name, MinTime, MinDistance);
 }
 
+CarlaRecorderQuery::FQueryResult ACarlaRecorder::QueryFile(std::string Name,
+    const CarlaRecorderQuery::FQueryOptions &Options)
+{
+  return Query.Query(Name, Options);
+}
+
 std::string ACarlaRecorder::ReplayFile(std::string Name, double TimeStart, double Duration,
     uint32_t FollowId, bool ReplaySensors)
 {
@@ -290,6 +296,29 @@ void ACarlaRecorder::AddDReyeVRData()
   // Add the latest instance of the DReyeVR snapshot to our data
   DReyeVRAggData.Add(DReyeVRDataRecorder<DReyeVR::AggregateData>(ADReyeVRSensor::Data));
 
+  // and every eye-tracker reading it was made from
+  if (bRecordEyeSamples)
+  {
+    const ADReyeVRSensor *Sensor = ADReyeVRSensor::GetDReyeVRSensor();
+    if (Sensor != nullptr)
+    {
+      const TArray<DReyeVR::EyeTracker> &Samples = Sensor->GetEyeTrackerSamples();
+      EyeSamples.insert(EyeSamples.end(), Samples.GetData(), Samples.GetData() + Samples.Num());
+    }
+  }
+
+  // and when its focus was traced
+  if (bRecordGazeTraces)
+  {
+    const ADReyeVRSensor *Sensor = ADReyeVRSensor::GetDReyeVRSensor();
+    if (Sensor != nullptr)
+      DReyeVRGazeTraces.Add(DReyeVRDataRecorder<DReyeVR::GazeTraces>(&Sensor->GetGazeTraces()));
+  }
+
+  // and its fixation classification
+  if (bRecordFixations)
+    DReyeVRFixations.Add(DReyeVRDataRecorder<DReyeVR::FixationData>(&ADReyeVRSensor::Data->GetFixations()));
+
   for (auto &ActiveCAs : ADReyeVRCustomActor::ActiveCustomActors)
   {
     ADReyeVRCustomActor *CustomActor = ActiveCAs.second;
@@ -370,10 +399,22 @@ std::string ACarlaRecorder::Start(std::string Name, FString MapName, bool Additi
   std::string Filename = GetRecorderFilename(Name);
 
   // binary file
-  File.open(Filename, std::ios::binary);
-  if (!File.is_open())
+  if (bAsyncWrite)
+  {
+    // packets are still written to File, but land in memory until the writer thread flushes them
+    if (!AsyncWriter.Open(Filename, File, NumWriterBuffers))
+    {
+      return "";
+    }
+    DReyeVR_LOG("Recording asynchronously with %d writer buffers", NumWriterBuffers);
+  }
+  else
   {
-    return "";
+    File.open(Filename, std::ios::binary);
+    if (!File.is_open())
+    {
+      return "";
+    }
   }
 
   // save info
@@ -386,6 +427,19 @@ std::string ACarlaRecorder::Start(std::string Name, FString MapName, bool Additi
   Info.Write(File);
 
   Frames.Reset();
+  FrameIndex.Clear();
+  LastKeyframeTime = 0.0;
+  NumKeyframes = 0;
+  KeyframeBytes = 0;
+  CompactStats = {};
+  PositionEncoder.Reset();
+  DReyeVREncoder.Reset();
+  EyeSampleEncoder.Reset();
+  NumEyeSamples = 0;
+  EyeSampleBytes = 0;
+  CustomActorEncoder.Reset();
+  CustomActorEncoder.RawBytes = 0;
+  CustomActorBytes = 0;
   PlatformTime.SetStartTime();
 
   Enable();
@@ -405,7 +459,64 @@ void ACarlaRecorder::Stop(void)
 {
   Disable();
 
-  if (File)
+  // the EgoSensor's per-actor dwell statistics, once (before the frame index, which has to be the last packet)
+  if (bRecordDwell && !FrameIndex.IsEmpty() && (AsyncWriter.IsOpen() || File.is_open()))
+  {
+    const ADReyeVRSensor *Sensor = ADReyeVRSensor::GetDReyeVRSensor();
+    if (Sensor != nullptr)
+    {
+      DReyeVR::DwellData Dwell;
+      Dwell.Set(Sensor->GetDwell());
+      DReyeVRDwell.Clear();
+      DReyeVRDwell.Add(DReyeVRDataRecorder<DReyeVR::DwellData>(&Dwell));
+      DReyeVRDwell.Write(File);
+      DReyeVRDwell.Clear();
+      DReyeVR_LOG("Recorded the gaze dwell time of %d actors", Dwell.Actors.Num());
+    }
+  }
+
+  // trailing frame index so the replayer/queries can seek without scanning the whole file
+  if (!FrameIndex.IsEmpty() && (AsyncWriter.IsOpen() || File.is_open()))
+  {
+    const uint64_t RecordingBytes =
+        AsyncWriter.IsOpen() ? AsyncWriter.GetPosition() : static_cast<uint64_t>(File.tellp());
+    if (NumKeyframes > 0 && RecordingBytes > 0)
+    {
+      DReyeVR_LOG("Recorded %u keyframes (every %.1fs) using %llu bytes (%.2f%% of the recording)", NumKeyframes,
+                  KeyframeInterval, KeyframeBytes, 100.0 * KeyframeBytes / RecordingBytes);
+    }
+    if (bCompactEncoding)
+    {
+      LogCompactStats();
+    }
+    if (bRecordEyeSamples && NumEyeSamples > 0)
+    {
+      DReyeVR_LOG("Recorded %llu eye-tracker samples (%.2f per frame) using %llu bytes", NumEyeSamples,
+                  static_cast<double>(NumEyeSamples) / FrameIndex.Num(), EyeSampleBytes);
+    }
+    if (bInternCustomActors && CustomActorBytes > 0)
+    {
+      DReyeVR_LOG("Interned custom actors: %llu bytes (%llu as regular packets)", CustomActorBytes,
+                  CustomActorEncoder.RawBytes);
+    }
+    FrameIndex.Write(File);
+  }
+  FrameIndex.Clear();
+
+  if (AsyncWriter.IsOpen())
+  {
+    AsyncWriter.Close(File);
+    const DReyeVRRecorderWriterStats Stats = AsyncWriter.GetStats();
+    DReyeVR_LOG("Async recorder wrote %llu/%llu frames (%llu bytes), max queue depth %d, "
+                "%llu stalled frames (%.3fs total), %llu dropped frames",
+                Stats.FramesWritten, Stats.FramesQueued, Stats.BytesWritten, static_cast<int>(Stats.MaxQueueDepth),
+                Stats.FramesStalled, Stats.StallSeconds, Stats.FramesDropped);
+    if (Stats.FramesDropped > 0)
+    {
+      DReyeVR_LOG_ERROR("Failed to write %llu frames to disk, recording is incomplete!", Stats.FramesDropped);
+    }
+  }
+  else if (File)
   {
     File.close();
   }
@@ -420,6 +531,8 @@ void ACarlaRecorder::Clear(void)
   EventsParent.Clear();
   Collisions.Clear();
   Positions.Clear();
+  CompactPositions.clear();
+  EyeSamples.clear();
   States.Clear();
   Vehicles.Clear();
   Walkers.Clear();
@@ -432,6 +545,8 @@ void ACarlaRecorder::Clear(void)
   TrafficLightTimes.Clear();
   DReyeVRAggData.Clear();
   DReyeVRCustomActorData.Clear();
+  DReyeVRGazeTraces.Clear();
+  DReyeVRFixations.Clear();
   DReyeVRConfigFileData.Clear();
   Weathers.Clear();
 }
@@ -442,7 +557,16 @@ void ACarlaRecorder::Write(double DeltaSeconds)
   Frames.SetFrame(DeltaSeconds);
 
   // start
+  const uint64_t FrameStartOffset =
+      AsyncWriter.IsOpen() ? AsyncWriter.GetPosition() : static_cast<uint64_t>(File.tellp());
+  FrameIndex.AddFrame(DeltaSeconds, FrameStartOffset);
   Frames.WriteStart(File);
+  if (AsyncWriter.IsOpen())
+  {
+    // WriteStart just patched the duration of the previous frame, so everything before
+    // this frame is final and can be handed to the writer thread
+    AsyncWriter.Commit(FrameStartOffset);
+  }
 
   // events
   EventsAdd.Write(File);
@@ -450,8 +574,24 @@ void ACarlaRecorder::Write(double DeltaSeconds)
   EventsParent.Write(File);
   Collisions.Write(File);
 
+  // DReyeVR keyframe (after this frame's events, so it holds the actor set as of this frame)
+  const double Elapsed = FrameIndex.GetTotalTime();
+  bool bWroteKeyframe = false;
+  if (KeyframeInterval > 0.0 && Elapsed - LastKeyframeTime >= KeyframeInterval)
+  {
+    WriteKeyframe();
+    LastKeyframeTime = Elapsed;
+    bWroteKeyframe = true;
+  }
+
+  // delta encoded packets restart from scratch where the replayer can start decoding (first frame, keyframes)
+  const bool bResetDeltas = bWroteKeyframe || FrameIndex.Num() == 1;
+
   // positions and states
-  Positions.Write(File);
+  if (bCompactEncoding)
+    WriteCompactPositions(bResetDeltas);
+  else
+    Positions.Write(File);
   States.Write(File);
 
   // animations
@@ -471,10 +611,28 @@ void ACarlaRecorder::Write(double DeltaSeconds)
     TrafficLightTimes.Write(File);
   }
   // custom DReyeVR data
-  DReyeVRAggData.Write(File);
+  if (bCompactEncoding)
+    WriteCompactDReyeVR(bResetDeltas);
+  else
+    DReyeVRAggData.Write(File);
+
+  // eye-tracker readings since the previous frame
+  if (bRecordEyeSamples)
+    WriteEyeSamples(bResetDeltas);
+
+  // when the focus in the DReyeVR packet was traced
+  if (bRecordGazeTraces)
+    DReyeVRGazeTraces.Write(File);
+
+  // fixations (after the DReyeVR packet, the replayer applies them on top of it)
+  if (bRecordFixations)
+    DReyeVRFixations.Write(File);
 
   // custom DReyeVR Actor data write
-  DReyeVRCustomActorData.Write(File);
+  if (bInternCustomActors)
+    CustomActorBytes += DReyeVRCustomActorData.WriteInterned(File, CustomActorEncoder, bResetDeltas);
+  else
+    DReyeVRCustomActorData.Write(File);
 
   // only write this once (at the beginning)
   static bool bWroteConfigFile = false;
@@ -497,7 +655,18 @@ void ACarlaRecorder::AddPosition(const CarlaRecorderPosition &Position)
 {
   if (Enabled)
   {
-    Positions.Add(Position);
+    if (bCompactEncoding)
+    {
+      DReyeVRCompactPosition Compact;
+      Compact.DatabaseId = Position.DatabaseId;
+      Compact.Location = {Position.Location.X, Position.Location.Y, Position.Location.Z};
+      Compact.Rotation = {Position.Rotation.X, Position.Rotation.Y, Position.Rotation.Z};
+      CompactPositions.push_back(Compact);
+    }
+    else
+    {
+      Positions.Add(Position);
+    }
   }
 }
 
@@ -667,6 +836,142 @@ void ACarlaRecorder::AddExistingActors(void)
 
 }
 
+void ACarlaRecorder::WriteKeyframe()
+{
+  // snapshot of everything that only gets recorded when it changes: the live actor set (and their
+  // parents), the weather, and the scene lights. Positions, traffic light states, DReyeVR sensor data and
+  // custom actors are recorded in full every frame, so the rest of this frame completes the keyframe
+  CarlaRecorderEventsAdd KeyframeEventsAdd;
+  CarlaRecorderEventsParent KeyframeEventsParent;
+  CarlaRecorderWeathers KeyframeWeathers;
+  CarlaRecorderLightScenes KeyframeLightScenes;
+
+  for (auto &It : Episode->GetActorRegistry())
+  {
+    const FCarlaActor *CarlaActor = It.Value.Get();
+    if (CarlaActor == nullptr || CarlaActor->IsPendingKill() || CarlaActor->GetActorInfo() == nullptr)
+      continue;
+    KeyframeEventsAdd.Add(MakeRecorderEventAdd(
+        CarlaActor->GetActorId(),
+        static_cast<uint8_t>(CarlaActor->GetActorType()),
+        CarlaActor->GetActorGlobalTransform(),
+        CarlaActor->GetActorInfo()->Description));
+    if (CarlaActor->GetParent() != 0)
+    {
+      KeyframeEventsParent.Add(CarlaRecorderEventParent{CarlaActor->GetActorId(), CarlaActor->GetParent()});
+    }
+  }
+
+  AWeather *Weather = AWeather::FindWeatherInstance(Episode->GetWorld());
+  if (Weather)
+  {
+    CarlaRecorderWeather RecordedWeather;
+    RecordedWeather.Params = Weather->GetCurrentWeather();
+    KeyframeWeathers.Add(RecordedWeather);
+  }
+
+  UWorld *World = GetWorld();
+  UCarlaLightSubsystem *CarlaLightSubsystem = World ? World->GetSubsystem<UCarlaLightSubsystem>() : nullptr;
+  if (CarlaLightSubsystem)
+  {
+    for (const auto &LightPair : CarlaLightSubsystem->GetLights())
+    {
+      const UCarlaLight *Light = LightPair.Value;
+      KeyframeLightScenes.Add(CarlaRecorderLightScene{
+        Light->GetId(),
+        Light->GetLightIntensity(),
+        Light->GetLightColor(),
+        Light->GetLightOn(),
+        static_cast<uint8>(Light->GetLightType())
+      });
+    }
+  }
+
+  // a regular packet (skipped by other readers) wrapping regular packets
+  const uint64_t PacketOffset =
+      AsyncWriter.IsOpen() ? AsyncWriter.GetPosition() : static_cast<uint64_t>(File.tellp());
+  WriteValue<char>(File, static_cast<char>(CarlaRecorderPacketId::DReyeVRKeyframe));
+  std::streampos PosStart = File.tellp();
+  uint32_t Total = 0;
+  WriteValue<uint32_t>(File, Total); // dummy size
+  KeyframeEventsAdd.Write(File);
+  KeyframeEventsParent.Write(File);
+  KeyframeWeathers.Write(File);
+  KeyframeLightScenes.Write(File);
+  std::streampos PosEnd = File.tellp();
+  Total = PosEnd - PosStart - sizeof(uint32_t);
+  File.seekp(PosStart, std::ios::beg);
+  WriteValue<uint32_t>(File, Total);
+  File.seekp(PosEnd, std::ios::beg);
+
+  FrameIndex.AddKeyframe(PacketOffset);
+  NumKeyframes++;
+  KeyframeBytes += sizeof(char) + sizeof(uint32_t) + Total;
+}
+
+void ACarlaRecorder::WriteCompactPositions(bool bReset)
+{
+  const double StartTime = FPlatformTime::Seconds();
+  CompactBytes.Clear();
+  PositionEncoder.Encode(CompactPositions, bReset, CompactBytes);
+  WriteValue<char>(File, static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactPosition));
+  WriteValue<uint32_t>(File, static_cast<uint32_t>(CompactBytes.Size()));
+  File.write(CompactBytes.GetBytes().data(), CompactBytes.Size());
+  CompactStats.EncodeSeconds += FPlatformTime::Seconds() - StartTime;
+
+  // same layout as CarlaRecorderPositions::Write (id, size, count, and id + 2 FVectors per actor)
+  constexpr size_t RawPositionSize = sizeof(uint32_t) + 6 * sizeof(float);
+  CompactStats.PositionRawBytes +=
+      sizeof(char) + sizeof(uint32_t) + sizeof(uint16_t) + CompactPositions.size() * RawPositionSize;
+  CompactStats.PositionBytes += sizeof(char) + sizeof(uint32_t) + CompactBytes.Size();
+  CompactStats.Frames++;
+}
+
+void ACarlaRecorder::WriteCompactDReyeVR(bool bReset)
+{
+  const double StartTime = FPlatformTime::Seconds();
+  const uint64_t RawBytesBefore = DReyeVREncoder.RawBytes;
+  const size_t PacketSize = DReyeVRAggData.WriteCompact(File, DReyeVREncoder, bReset);
+  CompactStats.EncodeSeconds += FPlatformTime::Seconds() - StartTime;
+
+  // raw size as DReyeVRDataRecorders::Write would have written it (id, size, count, records)
+  CompactStats.DReyeVRRawBytes +=
+      sizeof(char) + sizeof(uint32_t) + sizeof(uint16_t) + (DReyeVREncoder.RawBytes - RawBytesBefore);
+  CompactStats.DReyeVRBytes += PacketSize;
+}
+
+void ACarlaRecorder::WriteEyeSamples(bool bReset)
+{
+  // written in every frame (even without readings) so the delta chain is never broken
+  CompactBytes.Clear();
+  EyeSampleEncoder.BeginPacket(CompactBytes, bReset);
+  CompactBytes.Varint(EyeSamples.size());
+  for (const DReyeVR::EyeTracker &Sample : EyeSamples)
+  {
+    EyeSampleEncoder.BeginRecord();
+    Sample.WriteCompact(EyeSampleEncoder);
+    EyeSampleEncoder.EndRecord(CompactBytes);
+  }
+  WriteValue<char>(File, static_cast<char>(CarlaRecorderPacketId::DReyeVREyeSamples));
+  WriteValue<uint32_t>(File, static_cast<uint32_t>(CompactBytes.Size()));
+  File.write(CompactBytes.GetBytes().data(), CompactBytes.Size());
+  NumEyeSamples += EyeSamples.size();
+  EyeSampleBytes += sizeof(char) + sizeof(uint32_t) + CompactBytes.Size();
+}
+
+void ACarlaRecorder::LogCompactStats() const
+{
+  if (CompactStats.Frames == 0)
+    return;
+  auto Ratio = [](uint64_t Raw, uint64_t Compact) { return Compact > 0 ? static_cast<double>(Raw) / Compact : 0.0; };
+  DReyeVR_LOG("Compact encoding: Position %llu -> %llu bytes (%.2fx), DReyeVR %llu -> %llu bytes (%.2fx), "
+              "%.2f us/frame to encode",
+              CompactStats.PositionRawBytes, CompactStats.PositionBytes,
+              Ratio(CompactStats.PositionRawBytes, CompactStats.PositionBytes), CompactStats.DReyeVRRawBytes,
+              CompactStats.DReyeVRBytes, Ratio(CompactStats.DReyeVRRawBytes, CompactStats.DReyeVRBytes),
+              1e6 * CompactStats.EncodeSeconds / CompactStats.Frames);
+}
+
 void ACarlaRecorder::AddStartingWeather(void)
 {
   AWeather *Weather = AWeather::FindWeatherInstance(Episode->GetWorld());
@@ -676,11 +981,11 @@ void ACarlaRecorder::AddStartingWeather(void)
   }
 }
 
-void ACarlaRecorder::CreateRecorderEventAdd(
+CarlaRecorderEventAdd ACarlaRecorder::MakeRecorderEventAdd(
     uint32_t DatabaseId,
     uint8_t Type,
     const FTransform &Transform,
-    FActorDescription ActorDescription)
+    const FActorDescription &ActorDescription) const
 {
   CarlaRecorderActorDescription Description;
   Description.UId = ActorDescription.UId;
@@ -702,7 +1007,7 @@ void ACarlaRecorder::CreateRecorderEventAdd(
   }
 
   // recorder event
-  CarlaRecorderEventAdd RecEvent
+  return CarlaRecorderEventAdd
   {
     DatabaseId,
     Type,
@@ -710,7 +1015,16 @@ void ACarlaRecorder::CreateRecorderEventAdd(
     Transform.GetRotation().Euler(),
     std::move(Description)
   };
-  AddEvent(std::move(RecEvent));
+}
+
+void ACarlaRecorder::CreateRecorderEventAdd(
+    uint32_t DatabaseId,
+    uint8_t Type,
+    const FTransform &Transform,
+    FActorDescription ActorDescription)
+{
+  // recorder event
+  AddEvent(MakeRecorderEventAdd(DatabaseId, Type, Transform, ActorDescription));
 
   FCarlaActor* CarlaActor = Episode->FindCarlaActor(DatabaseId);
   // Other events related to spawning actors
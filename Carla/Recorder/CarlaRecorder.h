@@ -34,6 +34,9 @@
 
 // DReyeVR includes
 #include "DReyeVRRecorder.h"
+#include "DReyeVRRecorderCodec.h"
+#include "DReyeVRRecorderIndex.h"
+#include "DReyeVRRecorderWriter.h"
 #include "Carla/Sensor/DReyeVRData.h"
 
 #include "CarlaRecorder.generated.h"
@@ -48,6 +51,11 @@ class ATrafficLightBase;
 #define DREYEVR_PACKET_ID 139
 #define DREYEVR_CUSTOM_ACTOR_PACKET_ID 140
 #define DREYEVR_CONFIG_FILE_PACKET_ID 141
+#define DREYEVR_KEYFRAME_PACKET_ID 143 // (142 is the frame index, see DReyeVRRecorderIndex.h)
+// (144 and 145 are the compact Position and DReyeVR packets, see DReyeVRRecorderCodec.h)
+#define DREYEVR_GAZE_TRACES_PACKET_ID 148 // when the focus was traced, per-eye traces ([Recorder] GazeTraces)
+#define DREYEVR_FIXATIONS_PACKET_ID 149   // online fixation classification ([Recorder] Fixations)
+#define DREYEVR_DWELL_PACKET_ID 150       // per-actor gaze dwell statistics, once at the end ([Recorder] Dwell)
 
 enum class CarlaRecorderPacketId : uint8_t
 {
@@ -73,7 +81,16 @@ enum class CarlaRecorderPacketId : uint8_t
   // "We suggest to use id over 100 for user custom packets, because this list will keep growing in the future"
   DReyeVR = DREYEVR_PACKET_ID,                         // our custom DReyeVR packet (for raw sensor data)
   DReyeVRCustomActor = DREYEVR_CUSTOM_ACTOR_PACKET_ID, // custom DReyeVR actors (not raw sensor data)
-  DReyeVRConfigFile = DREYEVR_CONFIG_FILE_PACKET_ID    // DReyeVR configuration files (parameters)
+  DReyeVRConfigFile = DREYEVR_CONFIG_FILE_PACKET_ID,   // DReyeVR configuration files (parameters)
+  DReyeVRFrameIndex = DREYEVR_FRAME_INDEX_PACKET_ID,   // DReyeVR frame offset index (trailing packet)
+  DReyeVRKeyframe = DREYEVR_KEYFRAME_PACKET_ID,        // DReyeVR keyframe (full live actor set for seeking)
+  DReyeVRCompactPosition = DREYEVR_COMPACT_POSITION_PACKET_ID, // delta encoded Position (opt-in)
+  DReyeVRCompactDReyeVR = DREYEVR_COMPACT_DREYEVR_PACKET_ID,   // delta encoded DReyeVR (opt-in)
+  DReyeVRInternedCustomActor = DREYEVR_INTERNED_CUSTOM_ACTOR_PACKET_ID, // custom actors with a string table
+  DReyeVREyeSamples = DREYEVR_EYE_SAMPLES_PACKET_ID, // eye-tracker readings between frames (delta encoded)
+  DReyeVRGazeTraces = DREYEVR_GAZE_TRACES_PACKET_ID, // frame the focus was traced on (+ per-eye traces)
+  DReyeVRFixations = DREYEVR_FIXATIONS_PACKET_ID,    // fixation state and the fixations started/ended this frame
+  DReyeVRDwell = DREYEVR_DWELL_PACKET_ID             // per-actor gaze dwell statistics (before the frame index)
 };
 
 /// Recorder for the simulation
@@ -105,6 +122,77 @@ public:
 
   void Write(double DeltaSeconds);
 
+  // DReyeVR: serialize frames in memory and write them to disk from a background thread
+  void SetAsyncWrite(bool bAsyncWriteIn, int NumBuffers = 2)
+  {
+    bAsyncWrite = bAsyncWriteIn;
+    NumWriterBuffers = NumBuffers > 0 ? NumBuffers : 1;
+  }
+
+  DReyeVRRecorderWriterStats GetWriterStats() const
+  {
+    return AsyncWriter.GetStats();
+  }
+
+  // DReyeVR: write a keyframe (snapshot of all live actors) every Interval seconds, 0 to disable
+  void SetKeyframeInterval(double Interval)
+  {
+    KeyframeInterval = Interval;
+  }
+
+  // DReyeVR: write Position and DReyeVR packets delta encoded with the given quantization
+  void SetCompactEncoding(bool bEnabled, const DReyeVRCompactPrecision &Precision)
+  {
+    bCompactEncoding = bEnabled;
+    const DReyeVRCompactPrecision Valid = Precision.IsValid() ? Precision : DReyeVRCompactPrecision();
+    PositionEncoder.SetPrecision(Valid);
+    DReyeVREncoder.SetPrecision(Valid);
+    EyeSampleEncoder.SetPrecision(Valid);
+  }
+
+  // DReyeVR: write custom actors with a per-recording string table and changed-field masks
+  void SetInternCustomActors(bool bEnabled)
+  {
+    bInternCustomActors = bEnabled;
+  }
+
+  // DReyeVR: write every eye-tracker reading since the previous frame (not just the one in the DReyeVR packet)
+  void SetRecordEyeSamples(bool bEnabled)
+  {
+    bRecordEyeSamples = bEnabled;
+  }
+
+  // DReyeVR: write the frame the focus was traced on, and the per-eye traces (see [EgoSensor] AsyncFocusTrace)
+  void SetRecordGazeTraces(bool bEnabled)
+  {
+    bRecordGazeTraces = bEnabled;
+  }
+
+  // DReyeVR: write the EgoSensor's fixation classification (see [EgoSensor] ClassifyFixations)
+  void SetRecordFixations(bool bEnabled)
+  {
+    bRecordFixations = bEnabled;
+  }
+
+  // DReyeVR: write the EgoSensor's per-actor gaze dwell statistics when the recording stops
+  void SetRecordDwell(bool bEnabled)
+  {
+    bRecordDwell = bEnabled;
+  }
+
+  // DReyeVR: replayer and file queries parse recordings from a memory mapping
+  void SetMemoryMappedReads(bool bEnabled)
+  {
+    Replayer.SetMemoryMappedReads(bEnabled);
+    Query.SetMemoryMappedReads(bEnabled);
+  }
+
+  // DReyeVR: threads the file queries parse a recording with (0 = every hardware thread)
+  void SetQueryThreads(int NumThreads)
+  {
+    Query.SetQueryThreads(NumThreads);
+  }
+
   // events
   void AddEvent(const CarlaRecorderEventAdd &Event);
 
@@ -161,6 +249,8 @@ public:
   std::string ShowFileInfo(std::string Name, bool bShowAll = false);
   std::string ShowFileCollisions(std::string Name, char Type1, char Type2);
   std::string ShowFileActorsBlocked(std::string Name, double MinTime = 30, double MinDistance = 10);
+  // DReyeVR: several of the queries above in a single pass, with structured results
+  CarlaRecorderQuery::FQueryResult QueryFile(std::string Name, const CarlaRecorderQuery::FQueryOptions &Options);
 
   // replayer
   std::string ReplayFile(std::string Name, double TimeStart, double Duration,
@@ -183,6 +273,62 @@ private:
   // files
   std::ofstream File;
 
+  // DReyeVR asynchronous writer (File is redirected into its in-memory frame buffer while recording)
+  bool bAsyncWrite = false;
+  int NumWriterBuffers = 2;
+  DReyeVRRecorderWriter AsyncWriter;
+
+  // DReyeVR frame offset index (written as a trailing packet on Stop)
+  DReyeVRFrameIndex FrameIndex;
+
+  // DReyeVR keyframes (so the replayer can seek without replaying from the first frame)
+  double KeyframeInterval = 0.0;
+  double LastKeyframeTime = 0.0;
+  uint32_t NumKeyframes = 0;
+  uint64_t KeyframeBytes = 0;
+  void WriteKeyframe();
+  CarlaRecorderEventAdd MakeRecorderEventAdd(
+      uint32_t DatabaseId,
+      uint8_t Type,
+      const FTransform &Transform,
+      const FActorDescription &ActorDescription) const;
+
+  // DReyeVR compact (delta encoded) Position and DReyeVR packets
+  bool bCompactEncoding = false;
+  std::vector<DReyeVRCompactPosition> CompactPositions;
+  DReyeVRPositionEncoder PositionEncoder;
+  DReyeVRFieldEncoder DReyeVREncoder;
+  DReyeVRCompactWriter CompactBytes;
+  struct
+  {
+    uint64_t PositionRawBytes = 0; // size the raw packets would have had
+    uint64_t PositionBytes = 0;
+    uint64_t DReyeVRRawBytes = 0;
+    uint64_t DReyeVRBytes = 0;
+    uint64_t Frames = 0;
+    double EncodeSeconds = 0.0;
+  } CompactStats;
+  // DReyeVR custom actors with interned strings
+  bool bInternCustomActors = false;
+  DReyeVR::CustomActorEncoder CustomActorEncoder;
+  uint64_t CustomActorBytes = 0;
+  // DReyeVR eye-tracker readings between frames (always delta encoded, reset along with the compact packets)
+  bool bRecordEyeSamples = false;
+  std::vector<DReyeVR::EyeTracker> EyeSamples;
+  DReyeVRFieldEncoder EyeSampleEncoder;
+  uint64_t NumEyeSamples = 0;
+  uint64_t EyeSampleBytes = 0;
+  // DReyeVR gaze traces of the focus (regular packet, one record per frame)
+  bool bRecordGazeTraces = false;
+  // DReyeVR fixations (regular packet, one record per frame)
+  bool bRecordFixations = false;
+  // DReyeVR dwell statistics (regular packet, one record at the end)
+  bool bRecordDwell = false;
+  void WriteCompactPositions(bool bReset);
+  void WriteCompactDReyeVR(bool bReset);
+  void WriteEyeSamples(bool bReset);
+  void LogCompactStats() const;
+
   UCarlaEpisode *Episode = nullptr;
 
   // structures
@@ -207,6 +353,9 @@ private:
   CarlaRecorderWeathers Weathers;
   DReyeVRDataRecorders<DReyeVR::AggregateData, DREYEVR_PACKET_ID> DReyeVRAggData;
   DReyeVRDataRecorders<DReyeVR::CustomActorData, DREYEVR_CUSTOM_ACTOR_PACKET_ID> DReyeVRCustomActorData;
+  DReyeVRDataRecorders<DReyeVR::GazeTraces, DREYEVR_GAZE_TRACES_PACKET_ID> DReyeVRGazeTraces;
+  DReyeVRDataRecorders<DReyeVR::FixationData, DREYEVR_FIXATIONS_PACKET_ID> DReyeVRFixations;
+  DReyeVRDataRecorders<DReyeVR::DwellData, DREYEVR_DWELL_PACKET_ID> DReyeVRDwell;
   DReyeVRDataRecorders<DReyeVR::ConfigFileData, DREYEVR_CONFIG_FILE_PACKET_ID> DReyeVRConfigFileData;
 
   // replayer
@@ -9,9 +9,6 @@
 #include "UnrealString.h"
 #include "CarlaRecorderHelpers.h"
 
-// create a temporal buffer to convert from and to FString and bytes
-static std::vector<uint8_t> CarlaRecorderHelperBuffer;
-
 // get the final path + filename
 std::string GetRecorderFilename(std::string Filename)
 {
@@ -130,18 +127,14 @@ void ReadFLinearColor(std::ifstream &InFile, FLinearColor &OutObj)
 // read binary data to FString (length + text)
 void ReadFString(std::ifstream &InFile, FString &OutObj)
 {
-  uint16_t Length;
-  ReadValue<uint16_t>(InFile, Length);
-  // make room in vector buffer
-  if (CarlaRecorderHelperBuffer.capacity() < Length + 1)
+  // DReyeVR: view of the text in the mapped recording (only copied, into a per-thread buffer, for regular streams)
+  DReyeVRStringView Text;
+  if (!DReyeVRReadString(InFile, Text))
   {
-    CarlaRecorderHelperBuffer.reserve(Length + 1);
+    OutObj.Empty();
+    return;
   }
-  CarlaRecorderHelperBuffer.clear();
-  // initialize the vector space with 0
-  CarlaRecorderHelperBuffer.resize(Length + 1);
-  // read
-  InFile.read(reinterpret_cast<char *>(CarlaRecorderHelperBuffer.data()), Length);
   // convert from UTF8 to FString
-  OutObj = FString(UTF8_TO_TCHAR(CarlaRecorderHelperBuffer.data()));
+  FUTF8ToTCHAR Converted(Text.Data, Text.Length);
+  OutObj = FString(Converted.Length(), Converted.Get());
 }
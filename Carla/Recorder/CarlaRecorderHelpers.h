@@ -9,6 +9,8 @@
 #include <fstream>
 #include <vector>
 
+#include "DReyeVRRecorderReader.h" // DReyeVRReadBytes
+
 // get the final path + filename
 std::string GetRecorderFilename(std::string Filename);
 
@@ -68,7 +70,8 @@ void WriteFString(std::ofstream &OutFile, const FString &InObj);
 template <typename T>
 void ReadValue(std::ifstream &InFile, T &OutObj)
 {
-  InFile.read(reinterpret_cast<char *>(&OutObj), sizeof(T));
+  // DReyeVR: straight to the stream buffer, a memcpy for memory mapped recordings
+  DReyeVRReadBytes(InFile, reinterpret_cast<char *>(&OutObj), sizeof(T));
 }
 
 template <typename T>
@@ -6,6 +6,7 @@
 
 #include "CarlaRecorderHelpers.h"
 
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 #include <string>
@@ -38,6 +39,12 @@ inline bool CarlaRecorderQuery::CheckFileInfo(std::stringstream &Info)
   // read Info
   RecInfo.Read(File);
 
+  // (compact packets start over in every file)
+  PositionDecoder.Reset();
+  DReyeVRDecoder.Reset();
+  EyeSampleDecoder.Reset();
+  CustomActorDecoder.Reset();
+
   // check magic string
   if (RecInfo.Magic != "CARLA_RECORDER")
   {
@@ -51,26 +58,43 @@ inline bool CarlaRecorderQuery::CheckFileInfo(std::stringstream &Info)
   tm *TimeInfo = localtime(&RecInfo.Date);
   char DateStr[100];
   strftime(DateStr, sizeof(DateStr), "%x %X", TimeInfo);
-  Info << "Date: " << DateStr << std::endl << std::endl;
+  Info << "Date: " << DateStr << std::endl;
+
+  // DReyeVR frame index (restores the read position)
+  if (FrameIndex.Load(File))
+  {
+    Info << "Frame index: " << FrameIndex.Num() << " frames, " << FrameIndex.GetKeyframes().size() << " keyframes, "
+         << FrameIndex.GetTotalTime() << " seconds" << std::endl;
+  }
+  Info << std::endl;
 
   return true;
 }
 
-std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
+// DReyeVR: every query is a visitor of the packets parsed here, for the byte range of a single chunk
+void CarlaRecorderQuery::ParseChunk(const std::string &Filename, const DReyeVRQueryChunk &Chunk,
+    const FQueryOptions &Options, FChunkResult &Out)
 {
-  std::stringstream Info;
-
-  // get the final path + filename
-  std::string Filename2 = GetRecorderFilename(Filename);
-
-  // try to open
-  File.open(Filename2, std::ios::binary);
+  File.open(Filename, std::ios::binary);
   if (!File.is_open())
   {
-    Info << "File " << Filename2 << " not found on server\n";
-    return Info.str();
+    return;
   }
 
+  // DReyeVR: parse from a memory mapping of the file (keeps the regular stream if it can't be mapped)
+  if (bMemoryMappedReads)
+    MappedFile.Open(Filename, File);
+
+  // (a chunk starts at a frame where the compact packets start over)
+  PositionDecoder.Reset();
+  DReyeVRDecoder.Reset();
+  EyeSampleDecoder.Reset();
+  CustomActorDecoder.Reset();
+  File.seekg(Chunk.Begin, std::ios::beg);
+
+  std::stringstream Info;
+  const bool bShowAll = Options.bInfo && Options.bShowAll;
+  const bool bEvents = Options.bCollisions || Options.bBlocked;
   uint16_t i, Total;
   bool bFramePrinted = false;
 
@@ -80,11 +104,9 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
     Info << "Frame " << Frame.Id << " at " << Frame.Elapsed << " seconds\n";
   };
 
-  if (!CheckFileInfo(Info))
-    return Info.str();
-
-  // parse only frames
-  while (File)
+  // parse only the frames of the chunk
+  uint64_t Offset = Chunk.Begin;
+  while (File && Offset < Chunk.End)
   {
 
     // get header
@@ -92,6 +114,7 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
     {
       break;
     }
+    Offset += sizeof(char) + sizeof(uint32_t) + Header.Size;
 
     // check for a frame packet
     switch (Header.Id)
@@ -106,12 +129,20 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
         }
         else
           bFramePrinted = false;
+        Out.Frames.push_back(FChunkFrame {Frame.Id, Frame.Elapsed, Frame.DurationThis,
+            static_cast<uint32_t>(Out.Adds.size()), static_cast<uint32_t>(Out.Dels.size()),
+            static_cast<uint32_t>(Out.Collisions.size()), static_cast<uint32_t>(Out.Positions.size())});
         break;
 
       // events add
       case static_cast<char>(CarlaRecorderPacketId::EventAdd):
+        if (!Options.bInfo && !bEvents)
+        {
+          SkipPacket();
+          break;
+        }
         ReadValue<uint16_t>(File, Total);
-        if (Total > 0 && !bFramePrinted)
+        if (Options.bInfo && Total > 0 && !bFramePrinted)
         {
           PrintFrame(Info);
           bFramePrinted = true;
@@ -120,6 +151,10 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
         {
           // add
           EventAdd.Read(File);
+          if (bEvents)
+            Out.Adds.push_back(FChunkAdd {EventAdd.DatabaseId, EventAdd.Type, TCHAR_TO_UTF8(*EventAdd.Description.Id)});
+          if (!Options.bInfo)
+            continue;
           Info << " Create " << EventAdd.DatabaseId << ": " << TCHAR_TO_UTF8(*EventAdd.Description.Id) <<
             " (" <<
             static_cast<int>(EventAdd.Type) << ") at (" << EventAdd.Location.X << ", " <<
@@ -133,8 +168,13 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
 
       // events del
       case static_cast<char>(CarlaRecorderPacketId::EventDel):
+        if (!Options.bInfo && !bEvents)
+        {
+          SkipPacket();
+          break;
+        }
         ReadValue<uint16_t>(File, Total);
-        if (Total > 0 && !bFramePrinted)
+        if (Options.bInfo && Total > 0 && !bFramePrinted)
         {
           PrintFrame(Info);
           bFramePrinted = true;
@@ -142,12 +182,20 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
         for (i = 0; i < Total; ++i)
         {
           EventDel.Read(File);
-          Info << " Destroy " << EventDel.DatabaseId << "\n";
+          if (bEvents)
+            Out.Dels.push_back(EventDel.DatabaseId);
+          if (Options.bInfo)
+            Info << " Destroy " << EventDel.DatabaseId << "\n";
         }
         break;
 
       // events parenting
       case static_cast<char>(CarlaRecorderPacketId::EventParent):
+        if (!Options.bInfo)
+        {
+          SkipPacket();
+          break;
+        }
         ReadValue<uint16_t>(File, Total);
         if (Total > 0 && !bFramePrinted)
         {
@@ -164,8 +212,13 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
 
       // collisions
       case static_cast<char>(CarlaRecorderPacketId::Collision):
+        if (!Options.bInfo && !Options.bCollisions)
+        {
+          SkipPacket();
+          break;
+        }
         ReadValue<uint16_t>(File, Total);
-        if (Total > 0 && !bFramePrinted)
+        if (Options.bInfo && Total > 0 && !bFramePrinted)
         {
           PrintFrame(Info);
           bFramePrinted = true;
@@ -173,6 +226,11 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
         for (i = 0; i < Total; ++i)
         {
           Collision.Read(File);
+          if (Options.bCollisions)
+            Out.Collisions.push_back(FChunkCollision {Collision.DatabaseId1, Collision.DatabaseId2,
+                Collision.IsActor1Hero, Collision.IsActor2Hero});
+          if (!Options.bInfo)
+            continue;
           Info << " Collision id " << Collision.Id << " between " << Collision.DatabaseId1;
           if (Collision.IsActor1Hero)
             Info << " (hero) ";
@@ -185,19 +243,53 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
 
       // positions
       case static_cast<char>(CarlaRecorderPacketId::Position):
-        if (bShowAll)
+        if (bShowAll || Options.bBlocked)
         {
           ReadValue<uint16_t>(File, Total);
-          if (Total > 0 && !bFramePrinted)
+          if (bShowAll && Total > 0 && !bFramePrinted)
           {
             PrintFrame(Info);
             bFramePrinted = true;
           }
-          Info << " Positions: " << Total << std::endl;
+          if (bShowAll)
+            Info << " Positions: " << Total << std::endl;
           for (i = 0; i < Total; ++i)
           {
             Position.Read(File);
-            Info << "  Id: " << Position.DatabaseId << " Location: (" << Position.Location.X << ", " << Position.Location.Y << ", " << Position.Location.Z << ") Rotation (" <<  Position.Rotation.X << ", " << Position.Rotation.Y << ", " << Position.Rotation.Z << ")" << std::endl;
+            if (Options.bBlocked)
+              Out.Positions.push_back(FChunkPosition {Position.DatabaseId, Position.Location});
+            if (bShowAll)
+              Info << "  Id: " << Position.DatabaseId << " Location: (" << Position.Location.X << ", " << Position.Location.Y << ", " << Position.Location.Z << ") Rotation (" <<  Position.Rotation.X << ", " << Position.Rotation.Y << ", " << Position.Rotation.Z << ")" << std::endl;
+          }
+        }
+        else
+          SkipPacket();
+        break;
+
+      // compact positions
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactPosition):
+        if (bShowAll || Options.bBlocked)
+        {
+          if (!ReadCompactPositions())
+          {
+            if (bShowAll)
+              Info << " Compact positions: not decodable" << std::endl;
+            break;
+          }
+          if (bShowAll && !CompactPositions.empty() && !bFramePrinted)
+          {
+            PrintFrame(Info);
+            bFramePrinted = true;
+          }
+          if (bShowAll)
+            Info << " Positions: " << CompactPositions.size() << std::endl;
+          for (const DReyeVRCompactPosition &Compact : CompactPositions)
+          {
+            if (Options.bBlocked)
+              Out.Positions.push_back(FChunkPosition {Compact.DatabaseId,
+                  FVector(Compact.Location[0], Compact.Location[1], Compact.Location[2])});
+            if (bShowAll)
+              Info << "  Id: " << Compact.DatabaseId << " Location: (" << Compact.Location[0] << ", " << Compact.Location[1] << ", " << Compact.Location[2] << ") Rotation (" <<  Compact.Rotation[0] << ", " << Compact.Rotation[1] << ", " << Compact.Rotation[2] << ")" << std::endl;
           }
         }
         else
@@ -584,6 +676,132 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
             SkipPacket();
         break;
 
+        // compact DReyeVR data
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactDReyeVR):
+        if (bShowAll)
+        {
+            uint64_t NumRecords = 0;
+            if (!ReadCompactDReyeVR(NumRecords))
+            {
+                Info << " DReyeVR sensor data: not decodable" << std::endl;
+                break;
+            }
+            if (NumRecords > 0 && !bFramePrinted)
+            {
+                PrintFrame(Info);
+                bFramePrinted = true;
+            }
+            Info << " DReyeVR sensor data: " << NumRecords << std::endl;
+            if (NumRecords > 0)
+                Info << DReyeVRAggDataInstance.Print() << std::endl;
+        }
+        else
+            SkipPacket();
+        break;
+
+        // DReyeVR eye-tracker readings between frames
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVREyeSamples):
+        if (bShowAll)
+        {
+            if (!ReadEyeSamples())
+            {
+                Info << " DReyeVR eye samples: not decodable" << std::endl;
+                break;
+            }
+            if (EyeSamples.size() > 0 && !bFramePrinted)
+            {
+                PrintFrame(Info);
+                bFramePrinted = true;
+            }
+            if (EyeSamples.size() > 0)
+            {
+                Info << " DReyeVR eye samples: " << EyeSamples.size() << " (device time "
+                     << EyeSamples.front().TimestampDevice << " to " << EyeSamples.back().TimestampDevice << " ms)"
+                     << std::endl;
+            }
+        }
+        else
+            SkipPacket();
+        break;
+
+        // DReyeVR gaze traces (when the focus was traced)
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVRGazeTraces):
+        if (bShowAll)
+        {
+            ReadValue<uint16_t>(File, Total);
+            if (Total > 0 && !bFramePrinted)
+            {
+                PrintFrame(Info);
+                bFramePrinted = true;
+            }
+            for (i = 0; i < Total; ++i)
+            {
+                DReyeVRGazeTracesInstance.Read(File);
+                Info << " DReyeVR gaze traces: " << DReyeVRGazeTracesInstance.Print() << std::endl;
+            }
+        }
+        else
+            SkipPacket();
+        break;
+
+        // DReyeVR fixations
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVRFixations):
+        if (bShowAll)
+        {
+            ReadValue<uint16_t>(File, Total);
+            if (Total > 0 && !bFramePrinted)
+            {
+                PrintFrame(Info);
+                bFramePrinted = true;
+            }
+            for (i = 0; i < Total; ++i)
+            {
+                DReyeVRFixationsInstance.Read(File);
+                Info << " DReyeVR fixations: " << DReyeVRFixationsInstance.Print() << std::endl;
+            }
+        }
+        else
+            SkipPacket();
+        break;
+
+        // DReyeVR dwell statistics (once, at the end of the recording)
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVRDwell):
+        ReadValue<uint16_t>(File, Total);
+        for (i = 0; i < Total; ++i)
+        {
+            DReyeVRDwellInstance.Read(File);
+            Info << " DReyeVR dwell: " << DReyeVRDwellInstance.Print() << std::endl;
+        }
+        break;
+
+        // DReyeVR custom actors with interned strings
+        case static_cast<char>(CarlaRecorderPacketId::DReyeVRInternedCustomActor):
+        if (bShowAll)
+        {
+            DReyeVRStringView Body;
+            if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+                break;
+            DReyeVRCompactReader Reader(Body.Data, Body.Length);
+            if (!CustomActorDecoder.Decode(Reader, CustomActorRecords))
+            {
+                Info << " DReyeVR custom actor data: not decodable" << std::endl;
+                break;
+            }
+            if (!CustomActorRecords.empty() && !bFramePrinted)
+            {
+                PrintFrame(Info);
+                bFramePrinted = true;
+            }
+            Info << " DReyeVR custom actor data: " << CustomActorRecords.size() << std::endl;
+            for (const auto &Record : CustomActorRecords)
+            {
+                Info << TCHAR_TO_UTF8(*Record.Data->ToString()) << std::endl;
+            }
+        }
+        else
+            SkipPacket();
+        break;
+
         // DReyeVR data
         case static_cast<char>(CarlaRecorderPacketId::DReyeVRCustomActor):
         if (bShowAll)
@@ -636,16 +854,85 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
     }
   }
 
-  Info << "\nFrames: " << Frame.Id << "\n";
-  Info << "Duration: " << Frame.Elapsed << " seconds\n";
+  Out.Info = Info.str();
 
+  MappedFile.Close(File);
   File.close();
+}
 
-  return Info.str();
+void CarlaRecorderQuery::FindChunkStarts(std::vector<uint64_t> &Starts, uint64_t &DataEnd)
+{
+  const uint64_t DataBegin = static_cast<uint64_t>(File.tellg());
+  File.seekg(0, std::ios::end);
+  DataEnd = static_cast<uint64_t>(File.tellg());
+  File.seekg(DataBegin, std::ios::beg);
+
+  // compact packets are written in every frame, so the first frame is enough to tell (with a frame index, the
+  // rest of the scan only happens for recordings without one)
+  const bool bScan = FrameIndex.IsEmpty();
+  bool bCompact = false;
+  std::vector<uint64_t> Keyframes; // offsets of the frames holding a keyframe
+  uint64_t Offset = DataBegin;
+  uint64_t FrameOffset = DataBegin;
+  while (File && Offset < DataEnd)
+  {
+    if (!ReadHeader() || !File)
+    {
+      break;
+    }
+    if (Header.Id == static_cast<char>(CarlaRecorderPacketId::FrameStart))
+    {
+      if (!bScan && Offset != DataBegin)
+        break;
+      FrameOffset = Offset;
+      Starts.push_back(Offset);
+    }
+    else if (Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactPosition) ||
+             Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactDReyeVR) ||
+             Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVREyeSamples) ||
+             Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVRInternedCustomActor))
+    {
+      bCompact = true;
+    }
+    else if (Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVRKeyframe))
+    {
+      Keyframes.push_back(FrameOffset);
+    }
+    Offset += sizeof(char) + sizeof(uint32_t) + Header.Size;
+    SkipPacket();
+  }
+  File.clear();
+
+  if (!bScan)
+  {
+    const std::vector<DReyeVRFrameIndexEntry> &Entries = FrameIndex.GetEntries();
+    Starts.clear();
+    Keyframes.clear();
+    for (const DReyeVRFrameIndexEntry &Entry : Entries)
+      Starts.push_back(Entry.Offset);
+    for (const DReyeVRKeyframeEntry &Keyframe : FrameIndex.GetKeyframes())
+    {
+      if (Keyframe.FrameNumber < Entries.size())
+        Keyframes.push_back(Entries[Keyframe.FrameNumber].Offset);
+    }
+  }
+
+  // delta encoded packets can only be decoded from the first frame or a keyframe
+  if (bCompact && !Starts.empty())
+  {
+    std::vector<uint64_t> Resets = { Starts.front() };
+    for (uint64_t Keyframe : Keyframes)
+    {
+      if (Keyframe > Resets.back())
+        Resets.push_back(Keyframe);
+    }
+    Starts = std::move(Resets);
+  }
 }
 
-std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Category1, char Category2)
+CarlaRecorderQuery::FQueryResult CarlaRecorderQuery::Query(std::string Filename, const FQueryOptions &Options)
 {
+  FQueryResult Result;
   std::stringstream Info;
 
   // get the final path + filename
@@ -656,19 +943,45 @@ std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Categ
   if (!File.is_open())
   {
     Info << "File " << Filename2 << " not found on server\n";
-    return Info.str();
+    Result.Header = Info.str();
+    return Result;
   }
 
-  if (!CheckFileInfo(Info))
-    return Info.str();
+  // DReyeVR: parse from a memory mapping of the file (keeps the regular stream if it can't be mapped)
+  if (bMemoryMappedReads)
+    MappedFile.Open(Filename2, File);
 
-  // other, vehicle, walkers, trafficLight, hero, any
-  char Categories[] = { 'o', 'v', 'w', 't', 'h', 'a' };
-  uint16_t i, Total;
+  std::vector<uint64_t> Starts;
+  uint64_t DataEnd = 0;
+  Result.bValid = CheckFileInfo(Info);
+  if (Result.bValid)
+    FindChunkStarts(Starts, DataEnd);
+  Result.Header = Info.str();
+
+  MappedFile.Close(File);
+  File.close();
+
+  if (!Result.bValid)
+    return Result;
+
+  // a few MB per chunk, and enough chunks to keep every thread busy
+  constexpr uint64_t ChunkBytes = 8 << 20;
+  DReyeVRQueryEngine Engine(QueryThreads);
+  const uint64_t Bytes = Starts.empty() ? 0 : DataEnd - Starts.front();
+  const std::vector<DReyeVRQueryChunk> Plan = DReyeVRSplitChunks(Starts, DataEnd,
+      std::max<size_t>(Engine.GetNumThreads(), static_cast<size_t>(Bytes / ChunkBytes)));
+  std::vector<FChunkResult> Chunks(Plan.size());
+  Result.Chunks = Plan.size();
+
+  // state carried across chunks by the merge (other, vehicle, walkers, trafficLight, hero, any)
+  const char Categories[] = { 'o', 'v', 'w', 't', 'h', 'a' };
   struct ReplayerActorInfo
   {
-    uint8_t Type;
-    FString Id;
+    uint8_t Type = 0;
+    std::string Id;
+    FVector LastPosition = FVector(0, 0, 0);
+    double Time = 0.0;
+    double Duration = 0.0;
   };
   std::unordered_map<uint32_t, ReplayerActorInfo> Actors;
   struct PairHash
@@ -682,179 +995,168 @@ std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Categ
     }
   };
   std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash > oldCollisions, newCollisions;
-
-  // header
-  Info << std::setw(8) << "Time";
-  Info << " " << std::setw(6) << "Types";
-  Info << " " << std::setw(6) << std::right << "Id";
-  Info << " " << std::setw(35) << std::left << "Actor 1";
-  Info << " " << std::setw(6) << std::right << "Id";
-  Info << " " << std::setw(35) << std::left << "Actor 2";
-  Info << std::endl;
-
-  // parse only frames
-  while (File)
+  auto GetCategory = [&](uint32_t DatabaseId)
   {
+    if (DatabaseId == uint32_t(-1))
+      return 'o'; // other non-actor object
+    const uint8_t Type = Actors[DatabaseId].Type;
+    return Type < sizeof(Categories) ? Categories[Type] : 'o';
+  };
 
-    // get header
-    if (!ReadHeader())
-    {
-      break;
-    }
+  auto Parse = [&](size_t Index)
+  {
+    CarlaRecorderQuery Worker;
+    Worker.bMemoryMappedReads = bMemoryMappedReads;
+    Worker.ParseChunk(Filename2, Plan[Index], Options, Chunks[Index]);
+  };
 
-    // check for a frame packet
-    switch (Header.Id)
+  auto Merge = [&](size_t Index)
+  {
+    FChunkResult &Chunk = Chunks[Index];
+    Result.Info += Chunk.Info;
+    for (size_t f = 0; f < Chunk.Frames.size(); ++f)
     {
-      // frame
-      case static_cast<char>(CarlaRecorderPacketId::FrameStart):
-        Frame.Read(File);
-        // exchange sets of collisions (to know when a collision is new or continue from previous frame)
-        oldCollisions = std::move(newCollisions);
-        newCollisions.clear();
-        break;
-
-      // events add
-      case static_cast<char>(CarlaRecorderPacketId::EventAdd):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
+      const FChunkFrame &Frame = Chunk.Frames[f];
+      const bool bLast = (f + 1 == Chunk.Frames.size());
+      const FChunkFrame *Next = bLast ? nullptr : &Chunk.Frames[f + 1];
+
+      // events
+      for (uint32_t i = Frame.FirstAdd; i < (bLast ? Chunk.Adds.size() : Next->FirstAdd); ++i)
+      {
+        ReplayerActorInfo &Actor = Actors[Chunk.Adds[i].DatabaseId];
+        Actor = ReplayerActorInfo();
+        Actor.Type = Chunk.Adds[i].Type;
+        Actor.Id = std::move(Chunk.Adds[i].Id);
+      }
+      for (uint32_t i = Frame.FirstDel; i < (bLast ? Chunk.Dels.size() : Next->FirstDel); ++i)
+      {
+        Actors.erase(Chunk.Dels[i]);
+      }
+
+      // exchange sets of collisions (to know when a collision is new or continue from previous frame)
+      oldCollisions = std::move(newCollisions);
+      newCollisions.clear();
+      for (uint32_t i = Frame.FirstCollision; i < (bLast ? Chunk.Collisions.size() : Next->FirstCollision); ++i)
+      {
+        const FChunkCollision &Collision = Chunk.Collisions[i];
+        const char Type1 = GetCategory(Collision.DatabaseId1);
+        const char Type2 = GetCategory(Collision.DatabaseId2);
+
+        // only if both actors pass the filter
+        const bool bValid1 = Options.Category1 == 'a' || Options.Category1 == Type1 ||
+            (Options.Category1 == 'h' && Collision.IsActor1Hero);
+        const bool bValid2 = Options.Category2 == 'a' || Options.Category2 == Type2 ||
+            (Options.Category2 == 'h' && Collision.IsActor2Hero);
+        if (!bValid1 || !bValid2)
+          continue;
+
+        // a starting collision or one that continues from the previous frame
+        auto collisionPair = std::make_pair(Collision.DatabaseId1, Collision.DatabaseId2);
+        if (oldCollisions.count(collisionPair) == 0)
         {
-          // add
-          EventAdd.Read(File);
-          Actors[EventAdd.DatabaseId] = ReplayerActorInfo { EventAdd.Type, EventAdd.Description.Id };
+          Result.Collisions.push_back(FCollisionEvent {Frame.Elapsed, Type1, Type2, Collision.DatabaseId1,
+              Collision.DatabaseId2, Actors[Collision.DatabaseId1].Id, Actors[Collision.DatabaseId2].Id});
         }
-        break;
-
-      // events del
-      case static_cast<char>(CarlaRecorderPacketId::EventDel):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
+        newCollisions.insert(collisionPair);
+      }
+
+      // checks if the actor has been stopped for too long
+      for (uint32_t i = Frame.FirstPosition; i < (bLast ? Chunk.Positions.size() : Next->FirstPosition); ++i)
+      {
+        const FChunkPosition &Position = Chunk.Positions[i];
+        ReplayerActorInfo &Actor = Actors[Position.DatabaseId];
+        if (FVector::Distance(Actor.LastPosition, Position.Location) < Options.MinDistance)
         {
-          EventDel.Read(File);
-          Actors.erase(EventAdd.DatabaseId);
+          // actor stopped
+          if (Actor.Duration == 0)
+            Actor.Time = Frame.Elapsed;
+          Actor.Duration += Frame.DurationThis;
         }
-        break;
-
-      // events parenting
-      case static_cast<char>(CarlaRecorderPacketId::EventParent):
-        SkipPacket();
-        break;
-
-      // collisions
-      case static_cast<char>(CarlaRecorderPacketId::Collision):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
+        else
         {
-          Collision.Read(File);
-
-          int Valid = 0;
-
-          // get categories for both actors
-          uint8_t Type1, Type2;
-          if (Collision.DatabaseId1 != uint32_t(-1))
-            Type1 = Categories[Actors[Collision.DatabaseId1].Type];
-          else
-            Type1 = 'o'; // other non-actor object
-          
-          if (Collision.DatabaseId2 != uint32_t(-1))
-            Type2 = Categories[Actors[Collision.DatabaseId2].Type];
-          else
-            Type2 = 'o'; // other non-actor object
-
-          // filter actor 1
-          if (Category1 == 'a')
-            ++Valid;
-          else if (Category1 == Type1)
-            ++Valid;
-          else if (Category1 == 'h' && Collision.IsActor1Hero)
-            ++Valid;
-
-          // filter actor 2
-          if (Category2 == 'a')
-            ++Valid;
-          else if (Category2 == Type2)
-            ++Valid;
-          else if (Category2 == 'h' && Collision.IsActor2Hero)
-            ++Valid;
-
-          // only show if both actors has passed the filter
-          if (Valid == 2)
-          {
-            // check if we need to show as a starting collision or it is a continuation one
-            auto collisionPair = std::make_pair(Collision.DatabaseId1, Collision.DatabaseId2);
-            if (oldCollisions.count(collisionPair) == 0)
-            {
-              Info << std::setw(8) << std::setprecision(0) << std::right << std::fixed << Frame.Elapsed;
-              Info << " " << "  " << Type1 << " " << Type2 << " ";
-              Info << " " << std::setw(6) << std::right << Collision.DatabaseId1;
-              Info << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Collision.DatabaseId1].Id);
-              Info << " " << std::setw(6) << std::right << Collision.DatabaseId2;
-              Info << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Collision.DatabaseId2].Id);
-              Info << std::endl;
-            }
-            // save current collision
-            newCollisions.insert(collisionPair);
-          }
+          if (Actor.Duration >= Options.MinTime)
+            Result.Blocked.push_back(FBlockedActor {Actor.Time, Position.DatabaseId, Actor.Id, Actor.Duration});
+          // actor moving
+          Actor.Duration = 0;
+          Actor.LastPosition = Position.Location;
         }
-        break;
-
-      case static_cast<char>(CarlaRecorderPacketId::Position):
-        SkipPacket();
-        break;
+      }
 
-      case static_cast<char>(CarlaRecorderPacketId::State):
-        SkipPacket();
-        break;
+      Result.Frames = Frame.Id;
+      Result.Duration = Frame.Elapsed;
+    }
+    Chunk = FChunkResult(); // (only the chunks being parsed ahead of the merge are held in memory)
+  };
 
-      // frame end
-      case static_cast<char>(CarlaRecorderPacketId::FrameEnd):
-        // do nothing, it is empty
-        break;
+  Engine.Run(Plan.size(), Parse, Merge);
 
-      default:
-        SkipPacket();
-        break;
+  if (Options.bBlocked)
+  {
+    // actors stopped that were not moving again
+    for (auto &Actor : Actors)
+    {
+      if (Actor.second.Duration >= Options.MinTime)
+        Result.Blocked.push_back(FBlockedActor {Actor.second.Time, Actor.first, Actor.second.Id, Actor.second.Duration});
     }
+    // by the duration of each actor (decreasing order)
+    std::stable_sort(Result.Blocked.begin(), Result.Blocked.end(),
+        [](const FBlockedActor &A, const FBlockedActor &B) { return A.Duration > B.Duration; });
   }
 
-  Info << "\nFrames: " << Frame.Id << "\n";
-  Info << "Duration: " << Frame.Elapsed << " seconds\n";
+  return Result;
+}
 
-  File.close();
+std::string CarlaRecorderQuery::FormatInfo(const FQueryResult &Result)
+{
+  std::stringstream Info;
+  Info << Result.Header;
+  if (!Result.bValid)
+    return Info.str();
 
+  Info << Result.Info;
+  Info << "\nFrames: " << Result.Frames << "\n";
+  Info << "Duration: " << Result.Duration << " seconds\n";
   return Info.str();
 }
 
-std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTime, double MinDistance)
+std::string CarlaRecorderQuery::FormatCollisions(const FQueryResult &Result)
 {
   std::stringstream Info;
+  Info << Result.Header;
+  if (!Result.bValid)
+    return Info.str();
 
-  // get the final path + filename
-  std::string Filename2 = GetRecorderFilename(Filename);
+  // header
+  Info << std::setw(8) << "Time";
+  Info << " " << std::setw(6) << "Types";
+  Info << " " << std::setw(6) << std::right << "Id";
+  Info << " " << std::setw(35) << std::left << "Actor 1";
+  Info << " " << std::setw(6) << std::right << "Id";
+  Info << " " << std::setw(35) << std::left << "Actor 2";
+  Info << std::endl;
 
-  // try to open
-  File.open(Filename2, std::ios::binary);
-  if (!File.is_open())
+  for (const FCollisionEvent &Collision : Result.Collisions)
   {
-    Info << "File " << Filename2 << " not found on server\n";
-    return Info.str();
+    Info << std::setw(8) << std::setprecision(0) << std::right << std::fixed << Collision.Time;
+    Info << " " << "  " << Collision.Type1 << " " << Collision.Type2 << " ";
+    Info << " " << std::setw(6) << std::right << Collision.Id1;
+    Info << " " << std::setw(35) << std::left << Collision.Actor1;
+    Info << " " << std::setw(6) << std::right << Collision.Id2;
+    Info << " " << std::setw(35) << std::left << Collision.Actor2;
+    Info << std::endl;
   }
 
-  if (!CheckFileInfo(Info))
-    return Info.str();
+  Info << "\nFrames: " << Result.Frames << "\n";
+  Info << "Duration: " << Result.Duration << " seconds\n";
+  return Info.str();
+}
 
-  // other, vehicle, walkers, trafficLight, hero, any
-  uint16_t i, Total;
-  struct ReplayerActorInfo
-  {
-    uint8_t Type;
-    FString Id;
-    FVector LastPosition;
-    double Time;
-    double Duration;
-  };
-  std::unordered_map<uint32_t, ReplayerActorInfo> Actors;
-  // to be able to sort the results by the duration of each actor (decreasing order)
-  std::multimap<double, std::string, std::greater<double>> Results;
+std::string CarlaRecorderQuery::FormatBlocked(const FQueryResult &Result)
+{
+  std::stringstream Info;
+  Info << Result.Header;
+  if (!Result.bValid)
+    return Info.str();
 
   // header
   Info << std::setw(8) << "Time";
@@ -863,132 +1165,89 @@ std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTim
   Info << " " << std::setw(10) << std::right << "Duration";
   Info << std::endl;
 
-  // parse only frames
-  while (File)
+  for (const FBlockedActor &Blocked : Result.Blocked)
   {
+    std::stringstream Row;
+    Row << std::setw(8) << std::setprecision(0) << std::fixed << Blocked.Time;
+    Row << " " << std::setw(6) << Blocked.Id;
+    Row << " " << std::setw(35) << std::left << Blocked.Actor;
+    Row << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Blocked.Duration;
+    Row << std::endl;
+    Info << Row.str();
+  }
 
-    // get header
-    if (!ReadHeader())
-    {
-      break;
-    }
-
-    // check for a frame packet
-    switch (Header.Id)
-    {
-      // frame
-      case static_cast<char>(CarlaRecorderPacketId::FrameStart):
-        Frame.Read(File);
-        break;
-
-      // events add
-      case static_cast<char>(CarlaRecorderPacketId::EventAdd):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          // add
-          EventAdd.Read(File);
-          Actors[EventAdd.DatabaseId] = ReplayerActorInfo { EventAdd.Type, EventAdd.Description.Id, FVector(0, 0, 0), 0.0, 0.0 };
-        }
-        break;
-
-      // events del
-      case static_cast<char>(CarlaRecorderPacketId::EventDel):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          EventDel.Read(File);
-          Actors.erase(EventAdd.DatabaseId);
-        }
-        break;
-
-      // events parenting
-      case static_cast<char>(CarlaRecorderPacketId::EventParent):
-        SkipPacket();
-        break;
-
-      // collisions
-      case static_cast<char>(CarlaRecorderPacketId::Collision):
-        SkipPacket();
-        break;
+  Info << "\nFrames: " << Result.Frames << "\n";
+  Info << "Duration: " << Result.Duration << " seconds\n";
+  return Info.str();
+}
 
-      // positions
-      case static_cast<char>(CarlaRecorderPacketId::Position):
-        // read all positions
-        ReadValue<uint16_t>(File, Total);
-        for (i=0; i<Total; ++i)
-        {
-          Position.Read(File);
-          // check if actor moved less than a distance
-          if (FVector::Distance(Actors[Position.DatabaseId].LastPosition, Position.Location) < MinDistance)
-          {
-            // actor stopped
-            if (Actors[Position.DatabaseId].Duration == 0)
-              Actors[Position.DatabaseId].Time = Frame.Elapsed;
-            Actors[Position.DatabaseId].Duration += Frame.DurationThis;
-          }
-          else
-          {
-            // check to show info
-            if (Actors[Position.DatabaseId].Duration >= MinTime)
-            {
-              std::stringstream Result;
-              Result << std::setw(8) << std::setprecision(0) << std::fixed << Actors[Position.DatabaseId].Time;
-              Result << " " << std::setw(6) << Position.DatabaseId;
-              Result << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Position.DatabaseId].Id);
-              Result << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Actors[Position.DatabaseId].Duration;
-              Result << std::endl;
-              Results.insert(std::make_pair(Actors[Position.DatabaseId].Duration, Result.str()));
-            }
-            // actor moving
-            Actors[Position.DatabaseId].Duration = 0;
-            Actors[Position.DatabaseId].LastPosition = Position.Location;
-          }
-        }
-        break;
+std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
+{
+  FQueryOptions Options;
+  Options.bInfo = true;
+  Options.bShowAll = bShowAll;
+  return FormatInfo(Query(Filename, Options));
+}
 
-      // traffic light
-      case static_cast<char>(CarlaRecorderPacketId::State):
-        SkipPacket();
-        break;
+std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Category1, char Category2)
+{
+  FQueryOptions Options;
+  Options.bCollisions = true;
+  Options.Category1 = Category1;
+  Options.Category2 = Category2;
+  return FormatCollisions(Query(Filename, Options));
+}
 
-      // frame end
-      case static_cast<char>(CarlaRecorderPacketId::FrameEnd):
-        // do nothing, it is empty
-        break;
+std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTime, double MinDistance)
+{
+  FQueryOptions Options;
+  Options.bBlocked = true;
+  Options.MinTime = MinTime;
+  Options.MinDistance = MinDistance;
+  return FormatBlocked(Query(Filename, Options));
+}
 
-      default:
-        SkipPacket();
-        break;
-    }
-  }
+bool CarlaRecorderQuery::ReadCompactPositions(void)
+{
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+    return false;
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  return PositionDecoder.Decode(Reader, CompactPositions);
+}
 
-  // show actors stopped that were not moving again
-  for (auto &Actor : Actors)
+bool CarlaRecorderQuery::ReadEyeSamples(void)
+{
+  EyeSamples.clear();
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+    return false;
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  bool bDecoded = EyeSampleDecoder.BeginPacket(Reader);
+  const uint64_t Total = Reader.Varint();
+  for (uint64_t i = 0; i < Total && bDecoded; ++i)
   {
-    // check to show info
-    if (Actor.second.Duration >= MinTime)
-    {
-      std::stringstream Result;
-      Result << std::setw(8) << std::setprecision(0) << std::fixed << Actor.second.Time;
-      Result << " " << std::setw(6) << Actor.first;
-      Result << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actor.second.Id);
-      Result << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Actor.second.Duration;
-      Result << std::endl;
-      Results.insert(std::make_pair(Actor.second.Duration, Result.str()));
-    }
+    EyeSampleDecoder.BeginRecord(Reader);
+    EyeSamples.emplace_back();
+    EyeSamples.back().ReadCompact(EyeSampleDecoder);
+    bDecoded = EyeSampleDecoder.EndRecord();
   }
+  return bDecoded;
+}
 
-  // show the result
-  for (auto &Result : Results)
+bool CarlaRecorderQuery::ReadCompactDReyeVR(uint64_t &Total)
+{
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+    return false;
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  bool bDecoded = DReyeVRDecoder.BeginPacket(Reader);
+  Total = Reader.Varint();
+  for (uint64_t i = 0; i < Total && bDecoded; ++i)
   {
-    Info << Result.second;
+    DReyeVRDecoder.BeginRecord(Reader);
+    DReyeVRAggDataInstance.Data.ReadCompact(DReyeVRDecoder);
+    bDecoded = DReyeVRDecoder.EndRecord();
   }
-
-  Info << "\nFrames: " << Frame.Id << "\n";
-  Info << "Duration: " << Frame.Elapsed << " seconds\n";
-
-  File.close();
-
-  return Info.str();
+  return bDecoded;
 }
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "CarlaRecorderTraficLightTime.h"
 #include "CarlaRecorderPhysicsControl.h"
@@ -26,6 +28,10 @@
 #include "CarlaRecorderState.h"
 #include "CarlaRecorderWeather.h"
 #include "DReyeVRRecorder.h"
+#include "DReyeVRRecorderCodec.h"
+#include "DReyeVRRecorderIndex.h"
+#include "DReyeVRRecorderReader.h"
+#include "DReyeVRQueryEngine.h"
 
 class CarlaRecorderQuery
 {
@@ -40,6 +46,60 @@ class CarlaRecorderQuery
 
 public:
 
+  // DReyeVR: which queries a single pass over a recording runs (see Query)
+  struct FQueryOptions
+  {
+    bool bInfo = false;
+    bool bShowAll = false;
+    bool bCollisions = false;
+    char Category1 = 'a';
+    char Category2 = 'a';
+    bool bBlocked = false;
+    double MinTime = 30;
+    double MinDistance = 10;
+  };
+
+  // a collision between two actors that did not collide in the previous frame
+  struct FCollisionEvent
+  {
+    double Time;
+    char Type1;
+    char Type2;
+    uint32_t Id1;
+    uint32_t Id2;
+    std::string Actor1;
+    std::string Actor2;
+  };
+
+  // an actor that moved less than MinDistance for at least MinTime
+  struct FBlockedActor
+  {
+    double Time; // when it stopped
+    uint32_t Id;
+    std::string Actor;
+    double Duration;
+  };
+
+  struct FQueryResult
+  {
+    bool bValid = false;
+    std::string Header; // file info (or the reason the file could not be queried)
+    std::string Info;   // QueryInfo text of every frame
+    std::vector<FCollisionEvent> Collisions;
+    std::vector<FBlockedActor> Blocked; // by decreasing duration
+    uint64_t Frames = 0;
+    double Duration = 0.0;
+    size_t Chunks = 0; // parsed in parallel
+  };
+
+  // DReyeVR: runs all the queries selected in Options in one parallel pass over the file
+  FQueryResult Query(std::string Filename, const FQueryOptions &Options);
+
+  // text output of the queries (what QueryInfo/QueryCollisions/QueryBlocked return)
+  static std::string FormatInfo(const FQueryResult &Result);
+  static std::string FormatCollisions(const FQueryResult &Result);
+  static std::string FormatBlocked(const FQueryResult &Result);
+
   // get general info
   std::string QueryInfo(std::string Filename, bool bShowAll = false);
   // get info about collisions
@@ -47,9 +107,24 @@ public:
   // get info about blocked actors
   std::string QueryBlocked(std::string Filename, double MinTime = 30, double MinDistance = 10);
 
+  // DReyeVR: parse recordings from a memory mapping instead of the file stream
+  void SetMemoryMappedReads(bool bEnabled)
+  {
+    bMemoryMappedReads = bEnabled;
+  }
+
+  // DReyeVR: threads parsing a recording in Query (0 = every hardware thread)
+  void SetQueryThreads(int NumThreads)
+  {
+    QueryThreads = NumThreads > 0 ? static_cast<size_t>(NumThreads) : 0;
+  }
+
 private:
 
   std::ifstream File;
+  DReyeVRMappedRecording MappedFile; // (attached to File while a query runs)
+  bool bMemoryMappedReads = false;
+  size_t QueryThreads = 0;
   Header Header;
   CarlaRecorderInfo RecInfo;
   CarlaRecorderFrame Frame;
@@ -73,6 +148,73 @@ private:
   DReyeVRDataRecorder<DReyeVR::AggregateData> DReyeVRAggDataInstance;
   DReyeVRDataRecorder<DReyeVR::CustomActorData> DReyeVRCustomActorDataInstance;
   DReyeVRDataRecorder<DReyeVR::ConfigFileData> DReyeVRConfigFileDataInstance;
+  DReyeVRDataRecorder<DReyeVR::GazeTraces> DReyeVRGazeTracesInstance;
+  DReyeVRDataRecorder<DReyeVR::FixationData> DReyeVRFixationsInstance;
+  DReyeVRDataRecorder<DReyeVR::DwellData> DReyeVRDwellInstance;
+  // trailing frame offset index (empty for recordings without one)
+  DReyeVRFrameIndex FrameIndex;
+  // compact (delta encoded) packets, every one of them has to be decoded in order
+  DReyeVRPositionDecoder PositionDecoder;
+  DReyeVRFieldDecoder DReyeVRDecoder;
+  DReyeVRFieldDecoder EyeSampleDecoder;
+  std::vector<DReyeVR::EyeTracker> EyeSamples;
+  DReyeVR::CustomActorDecoder CustomActorDecoder;
+  std::vector<DReyeVRCompactPosition> CompactPositions;
+  std::vector<DReyeVR::CustomActorDecoder::Record> CustomActorRecords;
+  std::string CompactScratch;
+
+  // what a worker extracts from its chunk for the merge, in file order (every frame owns the records from its
+  // First* index up to the next frame's)
+  struct FChunkFrame
+  {
+    uint64_t Id;
+    double Elapsed;
+    double DurationThis;
+    uint32_t FirstAdd;
+    uint32_t FirstDel;
+    uint32_t FirstCollision;
+    uint32_t FirstPosition;
+  };
+  struct FChunkAdd
+  {
+    uint32_t DatabaseId;
+    uint8_t Type;
+    std::string Id;
+  };
+  struct FChunkCollision
+  {
+    uint32_t DatabaseId1;
+    uint32_t DatabaseId2;
+    bool IsActor1Hero;
+    bool IsActor2Hero;
+  };
+  struct FChunkPosition
+  {
+    uint32_t DatabaseId;
+    FVector Location;
+  };
+  struct FChunkResult
+  {
+    std::string Info;
+    std::vector<FChunkFrame> Frames;
+    std::vector<FChunkAdd> Adds;
+    std::vector<uint32_t> Dels;
+    std::vector<FChunkCollision> Collisions;
+    std::vector<FChunkPosition> Positions;
+  };
+
+  // offsets of the frames a chunk can start at (every frame, or only keyframes for compact recordings whose
+  // deltas can not be decoded from anywhere else), from the frame index or a scan of the packet headers
+  void FindChunkStarts(std::vector<uint64_t> &Starts, uint64_t &DataEnd);
+
+  // parses the packets in Chunk (runs on a worker thread with its own CarlaRecorderQuery)
+  void ParseChunk(const std::string &Filename, const DReyeVRQueryChunk &Chunk, const FQueryOptions &Options,
+                  FChunkResult &Out);
+
+  // decode the current compact packet (into CompactPositions, or DReyeVRAggDataInstance), false if not decodable
+  bool ReadCompactPositions(void);
+  bool ReadCompactDReyeVR(uint64_t &Total);
+  bool ReadEyeSamples(void); // (into EyeSamples)
 
   // read next header packet
   bool ReadHeader(void);
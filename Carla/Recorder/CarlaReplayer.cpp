@@ -12,6 +12,7 @@
 #include "Carla/Actor/DReyeVRCustomActor.h" // ADReyeVRCustomActor::ActiveCustomActors
 #include "Carla/Sensor/DReyeVRSensor.h"     // ADReyeVRSensor
 
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 
@@ -36,8 +37,13 @@ void CarlaReplayer::Stop(bool bKeepActors)
     // turn off DReyeVR replay
     if (GetEgoSensor())
       GetEgoSensor()->StopReplaying();
+
+    if (CompactDecodedPackets > 0)
+      DReyeVR_LOG("Decoded %llu compact packets, %.2f us/packet", CompactDecodedPackets,
+                  1e6 * CompactDecodeSeconds / CompactDecodedPackets);
   }
 
+  MappedFile.Close(File);
   File.close();
 }
 
@@ -74,6 +80,7 @@ void CarlaReplayer::Rewind(void)
 
   MappedId.clear();
   IsHeroMap.clear();
+  ResetCompactDecoders();
 
   // read geneal Info
   RecInfo.Read(File);
@@ -82,13 +89,22 @@ void CarlaReplayer::Rewind(void)
 // read last frame in File and return the Total time recorded
 double CarlaReplayer::GetTotalTime(void)
 {
+  // use the frame index if this recording has one
+  if (!FrameIndex.IsEmpty())
+  {
+    return FrameIndex.GetTotalTime();
+  }
+
   std::streampos Current = File.tellg();
 
-  // parse only frames
+  // parse only frames (rebuilding the frame index on the way, so seeking works for older recordings too)
+  FrameIndex.Clear();
   while (File)
   {
+    const std::streampos PacketStart = File.tellg();
+
     // get header
-    if (!ReadHeader())
+    if (!ReadHeader() || !File)
     {
       break;
     }
@@ -98,6 +114,11 @@ double CarlaReplayer::GetTotalTime(void)
     {
       case static_cast<char>(CarlaRecorderPacketId::FrameStart):
         Frame.Read(File);
+        FrameIndex.AddFrame(DReyeVRFrameIndexEntry{Frame.Id, Frame.Elapsed, static_cast<uint64_t>(PacketStart)});
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRKeyframe):
+        FrameIndex.AddKeyframe(static_cast<uint64_t>(PacketStart));
+        SkipPacket();
         break;
       default:
         SkipPacket();
@@ -113,6 +134,19 @@ double CarlaReplayer::GetTotalTime(void)
 // Read all the frames and collect their start times
 void CarlaReplayer::GetFrameStartTimes()
 {
+  FrameStartTimes.clear();
+
+  // use the frame index if this recording has one
+  if (!FrameIndex.IsEmpty())
+  {
+    FrameStartTimes.reserve(FrameIndex.Num());
+    for (const DReyeVRFrameIndexEntry &Entry : FrameIndex.GetEntries())
+    {
+      FrameStartTimes.push_back(Entry.Elapsed);
+    }
+    return;
+  }
+
   std::streampos Current = File.tellg();
 
   while (File)
@@ -138,6 +172,13 @@ void CarlaReplayer::GetFrameStartTimes()
   File.seekg(Current, std::ios::beg); // return to original position
 }
 
+void CarlaReplayer::LoadFrameIndex()
+{
+  FrameIndex.Load(File);
+  FrameStartTimes.clear();
+  bSyncFrameIdValid = false;
+}
+
 std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, double Duration,
     uint32_t ThisFollowId, bool ReplaySensors)
 {
@@ -158,6 +199,8 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
 
   // get the final path + filename
   std::string Filename2 = GetRecorderFilename(Filename);
+  CompactDecodeSeconds = 0.0;
+  CompactDecodedPackets = 0;
 
   Info << "Replaying File: " << Filename2 << std::endl;
 
@@ -170,9 +213,16 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
     return Info.str();
   }
 
+  // DReyeVR: parse from a memory mapping of the file (keeps the regular stream if it can't be mapped)
+  if (bMemoryMappedReads && MappedFile.Open(Filename2, File))
+    Info << "Memory mapped replay" << std::endl;
+
   // from start
   Rewind();
 
+  // load the frame index (if any) and invalidate the sync-mode frame times of the last file
+  LoadFrameIndex();
+
   // check to load map if different
   if (Episode->GetMapName() != RecInfo.Mapfile)
   {
@@ -199,6 +249,9 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
   // get Total time of recorder
   TotalTime = GetTotalTime();
   Info << "Total time recorded: " << TotalTime << std::endl;
+  if (!FrameIndex.IsEmpty())
+    Info << "Using frame index (" << FrameIndex.Num() << " frames, " << FrameIndex.GetKeyframes().size()
+         << " keyframes)" << std::endl;
 
   // set time to start replayer
   if (TimeStart < 0.0f)
@@ -226,7 +279,7 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
   {
     Helper.RemoveStaticProps();
     // process all events until the time
-    ProcessToTime(TimeStart, true);
+    ProcessToStartTime(TimeStart);
     // mark as enabled
     Enabled = true;
   }
@@ -257,9 +310,15 @@ void CarlaReplayer::CheckPlayAfterMapLoaded(void)
     return;
   }
 
+  if (bMemoryMappedReads)
+    MappedFile.Open(Autoplay.Filename, File);
+
   // from start
   Rewind();
 
+  // load the frame index (if any) and invalidate the sync-mode frame times of the last file
+  LoadFrameIndex();
+
   // get Total time of recorder
   TotalTime = GetTotalTime();
 
@@ -289,7 +348,7 @@ void CarlaReplayer::CheckPlayAfterMapLoaded(void)
   Helper.RemoveStaticProps();
 
   // process all events until the time
-  ProcessToTime(TimeStart, true);
+  ProcessToStartTime(TimeStart);
 
   // mark as enabled
   Enabled = true;
@@ -328,6 +387,72 @@ void CarlaReplayer::ProcessDReyeVR<DReyeVR::AggregateData>(double Per, double De
   }
 }
 
+void CarlaReplayer::ProcessCompactDReyeVR(bool bApply, double Per)
+{
+  const double StartTime = FPlatformTime::Seconds();
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+  {
+    return;
+  }
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  bool bDecoded = DReyeVRDecoder.BeginPacket(Reader);
+  const uint64_t Total = Reader.Varint();
+  DReyeVR::AggregateData Data;
+  for (uint64_t i = 0; i < Total && bDecoded; ++i)
+  {
+    DReyeVRDecoder.BeginRecord(Reader);
+    Data.ReadCompact(DReyeVRDecoder);
+    bDecoded = DReyeVRDecoder.EndRecord();
+  }
+  CompactDecodeSeconds += FPlatformTime::Seconds() - StartTime;
+  CompactDecodedPackets++;
+  if (bApply && bDecoded && Total > 0) // should be only one Agg data
+  {
+    Helper.ProcessReplayerDReyeVR<DReyeVR::AggregateData>(GetEgoSensor(), Data, Per);
+  }
+}
+
+void CarlaReplayer::ProcessInternedCustomActors(bool bApply, double Per)
+{
+  const double StartTime = FPlatformTime::Seconds();
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+  {
+    return;
+  }
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  const bool bDecoded = CustomActorDecoder.Decode(Reader, CustomActorRecords);
+  CompactDecodeSeconds += FPlatformTime::Seconds() - StartTime;
+  CompactDecodedPackets++;
+  if (!bApply || !bDecoded)
+  {
+    return;
+  }
+
+  bool bSameActors = CustomActorRecords.size() == LastCustomActors.size();
+  LastCustomActors.resize(CustomActorRecords.size());
+  for (size_t i = 0; i < CustomActorRecords.size(); ++i)
+  {
+    const DReyeVR::CustomActorData *Data = CustomActorRecords[i].Data;
+    Helper.ProcessReplayerDReyeVR<DReyeVR::CustomActorData>(GetEgoSensor(), *Data, Per);
+    bSameActors = bSameActors && LastCustomActors[i] == Data;
+    LastCustomActors[i] = Data;
+  }
+
+  // the same actors as last frame, and nothing else active: nothing to deactivate
+  if (bSameActors && ADReyeVRCustomActor::ActiveCustomActors.size() == CustomActorRecords.size())
+  {
+    return;
+  }
+  CustomActorsVisited.clear();
+  for (const auto &Record : CustomActorRecords)
+  {
+    CustomActorsVisited.insert(*Record.UniqueName);
+  }
+  DeactivateUnvisitedCustomActors();
+}
+
 template<>
 void CarlaReplayer::ProcessDReyeVR<DReyeVR::ConfigFileData>(double Per, double DeltaTime)
 {
@@ -357,7 +482,24 @@ void CarlaReplayer::ProcessDReyeVR<DReyeVR::CustomActorData>(double Per, double
     auto Name = Instance.GetUniqueName();
     CustomActorsVisited.insert(Name); // to track lifetime
   }
+  DeactivateUnvisitedCustomActors();
+}
+
+template<>
+void CarlaReplayer::ProcessDReyeVR<DReyeVR::FixationData>(double Per, double DeltaTime)
+{
+  uint16_t Total;
+  ReadValue<uint16_t>(File, Total); // read number of events
+  for (uint16_t i = 0; i < Total; ++i)
+  {
+    struct DReyeVRDataRecorder<DReyeVR::FixationData> Instance;
+    Instance.Read(File);
+    Helper.ProcessReplayerDReyeVR<DReyeVR::FixationData>(GetEgoSensor(), Instance.Data, Per);
+  }
+}
 
+void CarlaReplayer::DeactivateUnvisitedCustomActors()
+{
   for (auto It = ADReyeVRCustomActor::ActiveCustomActors.begin(); It != ADReyeVRCustomActor::ActiveCustomActors.end();){
     const std::string &ActiveActorName = It->first;
     if (CustomActorsVisited.find(ActiveActorName) == CustomActorsVisited.end()) // currently alive actor who was not visited... time to disable
@@ -383,7 +525,17 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
   bool bExitLoop = false;
 
   // check if we are in the right frame
-  if (NewTime >= Frame.Elapsed && NewTime < Frame.Elapsed + Frame.DurationThis)
+  if (bResumeInFrame)
+  {
+    // just restored a keyframe, the rest of its frame (positions, states...) still needs to be read
+    bResumeInFrame = false;
+    if (NewTime < Frame.Elapsed + Frame.DurationThis)
+    {
+      Per = (NewTime - Frame.Elapsed) / Frame.DurationThis;
+      bFrameFound = true;
+    }
+  }
+  else if (NewTime >= Frame.Elapsed && NewTime < Frame.Elapsed + Frame.DurationThis)
   {
     Per = (NewTime - Frame.Elapsed) / Frame.DurationThis;
     bFrameFound = true;
@@ -439,6 +591,11 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
           SkipPacket();
         break;
 
+      // compact positions (every packet is decoded to keep up with the deltas)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactPosition):
+        ProcessCompactPositions(bFrameFound, IsFirstTime);
+        break;
+
       // states
       case static_cast<char>(CarlaRecorderPacketId::State):
         if (bFrameFound)
@@ -492,6 +649,39 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
           SkipPacket();
         break;
 
+      // compact DReyeVR ego sensor data (every packet is decoded to keep up with the deltas)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRCompactDReyeVR):
+        ProcessCompactDReyeVR(bFrameFound, Per);
+        break;
+
+      // DReyeVR custom actors with interned strings (every packet is decoded to keep up with the string table)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRInternedCustomActor):
+        ProcessInternedCustomActors(bFrameFound, Per);
+        break;
+
+      // DReyeVR eye-tracker readings between frames (for analysis only, the DReyeVR packet drives the replay)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVREyeSamples):
+        SkipPacket();
+        break;
+
+      // DReyeVR gaze traces (for analysis only, the focus is replayed from the DReyeVR packet)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRGazeTraces):
+        SkipPacket();
+        break;
+
+      // DReyeVR fixations (on top of the DReyeVR packet of the same frame)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRFixations):
+        if (bFrameFound)
+          ProcessDReyeVR<DReyeVR::FixationData>(Per, Time);
+        else
+          SkipPacket();
+        break;
+
+      // DReyeVR dwell statistics (a summary of the whole recording, for analysis only)
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRDwell):
+        SkipPacket();
+        break;
+
       // DReyeVR custom actor data
       case static_cast<char>(CarlaRecorderPacketId::DReyeVRCustomActor):
         if (bFrameFound)
@@ -540,7 +730,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
   }
 }
 
-void CarlaReplayer::ProcessEventsAdd(void)
+void CarlaReplayer::ProcessEventsAdd(std::unordered_set<uint32_t> *RecordedIds)
 {
   uint16_t i, Total;
   CarlaRecorderEventAdd EventAdd;
@@ -550,6 +740,8 @@ void CarlaReplayer::ProcessEventsAdd(void)
   for (i = 0; i < Total; ++i)
   {
     EventAdd.Read(File);
+    if (RecordedIds != nullptr)
+      RecordedIds->insert(EventAdd.DatabaseId);
 
     // auto Result = CallbackEventAdd(
     auto Result = Helper.ProcessReplayerEventAdd(
@@ -598,6 +790,125 @@ void CarlaReplayer::ProcessEventsAdd(void)
   }
 }
 
+// restores the actor set, parents, weather and scene lights from a keyframe packet (header already read)
+void CarlaReplayer::ProcessKeyframe(void)
+{
+  const std::streampos End = File.tellg() + static_cast<std::streamoff>(Header.Size);
+  std::unordered_set<uint32_t> KeyframeActors; // recorded ids of every actor alive at the keyframe
+
+  while (File && File.tellg() < End)
+  {
+    if (!ReadHeader() || !File)
+    {
+      break;
+    }
+
+    switch (Header.Id)
+    {
+      // spawns the missing actors and relocates the existing ones
+      case static_cast<char>(CarlaRecorderPacketId::EventAdd):
+        ProcessEventsAdd(&KeyframeActors);
+        break;
+
+      case static_cast<char>(CarlaRecorderPacketId::EventParent):
+        ProcessEventsParent();
+        break;
+
+      case static_cast<char>(CarlaRecorderPacketId::Weather):
+        ProcessWeather();
+        break;
+
+      case static_cast<char>(CarlaRecorderPacketId::SceneLight):
+        ProcessLightScene();
+        break;
+
+      default:
+        SkipPacket();
+        break;
+    }
+  }
+
+  // destroy the replayed actors that do not exist (yet, or anymore) at the keyframe
+  for (auto It = MappedId.begin(); It != MappedId.end();)
+  {
+    if (KeyframeActors.find(It->first) == KeyframeActors.end())
+    {
+      Helper.ProcessReplayerEventDel(It->second);
+      It = MappedId.erase(It);
+    }
+    else
+    {
+      ++It;
+    }
+  }
+
+  File.clear();
+  File.seekg(End, std::ios::beg);
+}
+
+// jumps to the last keyframe at (or before) Time, only if its frame starts after MinFrameTime
+bool CarlaReplayer::RestoreKeyframe(double Time, double MinFrameTime)
+{
+  const DReyeVRKeyframeEntry *Keyframe = FrameIndex.FindKeyframe(Time);
+  if (Keyframe == nullptr)
+  {
+    return false;
+  }
+  const DReyeVRFrameIndexEntry &KeyframeFrame = FrameIndex.GetEntries()[Keyframe->FrameNumber];
+  if (KeyframeFrame.Elapsed <= MinFrameTime)
+  {
+    return false;
+  }
+
+  // keep the current state in case the recording does not match its index
+  const std::streampos Current = File.tellg();
+  const CarlaRecorderFrame CurrentFrame = Frame;
+
+  // read the frame containing the keyframe
+  File.clear();
+  File.seekg(KeyframeFrame.Offset, std::ios::beg);
+  bool bValid = ReadHeader() && File && Header.Id == static_cast<char>(CarlaRecorderPacketId::FrameStart);
+  if (bValid)
+  {
+    Frame.Read(File);
+    File.seekg(Keyframe->Offset, std::ios::beg);
+    bValid = ReadHeader() && File && Header.Id == static_cast<char>(CarlaRecorderPacketId::DReyeVRKeyframe);
+  }
+  if (!bValid)
+  {
+    DReyeVR_LOG_WARN("Keyframe at %.3fs does not match the recording, replaying from the start instead",
+                     KeyframeFrame.Elapsed);
+    Frame = CurrentFrame;
+    File.clear();
+    File.seekg(Current, std::ios::beg);
+    return false;
+  }
+
+  ProcessKeyframe();
+
+  // compact packets of the keyframe's frame restart their deltas (see ACarlaRecorder::Write)
+  ResetCompactDecoders();
+
+  // continue from the start of the keyframe's frame without interpolating from the old positions
+  CurrentTime = Frame.Elapsed;
+  PrevPos.clear();
+  CurrPos.clear();
+  bResumeInFrame = true;
+  bSyncFrameIdValid = false;
+  return true;
+}
+
+// replays up to TimeStart right after opening the file, like Advance does for seeks
+void CarlaReplayer::ProcessToStartTime(double TimeStart)
+{
+  if (RestoreKeyframe(TimeStart))
+  {
+    ProcessToTime(TimeStart - CurrentTime, true);
+    return;
+  }
+  ProcessToTime(TimeStart, true);
+}
+
 void CarlaReplayer::ProcessEventsDel(void)
 {
   uint16_t i, Total;
@@ -771,6 +1082,57 @@ void CarlaReplayer::ProcessPositions(bool IsFirstTime)
   }
 }
 
+void CarlaReplayer::ProcessCompactPositions(bool bApply, bool IsFirstTime)
+{
+  const double StartTime = FPlatformTime::Seconds();
+  DReyeVRStringView Body;
+  if (!DReyeVRReadView(File, Header.Size, CompactScratch, Body))
+  {
+    return;
+  }
+  DReyeVRCompactReader Reader(Body.Data, Body.Length);
+  const bool bDecoded = PositionDecoder.Decode(Reader, CompactPositions);
+  CompactDecodeSeconds += FPlatformTime::Seconds() - StartTime;
+  CompactDecodedPackets++;
+  if (!bApply || !bDecoded)
+  {
+    return; // (an undecodable packet keeps the last positions until the next reset packet)
+  }
+
+  // same as ProcessPositions
+  PrevPos = std::move(CurrPos);
+  CurrPos.clear();
+  CurrPos.reserve(CompactPositions.size());
+  for (const DReyeVRCompactPosition &Compact : CompactPositions)
+  {
+    CarlaRecorderPosition Pos;
+    Pos.DatabaseId = Compact.DatabaseId;
+    Pos.Location = FVector(Compact.Location[0], Compact.Location[1], Compact.Location[2]);
+    Pos.Rotation = FVector(Compact.Rotation[0], Compact.Rotation[1], Compact.Rotation[2]);
+    auto NewId = MappedId.find(Pos.DatabaseId);
+    if (NewId != MappedId.end())
+    {
+      Pos.DatabaseId = NewId->second;
+    }
+    else
+      UE_LOG(LogCarla, Log, TEXT("Actor not found when trying to move from replayer (id. %d)"), Pos.DatabaseId);
+    CurrPos.push_back(std::move(Pos));
+  }
+
+  if (IsFirstTime)
+  {
+    PrevPos.clear();
+  }
+}
+
+void CarlaReplayer::ResetCompactDecoders()
+{
+  PositionDecoder.Reset();
+  DReyeVRDecoder.Reset();
+  CustomActorDecoder.Reset();
+  LastCustomActors.clear(); // (the records they point to are gone)
+}
+
 void CarlaReplayer::UpdatePositions(double Per, double DeltaTime)
 {
   unsigned int i;
@@ -865,19 +1227,51 @@ void CarlaReplayer::ProcessFrameByFrame()
     ensure(FrameStartTimes.size() > 0);
   }
 
-  // process to those times
+  // find the first frame at (or after) the current time, ex. when starting from TimeStart > 0 or after a rewind
+  if (!bSyncFrameIdValid)
+  {
+    const auto It = std::lower_bound(FrameStartTimes.begin(), FrameStartTimes.end(), CurrentTime);
+    SyncCurrentFrameId = std::min<size_t>(std::distance(FrameStartTimes.begin(), It), FrameStartTimes.size() - 1);
+    bSyncFrameIdValid = true;
+  }
+
+  // only the frames in the capture window get a screenshot, the replay ends with it
   ensure(SyncCurrentFrameId < FrameStartTimes.size());
-  double LastTime = 0.f;
-  if (SyncCurrentFrameId > 0)
-    LastTime = FrameStartTimes[SyncCurrentFrameId - 1];
-  ProcessToTime(FrameStartTimes[SyncCurrentFrameId] - LastTime, (SyncCurrentFrameId == 0));
-  if (GetEgoSensor()) // take screenshot of this frame
-    GetEgoSensor()->TakeScreenshot();
+  const double FrameTime = FrameStartTimes[SyncCurrentFrameId];
+  if (CaptureEndTime > 0.0 && FrameTime >= CaptureEndTime)
+  {
+    FinishFrameByFrame();
+    return;
+  }
+  const bool bCapture = (FrameTime >= CaptureStartTime);
+
+  // wait for the frame capture to have room for this frame (asynchronous readbacks, image encoder budget)
+  if (bCapture && GetEgoSensor() && !GetEgoSensor()->IsReadyForScreenshot())
+    return;
+
+  // process to those times
+  ProcessToTime(FrameTime - CurrentTime, (SyncCurrentFrameId == 0));
+  if (bCapture && GetEgoSensor()) // take screenshot of this frame
+    GetEgoSensor()->TakeScreenshot(static_cast<int64>(Frame.Id));
   // progress to the next frame
   if (SyncCurrentFrameId < FrameStartTimes.size() - 1)
     SyncCurrentFrameId++;
   else
-    Stop();
+    FinishFrameByFrame();
+}
+
+void CarlaReplayer::FinishFrameByFrame()
+{
+  Stop();
+  if (bQuitWhenDone)
+  {
+    // write out every capture (GPU readbacks, queued images, frame container indices) before quitting, rather than
+    // relying on the EgoSensor being destroyed during the engine's teardown
+    if (GetEgoSensor())
+      GetEgoSensor()->FinishScreenshots();
+    DReyeVR_LOG("Synchronous replay done, quitting");
+    FGenericPlatformMisc::RequestExit(false);
+  }
 }
 
 void CarlaReplayer::Restart() 
@@ -904,8 +1298,12 @@ void CarlaReplayer::Advance(const float Amnt)
   // forward in time (easy)
   else if (Amnt > 0) 
   {
-    /// TODO: verify that this correctly places all actors
-    // else can use the Restart+ProcessToTime hack similar to backwards
+    // jump to a later keyframe (if any) instead of reading every frame in between
+    if (RestoreKeyframe(DesiredTime, Frame.Elapsed + Frame.DurationThis))
+    {
+      ProcessToTime(DesiredTime - CurrentTime, true);
+      return;
+    }
     ProcessToTime(Amnt, false);
   }
   // backwards in time (harder)
@@ -924,6 +1322,15 @@ void CarlaReplayer::Advance(const float Amnt)
     // UE_LOG(LogTemp, Log, TEXT("Now the time is: %.3f"), Frame.Elapsed);
     // // back to negative
     // ProcessToTime(Amnt, false);
+
+    // restore the last keyframe before the desired time and replay only from there
+    if (RestoreKeyframe(DesiredTime))
+    {
+      ProcessToTime(DesiredTime - CurrentTime, true);
+      return;
+    }
+
+    // no keyframe (older recording, or desired time before the first one), replay from the start
     Stop(true); // stops the replaying while keeping actors (dosen't destroy & respawn)
     Restart();
     ProcessToTime(DesiredTime, true);
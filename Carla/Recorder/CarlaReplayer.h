@@ -23,6 +23,9 @@
 #include "CarlaRecorderState.h"
 #include "CarlaRecorderHelpers.h"
 #include "CarlaReplayerHelper.h"
+#include "DReyeVRRecorderCodec.h"
+#include "DReyeVRRecorderIndex.h"
+#include "DReyeVRRecorderReader.h"
 
 class UCarlaEpisode;
 
@@ -108,6 +111,27 @@ public:
   {
     bReplaySync = bSyncModeIn;
   }
+
+  // parse recordings from a memory mapping instead of the file stream
+  void SetMemoryMappedReads(bool bEnabled)
+  {
+    bMemoryMappedReads = bEnabled;
+  }
+
+  // synchronous replays only take screenshots of the frames in [Start, End) (recording time in s, End <= 0 for the
+  // end of the recording) and stop at End. The frames before Start are replayed without capture, as a warm-up for
+  // the actor state of segments (see Tools/ParallelCapture)
+  void SetCaptureWindow(double Start, double End)
+  {
+    CaptureStartTime = Start;
+    CaptureEndTime = End;
+  }
+
+  // quit the simulator once a synchronous replay is done (headless capture)
+  void SetQuitWhenDone(bool bQuit)
+  {
+    bQuitWhenDone = bQuit;
+  }
   
 private:
 
@@ -117,6 +141,8 @@ private:
   UCarlaEpisode *Episode = nullptr;
   // binary file reader
   std::ifstream File;
+  DReyeVRMappedRecording MappedFile; // (attached to File while replaying, if enabled)
+  bool bMemoryMappedReads = false;
   Header Header;
   CarlaRecorderInfo RecInfo;
   CarlaRecorderFrame Frame;
@@ -151,11 +177,12 @@ private:
   // processing packets
   void ProcessToTime(double Time, bool IsFirstTime = false);
 
-  void ProcessEventsAdd(void);
+  void ProcessEventsAdd(std::unordered_set<uint32_t> *RecordedIds = nullptr);
   void ProcessEventsDel(void);
   void ProcessEventsParent(void);
 
   void ProcessPositions(bool IsFirstTime = false);
+  void ProcessCompactPositions(bool bApply, bool IsFirstTime = false);
 
   void ProcessStates(void);
 
@@ -170,6 +197,9 @@ private:
   // DReyeVR recordings
   template <typename T>
   void ProcessDReyeVR(double Per, double DeltaTime);
+  void ProcessCompactDReyeVR(bool bApply, double Per);
+  void ProcessInternedCustomActors(bool bApply, double Per);
+  void DeactivateUnvisitedCustomActors();
   std::unordered_set<std::string> CustomActorsVisited = {};
   class ADReyeVRSensor *GetEgoSensor(); // (safe) getter for EgoSensor
   TWeakObjectPtr<class ADReyeVRSensor> EgoSensor;
@@ -187,8 +217,33 @@ private:
   bool bReplaySync = false;
   std::vector<double> FrameStartTimes;
   size_t SyncCurrentFrameId = 0;
+  bool bSyncFrameIdValid = false; // whether SyncCurrentFrameId matches CurrentTime (reset on every new replay)
+  DReyeVRFrameIndex FrameIndex;   // frame offset index of the current file (empty for older recordings)
+  double CaptureStartTime = 0.0;
+  double CaptureEndTime = 0.0;
+  bool bQuitWhenDone = false;
   void GetFrameStartTimes();
   void ProcessFrameByFrame();
+  void FinishFrameByFrame();
+  void LoadFrameIndex();
+
+  // keyframes (seeking without replaying from the start)
+  bool bResumeInFrame = false; // positioned right after a keyframe, in the middle of its frame
+  bool RestoreKeyframe(double Time, double MinFrameTime = -1.0);
+  void ProcessKeyframe();
+  void ProcessToStartTime(double TimeStart); // from the last keyframe before TimeStart (if any), else from the start
+
+  // compact (delta encoded) packets, decoded in order even when skipped (see DReyeVRRecorderCodec.h)
+  DReyeVRPositionDecoder PositionDecoder;
+  DReyeVRFieldDecoder DReyeVRDecoder;
+  DReyeVR::CustomActorDecoder CustomActorDecoder;
+  std::vector<DReyeVRCompactPosition> CompactPositions;
+  std::vector<DReyeVR::CustomActorDecoder::Record> CustomActorRecords;
+  std::vector<const DReyeVR::CustomActorData *> LastCustomActors; // replayed last frame (to skip deactivation)
+  std::string CompactScratch;
+  double CompactDecodeSeconds = 0.0;
+  uint64_t CompactDecodedPackets = 0;
+  void ResetCompactDecoders();
 
   // positions
   void UpdatePositions(double Per, double DeltaTime);
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm> // std::max
+#include <cstdint>   // int64_t, uint32_t
+#include <vector>    // std::vector
+
+// Per-actor gaze dwell statistics, accumulated every tick in the EgoSensor (see [EgoSensor] DwellMaxActors)
+//
+// Actors are keyed by their Carla actor id (0 is "not a Carla actor": scenery, sky) in an open addressing hash
+// table of fixed capacity, so every tick is O(1) and the memory is bounded. Once MaxActors actors are tracked, the
+// time on new actors is only counted in GetDroppedDwell. UE-free (also tested in Tools/Recordings, whose reader
+// mirrors DReyeVRDwellStats for the summary recorded in packet 150)
+
+struct DReyeVRDwellStats
+{
+    uint32_t ActorId = 0;       // Carla actor id
+    uint32_t NumGlances = 0;    // separate visits of the gaze to this actor
+    uint32_t NumFixations = 0;  // fixations that were confirmed on it
+    int64_t TotalDwell = 0;     // ms of gaze on it
+    int64_t FirstGlance = -1;   // timestamp (ms) of its first glance
+    int64_t FirstFixation = -1; // timestamp (ms) its first fixation started (-1 if none)
+    int64_t LastGlance = -1;    // timestamp (ms) of the start of its latest glance
+    int64_t LongestGlance = 0;  // ms
+};
+
+class DReyeVRDwellAccumulator
+{
+  public:
+    explicit DReyeVRDwellAccumulator(uint32_t MaxActors = 1024)
+    {
+        SetMaxActors(MaxActors);
+    }
+
+    // (clears the statistics)
+    void SetMaxActors(uint32_t InMaxActors)
+    {
+        MaxActors = std::max<uint32_t>(InMaxActors, 1);
+        SlotBits = 1; // load factor <= 1/2
+        while ((size_t(1) << SlotBits) < 2 * size_t(MaxActors))
+            SlotBits++;
+        Slots.assign(size_t(1) << SlotBits, uint32_t(Empty)); // (copies, Empty is not odr-used)
+        Entries.clear();
+        Entries.reserve(MaxActors);
+        Reset();
+    }
+
+    uint32_t GetMaxActors() const
+    {
+        return MaxActors;
+    }
+
+    void Reset()
+    {
+        std::fill(Slots.begin(), Slots.end(), uint32_t(Empty));
+        Entries.clear();
+        bHasPrev = false;
+        PrevTimestamp = 0;
+        CurrentActor = 0;
+        GlanceStart = 0;
+        UntrackedDwell = 0;
+        DroppedDwell = 0;
+        NumDroppedActors = 0;
+        NumChanged = 0;
+    }
+
+    // the gaze is on ActorId (0 for none) from Timestamp (ms) on: the time since the previous call goes to the actor
+    // the gaze was on until now, and a new glance starts when the actor changed
+    void Add(int64_t Timestamp, uint32_t ActorId)
+    {
+        NumChanged = 0;
+        if (bHasPrev)
+        {
+            const int64_t Delta = std::max<int64_t>(Timestamp - PrevTimestamp, 0);
+            if (CurrentActor == 0)
+                UntrackedDwell += Delta;
+            else if (DReyeVRDwellStats *Stats = FindMutable(CurrentActor))
+            {
+                Stats->TotalDwell += Delta;
+                Stats->LongestGlance = std::max(Stats->LongestGlance, Timestamp - GlanceStart);
+                MarkChanged(CurrentActor);
+            }
+            else
+                DroppedDwell += Delta;
+        }
+        if (!bHasPrev || ActorId != CurrentActor)
+        {
+            GlanceStart = Timestamp;
+            if (ActorId != 0)
+            {
+                if (DReyeVRDwellStats *Stats = FindOrAdd(ActorId))
+                {
+                    Stats->NumGlances++;
+                    if (Stats->FirstGlance < 0)
+                        Stats->FirstGlance = Timestamp;
+                    Stats->LastGlance = Timestamp;
+                    MarkChanged(ActorId);
+                }
+            }
+        }
+        bHasPrev = true;
+        PrevTimestamp = Timestamp;
+        CurrentActor = ActorId;
+    }
+
+    // a fixation that started at Timestamp (ms) was confirmed on ActorId
+    void AddFixation(int64_t Timestamp, uint32_t ActorId)
+    {
+        if (ActorId == 0)
+            return;
+        if (DReyeVRDwellStats *Stats = FindOrAdd(ActorId))
+        {
+            Stats->NumFixations++;
+            if (Stats->FirstFixation < 0)
+                Stats->FirstFixation = Timestamp;
+            MarkChanged(ActorId);
+        }
+    }
+
+    const DReyeVRDwellStats *Find(uint32_t ActorId) const
+    {
+        const uint32_t Index = Slots[FindSlot(ActorId)];
+        return Index == Empty ? nullptr : &Entries[Index];
+    }
+
+    // the actor the gaze is on (0 for none)
+    uint32_t GetCurrentActor() const
+    {
+        return CurrentActor;
+    }
+
+    // every tracked actor, in the order they were first seen
+    const std::vector<DReyeVRDwellStats> &GetAll() const
+    {
+        return Entries;
+    }
+
+    // the actors whose statistics changed in the latest Add and the AddFixation calls after it (at most 3)
+    template <typename Fn> void ForEachChanged(Fn &&Callback) const
+    {
+        for (uint32_t i = 0; i < NumChanged; i++)
+            Callback(Entries[Changed[i]]);
+    }
+
+    int64_t GetUntrackedDwell() const // ms of gaze on no Carla actor
+    {
+        return UntrackedDwell;
+    }
+
+    int64_t GetDroppedDwell() const // ms of gaze on actors that did not fit in the table
+    {
+        return DroppedDwell;
+    }
+
+    uint64_t GetNumDroppedActors() const // glances on actors that did not fit in the table
+    {
+        return NumDroppedActors;
+    }
+
+  private:
+    static constexpr uint32_t Empty = UINT32_MAX;
+
+    size_t FindSlot(uint32_t ActorId) const
+    {
+        // Fibonacci hashing (Carla ids are sequential), linear probing
+        const size_t Mask = Slots.size() - 1;
+        size_t Slot = static_cast<size_t>((uint64_t(ActorId) * 11400714819323198485ull) >> (64 - SlotBits));
+        while (Slots[Slot] != Empty && Entries[Slots[Slot]].ActorId != ActorId)
+            Slot = (Slot + 1) & Mask;
+        return Slot;
+    }
+
+    DReyeVRDwellStats *FindMutable(uint32_t ActorId)
+    {
+        const uint32_t Index = Slots[FindSlot(ActorId)];
+        return Index == Empty ? nullptr : &Entries[Index];
+    }
+
+    DReyeVRDwellStats *FindOrAdd(uint32_t ActorId)
+    {
+        const size_t Slot = FindSlot(ActorId);
+        if (Slots[Slot] != Empty)
+            return &Entries[Slots[Slot]];
+        if (Entries.size() >= MaxActors)
+        {
+            NumDroppedActors++;
+            return nullptr;
+        }
+        Slots[Slot] = static_cast<uint32_t>(Entries.size());
+        Entries.emplace_back();
+        Entries.back().ActorId = ActorId;
+        return &Entries.back();
+    }
+
+    void MarkChanged(uint32_t ActorId)
+    {
+        const uint32_t Index = Slots[FindSlot(ActorId)];
+        for (uint32_t i = 0; i < NumChanged; i++)
+            if (Changed[i] == Index)
+                return;
+        if (NumChanged < 3)
+            Changed[NumChanged++] = Index;
+    }
+
+    uint32_t MaxActors = 0;
+    uint32_t SlotBits = 1;
+    std::vector<uint32_t> Slots; // index into Entries (or Empty)
+    std::vector<DReyeVRDwellStats> Entries;
+    bool bHasPrev = false;
+    int64_t PrevTimestamp = 0;
+    uint32_t CurrentActor = 0;
+    int64_t GlanceStart = 0;
+    int64_t UntrackedDwell = 0;
+    int64_t DroppedDwell = 0;
+    uint64_t NumDroppedActors = 0;
+    uint32_t Changed[3] = {};
+    uint32_t NumChanged = 0;
+};
@@ -0,0 +1,272 @@
+#include "DReyeVRFrameContainer.h"
+
+#include <algorithm> // std::max
+#include <cstring>   // std::memcpy, std::memcmp
+
+/// ========================================== ///
+/// --------:DReyeVRFrameContainerWriter:----- ///
+/// ========================================== ///
+
+DReyeVRFrameContainerWriter::~DReyeVRFrameContainerWriter()
+{
+    Close();
+}
+
+void DReyeVRFrameContainerWriter::Start(size_t NumBuffers, ECodec NewCodec, FCompressor NewCompressor)
+{
+    if (IsOpen())
+        Close();
+
+    Codec = (NewCodec == CODEC_ZLIB && !NewCompressor) ? CODEC_RAW : NewCodec;
+    Compressor = std::move(NewCompressor);
+    Streams.clear();
+    Pending.clear();
+    Free.clear();
+    Free.resize(std::max<size_t>(NumBuffers, 1));
+    Stats = DReyeVRFrameContainerStats{};
+    bExit = false;
+    WriterThread = std::thread(&DReyeVRFrameContainerWriter::WriterLoop, this);
+}
+
+int DReyeVRFrameContainerWriter::AddStream(const std::string &Filename, uint32_t Width, uint32_t Height,
+                                           int32_t Shader, int32_t Pose)
+{
+    std::unique_ptr<FStream> Stream(new FStream);
+    Stream->File.open(Filename, std::ios::binary | std::ios::trunc);
+    if (!Stream->File.is_open())
+        return -1;
+    Stream->Header.Width = Width;
+    Stream->Header.Height = Height;
+    Stream->Header.Codec = Codec;
+    Stream->Header.Shader = Shader;
+    Stream->Header.Pose = Pose;
+    // (the writer thread only sees the stream once a frame for it is queued, after this)
+    Stream->File.write(reinterpret_cast<const char *>(&Stream->Header), sizeof(Stream->Header));
+    Stream->File.flush();
+    if (!Stream->File.good())
+        return -1;
+    Stream->Offset = sizeof(Stream->Header);
+
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Streams.push_back(std::move(Stream));
+    return static_cast<int>(Streams.size()) - 1;
+}
+
+bool DReyeVRFrameContainerWriter::Add(int Stream, uint64_t Frame, int64_t Timestamp, const void *Pixels, size_t Size)
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    if (!IsOpen() || Stream < 0 || Stream >= static_cast<int>(Streams.size()))
+        return false;
+    const DReyeVRFrameContainerHeader &Header = Streams[Stream]->Header;
+    if (Size != static_cast<size_t>(Header.Width) * Header.Height * 4)
+        return false;
+    if (Free.empty())
+    {
+        // writer is behind by every frame buffer, wait rather than grow memory without bound
+        Stats.FramesStalled++;
+        const auto StallStart = std::chrono::steady_clock::now();
+        FreeCV.wait(Lock, [this] { return !Free.empty(); });
+        Stats.StallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - StallStart).count();
+    }
+    FFrame Buffer = std::move(Free.front());
+    Free.pop_front();
+    Lock.unlock();
+
+    // outside the lock, the writer thread never touches a buffer that is not pending
+    Buffer.Stream = Stream;
+    Buffer.Frame = Frame;
+    Buffer.Timestamp = Timestamp;
+    Buffer.Pixels.resize(Size);
+    std::memcpy(Buffer.Pixels.data(), Pixels, Size);
+
+    Lock.lock();
+    Pending.push_back(std::move(Buffer));
+    Stats.FramesQueued++;
+    Stats.MaxQueueDepth = std::max(Stats.MaxQueueDepth, Pending.size());
+    Lock.unlock();
+    QueueCV.notify_one();
+    return true;
+}
+
+void DReyeVRFrameContainerWriter::Close()
+{
+    if (!IsOpen())
+        return;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bExit = true;
+    }
+    QueueCV.notify_all();
+    WriterThread.join();
+
+    // the index is what makes a container seekable without walking its chunks
+    for (std::unique_ptr<FStream> &Stream : Streams)
+    {
+        DReyeVRFrameIndexFooter Footer;
+        Footer.IndexOffset = Stream->Offset;
+        Footer.NumFrames = Stream->Index.size();
+        if (!Stream->Index.empty())
+            Stream->File.write(reinterpret_cast<const char *>(Stream->Index.data()),
+                               static_cast<std::streamsize>(Stream->Index.size() * sizeof(DReyeVRFrameIndexEntry)));
+        Stream->File.write(reinterpret_cast<const char *>(&Footer), sizeof(Footer));
+        Stream->File.close();
+    }
+    Streams.clear();
+    Free.clear(); // (releases the frame buffers)
+}
+
+DReyeVRFrameContainerStats DReyeVRFrameContainerWriter::GetStats() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Stats;
+}
+
+bool DReyeVRFrameContainerWriter::Write(FFrame &Frame, std::vector<uint8_t> &Compressed)
+{
+    FStream *Stream = nullptr;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Stream = Streams[Frame.Stream].get(); // (stable, AddStream only appends)
+    }
+    const std::vector<uint8_t> *Out = &Frame.Pixels;
+    if (Codec == CODEC_ZLIB)
+    {
+        Compressed.clear();
+        if (!Compressor(Frame.Pixels, Compressed))
+            return false;
+        Out = &Compressed;
+    }
+
+    DReyeVRFrameChunk Chunk;
+    Chunk.Size = static_cast<uint32_t>(Out->size());
+    Chunk.Frame = Frame.Frame;
+    Chunk.Timestamp = Frame.Timestamp;
+    Stream->File.write(reinterpret_cast<const char *>(&Chunk), sizeof(Chunk));
+    Stream->File.write(reinterpret_cast<const char *>(Out->data()), static_cast<std::streamsize>(Out->size()));
+    if (!Stream->File.good())
+    {
+        // rewind over the partial chunk so the rest of the container stays readable
+        Stream->File.clear();
+        Stream->File.seekp(static_cast<std::streamoff>(Stream->Offset));
+        return false;
+    }
+
+    DReyeVRFrameIndexEntry Entry;
+    Entry.Frame = Chunk.Frame;
+    Entry.Timestamp = Chunk.Timestamp;
+    Entry.Offset = Stream->Offset;
+    Entry.Size = Chunk.Size;
+    Stream->Index.push_back(Entry);
+    Stream->Offset += sizeof(Chunk) + Out->size();
+    return true;
+}
+
+void DReyeVRFrameContainerWriter::WriterLoop()
+{
+    std::vector<uint8_t> Compressed; // (reused across frames)
+    std::unique_lock<std::mutex> Lock(Mutex);
+    while (true)
+    {
+        QueueCV.wait(Lock, [this] { return bExit || !Pending.empty(); });
+        if (Pending.empty()) // only exit once the queue is drained
+            break;
+        FFrame Frame = std::move(Pending.front());
+        Pending.pop_front();
+        Lock.unlock();
+
+        const bool bWritten = Write(Frame, Compressed);
+        const size_t BytesOut = (Codec == CODEC_ZLIB) ? Compressed.size() : Frame.Pixels.size();
+
+        Lock.lock();
+        if (bWritten)
+        {
+            Stats.FramesWritten++;
+            Stats.BytesIn += Frame.Pixels.size();
+            Stats.BytesWritten += sizeof(DReyeVRFrameChunk) + BytesOut;
+        }
+        else
+        {
+            Stats.FramesDropped++;
+        }
+        Free.push_back(std::move(Frame)); // keeps the pixel capacity for the next frame
+        FreeCV.notify_one();
+    }
+}
+
+/// ========================================== ///
+/// --------:DReyeVRFrameContainerReader:----- ///
+/// ========================================== ///
+
+bool DReyeVRFrameContainerReader::Open(const std::string &Filename)
+{
+    File.close();
+    File.clear();
+    Index.clear();
+    bIndexed = false;
+    File.open(Filename, std::ios::binary);
+    if (!File.is_open())
+        return false;
+
+    const DReyeVRFrameContainerHeader Expected;
+    File.read(reinterpret_cast<char *>(&Header), sizeof(Header));
+    if (!File.good() || std::memcmp(Header.Magic, Expected.Magic, sizeof(Header.Magic)) != 0 ||
+        Header.Version != Expected.Version || Header.HeaderSize < sizeof(Header))
+        return false;
+    File.seekg(0, std::ios::end);
+    const uint64_t FileSize = static_cast<uint64_t>(File.tellg());
+
+    // closed containers end in the index
+    const DReyeVRFrameIndexFooter ExpectedFooter;
+    DReyeVRFrameIndexFooter Footer;
+    if (FileSize >= Header.HeaderSize + sizeof(Footer))
+    {
+        File.seekg(static_cast<std::streamoff>(FileSize - sizeof(Footer)));
+        File.read(reinterpret_cast<char *>(&Footer), sizeof(Footer));
+        if (File.good() && std::memcmp(Footer.Magic, ExpectedFooter.Magic, sizeof(Footer.Magic)) == 0 &&
+            Footer.IndexOffset + Footer.NumFrames * sizeof(DReyeVRFrameIndexEntry) + sizeof(Footer) == FileSize)
+        {
+            Index.resize(static_cast<size_t>(Footer.NumFrames));
+            File.seekg(static_cast<std::streamoff>(Footer.IndexOffset));
+            File.read(reinterpret_cast<char *>(Index.data()),
+                      static_cast<std::streamsize>(Index.size() * sizeof(DReyeVRFrameIndexEntry)));
+            bIndexed = File.good();
+            if (bIndexed)
+                return true;
+            Index.clear();
+        }
+    }
+
+    // otherwise every complete chunk (the last one may be cut off)
+    const DReyeVRFrameChunk ExpectedChunk;
+    uint64_t Offset = Header.HeaderSize;
+    while (Offset + sizeof(DReyeVRFrameChunk) <= FileSize)
+    {
+        DReyeVRFrameChunk Chunk;
+        File.clear();
+        File.seekg(static_cast<std::streamoff>(Offset));
+        File.read(reinterpret_cast<char *>(&Chunk), sizeof(Chunk));
+        if (!File.good() || std::memcmp(Chunk.Magic, ExpectedChunk.Magic, sizeof(Chunk.Magic)) != 0 ||
+            Offset + sizeof(Chunk) + Chunk.Size > FileSize)
+            break;
+        DReyeVRFrameIndexEntry Entry;
+        Entry.Frame = Chunk.Frame;
+        Entry.Timestamp = Chunk.Timestamp;
+        Entry.Offset = Offset;
+        Entry.Size = Chunk.Size;
+        Index.push_back(Entry);
+        Offset += sizeof(Chunk) + Chunk.Size;
+    }
+    File.clear();
+    return true;
+}
+
+bool DReyeVRFrameContainerReader::Read(size_t i, std::vector<uint8_t> &Out)
+{
+    if (i >= Index.size())
+        return false;
+    Out.resize(Index[i].Size);
+    File.clear();
+    File.seekg(static_cast<std::streamoff>(Index[i].Offset + sizeof(DReyeVRFrameChunk)));
+    File.read(reinterpret_cast<char *>(Out.data()), static_cast<std::streamsize>(Out.size()));
+    return File.good();
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <chrono>             // stall timing
+#include <condition_variable> // std::condition_variable
+#include <cstdint>            // uint32_t, uint64_t
+#include <deque>              // std::deque
+#include <fstream>            // std::ofstream, std::ifstream
+#include <functional>         // std::function
+#include <memory>             // std::unique_ptr
+#include <mutex>              // std::mutex
+#include <string>             // std::string
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+// Replay frame capture into one container file per shader and pose (see [Replayer] FrameOutput in
+// DReyeVRConfig.ini) instead of one image per capture
+//
+// Layout (little-endian): a 64-byte DReyeVRFrameContainerHeader, then one chunk per frame (a 24-byte
+// DReyeVRFrameChunk followed by the frame's bytes: Width*Height BGRA8 pixels, or those compressed by the codec), then
+// when the container is closed the index of every chunk (DReyeVRFrameIndexEntry) and a DReyeVRFrameIndexFooter.
+// Containers that were not closed (ex. a crash) are read by walking the chunks. Raw frames stay 8-byte aligned
+// (for an even number of pixels), so they can be memory-mapped (Tools/Recordings/python/dreyevr_frames.py)
+//
+// Frames are written (and compressed) by one writer thread for every container, through a bounded pool of frame
+// buffers: the game thread only copies the pixels, and waits when the writer is behind by every buffer. UE-free
+// (tested in Tools/Recordings)
+
+#ifndef CARLA_API
+#define CARLA_API // (exported from the Carla module for the EgoSensor, nothing to export without Unreal)
+#endif
+
+#pragma pack(push, 1)
+struct DReyeVRFrameContainerHeader
+{
+    char Magic[4] = {'D', 'R', 'V', 'F'};
+    uint16_t Version = 1;
+    uint16_t HeaderSize = 64;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t PixelFormat = 1; // 1: BGRA8
+    uint32_t Codec = 0;       // DReyeVRFrameContainerWriter::ECodec
+    int32_t Shader = 0;       // [Replayer] RecordAllShaders index
+    int32_t Pose = 0;         // camera pose index
+    uint8_t Reserved[32] = {};
+};
+
+struct DReyeVRFrameChunk
+{
+    char Magic[4] = {'F', 'R', 'A', 'M'};
+    uint32_t Size = 0;     // bytes that follow
+    uint64_t Frame = 0;    // id of the replayed recording frame (as in show_recorder_file_info)
+    int64_t Timestamp = 0; // TimestampCarla of the replayed frame (ms)
+};
+
+struct DReyeVRFrameIndexEntry
+{
+    uint64_t Frame = 0;
+    int64_t Timestamp = 0;
+    uint64_t Offset = 0; // of the frame's DReyeVRFrameChunk
+    uint32_t Size = 0;
+    uint32_t Reserved = 0;
+};
+
+struct DReyeVRFrameIndexFooter
+{
+    uint64_t IndexOffset = 0;
+    uint64_t NumFrames = 0;
+    char Magic[8] = {'D', 'R', 'V', 'F', 'I', 'D', 'X', '1'};
+};
+#pragma pack(pop)
+
+static_assert(sizeof(DReyeVRFrameContainerHeader) == 64, "DReyeVRFrameContainerHeader layout");
+static_assert(sizeof(DReyeVRFrameChunk) == 24, "DReyeVRFrameChunk layout");
+static_assert(sizeof(DReyeVRFrameIndexEntry) == 32, "DReyeVRFrameIndexEntry layout");
+static_assert(sizeof(DReyeVRFrameIndexFooter) == 24, "DReyeVRFrameIndexFooter layout");
+
+struct DReyeVRFrameContainerStats
+{
+    uint64_t FramesQueued = 0;  // frames handed off to the writer thread
+    uint64_t FramesWritten = 0; // frames that reached the disk
+    uint64_t FramesDropped = 0; // frames lost to a failed compression or disk write
+    uint64_t FramesStalled = 0; // frames where the game thread had to wait for a free buffer
+    double StallSeconds = 0.0;  // total time the game thread spent waiting
+    size_t MaxQueueDepth = 0;   // maximum number of frames waiting to be written
+    uint64_t BytesIn = 0;       // pixel bytes of the written frames
+    uint64_t BytesWritten = 0;  // (after compression)
+};
+
+class CARLA_API DReyeVRFrameContainerWriter
+{
+  public:
+    enum ECodec : uint32_t
+    {
+        CODEC_RAW = 0,
+        CODEC_ZLIB = 1, // (the zlib stream, compressed by the Compressor)
+    };
+    // compresses In into Out (false on failure), called from the writer thread
+    using FCompressor = std::function<bool(const std::vector<uint8_t> &In, std::vector<uint8_t> &Out)>;
+
+    DReyeVRFrameContainerWriter() = default;
+    ~DReyeVRFrameContainerWriter();
+    DReyeVRFrameContainerWriter(const DReyeVRFrameContainerWriter &) = delete;
+    DReyeVRFrameContainerWriter &operator=(const DReyeVRFrameContainerWriter &) = delete;
+
+    // starts the writer thread, at most NumBuffers frames are queued (Compressor is required for CODEC_ZLIB)
+    void Start(size_t NumBuffers, ECodec Codec = CODEC_RAW, FCompressor Compressor = nullptr);
+
+    // creates a container (overwriting Filename), -1 if it cannot be opened
+    int AddStream(const std::string &Filename, uint32_t Width, uint32_t Height, int32_t Shader, int32_t Pose);
+
+    // copies Size bytes of BGRA8 pixels to be written to the stream (blocks if every buffer is in use)
+    bool Add(int Stream, uint64_t Frame, int64_t Timestamp, const void *Pixels, size_t Size);
+
+    // writes every queued frame and the indices, joins the writer thread
+    void Close();
+
+    bool IsOpen() const
+    {
+        return WriterThread.joinable();
+    }
+
+    DReyeVRFrameContainerStats GetStats() const;
+
+  private:
+    struct FStream
+    {
+        std::ofstream File; // writer thread only (after AddStream)
+        DReyeVRFrameContainerHeader Header;
+        uint64_t Offset = 0;
+        std::vector<DReyeVRFrameIndexEntry> Index;
+    };
+    struct FFrame
+    {
+        int Stream = -1;
+        uint64_t Frame = 0;
+        int64_t Timestamp = 0;
+        std::vector<uint8_t> Pixels;
+    };
+
+    void WriterLoop();
+    bool Write(FFrame &Frame, std::vector<uint8_t> &Compressed);
+
+    ECodec Codec = CODEC_RAW;
+    FCompressor Compressor;
+    std::vector<std::unique_ptr<FStream>> Streams;
+    std::thread WriterThread;
+
+    mutable std::mutex Mutex;
+    std::condition_variable QueueCV; // signals the writer thread that there is work (or to exit)
+    std::condition_variable FreeCV;  // signals the game thread that a frame buffer was released
+    std::deque<FFrame> Pending;
+    std::deque<FFrame> Free;
+    bool bExit = false;
+    DReyeVRFrameContainerStats Stats;
+};
+
+// reads the chunks of a container (the frames are decompressed by the caller, see Header.Codec)
+class CARLA_API DReyeVRFrameContainerReader
+{
+  public:
+    bool Open(const std::string &Filename);
+
+    const DReyeVRFrameContainerHeader &GetHeader() const
+    {
+        return Header;
+    }
+
+    // every frame in file order (from the index, or from the chunks if the container was not closed)
+    const std::vector<DReyeVRFrameIndexEntry> &GetIndex() const
+    {
+        return Index;
+    }
+
+    bool IsIndexed() const
+    {
+        return bIndexed;
+    }
+
+    // the frame's bytes as stored
+    bool Read(size_t i, std::vector<uint8_t> &Out);
+
+  private:
+    std::ifstream File;
+    DReyeVRFrameContainerHeader Header;
+    std::vector<DReyeVRFrameIndexEntry> Index;
+    bool bIndexed = false;
+};
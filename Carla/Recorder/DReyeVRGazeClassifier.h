@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>     // std::min, std::max
+#include <cctype>        // std::tolower
+#include <cmath>         // std::atan2, std::sqrt
+#include <cstdint>       // int64_t
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+// Online fixation/saccade classification of eye-tracker readings (see [EgoSensor] Fixation* in DReyeVRConfig.ini)
+//
+// Readings are added one at a time, in order, and fixation start/end events come out as soon as they are known:
+// - I-VT (velocity threshold): a reading belongs to a fixation when the angular velocity from the previous one is
+//   below VelocityThreshold;
+// - I-DT (dispersion threshold): a fixation lasts while its readings stay within DispersionThreshold (the yaw range
+//   plus the pitch range of the gaze).
+// Either way, only fixations of at least MinDuration are reported, and a gap in the valid readings (ex. a blink)
+// longer than MaxGap ends the fixation. Every reading is O(1): until a fixation is confirmed its readings wait in a
+// ring buffer whose yaw/pitch ranges are kept by monotonic queues, and a confirmed fixation only keeps running sums
+// and ranges. UE-free, the same code classifies the readings in the EgoSensor and in recordings (Tools/Recordings)
+
+struct DReyeVRGazeClassifierParams
+{
+    enum class EMethod : uint8_t
+    {
+        Velocity,   // I-VT
+        Dispersion, // I-DT
+    };
+    EMethod Method = EMethod::Velocity;
+    float VelocityThreshold = 30.f;  // deg/s (I-VT)
+    float DispersionThreshold = 1.f; // deg, yaw range + pitch range (I-DT)
+    float MinDuration = 100.f;       // ms
+    float MaxGap = 75.f;             // ms without valid readings that still continue a fixation
+    uint32_t WindowSize = 256;       // readings waiting for a fixation (at least MinDuration worth of readings)
+
+    // "ivt"/"velocity" or "idt"/"dispersion" (false if unknown)
+    static bool ParseMethod(const std::string &In, EMethod &Out)
+    {
+        std::string Name;
+        for (char C : In)
+            Name += static_cast<char>(std::tolower(static_cast<unsigned char>(C)));
+        if (Name == "ivt" || Name == "i-vt" || Name == "velocity")
+            Out = EMethod::Velocity;
+        else if (Name == "idt" || Name == "i-dt" || Name == "dispersion")
+            Out = EMethod::Dispersion;
+        else
+            return false;
+        return true;
+    }
+};
+
+struct DReyeVRFixationEvent
+{
+    bool bStart = false; // a fixation started (else it ended)
+    int64_t Start = 0;   // timestamp (ms) of its first reading
+    int64_t End = 0;     // timestamp of its last reading (so far, for starts)
+    float Yaw = 0.f;     // mean gaze direction (degrees, in the frame of the gaze directions)
+    float Pitch = 0.f;
+    std::string Actor; // focused actor of the majority of its readings (if any, else of the most recent ones)
+
+    int64_t GetDuration() const
+    {
+        return End - Start;
+    }
+};
+
+class DReyeVRGazeClassifier
+{
+  public:
+    using Params = DReyeVRGazeClassifierParams;
+
+    explicit DReyeVRGazeClassifier(const Params &P = Params())
+    {
+        SetParams(P);
+    }
+
+    // (resets the classification)
+    void SetParams(const Params &P)
+    {
+        Config = P;
+        Config.WindowSize = std::max<uint32_t>(Config.WindowSize, 2);
+        Window.assign(Config.WindowSize, Reading());
+        for (MonotonicQueue *Q : {&MinYaw, &MaxYaw, &MinPitch, &MaxPitch})
+            Q->Ids.assign(Config.WindowSize, 0);
+        Reset();
+    }
+
+    const Params &GetParams() const
+    {
+        return Config;
+    }
+
+    void Reset()
+    {
+        ClearWindow();
+        bFixating = false;
+        bHasPrev = false;
+        bPrevFixation = false;
+        Fix = Fixation();
+        Last = DReyeVRFixationEvent();
+    }
+
+    // one reading (timestamps in ms, never decreasing), Dir does not need to be normalized. Appends the events it
+    // caused to Out and returns how many
+    size_t Add(int64_t Timestamp, float DirX, float DirY, float DirZ, bool bValid, const std::string &Actor,
+               std::vector<DReyeVRFixationEvent> &Out)
+    {
+        const size_t NumBefore = Out.size();
+        const double Length = std::sqrt(double(DirX) * DirX + double(DirY) * DirY + double(DirZ) * DirZ);
+        const bool bGap = bHasPrev && Timestamp - PrevTimestamp > Config.MaxGap;
+        if (bGap) // (also while the eyes are closed, so the fixation ends on time)
+        {
+            EndFixation(Out);
+            ClearWindow();
+            bHasPrev = false;
+        }
+        if (!bValid || !(Length > 1e-6))
+            return Out.size() - NumBefore;
+
+        Reading R;
+        R.Timestamp = Timestamp;
+        const double X = DirX / Length, Y = DirY / Length, Z = DirZ / Length;
+        R.Yaw = static_cast<float>(std::atan2(Y, X) * RadToDeg);
+        R.Pitch = static_cast<float>(std::atan2(Z, std::sqrt(X * X + Y * Y)) * RadToDeg);
+        R.Actor = Intern(Actor);
+
+        if (Config.Method == Params::EMethod::Velocity)
+        {
+            bool bFixationReading = true; // (the first reading after a gap starts a candidate)
+            if (bHasPrev)
+            {
+                const int64_t Dt = Timestamp - PrevTimestamp;
+                if (Dt > 0)
+                {
+                    const double CrossX = PrevY * Z - PrevZ * Y, CrossY = PrevZ * X - PrevX * Z,
+                                 CrossZ = PrevX * Y - PrevY * X;
+                    const double Cross = std::sqrt(CrossX * CrossX + CrossY * CrossY + CrossZ * CrossZ);
+                    const double Angle = std::atan2(Cross, PrevX * X + PrevY * Y + PrevZ * Z) * RadToDeg;
+                    bFixationReading = Angle * 1000.0 / Dt < Config.VelocityThreshold;
+                }
+                else
+                {
+                    bFixationReading = bPrevFixation; // (same timestamp, no velocity)
+                }
+            }
+            bPrevFixation = bFixationReading;
+            if (!bFixationReading)
+            {
+                EndFixation(Out);
+                ClearWindow();
+            }
+            else if (bFixating)
+            {
+                Extend(R);
+            }
+            else
+            {
+                Push(R);
+                TryStartFixation(Out);
+            }
+        }
+        else // Dispersion
+        {
+            if (bFixating)
+            {
+                const float Range = (std::max(Fix.MaxYaw, R.Yaw) - std::min(Fix.MinYaw, R.Yaw)) +
+                                    (std::max(Fix.MaxPitch, R.Pitch) - std::min(Fix.MinPitch, R.Pitch));
+                if (Range > Config.DispersionThreshold)
+                {
+                    EndFixation(Out);
+                    Push(R); // (the first reading of the next candidate)
+                    TryStartFixation(Out);
+                }
+                else
+                {
+                    Extend(R);
+                }
+            }
+            else
+            {
+                Push(R);
+                while (GetWindowRange() > Config.DispersionThreshold) // (a single reading has no range)
+                    PopFront();
+                TryStartFixation(Out);
+            }
+        }
+
+        bHasPrev = true;
+        PrevTimestamp = Timestamp;
+        PrevX = X;
+        PrevY = Y;
+        PrevZ = Z;
+        return Out.size() - NumBefore;
+    }
+
+    // ends the ongoing fixation (ex. at the end of a recording), returns the number of events appended to Out
+    size_t Flush(std::vector<DReyeVRFixationEvent> &Out)
+    {
+        const size_t NumBefore = Out.size();
+        EndFixation(Out);
+        ClearWindow();
+        bHasPrev = false;
+        return Out.size() - NumBefore;
+    }
+
+    bool IsFixating() const
+    {
+        return bFixating;
+    }
+
+    // the ongoing fixation (bStart) or else the last one that ended
+    DReyeVRFixationEvent GetFixation() const
+    {
+        return bFixating ? MakeEvent(true) : Last;
+    }
+
+  private:
+    static constexpr double RadToDeg = 57.29577951308232;
+
+    struct Reading
+    {
+        int64_t Timestamp = 0;
+        float Yaw = 0.f;
+        float Pitch = 0.f;
+        uint32_t Actor = 0;
+    };
+
+    struct Fixation
+    {
+        int64_t Start = 0;
+        int64_t End = 0;
+        double SumYaw = 0.0;
+        double SumPitch = 0.0;
+        uint64_t Count = 0;
+        float MinYaw = 0.f, MaxYaw = 0.f, MinPitch = 0.f, MaxPitch = 0.f;
+        // Boyer-Moore majority vote of the focused actors
+        uint32_t Actor = 0;
+        int64_t Votes = 0;
+
+        void Vote(uint32_t Id)
+        {
+            if (Votes == 0)
+                Actor = Id;
+            Votes += (Id == Actor) ? 1 : -1;
+        }
+    };
+
+    // window indices in increasing order whose values are increasing (Min) or decreasing (Max), the first one is the
+    // extreme of the window
+    struct MonotonicQueue
+    {
+        std::vector<uint64_t> Ids;
+        uint64_t Head = 0, Tail = 0;
+
+        bool Empty() const
+        {
+            return Head == Tail;
+        }
+        uint64_t Front() const
+        {
+            return Ids[Head % Ids.size()];
+        }
+        uint64_t Back() const
+        {
+            return Ids[(Tail - 1) % Ids.size()];
+        }
+        void Clear()
+        {
+            Head = Tail = 0;
+        }
+    };
+
+    const Reading &At(uint64_t Id) const
+    {
+        return Window[Id % Window.size()];
+    }
+
+    template <typename BeforeFn> void PushId(MonotonicQueue &Q, uint64_t Id, BeforeFn &&Before)
+    {
+        // drop the readings that can no longer be the extreme (the new one is more extreme and stays longer)
+        while (!Q.Empty() && !Before(At(Q.Back()), At(Id)))
+            Q.Tail--;
+        Q.Ids[Q.Tail++ % Q.Ids.size()] = Id;
+    }
+
+    void Push(const Reading &R)
+    {
+        if (WindowTail - WindowHead == Window.size())
+            PopFront(); // (a window shorter than MinDuration, see WindowSize)
+        const uint64_t Id = WindowTail++;
+        Window[Id % Window.size()] = R;
+        if (Config.Method == Params::EMethod::Dispersion)
+        {
+            PushId(MinYaw, Id, [](const Reading &A, const Reading &B) { return A.Yaw < B.Yaw; });
+            PushId(MaxYaw, Id, [](const Reading &A, const Reading &B) { return A.Yaw > B.Yaw; });
+            PushId(MinPitch, Id, [](const Reading &A, const Reading &B) { return A.Pitch < B.Pitch; });
+            PushId(MaxPitch, Id, [](const Reading &A, const Reading &B) { return A.Pitch > B.Pitch; });
+        }
+    }
+
+    void PopFront()
+    {
+        const uint64_t Id = WindowHead++;
+        for (MonotonicQueue *Q : {&MinYaw, &MaxYaw, &MinPitch, &MaxPitch})
+            if (!Q->Empty() && Q->Front() == Id)
+                Q->Head++;
+    }
+
+    void ClearWindow()
+    {
+        WindowHead = WindowTail = 0;
+        for (MonotonicQueue *Q : {&MinYaw, &MaxYaw, &MinPitch, &MaxPitch})
+            Q->Clear();
+    }
+
+    float GetWindowRange() const
+    {
+        if (MinYaw.Empty())
+            return 0.f;
+        return (At(MaxYaw.Front()).Yaw - At(MinYaw.Front()).Yaw) +
+               (At(MaxPitch.Front()).Pitch - At(MinPitch.Front()).Pitch);
+    }
+
+    void TryStartFixation(std::vector<DReyeVRFixationEvent> &Out)
+    {
+        if (WindowTail == WindowHead || At(WindowTail - 1).Timestamp - At(WindowHead).Timestamp < Config.MinDuration)
+            return;
+        // the window becomes the fixation (once per fixation)
+        Fix = Fixation();
+        Fix.Start = At(WindowHead).Timestamp;
+        Fix.MinYaw = Fix.MaxYaw = At(WindowHead).Yaw;
+        Fix.MinPitch = Fix.MaxPitch = At(WindowHead).Pitch;
+        for (uint64_t Id = WindowHead; Id < WindowTail; Id++)
+            Extend(At(Id));
+        ClearWindow();
+        bFixating = true;
+        Out.push_back(MakeEvent(true));
+    }
+
+    void Extend(const Reading &R)
+    {
+        Fix.End = R.Timestamp;
+        Fix.SumYaw += R.Yaw;
+        Fix.SumPitch += R.Pitch;
+        Fix.Count++;
+        Fix.MinYaw = std::min(Fix.MinYaw, R.Yaw);
+        Fix.MaxYaw = std::max(Fix.MaxYaw, R.Yaw);
+        Fix.MinPitch = std::min(Fix.MinPitch, R.Pitch);
+        Fix.MaxPitch = std::max(Fix.MaxPitch, R.Pitch);
+        Fix.Vote(R.Actor);
+    }
+
+    void EndFixation(std::vector<DReyeVRFixationEvent> &Out)
+    {
+        if (!bFixating)
+            return;
+        bFixating = false;
+        Last = MakeEvent(false);
+        Out.push_back(Last);
+    }
+
+    DReyeVRFixationEvent MakeEvent(bool bStart) const
+    {
+        DReyeVRFixationEvent E;
+        E.bStart = bStart;
+        E.Start = Fix.Start;
+        E.End = Fix.End;
+        E.Yaw = Fix.Count > 0 ? static_cast<float>(Fix.SumYaw / Fix.Count) : 0.f;
+        E.Pitch = Fix.Count > 0 ? static_cast<float>(Fix.SumPitch / Fix.Count) : 0.f;
+        E.Actor = Actors.empty() ? std::string() : Actors[Fix.Actor];
+        return E;
+    }
+
+    uint32_t Intern(const std::string &Actor)
+    {
+        if (!Actors.empty() && Actors[LastActor] == Actor) // (usually the same as the previous reading)
+            return LastActor;
+        auto It = ActorIds.find(Actor);
+        if (It == ActorIds.end())
+        {
+            It = ActorIds.emplace(Actor, static_cast<uint32_t>(Actors.size())).first;
+            Actors.push_back(Actor);
+        }
+        LastActor = It->second;
+        return LastActor;
+    }
+
+    Params Config;
+    // readings of the candidate fixation: absolute ids [WindowHead, WindowTail) at Window[Id % WindowSize]
+    std::vector<Reading> Window;
+    uint64_t WindowHead = 0, WindowTail = 0;
+    MonotonicQueue MinYaw, MaxYaw, MinPitch, MaxPitch; // (I-DT)
+    // the ongoing fixation
+    bool bFixating = false;
+    Fixation Fix;
+    DReyeVRFixationEvent Last; // the last fixation that ended
+    // previous valid reading
+    bool bHasPrev = false;
+    bool bPrevFixation = false;
+    int64_t PrevTimestamp = 0;
+    double PrevX = 0.0, PrevY = 0.0, PrevZ = 0.0;
+    // focused actors, interned (kept for the classifier's lifetime)
+    std::unordered_map<std::string, uint32_t> ActorIds;
+    std::vector<std::string> Actors;
+    uint32_t LastActor = 0;
+};
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm> // std::sort, std::partial_sort
+#include <cmath>     // std::sqrt, std::acos, std::asin, std::tan, std::floor
+#include <cstdint>   // int64_t, uint32_t
+#include <vector>    // std::vector
+
+// Gaze-cone query over the actors of the world (see [EgoSensor] GazeCone* in DReyeVRConfig.ini)
+//
+// Every actor is the bounding sphere of its bounding box, kept in a uniform grid over the ground plane (X, Y), so a
+// query only visits the cells along the gaze ray (widened by the cone) instead of every actor or a physics sweep.
+// The grid is updated incrementally: Update does nothing for actors that did not move, and only touches the grid
+// when an actor changes cells. Cells are hashed (the grid is unbounded), a cell is kept once an actor was in it so
+// the memory grows with the area the actors covered, not with time. UE-free (tested and benchmarked in
+// Tools/Recordings)
+
+struct DReyeVRGazeConeHit
+{
+    uint32_t ActorId = 0;  // Carla actor id
+    float Angle = 0.f;     // degrees between the gaze ray and the direction to the actor's center
+    float EdgeAngle = 0.f; // degrees between the gaze ray and the actor's bounding sphere (0 if the ray goes through)
+    float Distance = 0.f;  // to the actor's center (cm)
+};
+
+class DReyeVRGazeConeIndex
+{
+  public:
+    struct Vec
+    {
+        float X = 0.f, Y = 0.f, Z = 0.f;
+    };
+
+    explicit DReyeVRGazeConeIndex(float CellSize = 2000.f)
+    {
+        SetCellSize(CellSize);
+    }
+
+    // (re-inserts every actor)
+    void SetCellSize(float InCellSize)
+    {
+        CellSize = std::max(InCellSize, 1.f);
+        Cells.Clear();
+        CellHeads.clear();
+        for (uint32_t i = 0; i < Entries.size(); i++)
+            Insert(i, CellOf(Entries[i].Center));
+    }
+
+    float GetCellSize() const
+    {
+        return CellSize;
+    }
+
+    // starts a round of Updates, the actors that are not updated until RemoveStale are removed then
+    void BeginUpdate()
+    {
+        Stamp++;
+    }
+
+    // adds the actor or moves it (Center in cm), false if it did not move
+    bool Update(uint32_t Id, const Vec &Center, float Radius)
+    {
+        uint32_t &Index = IndexOf.FindOrAdd(Id, static_cast<uint32_t>(Entries.size()));
+        if (Index == Entries.size())
+        {
+            Entries.push_back(Entry{Id, Center, Radius, 0, None, None, Stamp});
+            Insert(Index, CellOf(Center));
+            MaxRadius = std::max(MaxRadius, Radius);
+            return true;
+        }
+        Entry &E = Entries[Index];
+        E.Stamp = Stamp;
+        const float DX = Center.X - E.Center.X, DY = Center.Y - E.Center.Y, DZ = Center.Z - E.Center.Z;
+        if (DX * DX + DY * DY + DZ * DZ < MoveTolerance * MoveTolerance && Radius == E.Radius)
+            return false;
+        E.Center = Center;
+        E.Radius = Radius;
+        MaxRadius = std::max(MaxRadius, Radius);
+        const uint64_t Cell = CellOf(Center);
+        if (Cell != E.Cell)
+        {
+            Unlink(Index);
+            Insert(Index, Cell);
+        }
+        return true;
+    }
+
+    // removes the actors that were not updated since BeginUpdate (ex. destroyed), calling OnRemove(Id) for each
+    template <typename Fn> size_t RemoveStale(Fn &&OnRemove)
+    {
+        size_t NumRemoved = 0;
+        MaxRadius = 0.f;
+        for (uint32_t i = 0; i < Entries.size();)
+        {
+            if (Entries[i].Stamp == Stamp)
+            {
+                MaxRadius = std::max(MaxRadius, Entries[i].Radius);
+                i++;
+                continue;
+            }
+            OnRemove(Entries[i].Id);
+            Remove(i);
+            NumRemoved++;
+        }
+        return NumRemoved;
+    }
+
+    size_t RemoveStale()
+    {
+        return RemoveStale([](uint32_t) {});
+    }
+
+    void Clear()
+    {
+        Entries.clear();
+        IndexOf.Clear();
+        Cells.Clear();
+        CellHeads.clear();
+        MaxRadius = 0.f;
+    }
+
+    size_t Num() const
+    {
+        return Entries.size();
+    }
+
+    // the actors within HalfAngle degrees of the ray from Origin along Dir (normalized) up to MaxDistance (cm),
+    // the smallest Angle first, at most MaxHits of them (0 for all)
+    void Query(const Vec &Origin, const Vec &Dir, float HalfAngle, float MaxDistance, size_t MaxHits,
+               std::vector<DReyeVRGazeConeHit> &Out) const
+    {
+        Out.clear();
+        if (Entries.empty())
+            return;
+        const Cone C(Origin, Dir, HalfAngle, MaxDistance);
+
+        // cells around the points of the ray every cell, widened by the cone there, the largest actor and half a
+        // step (so the cells that the ray crosses between two points are included). The ray is extended by the
+        // largest actor at both ends for the actors whose center is behind the origin or past MaxDistance
+        VisitStamp++;
+        const float Step = CellSize;
+        const float End = MaxDistance + MaxRadius;
+        for (float t = -MaxRadius;; t += Step)
+        {
+            const float T = std::min(t, End);
+            const float Width = (std::max(T, 0.f) + Step) * C.TanHalf + MaxRadius + 0.5f * Step;
+            const float PX = Origin.X + T * Dir.X, PY = Origin.Y + T * Dir.Y;
+            const int64_t X0 = Coord(PX - Width), X1 = Coord(PX + Width);
+            const int64_t Y0 = Coord(PY - Width), Y1 = Coord(PY + Width);
+            for (int64_t X = X0; X <= X1; X++)
+            {
+                for (int64_t Y = Y0; Y <= Y1; Y++)
+                {
+                    const uint32_t *Cell = Cells.Find(Key(X, Y));
+                    if (Cell == nullptr || CellHeads[*Cell].Visit == VisitStamp)
+                        continue;
+                    CellHeads[*Cell].Visit = VisitStamp;
+                    for (uint32_t i = CellHeads[*Cell].Head; i != None; i = Entries[i].Next)
+                        C.Test(Entries[i], Out);
+                }
+            }
+            if (T >= End)
+                break;
+        }
+        Sort(Out, MaxHits);
+    }
+
+    // the same result testing every actor (reference for tests and benchmarks)
+    void QueryAll(const Vec &Origin, const Vec &Dir, float HalfAngle, float MaxDistance, size_t MaxHits,
+                  std::vector<DReyeVRGazeConeHit> &Out) const
+    {
+        Out.clear();
+        const Cone C(Origin, Dir, HalfAngle, MaxDistance);
+        for (const Entry &E : Entries)
+            C.Test(E, Out);
+        Sort(Out, MaxHits);
+    }
+
+  private:
+    static constexpr float MoveTolerance = 1.f; // cm
+    static constexpr float RadToDeg = 57.2957795f;
+
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Entry
+    {
+        uint32_t Id;
+        Vec Center;
+        float Radius;
+        uint64_t Cell;
+        uint32_t Prev, Next; // actors in the same cell
+        uint32_t Stamp;      // of the last BeginUpdate it was updated in
+    };
+
+    struct CellHead
+    {
+        uint32_t Head = None;
+        uint32_t Visit = 0; // VisitStamp of the last Query that visited it
+    };
+
+    // open addressing (Fibonacci hashing, linear probing with backward shift deletion) of uint64 keys to indices
+    class FlatMap
+    {
+      public:
+        const uint32_t *Find(uint64_t Key) const
+        {
+            const size_t i = FindSlot(Key);
+            return i == NotFound ? nullptr : &Slots[i].Value;
+        }
+
+        uint32_t *Find(uint64_t Key)
+        {
+            const size_t i = FindSlot(Key);
+            return i == NotFound ? nullptr : &Slots[i].Value;
+        }
+
+        // (Value is only used if the key is new)
+        uint32_t &FindOrAdd(uint64_t Key, uint32_t Value)
+        {
+            if (2 * (Num + 1) > Slots.size())
+                Grow();
+            size_t i = Hash(Key);
+            for (; Slots[i].bUsed; i = (i + 1) & Mask())
+                if (Slots[i].Key == Key)
+                    return Slots[i].Value;
+            Slots[i] = Slot{Key, Value, true};
+            Num++;
+            return Slots[i].Value;
+        }
+
+        void Erase(uint64_t Key)
+        {
+            size_t Hole = FindSlot(Key);
+            if (Hole == NotFound)
+                return;
+            Slots[Hole].bUsed = false;
+            Num--;
+            // shift back the keys of the same probe sequence so the lookups still find them
+            for (size_t i = (Hole + 1) & Mask(); Slots[i].bUsed; i = (i + 1) & Mask())
+            {
+                const size_t Home = Hash(Slots[i].Key);
+                if (((i - Home) & Mask()) >= ((i - Hole) & Mask()))
+                {
+                    Slots[Hole] = Slots[i];
+                    Slots[i].bUsed = false;
+                    Hole = i;
+                }
+            }
+        }
+
+        void Clear()
+        {
+            Slots.clear();
+            Bits = 0;
+            Num = 0;
+        }
+
+      private:
+        static constexpr size_t NotFound = SIZE_MAX;
+
+        struct Slot
+        {
+            uint64_t Key;
+            uint32_t Value;
+            bool bUsed;
+        };
+
+        size_t Mask() const
+        {
+            return Slots.size() - 1;
+        }
+
+        size_t Hash(uint64_t Key) const
+        {
+            return static_cast<size_t>((Key * 11400714819323198485ull) >> (64 - Bits));
+        }
+
+        size_t FindSlot(uint64_t Key) const
+        {
+            if (Slots.empty())
+                return NotFound;
+            for (size_t i = Hash(Key);; i = (i + 1) & Mask())
+            {
+                if (!Slots[i].bUsed)
+                    return NotFound;
+                if (Slots[i].Key == Key)
+                    return i;
+            }
+        }
+
+        void Grow()
+        {
+            std::vector<Slot> Old;
+            Old.swap(Slots);
+            Bits = std::max<uint32_t>(Bits + 1, 4);
+            Slots.assign(size_t(1) << Bits, Slot{0, 0, false});
+            Num = 0;
+            for (const Slot &S : Old)
+                if (S.bUsed)
+                    FindOrAdd(S.Key, S.Value);
+        }
+
+        std::vector<Slot> Slots;
+        uint32_t Bits = 0;
+        size_t Num = 0;
+    };
+
+    struct Cone
+    {
+        Cone(const Vec &InOrigin, const Vec &InDir, float InHalfAngle, float InMaxDistance)
+            : Origin(InOrigin), Dir(InDir), HalfAngle(std::min(std::max(InHalfAngle, 0.f), 89.f)),
+              MaxDistance(InMaxDistance), TanHalf(std::tan(HalfAngle / RadToDeg))
+        {
+        }
+
+        void Test(const Entry &E, std::vector<DReyeVRGazeConeHit> &Out) const
+        {
+            const float VX = E.Center.X - Origin.X, VY = E.Center.Y - Origin.Y, VZ = E.Center.Z - Origin.Z;
+            const float Dist = std::sqrt(VX * VX + VY * VY + VZ * VZ);
+            if (Dist - E.Radius > MaxDistance)
+                return;
+            DReyeVRGazeConeHit Hit;
+            Hit.ActorId = E.Id;
+            Hit.Distance = Dist;
+            if (Dist > 0.f)
+            {
+                const float Cos = (VX * Dir.X + VY * Dir.Y + VZ * Dir.Z) / Dist;
+                Hit.Angle = std::acos(std::min(std::max(Cos, -1.f), 1.f)) * RadToDeg;
+            }
+            if (Dist > E.Radius) // (else the origin is inside the sphere)
+                Hit.EdgeAngle = std::max(Hit.Angle - std::asin(E.Radius / Dist) * RadToDeg, 0.f);
+            if (Hit.EdgeAngle <= HalfAngle)
+                Out.push_back(Hit);
+        }
+
+        Vec Origin;
+        Vec Dir;
+        float HalfAngle;
+        float MaxDistance;
+        float TanHalf;
+    };
+
+    static void Sort(std::vector<DReyeVRGazeConeHit> &Out, size_t MaxHits)
+    {
+        auto Less = [](const DReyeVRGazeConeHit &A, const DReyeVRGazeConeHit &B) {
+            return A.Angle < B.Angle || (A.Angle == B.Angle && A.ActorId < B.ActorId);
+        };
+        if (MaxHits > 0 && Out.size() > MaxHits)
+        {
+            std::partial_sort(Out.begin(), Out.begin() + MaxHits, Out.end(), Less);
+            Out.resize(MaxHits);
+        }
+        else
+            std::sort(Out.begin(), Out.end(), Less);
+    }
+
+    int64_t Coord(float X) const
+    {
+        return static_cast<int64_t>(std::floor(X / CellSize));
+    }
+
+    static uint64_t Key(int64_t X, int64_t Y)
+    {
+        return (static_cast<uint64_t>(X) << 32) ^ static_cast<uint32_t>(Y);
+    }
+
+    uint64_t CellOf(const Vec &Center) const
+    {
+        return Key(Coord(Center.X), Coord(Center.Y));
+    }
+
+    void Insert(uint32_t Index, uint64_t Cell)
+    {
+        const uint32_t CellIndex = Cells.FindOrAdd(Cell, static_cast<uint32_t>(CellHeads.size()));
+        if (CellIndex == CellHeads.size())
+            CellHeads.emplace_back();
+        Entry &E = Entries[Index];
+        E.Cell = Cell;
+        E.Prev = None;
+        E.Next = CellHeads[CellIndex].Head;
+        if (E.Next != None)
+            Entries[E.Next].Prev = Index;
+        CellHeads[CellIndex].Head = Index;
+    }
+
+    // (from its cell only)
+    void Unlink(uint32_t Index)
+    {
+        const Entry &E = Entries[Index];
+        if (E.Prev != None)
+            Entries[E.Prev].Next = E.Next;
+        else
+            CellHeads[*Cells.Find(E.Cell)].Head = E.Next;
+        if (E.Next != None)
+            Entries[E.Next].Prev = E.Prev;
+    }
+
+    void Remove(uint32_t Index)
+    {
+        Unlink(Index);
+        IndexOf.Erase(Entries[Index].Id);
+        const uint32_t Last = static_cast<uint32_t>(Entries.size() - 1);
+        if (Index != Last)
+        {
+            // move the last actor into the hole (and the links to it)
+            Entry &E = Entries[Index];
+            E = Entries[Last];
+            *IndexOf.Find(E.Id) = Index;
+            if (E.Prev != None)
+                Entries[E.Prev].Next = Index;
+            else
+                CellHeads[*Cells.Find(E.Cell)].Head = Index;
+            if (E.Next != None)
+                Entries[E.Next].Prev = Index;
+        }
+        Entries.pop_back();
+    }
+
+    float CellSize = 2000.f;
+    float MaxRadius = 0.f; // of every actor (the query widens the cells it visits by it)
+    uint32_t Stamp = 0;
+    std::vector<Entry> Entries;
+    FlatMap IndexOf;                         // Id -> index into Entries
+    FlatMap Cells;                           // cell -> index into CellHeads
+    mutable std::vector<CellHead> CellHeads; // (Visit is updated by Query)
+    mutable uint32_t VisitStamp = 0;
+};
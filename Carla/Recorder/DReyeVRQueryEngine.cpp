@@ -0,0 +1,106 @@
+#include "DReyeVRQueryEngine.h"
+
+#include <algorithm>          // std::lower_bound, std::min, std::max
+#include <condition_variable> // std::condition_variable
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+
+std::vector<DReyeVRQueryChunk> DReyeVRSplitChunks(const std::vector<uint64_t> &FrameOffsets, uint64_t DataEnd,
+                                                  size_t MaxChunks)
+{
+    std::vector<DReyeVRQueryChunk> Chunks;
+    if (FrameOffsets.empty() || DataEnd <= FrameOffsets.front())
+        return Chunks;
+    const uint64_t Begin = FrameOffsets.front();
+    const uint64_t Bytes = DataEnd - Begin;
+    MaxChunks = std::max<size_t>(MaxChunks, 1);
+
+    // first frame starting at or after each of the evenly spaced byte targets
+    std::vector<uint64_t> Starts = {Begin};
+    for (size_t i = 1; i < MaxChunks; i++)
+    {
+        const uint64_t Target = Begin + Bytes / MaxChunks * i;
+        auto It = std::lower_bound(FrameOffsets.begin(), FrameOffsets.end(), Target);
+        if (It == FrameOffsets.end() || *It >= DataEnd)
+            break;
+        if (*It > Starts.back())
+            Starts.push_back(*It);
+    }
+    for (size_t i = 0; i < Starts.size(); i++)
+    {
+        const uint64_t End = (i + 1 < Starts.size()) ? Starts[i + 1] : DataEnd;
+        Chunks.push_back({Starts[i], End});
+    }
+    return Chunks;
+}
+
+DReyeVRQueryEngine::DReyeVRQueryEngine(size_t NumThreads)
+    : NumThreads(NumThreads > 0 ? NumThreads : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+{
+}
+
+void DReyeVRQueryEngine::Run(size_t NumChunks, const std::function<void(size_t)> &Parse,
+                             const std::function<void(size_t)> &Merge, size_t MaxAhead) const
+{
+    const size_t NumWorkers = std::min(NumThreads, NumChunks);
+    if (NumWorkers <= 1)
+    {
+        // nothing to overlap, no threads
+        for (size_t i = 0; i < NumChunks; i++)
+        {
+            Parse(i);
+            Merge(i);
+        }
+        return;
+    }
+    const size_t Ahead = std::max(MaxAhead > 0 ? MaxAhead : 2 * NumThreads, NumWorkers);
+
+    std::mutex Mutex;
+    std::condition_variable ParsedCV; // a chunk finished parsing (the merging thread waits on it)
+    std::condition_variable MergedCV; // a chunk was merged (workers that are too far ahead wait on it)
+    std::vector<char> bParsed(NumChunks, 0);
+    size_t NextChunk = 0;
+    size_t NumMerged = 0;
+
+    auto WorkerLoop = [&]() {
+        while (true)
+        {
+            size_t Chunk;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                MergedCV.wait(Lock, [&] { return NextChunk >= NumChunks || NextChunk < NumMerged + Ahead; });
+                if (NextChunk >= NumChunks)
+                    return;
+                Chunk = NextChunk++;
+            }
+            Parse(Chunk);
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                bParsed[Chunk] = 1;
+            }
+            ParsedCV.notify_all();
+        }
+    };
+
+    std::vector<std::thread> Workers;
+    Workers.reserve(NumWorkers);
+    for (size_t i = 0; i < NumWorkers; i++)
+        Workers.emplace_back(WorkerLoop);
+
+    for (size_t i = 0; i < NumChunks; i++)
+    {
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            ParsedCV.wait(Lock, [&] { return bParsed[i] != 0; });
+        }
+        Merge(i);
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            NumMerged = i + 1;
+        }
+        MergedCV.notify_all();
+    }
+
+    for (std::thread &Worker : Workers)
+        Worker.join();
+}
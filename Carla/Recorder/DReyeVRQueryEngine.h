@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>    // uint64_t
+#include <functional> // std::function
+#include <vector>     // std::vector
+
+// Parallel recording queries (see CarlaRecorderQuery::Query and [Replayer] QueryThreads in DReyeVRConfig.ini)
+//
+// A recording is split into byte ranges that start at a FrameStart packet (from the frame index when there is one,
+// or from a scan of the packet headers). Chunks are parsed concurrently on a pool of threads, each worker with its
+// own stream (and mapping) of the file, into small per-chunk extracts. The extracts are then merged in file order
+// on the calling thread, which is where state that spans chunks (the actor table, collisions still going on from the
+// previous frame, how long an actor has been stopped) is carried from one chunk to the next. Only a bounded number
+// of chunks is parsed ahead of the merge, so memory does not grow with the length of the recording.
+
+// byte range [Begin, End) of a recording, Begin is the offset of a FrameStart packet
+struct DReyeVRQueryChunk
+{
+    uint64_t Begin = 0;
+    uint64_t End = 0;
+};
+
+// groups the frames starting at FrameOffsets (ascending) into at most MaxChunks chunks of about the same number of
+// bytes, the last chunk ends at DataEnd
+std::vector<DReyeVRQueryChunk> DReyeVRSplitChunks(const std::vector<uint64_t> &FrameOffsets, uint64_t DataEnd,
+                                                  size_t MaxChunks);
+
+class DReyeVRQueryEngine
+{
+  public:
+    // NumThreads = 0 uses every hardware thread
+    explicit DReyeVRQueryEngine(size_t NumThreads = 0);
+
+    size_t GetNumThreads() const
+    {
+        return NumThreads;
+    }
+
+    // calls Parse(i) for every chunk on the pool (concurrently, in any order) and Merge(i) on the calling thread in
+    // chunk order as soon as chunk i is parsed. At most MaxAhead chunks are parsed ahead of the next Merge
+    // (0 = twice the number of threads). Parse must only touch state of its own chunk
+    void Run(size_t NumChunks, const std::function<void(size_t)> &Parse, const std::function<void(size_t)> &Merge,
+             size_t MaxAhead = 0) const;
+
+  private:
+    size_t NumThreads;
+};
@@ -74,8 +74,43 @@ template <typename T, uint8_t N> class DReyeVRDataRecorders
         OutFile.seekp(PosEnd, std::ios::beg);
     }
 
+    // compact packet (see DReyeVRRecorderCodec.h), only for data types implementing WriteCompact
+    // returns the number of bytes written
+    size_t WriteCompact(std::ofstream &OutFile, DReyeVRFieldEncoder &Encoder, bool bReset)
+    {
+        CompactBytes.Clear();
+        Encoder.BeginPacket(CompactBytes, bReset);
+        CompactBytes.Varint(AllData.size());
+        for (auto &Snapshot : AllData)
+        {
+            Encoder.BeginRecord();
+            Snapshot.Data.WriteCompact(Encoder);
+            Encoder.EndRecord(CompactBytes);
+        }
+        WriteValue<char>(OutFile, static_cast<char>(DREYEVR_COMPACT_DREYEVR_PACKET_ID));
+        WriteValue<uint32_t>(OutFile, static_cast<uint32_t>(CompactBytes.Size()));
+        OutFile.write(CompactBytes.GetBytes().data(), CompactBytes.Size());
+        return sizeof(char) + sizeof(uint32_t) + CompactBytes.Size();
+    }
+
+    // custom actor packet with interned strings (see DReyeVR::CustomActorEncoder)
+    // returns the number of bytes written
+    size_t WriteInterned(std::ofstream &OutFile, DReyeVR::CustomActorEncoder &Encoder, bool bReset)
+    {
+        Encoder.BeginPacket(bReset);
+        for (auto &Snapshot : AllData)
+            Encoder.Add(Snapshot.Data);
+        CompactBytes.Clear();
+        Encoder.EndPacket(CompactBytes);
+        WriteValue<char>(OutFile, static_cast<char>(DREYEVR_INTERNED_CUSTOM_ACTOR_PACKET_ID));
+        WriteValue<uint32_t>(OutFile, static_cast<uint32_t>(CompactBytes.Size()));
+        OutFile.write(CompactBytes.GetBytes().data(), CompactBytes.Size());
+        return sizeof(char) + sizeof(uint32_t) + CompactBytes.Size();
+    }
+
   private:
     // using a vector as a queue that holds everything, gets written and flushed on every tick
     std::vector<DReyeVRDataRecorder<T>> AllData;
     uint8_t PacketId = N;
+    DReyeVRCompactWriter CompactBytes; // (reused across frames)
 };
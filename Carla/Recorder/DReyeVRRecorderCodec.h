@@ -0,0 +1,617 @@
+#pragma once
+
+#include <array>         // std::array
+#include <cmath>         // std::llround, std::isfinite
+#include <cstdint>       // uint64_t
+#include <cstring>       // std::memcpy
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+// Compact encoding for the per-frame Position and DReyeVR packets (see [Recorder] CompactEncoding)
+//
+// Every float is quantized to a fixed precision and stored as the zig-zag varint of its difference to the same
+// value in the previous packet of that kind, so values that (almost) do not change take a single byte. Packets
+// flagged as reset are encoded against zero and carry the precisions, so decoding can (re)start at them: the
+// recorder resets on the first frame and on every keyframe (the frames the replayer seeks to). Every other
+// packet depends on the one before it, so readers must decode these packets even when they are not used.
+
+#define DREYEVR_COMPACT_POSITION_PACKET_ID 144
+#define DREYEVR_COMPACT_DREYEVR_PACKET_ID 145
+#define DREYEVR_INTERNED_CUSTOM_ACTOR_PACKET_ID 146 // custom actors with a string table (see DReyeVR::CustomActorEncoder)
+#define DREYEVR_EYE_SAMPLES_PACKET_ID 147 // every eye-tracker reading since the previous frame ([Recorder] EyeSamples)
+#define DREYEVR_COMPACT_FLAG_RESET 0x01
+
+inline uint64_t DReyeVRZigZag(int64_t Value)
+{
+    return (static_cast<uint64_t>(Value) << 1) ^ static_cast<uint64_t>(Value >> 63);
+}
+
+inline int64_t DReyeVRUnZigZag(uint64_t Value)
+{
+    return static_cast<int64_t>(Value >> 1) ^ -static_cast<int64_t>(Value & 1);
+}
+
+// quantization step of each kind of value (written to every reset packet)
+struct DReyeVRCompactPrecision
+{
+    float Location = 0.1f;  // cm: locations, distances, velocities
+    float Rotation = 0.01f; // degrees
+    float Unit = 0.0001f;   // normalized values: directions, eye openness, pedal inputs...
+
+    enum Kind : uint8_t
+    {
+        LOCATION,
+        ROTATION,
+        UNIT,
+    };
+
+    float Get(Kind K) const
+    {
+        return (K == LOCATION) ? Location : ((K == ROTATION) ? Rotation : Unit);
+    }
+
+    bool IsValid() const
+    {
+        return Location > 0.f && Rotation > 0.f && Unit > 0.f; // (also false for NaN)
+    }
+
+    static int64_t Quantize(float Value, float Step)
+    {
+        return std::isfinite(Value) ? static_cast<int64_t>(std::llround(static_cast<double>(Value) / Step)) : 0;
+    }
+
+    static float Dequantize(int64_t Q, float Step)
+    {
+        return static_cast<float>(static_cast<double>(Q) * Step);
+    }
+};
+
+class DReyeVRCompactWriter
+{
+  public:
+    void Clear()
+    {
+        Bytes.clear();
+    }
+
+    void Varint(uint64_t Value)
+    {
+        while (Value >= 0x80)
+        {
+            Bytes.push_back(static_cast<char>(Value | 0x80));
+            Value >>= 7;
+        }
+        Bytes.push_back(static_cast<char>(Value));
+    }
+
+    void ZigZag(int64_t Value)
+    {
+        Varint(DReyeVRZigZag(Value));
+    }
+
+    template <typename T> void Raw(const T &Value)
+    {
+        Bytes.append(reinterpret_cast<const char *>(&Value), sizeof(T));
+    }
+
+    void Append(const char *Data, size_t Size)
+    {
+        Bytes.append(Data, Size);
+    }
+
+    const std::string &GetBytes() const
+    {
+        return Bytes;
+    }
+
+    size_t Size() const
+    {
+        return Bytes.size();
+    }
+
+  private:
+    std::string Bytes;
+};
+
+// bounds-checked cursor over an encoded packet (Failed() once anything was read past the end)
+class DReyeVRCompactReader
+{
+  public:
+    DReyeVRCompactReader(const char *Data, size_t Size) : Cursor(Data), End(Data + Size)
+    {
+    }
+
+    uint64_t Varint()
+    {
+        uint64_t Value = 0;
+        for (int Shift = 0; Shift < 64 && Cursor < End; Shift += 7)
+        {
+            const uint8_t Byte = static_cast<uint8_t>(*Cursor++);
+            Value |= static_cast<uint64_t>(Byte & 0x7f) << Shift;
+            if ((Byte & 0x80) == 0)
+                return Value;
+        }
+        bFailed = true;
+        return 0;
+    }
+
+    int64_t ZigZag()
+    {
+        return DReyeVRUnZigZag(Varint());
+    }
+
+    template <typename T> T Raw()
+    {
+        T Value{};
+        if (static_cast<size_t>(End - Cursor) < sizeof(T))
+        {
+            bFailed = true;
+            return Value;
+        }
+        std::memcpy(&Value, Cursor, sizeof(T));
+        Cursor += sizeof(T);
+        return Value;
+    }
+
+    // pointer to the next Size bytes (nullptr if there are not enough)
+    const char *View(size_t Size)
+    {
+        if (static_cast<size_t>(End - Cursor) < Size)
+        {
+            bFailed = true;
+            return nullptr;
+        }
+        const char *Data = Cursor;
+        Cursor += Size;
+        return Data;
+    }
+
+    bool Failed() const
+    {
+        return bFailed;
+    }
+
+    size_t Remaining() const
+    {
+        return static_cast<size_t>(End - Cursor);
+    }
+
+  private:
+    const char *Cursor;
+    const char *End;
+    bool bFailed = false;
+};
+
+/// ========================================== ///
+/// ---------------:POSITIONS:---------------- ///
+/// ========================================== ///
+
+// same values as CarlaRecorderPosition (Location, then Rotation as euler angles), without the UE types
+struct DReyeVRCompactPosition
+{
+    uint32_t DatabaseId = 0;
+    std::array<float, 3> Location = {};
+    std::array<float, 3> Rotation = {};
+};
+
+// per-actor delta state, shared by the encoder and the decoder so both evolve identically
+class DReyeVRPositionDeltas
+{
+  public:
+    void Reset()
+    {
+        Prev.clear();
+        Next.clear();
+    }
+
+  protected:
+    using FQuantized = std::array<int64_t, 6>;
+
+    // previous quantized values of an actor (zero for actors not in the previous packet)
+    FQuantized GetPrev(uint32_t DatabaseId) const
+    {
+        auto It = Prev.find(DatabaseId);
+        return (It == Prev.end()) ? FQuantized{} : It->second;
+    }
+
+    // only the actors of the last packet are kept, so destroyed actors do not accumulate
+    void Swap()
+    {
+        std::swap(Prev, Next);
+        Next.clear();
+    }
+
+    std::unordered_map<uint32_t, FQuantized> Prev;
+    std::unordered_map<uint32_t, FQuantized> Next;
+};
+
+class DReyeVRPositionEncoder : public DReyeVRPositionDeltas
+{
+  public:
+    void SetPrecision(const DReyeVRCompactPrecision &NewPrecision)
+    {
+        Precision = NewPrecision;
+    }
+
+    // appends the packet body (without the packet header) to Out
+    void Encode(const std::vector<DReyeVRCompactPosition> &Positions, bool bReset, DReyeVRCompactWriter &Out)
+    {
+        if (bReset)
+            Reset();
+        Out.Raw<uint8_t>(bReset ? DREYEVR_COMPACT_FLAG_RESET : 0);
+        if (bReset)
+        {
+            Out.Raw<float>(Precision.Location);
+            Out.Raw<float>(Precision.Rotation);
+        }
+        Out.Varint(Positions.size());
+        uint32_t PrevId = 0;
+        for (const DReyeVRCompactPosition &Pos : Positions)
+        {
+            Out.ZigZag(static_cast<int64_t>(Pos.DatabaseId) - static_cast<int64_t>(PrevId));
+            PrevId = Pos.DatabaseId;
+            const FQuantized Last = GetPrev(Pos.DatabaseId);
+            FQuantized &Current = Next[Pos.DatabaseId];
+            for (size_t i = 0; i < 3; i++)
+            {
+                Current[i] = DReyeVRCompactPrecision::Quantize(Pos.Location[i], Precision.Location);
+                Current[i + 3] = DReyeVRCompactPrecision::Quantize(Pos.Rotation[i], Precision.Rotation);
+            }
+            for (size_t i = 0; i < Current.size(); i++)
+                Out.ZigZag(Current[i] - Last[i]);
+        }
+        Swap();
+    }
+
+  private:
+    DReyeVRCompactPrecision Precision;
+};
+
+class DReyeVRPositionDecoder : public DReyeVRPositionDeltas
+{
+  public:
+    // decodes a packet body, false if it is malformed or depends on a packet that was not decoded
+    bool Decode(DReyeVRCompactReader &In, std::vector<DReyeVRCompactPosition> &OutPositions)
+    {
+        const uint8_t Flags = In.Raw<uint8_t>();
+        if (Flags & DREYEVR_COMPACT_FLAG_RESET)
+        {
+            Reset();
+            Precision.Location = In.Raw<float>();
+            Precision.Rotation = In.Raw<float>();
+            bSynced = true;
+        }
+        const uint64_t Num = In.Varint();
+        OutPositions.clear();
+        OutPositions.reserve(static_cast<size_t>(Num));
+        uint32_t PrevId = 0;
+        for (uint64_t n = 0; n < Num && !In.Failed(); n++)
+        {
+            DReyeVRCompactPosition Pos;
+            Pos.DatabaseId = static_cast<uint32_t>(static_cast<int64_t>(PrevId) + In.ZigZag());
+            PrevId = Pos.DatabaseId;
+            const FQuantized Last = GetPrev(Pos.DatabaseId);
+            FQuantized &Current = Next[Pos.DatabaseId];
+            for (size_t i = 0; i < Current.size(); i++)
+                Current[i] = Last[i] + In.ZigZag();
+            for (size_t i = 0; i < 3; i++)
+            {
+                Pos.Location[i] = DReyeVRCompactPrecision::Dequantize(Current[i], Precision.Location);
+                Pos.Rotation[i] = DReyeVRCompactPrecision::Dequantize(Current[i + 3], Precision.Rotation);
+            }
+            OutPositions.push_back(Pos);
+        }
+        Swap();
+        if (In.Failed())
+            bSynced = false;
+        return bSynced;
+    }
+
+    void Reset()
+    {
+        DReyeVRPositionDeltas::Reset();
+        bSynced = false;
+    }
+
+  private:
+    DReyeVRCompactPrecision Precision;
+    bool bSynced = false; // decoded continuously since a reset packet
+};
+
+/// ========================================== ///
+/// -----------------:FIELDS:----------------- ///
+/// ========================================== ///
+
+// Fixed sequences of fields (ex. DReyeVR::AggregateData) are encoded by visiting them in the same order on both
+// sides, every field occupying one delta slot. Bools are gathered into a bitmask in front of the other fields.
+class DReyeVRFieldDeltas
+{
+  public:
+    void Reset()
+    {
+        Prev.clear();
+        PrevStrings.clear();
+    }
+
+  protected:
+    int64_t &Slot()
+    {
+        if (NumSlots == Prev.size())
+            Prev.push_back(0);
+        return Prev[NumSlots++];
+    }
+
+    std::string &StringSlot()
+    {
+        if (NumStrings == PrevStrings.size())
+            PrevStrings.emplace_back();
+        return PrevStrings[NumStrings++];
+    }
+
+    std::vector<int64_t> Prev;
+    std::vector<std::string> PrevStrings;
+    size_t NumSlots = 0;
+    size_t NumStrings = 0;
+};
+
+class DReyeVRFieldEncoder : public DReyeVRFieldDeltas
+{
+  public:
+    void SetPrecision(const DReyeVRCompactPrecision &NewPrecision)
+    {
+        Precision = NewPrecision;
+    }
+
+    // starts a packet body (flags and precisions) in Out
+    void BeginPacket(DReyeVRCompactWriter &Out, bool bReset)
+    {
+        if (bReset)
+            Reset();
+        Out.Raw<uint8_t>(bReset ? DREYEVR_COMPACT_FLAG_RESET : 0);
+        if (bReset)
+        {
+            Out.Raw<float>(Precision.Location);
+            Out.Raw<float>(Precision.Rotation);
+            Out.Raw<float>(Precision.Unit);
+        }
+    }
+
+    // every record of the packet is visited between BeginRecord and EndRecord
+    void BeginRecord()
+    {
+        NumSlots = 0;
+        NumStrings = 0;
+        Bools.clear();
+        Body.Clear();
+    }
+
+    void EndRecord(DReyeVRCompactWriter &Out)
+    {
+        Out.Varint(Bools.size());
+        for (size_t i = 0; i < Bools.size(); i += 8)
+        {
+            uint8_t Mask = 0;
+            for (size_t b = 0; b < 8 && i + b < Bools.size(); b++)
+                Mask |= static_cast<uint8_t>(Bools[i + b]) << b;
+            Out.Raw<uint8_t>(Mask);
+        }
+        Out.Append(Body.GetBytes().data(), Body.Size());
+    }
+
+    void Float(const float &Value, DReyeVRCompactPrecision::Kind Kind)
+    {
+        const int64_t Q = DReyeVRCompactPrecision::Quantize(Value, Precision.Get(Kind));
+        int64_t &Last = Slot();
+        Body.ZigZag(Q - Last);
+        Last = Q;
+        RawBytes += sizeof(float);
+    }
+
+    void Int(const int64_t &Value)
+    {
+        int64_t &Last = Slot();
+        Body.ZigZag(Value - Last);
+        Last = Value;
+        RawBytes += sizeof(int64_t);
+    }
+
+    void Bool(const bool &Value)
+    {
+        Bools.push_back(Value);
+        RawBytes += sizeof(bool);
+    }
+
+    // 0 if unchanged, otherwise the length + 1 followed by the text
+    void String(const std::string &Value)
+    {
+        std::string &Last = StringSlot();
+        if (Value == Last)
+        {
+            Body.Varint(0);
+        }
+        else
+        {
+            Body.Varint(Value.size() + 1);
+            Body.Append(Value.data(), Value.size());
+            Last = Value;
+        }
+        RawBytes += sizeof(uint16_t) + Value.size();
+    }
+
+    // size the visited fields would have taken in the raw (uncompressed) packets
+    uint64_t RawBytes = 0;
+
+  private:
+    DReyeVRCompactPrecision Precision;
+    std::vector<bool> Bools;
+    DReyeVRCompactWriter Body;
+};
+
+class DReyeVRFieldDecoder : public DReyeVRFieldDeltas
+{
+  public:
+    // reads the packet flags (and precisions), false if decoding cannot start at this packet
+    bool BeginPacket(DReyeVRCompactReader &In)
+    {
+        const uint8_t Flags = In.Raw<uint8_t>();
+        if (Flags & DREYEVR_COMPACT_FLAG_RESET)
+        {
+            Reset();
+            Precision.Location = In.Raw<float>();
+            Precision.Rotation = In.Raw<float>();
+            Precision.Unit = In.Raw<float>();
+            bSynced = true;
+        }
+        return bSynced && !In.Failed();
+    }
+
+    void BeginRecord(DReyeVRCompactReader &In)
+    {
+        Reader = &In;
+        NumSlots = 0;
+        NumStrings = 0;
+        NumBools = static_cast<size_t>(In.Varint());
+        const size_t NumBytes = (NumBools + 7) / 8;
+        const char *MaskBytes = In.View(NumBytes);
+        Masks.assign(MaskBytes, MaskBytes == nullptr ? MaskBytes : MaskBytes + NumBytes);
+        NextBool = 0;
+    }
+
+    // false if the record was malformed (the decoder has to wait for the next reset packet)
+    bool EndRecord()
+    {
+        if (Reader->Failed() || NextBool != NumBools)
+            bSynced = false;
+        return bSynced;
+    }
+
+    void Float(float &Value, DReyeVRCompactPrecision::Kind Kind)
+    {
+        int64_t &Last = Slot();
+        Last += Reader->ZigZag();
+        Value = DReyeVRCompactPrecision::Dequantize(Last, Precision.Get(Kind));
+    }
+
+    void Int(int64_t &Value)
+    {
+        int64_t &Last = Slot();
+        Last += Reader->ZigZag();
+        Value = Last;
+    }
+
+    void Bool(bool &Value)
+    {
+        const size_t i = NextBool++;
+        Value = (i < NumBools && i / 8 < Masks.size()) ? ((static_cast<uint8_t>(Masks[i / 8]) >> (i % 8)) & 1) : false;
+    }
+
+    void String(std::string &Value)
+    {
+        std::string &Last = StringSlot();
+        const uint64_t Length = Reader->Varint();
+        if (Length > 0)
+        {
+            const char *Text = Reader->View(static_cast<size_t>(Length - 1));
+            if (Text != nullptr)
+                Last.assign(Text, static_cast<size_t>(Length - 1));
+        }
+        Value = Last;
+    }
+
+    void Reset()
+    {
+        DReyeVRFieldDeltas::Reset();
+        bSynced = false;
+    }
+
+  private:
+    DReyeVRCompactPrecision Precision;
+    DReyeVRCompactReader *Reader = nullptr;
+    std::string Masks;
+    size_t NumBools = 0;
+    size_t NextBool = 0;
+    bool bSynced = false;
+};
+
+/// ========================================== ///
+/// --------------:STRING TABLE:-------------- ///
+/// ========================================== ///
+
+// Strings (actor names, asset paths) are written once, in the first packet that uses them after a reset, and
+// referred to by their index afterwards. Each packet starts with the strings it adds to the table.
+
+class DReyeVRStringTableWriter
+{
+  public:
+    void Reset()
+    {
+        Ids.clear();
+        Pending.clear();
+    }
+
+    // id of Str, added to the table (and to the next definitions) if it is new
+    uint32_t Intern(const std::string &Str)
+    {
+        auto It = Ids.find(Str);
+        if (It == Ids.end())
+        {
+            It = Ids.emplace(Str, static_cast<uint32_t>(Ids.size())).first;
+            Pending.push_back(&It->first); // (keys of an unordered_map never move)
+        }
+        return It->second;
+    }
+
+    // writes the strings interned since the last call
+    void WriteDefinitions(DReyeVRCompactWriter &Out)
+    {
+        Out.Varint(Pending.size());
+        for (const std::string *Str : Pending)
+        {
+            Out.Varint(Str->size());
+            Out.Append(Str->data(), Str->size());
+        }
+        Pending.clear();
+    }
+
+    size_t Size() const
+    {
+        return Ids.size();
+    }
+
+  private:
+    std::unordered_map<std::string, uint32_t> Ids;
+    std::vector<const std::string *> Pending;
+};
+
+class DReyeVRStringTableReader
+{
+  public:
+    void Reset()
+    {
+        Strings.clear();
+    }
+
+    // appends the strings defined by a packet to the table, false if they are malformed
+    bool ReadDefinitions(DReyeVRCompactReader &In)
+    {
+        const uint64_t Num = In.Varint();
+        for (uint64_t n = 0; n < Num && !In.Failed(); n++)
+        {
+            const size_t Length = static_cast<size_t>(In.Varint());
+            const char *Text = In.View(Length);
+            if (Text != nullptr)
+                Strings.emplace_back(Text, Length);
+        }
+        return !In.Failed();
+    }
+
+    // nullptr for ids that were never defined
+    const std::string *Get(uint64_t Id) const
+    {
+        return Id < Strings.size() ? &Strings[static_cast<size_t>(Id)] : nullptr;
+    }
+
+  private:
+    std::vector<std::string> Strings;
+};
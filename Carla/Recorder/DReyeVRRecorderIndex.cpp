@@ -0,0 +1,162 @@
+#include "DReyeVRRecorderIndex.h"
+#include "CarlaRecorderHelpers.h" // WriteValue, ReadValue
+
+#include <algorithm> // std::upper_bound, std::lower_bound
+#include <cstring>   // std::memcmp
+#include <iterator>  // std::prev, std::distance
+
+void DReyeVRFrameIndex::Clear()
+{
+    Entries.clear();
+    Keyframes.clear();
+    NextFrameId = 0;
+    NextElapsed = 0.0;
+}
+
+void DReyeVRFrameIndex::AddFrame(double DeltaSeconds, uint64_t Offset)
+{
+    // same arithmetic (and order) as CarlaRecorderFrames::SetFrame
+    if (NextFrameId == 0)
+        NextElapsed = 0.0;
+    else
+        NextElapsed += DeltaSeconds;
+    ++NextFrameId;
+    Entries.push_back({NextFrameId, NextElapsed, Offset});
+}
+
+void DReyeVRFrameIndex::AddFrame(const DReyeVRFrameIndexEntry &Entry)
+{
+    Entries.push_back(Entry);
+    NextFrameId = Entry.FrameId;
+    NextElapsed = Entry.Elapsed;
+}
+
+void DReyeVRFrameIndex::AddKeyframe(uint64_t Offset)
+{
+    if (!Entries.empty())
+        Keyframes.push_back({static_cast<uint32_t>(Entries.size() - 1), Offset});
+}
+
+void DReyeVRFrameIndex::Write(std::ofstream &OutFile) const
+{
+    const uint64_t PacketOffset = static_cast<uint64_t>(OutFile.tellp());
+    const uint32_t NumFrames = static_cast<uint32_t>(Entries.size());
+    const uint32_t NumKeyframes = static_cast<uint32_t>(Keyframes.size());
+    const uint32_t Size = sizeof(uint16_t) + sizeof(uint32_t) +                                  // version + count
+                          NumFrames * (sizeof(uint64_t) + sizeof(double) + sizeof(uint64_t)) + // entries
+                          sizeof(uint32_t) + NumKeyframes * (sizeof(uint32_t) + sizeof(uint64_t)) + // keyframes
+                          sizeof(uint64_t) + 8;                                                // footer
+    WriteValue<char>(OutFile, static_cast<char>(DREYEVR_FRAME_INDEX_PACKET_ID));
+    WriteValue<uint32_t>(OutFile, Size);
+    WriteValue<uint16_t>(OutFile, DREYEVR_FRAME_INDEX_VERSION);
+    WriteValue<uint32_t>(OutFile, NumFrames);
+    for (const DReyeVRFrameIndexEntry &Entry : Entries)
+    {
+        WriteValue<uint64_t>(OutFile, Entry.FrameId);
+        WriteValue<double>(OutFile, Entry.Elapsed);
+        WriteValue<uint64_t>(OutFile, Entry.Offset);
+    }
+    WriteValue<uint32_t>(OutFile, NumKeyframes);
+    for (const DReyeVRKeyframeEntry &Keyframe : Keyframes)
+    {
+        WriteValue<uint32_t>(OutFile, Keyframe.FrameNumber);
+        WriteValue<uint64_t>(OutFile, Keyframe.Offset);
+    }
+    // footer
+    WriteValue<uint64_t>(OutFile, PacketOffset);
+    OutFile.write(DREYEVR_FRAME_INDEX_MAGIC, 8);
+}
+
+bool DReyeVRFrameIndex::Load(std::ifstream &InFile)
+{
+    Clear();
+    const std::streampos Current = InFile.tellg();
+    constexpr uint64_t FooterSize = sizeof(uint64_t) + 8;
+
+    bool bSuccess = false;
+    InFile.clear();
+    InFile.seekg(0, std::ios::end);
+    const uint64_t FileSize = static_cast<uint64_t>(InFile.tellg());
+    if (InFile && FileSize > FooterSize)
+    {
+        uint64_t PacketOffset = 0;
+        char Magic[8];
+        InFile.seekg(FileSize - FooterSize, std::ios::beg);
+        ReadValue<uint64_t>(InFile, PacketOffset);
+        InFile.read(Magic, 8);
+        if (InFile && std::memcmp(Magic, DREYEVR_FRAME_INDEX_MAGIC, 8) == 0 && PacketOffset < FileSize)
+        {
+            char Id = 0;
+            uint32_t Size = 0;
+            uint16_t FileVersion = 0;
+            uint32_t NumFrames = 0;
+            InFile.seekg(PacketOffset, std::ios::beg);
+            ReadValue<char>(InFile, Id);
+            ReadValue<uint32_t>(InFile, Size);
+            ReadValue<uint16_t>(InFile, FileVersion);
+            ReadValue<uint32_t>(InFile, NumFrames);
+            const bool bValid = InFile && Id == static_cast<char>(DREYEVR_FRAME_INDEX_PACKET_ID) &&
+                                PacketOffset + sizeof(char) + sizeof(uint32_t) + Size == FileSize &&
+                                FileVersion >= 1;
+            if (bValid)
+            {
+                Entries.resize(NumFrames);
+                for (DReyeVRFrameIndexEntry &Entry : Entries)
+                {
+                    ReadValue<uint64_t>(InFile, Entry.FrameId);
+                    ReadValue<double>(InFile, Entry.Elapsed);
+                    ReadValue<uint64_t>(InFile, Entry.Offset);
+                }
+                if (FileVersion >= 2)
+                {
+                    uint32_t NumKeyframes = 0;
+                    ReadValue<uint32_t>(InFile, NumKeyframes);
+                    Keyframes.resize(InFile ? NumKeyframes : 0);
+                    for (DReyeVRKeyframeEntry &Keyframe : Keyframes)
+                    {
+                        ReadValue<uint32_t>(InFile, Keyframe.FrameNumber);
+                        ReadValue<uint64_t>(InFile, Keyframe.Offset);
+                        if (Keyframe.FrameNumber >= NumFrames)
+                            InFile.setstate(std::ios::failbit); // corrupt index
+                    }
+                }
+                bSuccess = static_cast<bool>(InFile);
+            }
+        }
+    }
+    if (!bSuccess)
+        Clear();
+
+    // return to the original position
+    InFile.clear();
+    InFile.seekg(Current, std::ios::beg);
+    return bSuccess;
+}
+
+double DReyeVRFrameIndex::GetTotalTime() const
+{
+    return Entries.empty() ? 0.0 : Entries.back().Elapsed;
+}
+
+size_t DReyeVRFrameIndex::FindFrame(double Time) const
+{
+    auto It = std::upper_bound(Entries.begin(), Entries.end(), Time,
+                               [](double T, const DReyeVRFrameIndexEntry &E) { return T < E.Elapsed; });
+    return (It == Entries.begin()) ? 0 : static_cast<size_t>(std::distance(Entries.begin(), It) - 1);
+}
+
+size_t DReyeVRFrameIndex::FindFirstFrameAfter(double Time) const
+{
+    auto It = std::lower_bound(Entries.begin(), Entries.end(), Time,
+                               [](const DReyeVRFrameIndexEntry &E, double T) { return E.Elapsed < T; });
+    return static_cast<size_t>(std::distance(Entries.begin(), It));
+}
+
+const DReyeVRKeyframeEntry *DReyeVRFrameIndex::FindKeyframe(double Time) const
+{
+    auto It = std::upper_bound(Keyframes.begin(), Keyframes.end(), Time,
+                               [this](double T, const DReyeVRKeyframeEntry &K) {
+                                   return T < Entries[K.FrameNumber].Elapsed;
+                               });
+    return (It == Keyframes.begin()) ? nullptr : &(*std::prev(It));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint> // uint64_t
+#include <fstream> // std::ofstream, std::ifstream
+#include <vector>  // std::vector
+
+// Frame offset index, written as a trailing packet by ACarlaRecorder::Stop
+//
+// The packet is a regular (Id, Size) packet so older readers simply skip it. It ends with a fixed footer
+// (absolute offset of the packet + magic) so readers can locate it from the end of the file without
+// scanning. Recordings without the footer (older or interrupted recordings) fall back to a linear scan.
+//
+//   char     Id = DREYEVR_FRAME_INDEX_PACKET_ID
+//   uint32   Size (of everything below)
+//   uint16   Version
+//   uint32   NumFrames
+//   NumFrames x { uint64 FrameId, double Elapsed, uint64 Offset (of the FrameStart packet) }
+//   uint32   NumKeyframes (version >= 2)
+//   NumKeyframes x { uint32 FrameNumber (into the frames above), uint64 Offset (of the keyframe packet) }
+//   uint64   Offset of this packet (footer)
+//   char[8]  DREYEVR_FRAME_INDEX_MAGIC (footer)
+
+#define DREYEVR_FRAME_INDEX_PACKET_ID 142
+#define DREYEVR_FRAME_INDEX_MAGIC "DRVRIDX1"
+#define DREYEVR_FRAME_INDEX_VERSION 2
+
+struct DReyeVRFrameIndexEntry
+{
+    uint64_t FrameId;
+    double Elapsed;  // start time of the frame (same as CarlaRecorderFrame::Elapsed)
+    uint64_t Offset; // absolute file offset of the FrameStart packet
+};
+
+struct DReyeVRKeyframeEntry
+{
+    uint32_t FrameNumber; // index into the frame entries of the frame containing this keyframe
+    uint64_t Offset;      // absolute file offset of the keyframe packet
+};
+
+class DReyeVRFrameIndex
+{
+  public:
+    void Clear();
+
+    // mirrors CarlaRecorderFrames::SetFrame so the index matches the recorded frame ids/times exactly
+    void AddFrame(double DeltaSeconds, uint64_t Offset);
+
+    // for indices rebuilt by scanning a recording (that was written without one)
+    void AddFrame(const DReyeVRFrameIndexEntry &Entry);
+
+    // marks a keyframe packet (at Offset) in the last added frame
+    void AddKeyframe(uint64_t Offset);
+
+    // writes the index packet (and footer) at the current position of the stream
+    void Write(std::ofstream &OutFile) const;
+
+    // reads the index from the end of the file, the read position of InFile is restored afterwards
+    bool Load(std::ifstream &InFile);
+
+    bool IsEmpty() const
+    {
+        return Entries.empty();
+    }
+
+    size_t Num() const
+    {
+        return Entries.size();
+    }
+
+    const std::vector<DReyeVRFrameIndexEntry> &GetEntries() const
+    {
+        return Entries;
+    }
+
+    const std::vector<DReyeVRKeyframeEntry> &GetKeyframes() const
+    {
+        return Keyframes;
+    }
+
+    // start time of the last frame (what CarlaReplayer::GetTotalTime used to compute by scanning)
+    double GetTotalTime() const;
+
+    // index of the frame containing Time (last frame starting at or before Time), O(log n)
+    size_t FindFrame(double Time) const;
+
+    // index of the first frame starting at or after Time, O(log n)
+    size_t FindFirstFrameAfter(double Time) const;
+
+    // last keyframe whose frame starts at or before Time (nullptr if none), O(log n)
+    const DReyeVRKeyframeEntry *FindKeyframe(double Time) const;
+
+  private:
+    std::vector<DReyeVRFrameIndexEntry> Entries;
+    std::vector<DReyeVRKeyframeEntry> Keyframes;
+    uint64_t NextFrameId = 0;
+    double NextElapsed = 0.0;
+};
@@ -0,0 +1,43 @@
+#include "DReyeVRRecorderReader.h"
+
+#include "Async/MappedFileHandle.h"  // IMappedFileHandle, IMappedFileRegion
+#include "HAL/PlatformFilemanager.h" // FPlatformFileManager
+
+struct DReyeVRMappedRecording::FMapping
+{
+    TUniquePtr<IMappedFileHandle> Handle;
+    TUniquePtr<IMappedFileRegion> Region; // (declared last so it is released before the handle)
+};
+
+DReyeVRMappedRecording::DReyeVRMappedRecording() = default;
+
+DReyeVRMappedRecording::~DReyeVRMappedRecording() = default; // (streams are detached by their owners on close)
+
+bool DReyeVRMappedRecording::Open(const std::string &Filename, std::istream &Stream)
+{
+    Close(Stream);
+
+    IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    auto NewMapping = std::make_unique<FMapping>();
+    NewMapping->Handle.Reset(PlatformFile.OpenMapped(UTF8_TO_TCHAR(Filename.c_str())));
+    if (!NewMapping->Handle.IsValid() || NewMapping->Handle->GetFileSize() <= 0)
+        return false; // (not supported on this platform, or nothing to map)
+    NewMapping->Region.Reset(NewMapping->Handle->MapRegion(0, NewMapping->Handle->GetFileSize()));
+    if (!NewMapping->Region.IsValid())
+        return false;
+
+    Mapping = std::move(NewMapping);
+    Buffer.Reset(reinterpret_cast<const char *>(Mapping->Region->GetMappedPtr()),
+                 static_cast<size_t>(Mapping->Region->GetMappedSize()));
+    Buffer.Attach(Stream);
+    return true;
+}
+
+void DReyeVRMappedRecording::Close(std::istream &Stream)
+{
+    if (!IsOpen())
+        return;
+    Buffer.Detach(Stream);
+    Buffer.Reset();
+    Mapping.reset();
+}
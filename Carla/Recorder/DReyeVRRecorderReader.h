@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm> // std::min
+#include <cstdint>   // uint64_t
+#include <cstring>   // std::memcpy
+#include <istream>   // std::istream
+#include <memory>    // std::unique_ptr
+#include <streambuf> // std::streambuf
+#include <string>    // std::string
+
+// Memory mapped recording reads (see [Replayer] MemoryMappedReads in DReyeVRConfig.ini)
+//
+// Every packet reader takes the std::ifstream of the replayer/query, so rather than rewriting all of them the
+// mapped file is exposed to them as the stream buffer of that same ifstream. The get area of the buffer is the
+// whole mapping, so ReadValue (which goes straight to the stream buffer) becomes a bounds-checked memcpy with no
+// file system reads, and seeks are pointer arithmetic. Strings can be read as views into the mapping and are only
+// copied when converted (see ReadFString).
+
+// non-owning view of bytes in the recording (valid while the mapping, or the stream scratch buffer, is alive)
+struct DReyeVRStringView
+{
+    const char *Data = nullptr;
+    size_t Length = 0;
+
+    std::string ToString() const
+    {
+        return std::string(Data, Length);
+    }
+};
+
+// read-only stream buffer over bytes that are already in memory (the mapped recording)
+class DReyeVRMappedBuffer : public std::streambuf
+{
+  public:
+    void Reset(const char *Data = nullptr, size_t Size = 0)
+    {
+        char *Begin = const_cast<char *>(Data); // the get area is never written to
+        setg(Begin, Begin, Begin + Size);
+    }
+
+    const char *Data() const
+    {
+        return eback();
+    }
+
+    size_t Size() const
+    {
+        return static_cast<size_t>(egptr() - eback());
+    }
+
+    uint64_t GetPosition() const
+    {
+        return static_cast<uint64_t>(gptr() - eback());
+    }
+
+    // zero-copy access to the next Count bytes (advances the read position), nullptr if fewer are left
+    const char *ReadView(size_t Count)
+    {
+        if (static_cast<size_t>(egptr() - gptr()) < Count)
+            return nullptr;
+        const char *View = gptr();
+        setg(eback(), gptr() + Count, egptr());
+        return View;
+    }
+
+    // replaces the buffer of Stream with this one (tagging the stream so Find can get back to it)
+    void Attach(std::istream &Stream)
+    {
+        OriginalBuffer = Stream.rdbuf(this);
+        Stream.pword(StreamIndex()) = this;
+    }
+
+    // returns Stream to the buffer it had before Attach
+    void Detach(std::istream &Stream)
+    {
+        if (Stream.pword(StreamIndex()) != this)
+            return;
+        Stream.pword(StreamIndex()) = nullptr;
+        Stream.rdbuf(OriginalBuffer);
+        OriginalBuffer = nullptr;
+    }
+
+    // the mapped buffer attached to Stream (nullptr for regular file streams), no RTTI needed
+    static DReyeVRMappedBuffer *Find(std::ios_base &Stream)
+    {
+        return static_cast<DReyeVRMappedBuffer *>(Stream.pword(StreamIndex()));
+    }
+
+  protected:
+    std::streamsize xsgetn(char *Out, std::streamsize Count) override
+    {
+        const std::streamsize Num = std::min<std::streamsize>(Count, egptr() - gptr());
+        std::memcpy(Out, gptr(), static_cast<size_t>(Num));
+        setg(eback(), gptr() + Num, egptr()); // (gbump takes an int, mappings can be larger)
+        return Num;
+    }
+
+    int_type underflow() override
+    {
+        return gptr() < egptr() ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+    }
+
+    std::streamsize showmanyc() override
+    {
+        return gptr() < egptr() ? egptr() - gptr() : -1;
+    }
+
+    pos_type seekoff(off_type Off, std::ios_base::seekdir Dir, std::ios_base::openmode Which) override
+    {
+        off_type Target = Off;
+        if (Dir == std::ios_base::cur)
+            Target += gptr() - eback();
+        else if (Dir == std::ios_base::end)
+            Target += egptr() - eback();
+        return seekpos(pos_type(Target), Which);
+    }
+
+    pos_type seekpos(pos_type Pos, std::ios_base::openmode Which) override
+    {
+        const off_type Target = static_cast<off_type>(Pos);
+        if (!(Which & std::ios_base::in) || Target < 0 || Target > egptr() - eback())
+            return pos_type(off_type(-1));
+        setg(eback(), eback() + Target, egptr());
+        return Pos;
+    }
+
+  private:
+    static int StreamIndex()
+    {
+        static const int Index = std::ios_base::xalloc();
+        return Index;
+    }
+
+    std::streambuf *OriginalBuffer = nullptr;
+};
+
+// same result as InStream.read(Out, Count) but straight to the stream buffer (no sentry per field), so reading
+// from a mapped recording is a single memcpy
+inline void DReyeVRReadBytes(std::istream &InStream, char *Out, size_t Count)
+{
+    if (!InStream.good())
+    {
+        InStream.setstate(std::ios::failbit);
+        return;
+    }
+    const std::streamsize Num = static_cast<std::streamsize>(Count);
+    if (InStream.rdbuf()->sgetn(Out, Num) != Num)
+        InStream.setstate(std::ios::eofbit | std::ios::failbit);
+}
+
+// reads Length bytes as a view: into the mapping if InStream is mapped, otherwise into Scratch
+inline bool DReyeVRReadView(std::istream &InStream, size_t Length, std::string &Scratch, DReyeVRStringView &OutView)
+{
+    DReyeVRMappedBuffer *Mapped = DReyeVRMappedBuffer::Find(InStream);
+    if (Mapped != nullptr && InStream.good())
+    {
+        OutView.Data = Mapped->ReadView(Length);
+        OutView.Length = Length;
+        if (OutView.Data == nullptr)
+            InStream.setstate(std::ios::eofbit | std::ios::failbit);
+    }
+    else
+    {
+        Scratch.resize(Length);
+        DReyeVRReadBytes(InStream, &Scratch[0], Length);
+        OutView.Data = Scratch.data();
+        OutView.Length = Length;
+    }
+    return InStream.good();
+}
+
+// reads a recorded string (uint16 length + UTF-8 text, as WriteFString) as a view. For regular streams the text is
+// copied into a buffer of the calling thread, since the query workers parse their chunks concurrently (the view is
+// valid until the next string this thread reads)
+inline bool DReyeVRReadString(std::istream &InStream, DReyeVRStringView &OutView)
+{
+    static thread_local std::string Scratch;
+    uint16_t Length = 0;
+    DReyeVRReadBytes(InStream, reinterpret_cast<char *>(&Length), sizeof(Length));
+    return InStream.good() && DReyeVRReadView(InStream, Length, Scratch, OutView);
+}
+
+// read-only memory mapping of a recording, attached to the ifstream of a replayer/query
+class DReyeVRMappedRecording
+{
+  public:
+    DReyeVRMappedRecording();
+    ~DReyeVRMappedRecording();
+    DReyeVRMappedRecording(const DReyeVRMappedRecording &) = delete;
+    DReyeVRMappedRecording &operator=(const DReyeVRMappedRecording &) = delete;
+
+    // maps Filename and attaches it to Stream (which should already be open), false if it could not be mapped
+    bool Open(const std::string &Filename, std::istream &Stream);
+
+    // detaches from Stream and unmaps the file
+    void Close(std::istream &Stream);
+
+    bool IsOpen() const
+    {
+        return Mapping != nullptr;
+    }
+
+  private:
+    struct FMapping; // platform file mapping (see DReyeVRRecorderReader.cpp)
+    std::unique_ptr<FMapping> Mapping;
+    DReyeVRMappedBuffer Buffer;
+};
@@ -0,0 +1,195 @@
+#include "DReyeVRRecorderWriter.h"
+
+#include <algorithm> // std::min
+#include <cstring>   // std::memcpy
+#include <limits>    // std::numeric_limits
+
+/// ========================================== ///
+/// ------------:DReyeVRFrameBuffer:---------- ///
+/// ========================================== ///
+
+void DReyeVRFrameBuffer::Reset(uint64_t NewBaseOffset)
+{
+    Bytes.clear();
+    BaseOffset = NewBaseOffset;
+    Cursor = 0;
+}
+
+void DReyeVRFrameBuffer::Extract(uint64_t UpTo, std::vector<char> &Out)
+{
+    const size_t Num = static_cast<size_t>(std::min<uint64_t>(UpTo > BaseOffset ? UpTo - BaseOffset : 0, Bytes.size()));
+    // swap so the (large) committed bytes change hands without a copy, then move the (small) tail back
+    Out.clear();
+    std::swap(Out, Bytes);
+    Bytes.assign(Out.begin() + Num, Out.end());
+    Out.resize(Num);
+    BaseOffset += Num;
+    Cursor = (Cursor > Num) ? Cursor - Num : 0;
+}
+
+std::streamsize DReyeVRFrameBuffer::xsputn(const char *Data, std::streamsize Count)
+{
+    const size_t End = Cursor + static_cast<size_t>(Count);
+    if (End > Bytes.size())
+        Bytes.resize(End);
+    std::memcpy(Bytes.data() + Cursor, Data, static_cast<size_t>(Count));
+    Cursor = End;
+    return Count;
+}
+
+DReyeVRFrameBuffer::int_type DReyeVRFrameBuffer::overflow(int_type Ch)
+{
+    if (traits_type::eq_int_type(Ch, traits_type::eof()))
+        return traits_type::not_eof(Ch);
+    const char C = traits_type::to_char_type(Ch);
+    xsputn(&C, 1);
+    return Ch;
+}
+
+DReyeVRFrameBuffer::pos_type DReyeVRFrameBuffer::seekoff(off_type Off, std::ios_base::seekdir Dir,
+                                                         std::ios_base::openmode Which)
+{
+    int64_t Target = Off;
+    if (Dir == std::ios_base::cur)
+        Target += static_cast<int64_t>(GetPosition());
+    else if (Dir == std::ios_base::end)
+        Target += static_cast<int64_t>(BaseOffset + Bytes.size());
+    return seekpos(pos_type(static_cast<off_type>(Target)), Which);
+}
+
+DReyeVRFrameBuffer::pos_type DReyeVRFrameBuffer::seekpos(pos_type Pos, std::ios_base::openmode Which)
+{
+    const int64_t Target = static_cast<int64_t>(static_cast<off_type>(Pos));
+    // can only seek within what has not been handed to the writer yet
+    if (!(Which & std::ios_base::out) || Target < static_cast<int64_t>(BaseOffset) ||
+        Target > static_cast<int64_t>(BaseOffset + Bytes.size()))
+        return pos_type(off_type(-1));
+    Cursor = static_cast<size_t>(Target - static_cast<int64_t>(BaseOffset));
+    return Pos;
+}
+
+/// ========================================== ///
+/// -----------:DReyeVRRecorderWriter:-------- ///
+/// ========================================== ///
+
+DReyeVRRecorderWriter::~DReyeVRRecorderWriter()
+{
+    if (IsOpen())
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            bExit = true;
+        }
+        QueueCV.notify_all();
+        WriterThread.join();
+    }
+}
+
+bool DReyeVRRecorderWriter::Open(const std::string &Filename, std::ostream &Stream, size_t NumBuffers)
+{
+    if (IsOpen())
+        Close(Stream);
+
+    OutFile.open(Filename, std::ios::binary);
+    if (!OutFile.is_open())
+        return false;
+
+    FrameBuffer.Reset(0);
+    Pending.clear();
+    Free.clear();
+    Free.resize(std::max<size_t>(NumBuffers, 1));
+    Stats = DReyeVRRecorderWriterStats{};
+    bExit = false;
+
+    // the recorder keeps writing to Stream as before, but now all of it lands in memory
+    OriginalBuffer = Stream.rdbuf(&FrameBuffer);
+    WriterThread = std::thread(&DReyeVRRecorderWriter::WriterLoop, this);
+    return true;
+}
+
+void DReyeVRRecorderWriter::Commit(uint64_t UpTo)
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    if (Free.empty())
+    {
+        // writer is behind by every back buffer, wait rather than grow memory without bound
+        Stats.FramesStalled++;
+        const auto StallStart = std::chrono::steady_clock::now();
+        FreeCV.wait(Lock, [this] { return !Free.empty(); });
+        Stats.StallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - StallStart).count();
+    }
+    std::vector<char> Back = std::move(Free.front());
+    Free.pop_front();
+    Lock.unlock();
+
+    FrameBuffer.Extract(UpTo, Back); // outside the lock, the writer thread never touches the front buffer
+
+    Lock.lock();
+    Pending.push_back(std::move(Back));
+    Stats.FramesQueued++;
+    Stats.QueueDepth = Pending.size();
+    Stats.MaxQueueDepth = std::max(Stats.MaxQueueDepth, Stats.QueueDepth);
+    Lock.unlock();
+    QueueCV.notify_one();
+}
+
+void DReyeVRRecorderWriter::Close(std::ostream &Stream)
+{
+    if (!IsOpen())
+        return;
+    Stream.flush();
+    Commit(std::numeric_limits<uint64_t>::max()); // everything that is left
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bExit = true;
+    }
+    QueueCV.notify_all();
+    WriterThread.join();
+    OutFile.close();
+    Stream.rdbuf(OriginalBuffer);
+    OriginalBuffer = nullptr;
+    FrameBuffer.Reset(0);
+}
+
+DReyeVRRecorderWriterStats DReyeVRRecorderWriter::GetStats() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Stats;
+}
+
+void DReyeVRRecorderWriter::WriterLoop()
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    while (true)
+    {
+        QueueCV.wait(Lock, [this] { return bExit || !Pending.empty(); });
+        if (Pending.empty()) // only exit once the queue is drained
+            break;
+        std::vector<char> Back = std::move(Pending.front());
+        Pending.pop_front();
+        Stats.QueueDepth = Pending.size();
+        Lock.unlock();
+
+        bool bWritten = true;
+        if (!Back.empty())
+        {
+            OutFile.write(Back.data(), static_cast<std::streamsize>(Back.size()));
+            bWritten = OutFile.good();
+            OutFile.clear(); // keep trying on the next frame
+        }
+
+        Lock.lock();
+        if (bWritten)
+        {
+            Stats.FramesWritten++;
+            Stats.BytesWritten += Back.size();
+        }
+        else
+        {
+            Stats.FramesDropped++;
+        }
+        Back.clear(); // keeps capacity for the next frame
+        Free.push_back(std::move(Back));
+        FreeCV.notify_one();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>             // stall timing
+#include <condition_variable> // std::condition_variable
+#include <cstdint>            // uint64_t
+#include <deque>              // std::deque
+#include <fstream>            // std::ofstream
+#include <mutex>              // std::mutex
+#include <streambuf>          // std::streambuf
+#include <string>             // std::string
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+// Asynchronous recorder output (see [Recorder] AsyncWrite in DReyeVRConfig.ini)
+//
+// The recorder serializes every packet into an in-memory DReyeVRFrameBuffer instead of the file, which keeps
+// all the tellp/seekp size-patching of the packet writers working unchanged. Once a frame can no longer be
+// patched (the next FrameStart has updated its duration) its bytes are handed to a writer thread through a
+// bounded pool of back buffers (double/triple buffering), so the game thread never touches the disk.
+
+// seekable, growable in-memory output buffer whose positions are absolute file offsets
+class DReyeVRFrameBuffer : public std::streambuf
+{
+  public:
+    void Reset(uint64_t NewBaseOffset = 0);
+
+    // absolute file offset of the next byte to be written
+    uint64_t GetPosition() const
+    {
+        return BaseOffset + Cursor;
+    }
+
+    // moves all bytes before the absolute offset UpTo into Out (reusing Out's capacity), keeps the rest buffered
+    void Extract(uint64_t UpTo, std::vector<char> &Out);
+
+    size_t Size() const
+    {
+        return Bytes.size();
+    }
+
+  protected:
+    std::streamsize xsputn(const char *Data, std::streamsize Count) override;
+    int_type overflow(int_type Ch) override;
+    pos_type seekoff(off_type Off, std::ios_base::seekdir Dir, std::ios_base::openmode Which) override;
+    pos_type seekpos(pos_type Pos, std::ios_base::openmode Which) override;
+
+  private:
+    std::vector<char> Bytes; // not-yet-committed bytes, Bytes[0] lives at file offset BaseOffset
+    uint64_t BaseOffset = 0;
+    size_t Cursor = 0; // write position relative to BaseOffset
+};
+
+struct DReyeVRRecorderWriterStats
+{
+    uint64_t FramesQueued = 0;  // frames handed off to the writer thread
+    uint64_t FramesWritten = 0; // frames that reached the disk
+    uint64_t FramesDropped = 0; // frames lost to a failed disk write
+    uint64_t FramesStalled = 0; // frames where the game thread had to wait for a free buffer
+    double StallSeconds = 0.0;  // total time the game thread spent waiting
+    size_t MaxQueueDepth = 0;   // maximum number of buffers waiting to be written
+    size_t QueueDepth = 0;      // number of buffers currently waiting to be written
+    uint64_t BytesWritten = 0;
+};
+
+class DReyeVRRecorderWriter
+{
+  public:
+    DReyeVRRecorderWriter() = default;
+    ~DReyeVRRecorderWriter();
+    DReyeVRRecorderWriter(const DReyeVRRecorderWriter &) = delete;
+    DReyeVRRecorderWriter &operator=(const DReyeVRRecorderWriter &) = delete;
+
+    // opens Filename for the writer thread and redirects Stream into the in-memory frame buffer
+    bool Open(const std::string &Filename, std::ostream &Stream, size_t NumBuffers);
+
+    // hands off every buffered byte before the absolute offset UpTo (blocks if all back buffers are in use)
+    void Commit(uint64_t UpTo);
+
+    // flushes everything to disk, joins the writer thread, and returns Stream to its original buffer
+    void Close(std::ostream &Stream);
+
+    bool IsOpen() const
+    {
+        return WriterThread.joinable();
+    }
+
+    uint64_t GetPosition() const
+    {
+        return FrameBuffer.GetPosition();
+    }
+
+    DReyeVRRecorderWriterStats GetStats() const;
+
+  private:
+    void WriterLoop();
+
+    DReyeVRFrameBuffer FrameBuffer; // front buffer (game thread only)
+    std::streambuf *OriginalBuffer = nullptr;
+
+    std::ofstream OutFile; // writer thread only (after Open)
+    std::thread WriterThread;
+
+    mutable std::mutex Mutex;
+    std::condition_variable QueueCV; // signals the writer thread that there is work (or to exit)
+    std::condition_variable FreeCV;  // signals the game thread that a back buffer was released
+    std::deque<std::vector<char>> Pending;
+    std::deque<std::vector<char>> Free;
+    bool bExit = false;
+    DReyeVRRecorderWriterStats Stats;
+};
@@ -200,6 +200,160 @@ FString FocusInfo::ToString() const
     return Print;
 }
 
+void GazeTraces::Read(std::ifstream &InFile)
+{
+    ReadValue<uint64_t>(InFile, IssuedFrame);
+    ReadValue<uint64_t>(InFile, ConsumedFrame);
+    ReadValue<bool>(InFile, bAsync);
+    Left.Read(InFile);
+    Right.Read(InFile);
+}
+
+void GazeTraces::Write(std::ofstream &OutFile) const
+{
+    WriteValue<uint64_t>(OutFile, IssuedFrame);
+    WriteValue<uint64_t>(OutFile, ConsumedFrame);
+    WriteValue<bool>(OutFile, bAsync);
+    Left.Write(OutFile);
+    Right.Write(OutFile);
+}
+
+FString GazeTraces::ToString() const
+{
+    FString Print;
+    Print += FString::Printf(TEXT("IssuedFrame:%llu,"), static_cast<unsigned long long>(IssuedFrame));
+    Print += FString::Printf(TEXT("ConsumedFrame:%llu,"), static_cast<unsigned long long>(ConsumedFrame));
+    Print += FString::Printf(TEXT("Async:%d,"), bAsync);
+    Print += FString::Printf(TEXT("Left:{%s},"), *Left.ToString());
+    Print += FString::Printf(TEXT("Right:{%s},"), *Right.ToString());
+    return Print;
+}
+
+void FixationEvent::Read(std::ifstream &InFile)
+{
+    ReadValue<bool>(InFile, bStart);
+    ReadValue<int64_t>(InFile, Start);
+    ReadValue<int64_t>(InFile, End);
+    ReadFVector2D(InFile, Direction);
+    ReadFString(InFile, ActorNameTag);
+}
+
+void FixationEvent::Write(std::ofstream &OutFile) const
+{
+    WriteValue<bool>(OutFile, bStart);
+    WriteValue<int64_t>(OutFile, Start);
+    WriteValue<int64_t>(OutFile, End);
+    WriteFVector2D(OutFile, Direction);
+    WriteFString(OutFile, ActorNameTag);
+}
+
+FString FixationEvent::ToString() const
+{
+    FString Print;
+    Print += FString::Printf(TEXT("%s:%ld-%ld,"), bStart ? TEXT("Start") : TEXT("End"), long(Start), long(End));
+    Print += FString::Printf(TEXT("Direction:%s,"), *Direction.ToString());
+    Print += FString::Printf(TEXT("ActorName:%s,"), *ActorNameTag);
+    return Print;
+}
+
+void FixationData::Read(std::ifstream &InFile)
+{
+    ReadValue<bool>(InFile, bFixating);
+    Current.Read(InFile);
+    uint32_t NumEvents = 0;
+    ReadValue<uint32_t>(InFile, NumEvents);
+    Events.SetNum(NumEvents);
+    for (FixationEvent &Event : Events)
+        Event.Read(InFile);
+}
+
+void FixationData::Write(std::ofstream &OutFile) const
+{
+    WriteValue<bool>(OutFile, bFixating);
+    Current.Write(OutFile);
+    WriteValue<uint32_t>(OutFile, static_cast<uint32_t>(Events.Num()));
+    for (const FixationEvent &Event : Events)
+        Event.Write(OutFile);
+}
+
+FString FixationData::ToString() const
+{
+    FString Print;
+    Print += FString::Printf(TEXT("Fixating:%d,"), bFixating);
+    Print += FString::Printf(TEXT("Current:{%s},"), *Current.ToString());
+    for (const FixationEvent &Event : Events)
+        Print += FString::Printf(TEXT("Event:{%s},"), *Event.ToString());
+    return Print;
+}
+
+/// ========================================== ///
+/// -----------------:DWELL:------------------ ///
+/// ========================================== ///
+
+void DwellData::Set(const DReyeVRDwellAccumulator &Dwell)
+{
+    const std::vector<DReyeVRDwellStats> &All = Dwell.GetAll();
+    Actors.SetNum(static_cast<int32>(All.size()));
+    for (int32 i = 0; i < Actors.Num(); i++)
+        Actors[i] = All[i];
+    UntrackedDwell = Dwell.GetUntrackedDwell();
+    DroppedDwell = Dwell.GetDroppedDwell();
+    NumDroppedActors = Dwell.GetNumDroppedActors();
+}
+
+void DwellData::Read(std::ifstream &InFile)
+{
+    ReadValue<int64_t>(InFile, UntrackedDwell);
+    ReadValue<int64_t>(InFile, DroppedDwell);
+    ReadValue<uint64_t>(InFile, NumDroppedActors);
+    uint32_t NumActors = 0;
+    ReadValue<uint32_t>(InFile, NumActors);
+    Actors.SetNum(NumActors);
+    for (DReyeVRDwellStats &Stats : Actors)
+    {
+        ReadValue<uint32_t>(InFile, Stats.ActorId);
+        ReadValue<uint32_t>(InFile, Stats.NumGlances);
+        ReadValue<uint32_t>(InFile, Stats.NumFixations);
+        ReadValue<int64_t>(InFile, Stats.TotalDwell);
+        ReadValue<int64_t>(InFile, Stats.FirstGlance);
+        ReadValue<int64_t>(InFile, Stats.FirstFixation);
+        ReadValue<int64_t>(InFile, Stats.LastGlance);
+        ReadValue<int64_t>(InFile, Stats.LongestGlance);
+    }
+}
+
+void DwellData::Write(std::ofstream &OutFile) const
+{
+    WriteValue<int64_t>(OutFile, UntrackedDwell);
+    WriteValue<int64_t>(OutFile, DroppedDwell);
+    WriteValue<uint64_t>(OutFile, NumDroppedActors);
+    WriteValue<uint32_t>(OutFile, static_cast<uint32_t>(Actors.Num()));
+    for (const DReyeVRDwellStats &Stats : Actors)
+    {
+        WriteValue<uint32_t>(OutFile, Stats.ActorId);
+        WriteValue<uint32_t>(OutFile, Stats.NumGlances);
+        WriteValue<uint32_t>(OutFile, Stats.NumFixations);
+        WriteValue<int64_t>(OutFile, Stats.TotalDwell);
+        WriteValue<int64_t>(OutFile, Stats.FirstGlance);
+        WriteValue<int64_t>(OutFile, Stats.FirstFixation);
+        WriteValue<int64_t>(OutFile, Stats.LastGlance);
+        WriteValue<int64_t>(OutFile, Stats.LongestGlance);
+    }
+}
+
+FString DwellData::ToString() const
+{
+    FString Print;
+    Print += FString::Printf(TEXT("Untracked:%ld,Dropped:%ld (%lu actors),"), long(UntrackedDwell), long(DroppedDwell),
+                             static_cast<unsigned long>(NumDroppedActors));
+    for (const DReyeVRDwellStats &Stats : Actors)
+        Print += FString::Printf(TEXT("Actor:{Id:%u,Dwell:%ld,Glances:%u,Fixations:%u,FirstGlance:%ld,"
+                                      "FirstFixation:%ld,LongestGlance:%ld},"),
+                                 Stats.ActorId, long(Stats.TotalDwell), Stats.NumGlances, Stats.NumFixations,
+                                 long(Stats.FirstGlance), long(Stats.FirstFixation), long(Stats.LongestGlance));
+    return Print;
+}
+
 /// ========================================== ///
 /// ---------------:EYETRACKER:--------------- ///
 /// ========================================== ///
@@ -448,6 +602,11 @@ const DReyeVR::UserInputs &AggregateData::GetUserInputs() const
     return Inputs;
 }
 
+const DReyeVR::FixationData &AggregateData::GetFixations() const
+{
+    return Fixations;
+}
+
 void AggregateData::UpdateCamera(const FVector &NewCameraLoc, const FRotator &NewCameraRot)
 {
     EgoVars.CameraLocation = NewCameraLoc;
@@ -477,6 +636,11 @@ void AggregateData::Update(int64_t NewTimestamp, const struct EyeTracker &NewEye
     Inputs = NewInputs;
 }
 
+void AggregateData::UpdateFixations(const struct FixationData &NewFixations)
+{
+    Fixations = NewFixations;
+}
+
 void AggregateData::Read(std::ifstream &InFile)
 {
     /// CAUTION: make sure the order of writes/reads is the same
@@ -497,6 +661,113 @@ void AggregateData::Write(std::ofstream &OutFile) const
     Inputs.Write(OutFile);
 }
 
+// (const) fields for the encoder, mutable fields for the decoder
+template <typename VecT, typename CodecT>
+static void VisitCompactVector(VecT &Vec, CodecT &Codec, DReyeVRCompactPrecision::Kind Kind)
+{
+    Codec.Float(Vec.X, Kind);
+    Codec.Float(Vec.Y, Kind);
+    Codec.Float(Vec.Z, Kind);
+}
+
+template <typename RotT, typename CodecT> static void VisitCompactRotator(RotT &Rot, CodecT &Codec)
+{
+    // same order as WriteFRotator
+    Codec.Float(Rot.Pitch, DReyeVRCompactPrecision::ROTATION);
+    Codec.Float(Rot.Roll, DReyeVRCompactPrecision::ROTATION);
+    Codec.Float(Rot.Yaw, DReyeVRCompactPrecision::ROTATION);
+}
+
+static void VisitCompactString(const FString &Str, DReyeVRFieldEncoder &Encoder)
+{
+    Encoder.String(std::string(TCHAR_TO_UTF8(*Str)));
+}
+
+static void VisitCompactString(FString &Str, DReyeVRFieldDecoder &Decoder)
+{
+    std::string Decoded;
+    Decoder.String(Decoded);
+    Str = FString(UTF8_TO_TCHAR(Decoded.c_str()));
+}
+
+template <typename EyeT, typename CodecT> static void VisitCompactEye(EyeT &Eye, CodecT &Codec)
+{
+    VisitCompactVector(Eye.GazeDir, Codec, DReyeVRCompactPrecision::UNIT);
+    VisitCompactVector(Eye.GazeOrigin, Codec, DReyeVRCompactPrecision::LOCATION);
+    Codec.Bool(Eye.GazeValid);
+}
+
+template <typename EyeT, typename CodecT> static void VisitCompactSingleEye(EyeT &Eye, CodecT &Codec)
+{
+    VisitCompactEye(Eye, Codec);
+    Codec.Float(Eye.EyeOpenness, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Eye.EyeOpennessValid);
+    Codec.Float(Eye.PupilDiameter, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Eye.PupilPosition.X, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Eye.PupilPosition.Y, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Eye.PupilPositionValid);
+}
+
+template <typename DataT, typename CodecT> void EyeTracker::VisitCompact(DataT &Data, CodecT &Codec)
+{
+    Codec.Int(Data.TimestampDevice);
+    Codec.Int(Data.FrameSequence);
+    VisitCompactEye(Data.Combined, Codec);
+    Codec.Float(Data.Combined.Vergence, DReyeVRCompactPrecision::LOCATION);
+    VisitCompactSingleEye(Data.Left, Codec);
+    VisitCompactSingleEye(Data.Right, Codec);
+}
+
+void EyeTracker::ReadCompact(DReyeVRFieldDecoder &Decoder)
+{
+    VisitCompact(*this, Decoder);
+}
+
+void EyeTracker::WriteCompact(DReyeVRFieldEncoder &Encoder) const
+{
+    VisitCompact(*this, Encoder);
+}
+
+template <typename DataT, typename CodecT> void AggregateData::VisitCompact(DataT &Data, CodecT &Codec)
+{
+    /// CAUTION: both the encoder and the decoder go through here, so they always agree on the field order
+    Codec.Int(Data.TimestampCarlaUE4);
+    // EgoVars
+    VisitCompactVector(Data.EgoVars.CameraLocation, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitCompactRotator(Data.EgoVars.CameraRotation, Codec);
+    VisitCompactVector(Data.EgoVars.CameraLocationAbs, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitCompactRotator(Data.EgoVars.CameraRotationAbs, Codec);
+    VisitCompactVector(Data.EgoVars.VehicleLocation, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitCompactRotator(Data.EgoVars.VehicleRotation, Codec);
+    Codec.Float(Data.EgoVars.Velocity, DReyeVRCompactPrecision::LOCATION);
+    // EyeTrackerData
+    EyeTracker::VisitCompact(Data.EyeTrackerData, Codec);
+    // FocusData
+    VisitCompactString(Data.FocusData.ActorNameTag, Codec);
+    Codec.Bool(Data.FocusData.bDidHit);
+    VisitCompactVector(Data.FocusData.HitPoint, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitCompactVector(Data.FocusData.Normal, Codec, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.FocusData.Distance, DReyeVRCompactPrecision::LOCATION);
+    // Inputs
+    Codec.Float(Data.Inputs.Throttle, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.Inputs.Steering, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.Inputs.Brake, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Data.Inputs.ToggledReverse);
+    Codec.Bool(Data.Inputs.TurnSignalLeft);
+    Codec.Bool(Data.Inputs.TurnSignalRight);
+    Codec.Bool(Data.Inputs.HoldHandbrake);
+}
+
+void AggregateData::ReadCompact(DReyeVRFieldDecoder &Decoder)
+{
+    VisitCompact(*this, Decoder);
+}
+
+void AggregateData::WriteCompact(DReyeVRFieldEncoder &Encoder) const
+{
+    VisitCompact(*this, Encoder);
+}
+
 FString AggregateData::ToString() const
 {
     FString print;
@@ -637,4 +908,238 @@ std::string CustomActorData::GetUniqueName() const
     return TCHAR_TO_UTF8(*Name);
 }
 
+// fields of an interned custom actor record (bitmask in front of every record)
+enum CustomActorField : uint32_t
+{
+    CA_LOCATION = 1 << 0,
+    CA_ROTATION = 1 << 1,
+    CA_SCALE3D = 1 << 2,
+    CA_MESH_PATH = 1 << 3,
+    CA_MATERIAL_SCALARS = 1 << 4, // Metallic, Specular, Roughness, Anisotropy, Opacity
+    CA_BASE_COLOR = 1 << 5,
+    CA_EMISSIVE = 1 << 6,
+    CA_MATERIAL_PATH = 1 << 7,
+    CA_OTHER = 1 << 8,
+    CA_ALL = (1 << 9) - 1,
+};
+
+static bool SameString(const FString &A, const FString &B)
+{
+    return A.Equals(B, ESearchCase::CaseSensitive); // (FString::operator== ignores case)
+}
+
+static void WriteInternedString(DReyeVRCompactWriter &Out, DReyeVRStringTableWriter &Strings, const FString &Str)
+{
+    Out.Varint(Strings.Intern(std::string(TCHAR_TO_UTF8(*Str))));
+}
+
+static bool ReadInternedString(DReyeVRCompactReader &In, const DReyeVRStringTableReader &Strings, FString &Str)
+{
+    const std::string *Interned = Strings.Get(In.Varint());
+    if (Interned == nullptr)
+        return false;
+    Str = FString(UTF8_TO_TCHAR(Interned->c_str()));
+    return true;
+}
+
+void CustomActorData::WriteInterned(DReyeVRCompactWriter &Out, DReyeVRStringTableWriter &Strings,
+                                    const CustomActorData *Prev) const
+{
+    const MaterialParamsStruct &Mat = MaterialParams;
+    uint32_t Changed = CA_ALL;
+    if (Prev != nullptr)
+    {
+        const MaterialParamsStruct &PrevMat = Prev->MaterialParams;
+        Changed = 0;
+        Changed |= (Location != Prev->Location) ? CA_LOCATION : 0;
+        Changed |= (Rotation != Prev->Rotation) ? CA_ROTATION : 0;
+        Changed |= (Scale3D != Prev->Scale3D) ? CA_SCALE3D : 0;
+        Changed |= !SameString(MeshPath, Prev->MeshPath) ? CA_MESH_PATH : 0;
+        const bool bSameScalars = Mat.Metallic == PrevMat.Metallic && Mat.Specular == PrevMat.Specular &&
+                                  Mat.Roughness == PrevMat.Roughness && Mat.Anisotropy == PrevMat.Anisotropy &&
+                                  Mat.Opacity == PrevMat.Opacity;
+        Changed |= !bSameScalars ? CA_MATERIAL_SCALARS : 0;
+        Changed |= (Mat.BaseColor != PrevMat.BaseColor) ? CA_BASE_COLOR : 0;
+        Changed |= (Mat.Emissive != PrevMat.Emissive) ? CA_EMISSIVE : 0;
+        Changed |= !SameString(Mat.MaterialPath, PrevMat.MaterialPath) ? CA_MATERIAL_PATH : 0;
+        Changed |= !SameString(Other, Prev->Other) ? CA_OTHER : 0;
+    }
+
+    Out.Varint(Changed);
+    if (Changed & CA_LOCATION)
+    {
+        Out.Raw<float>(Location.X);
+        Out.Raw<float>(Location.Y);
+        Out.Raw<float>(Location.Z);
+    }
+    if (Changed & CA_ROTATION)
+    {
+        // same order as WriteFRotator
+        Out.Raw<float>(Rotation.Pitch);
+        Out.Raw<float>(Rotation.Roll);
+        Out.Raw<float>(Rotation.Yaw);
+    }
+    if (Changed & CA_SCALE3D)
+    {
+        Out.Raw<float>(Scale3D.X);
+        Out.Raw<float>(Scale3D.Y);
+        Out.Raw<float>(Scale3D.Z);
+    }
+    if (Changed & CA_MESH_PATH)
+        WriteInternedString(Out, Strings, MeshPath);
+    if (Changed & CA_MATERIAL_SCALARS)
+    {
+        Out.Raw<float>(Mat.Metallic);
+        Out.Raw<float>(Mat.Specular);
+        Out.Raw<float>(Mat.Roughness);
+        Out.Raw<float>(Mat.Anisotropy);
+        Out.Raw<float>(Mat.Opacity);
+    }
+    if (Changed & CA_BASE_COLOR)
+        Out.Raw<FLinearColor>(Mat.BaseColor);
+    if (Changed & CA_EMISSIVE)
+        Out.Raw<FLinearColor>(Mat.Emissive);
+    if (Changed & CA_MATERIAL_PATH)
+        WriteInternedString(Out, Strings, Mat.MaterialPath);
+    if (Changed & CA_OTHER)
+        WriteInternedString(Out, Strings, Other);
+}
+
+bool CustomActorData::ReadInterned(DReyeVRCompactReader &In, const DReyeVRStringTableReader &Strings)
+{
+    // fields that are not in the record keep their last value
+    MaterialParamsStruct &Mat = MaterialParams;
+    const uint64_t Changed = In.Varint();
+    if (Changed & CA_LOCATION)
+    {
+        Location.X = In.Raw<float>();
+        Location.Y = In.Raw<float>();
+        Location.Z = In.Raw<float>();
+    }
+    if (Changed & CA_ROTATION)
+    {
+        Rotation.Pitch = In.Raw<float>();
+        Rotation.Roll = In.Raw<float>();
+        Rotation.Yaw = In.Raw<float>();
+    }
+    if (Changed & CA_SCALE3D)
+    {
+        Scale3D.X = In.Raw<float>();
+        Scale3D.Y = In.Raw<float>();
+        Scale3D.Z = In.Raw<float>();
+    }
+    if ((Changed & CA_MESH_PATH) && !ReadInternedString(In, Strings, MeshPath))
+        return false;
+    if (Changed & CA_MATERIAL_SCALARS)
+    {
+        Mat.Metallic = In.Raw<float>();
+        Mat.Specular = In.Raw<float>();
+        Mat.Roughness = In.Raw<float>();
+        Mat.Anisotropy = In.Raw<float>();
+        Mat.Opacity = In.Raw<float>();
+    }
+    if (Changed & CA_BASE_COLOR)
+        Mat.BaseColor = In.Raw<FLinearColor>();
+    if (Changed & CA_EMISSIVE)
+        Mat.Emissive = In.Raw<FLinearColor>();
+    if ((Changed & CA_MATERIAL_PATH) && !ReadInternedString(In, Strings, Mat.MaterialPath))
+        return false;
+    if ((Changed & CA_OTHER) && !ReadInternedString(In, Strings, Other))
+        return false;
+    return !In.Failed();
+}
+
+size_t CustomActorData::GetRawSize() const
+{
+    // 9 dof + 5 material scalars + 2 colors + 4 strings (length + text, paths are ASCII)
+    const size_t NumChars = MeshPath.Len() + MaterialParams.MaterialPath.Len() + Other.Len() + Name.Len();
+    return 9 * sizeof(float) + 5 * sizeof(float) + 2 * sizeof(FLinearColor) + 4 * sizeof(uint16_t) + NumChars;
+}
+
+void CustomActorEncoder::Reset()
+{
+    Strings.Reset();
+    Last.clear();
+    Body.Clear();
+    NumRecords = 0;
+}
+
+void CustomActorEncoder::BeginPacket(bool bReset)
+{
+    if (bReset)
+        Reset();
+    bResetPacket = bReset;
+    Body.Clear();
+    NumRecords = 0;
+}
+
+void CustomActorEncoder::Add(const CustomActorData &Data)
+{
+    const uint32_t NameId = Strings.Intern(Data.GetUniqueName());
+    Body.Varint(NameId);
+    auto It = Last.find(NameId);
+    Data.WriteInterned(Body, Strings, It != Last.end() ? &It->second : nullptr);
+    if (It == Last.end())
+        Last.emplace(NameId, Data);
+    else
+        It->second = Data;
+    NumRecords++;
+    RawBytes += Data.GetRawSize();
+}
+
+void CustomActorEncoder::EndPacket(DReyeVRCompactWriter &Out)
+{
+    // flags, new strings, then the records (which interned them)
+    Out.Raw<uint8_t>(bResetPacket ? DREYEVR_COMPACT_FLAG_RESET : 0);
+    Strings.WriteDefinitions(Out);
+    Out.Varint(NumRecords);
+    Out.Append(Body.GetBytes().data(), Body.Size());
+}
+
+void CustomActorDecoder::Reset()
+{
+    Strings.Reset();
+    Last.clear();
+    bSynced = false;
+}
+
+bool CustomActorDecoder::Decode(DReyeVRCompactReader &In, std::vector<Record> &OutRecords)
+{
+    OutRecords.clear();
+    const uint8_t Flags = In.Raw<uint8_t>();
+    if (Flags & DREYEVR_COMPACT_FLAG_RESET)
+    {
+        Reset();
+        bSynced = true;
+    }
+    if (!bSynced || !Strings.ReadDefinitions(In))
+    {
+        bSynced = false;
+        return false;
+    }
+
+    const uint64_t Num = In.Varint();
+    for (uint64_t n = 0; n < Num && bSynced; n++)
+    {
+        const uint32_t NameId = static_cast<uint32_t>(In.Varint());
+        const std::string *Name = Strings.Get(NameId);
+        if (Name == nullptr)
+        {
+            bSynced = false;
+            break;
+        }
+        auto It = Last.find(NameId);
+        if (It == Last.end())
+        {
+            It = Last.emplace(NameId, CustomActorData()).first;
+            It->second.Name = FString(UTF8_TO_TCHAR(Name->c_str()));
+        }
+        bSynced = It->second.ReadInterned(In, Strings);
+        OutRecords.push_back(Record{Name, &It->second});
+    }
+    if (!bSynced)
+        OutRecords.clear();
+    return bSynced;
+}
+
 }; // namespace DReyeVR
\ No newline at end of file
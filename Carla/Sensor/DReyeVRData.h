@@ -1,14 +1,17 @@
 #pragma once
 
-#include "Carla/Recorder/CarlaRecorderHelpers.h" // WriteValue, WriteFVector, WriteFString, ...
-#include "Materials/MaterialInstanceDynamic.h"   // UMaterialInstanceDynamic
-#include <chrono>                                // timing threads
-#include <cstdint>                               // int64_t
+#include "Carla/Recorder/CarlaRecorderHelpers.h"    // WriteValue, WriteFVector, WriteFString, ...
+#include "Carla/Recorder/DReyeVRDwellAccumulator.h" // DReyeVRDwellStats
+#include "Carla/Recorder/DReyeVRRecorderCodec.h"    // DReyeVRFieldEncoder, DReyeVRStringTableWriter, ...
+#include "Materials/MaterialInstanceDynamic.h"      // UMaterialInstanceDynamic
+#include <chrono>                                   // timing threads
+#include <cstdint>                                  // int64_t
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace DReyeVR
 {
@@ -99,14 +102,68 @@ struct CARLA_API FocusInfo : public DataSerializer
     FVector HitPoint; // in world space (absolute location)
     FVector Normal;
     FString ActorNameTag = "None"; // Tag of the actor being focused on
-    float Distance;
-    bool bDidHit;
+    float Distance = 0.f;
+    bool bDidHit = false;
 
     void Read(std::ifstream &InFile) override;
     void Write(std::ofstream &OutFile) const override;
     FString ToString() const override;
 };
 
+struct CARLA_API GazeTraces : public DataSerializer
+{
+    // when the focus (FocusInfo) was traced, and the per-eye traces of the same batch ([Recorder] GazeTraces)
+    uint64_t IssuedFrame = 0;   // game frame the traces were issued on
+    uint64_t ConsumedFrame = 0; // and the one their results became the focus on (the latency is the difference)
+    bool bAsync = false;        // async traces: results of the frame before the one they are recorded in
+    FocusInfo Left;           // (only traced along with async traces)
+    FocusInfo Right;
+
+    void Read(std::ifstream &InFile) override;
+    void Write(std::ofstream &OutFile) const override;
+    FString ToString() const override;
+};
+
+struct CARLA_API FixationEvent : public DataSerializer
+{
+    // see DReyeVRFixationEvent in DReyeVRGazeClassifier.h
+    bool bStart = false;                         // a fixation started (else it ended)
+    int64_t Start = 0;                           // device timestamp (ms) of its first eye-tracker reading
+    int64_t End = 0;                             // and of its last one (so far, for starts)
+    FVector2D Direction = FVector2D::ZeroVector; // mean combined gaze yaw and pitch (degrees, in the camera frame)
+    FString ActorNameTag = "None";               // focused actor of the majority of its readings
+
+    void Read(std::ifstream &InFile) override;
+    void Write(std::ofstream &OutFile) const override;
+    FString ToString() const override;
+};
+
+struct CARLA_API FixationData : public DataSerializer
+{
+    // online fixation classification of the eye-tracker readings ([EgoSensor] Fixation*, [Recorder] Fixations)
+    bool bFixating = false;
+    FixationEvent Current;        // the ongoing fixation, or the last one if !bFixating
+    TArray<FixationEvent> Events; // fixations that started or ended since the previous tick
+
+    void Read(std::ifstream &InFile) override;
+    void Write(std::ofstream &OutFile) const override;
+    FString ToString() const override;
+};
+
+struct CARLA_API DwellData : public DataSerializer
+{
+    // per-actor gaze dwell statistics of the EgoSensor, recorded once at the end ([Recorder] Dwell)
+    TArray<DReyeVRDwellStats> Actors; // in the order they were first seen
+    int64_t UntrackedDwell = 0;       // ms of gaze on no Carla actor
+    int64_t DroppedDwell = 0;         // ms of gaze on actors beyond [EgoSensor] DwellMaxActors
+    uint64_t NumDroppedActors = 0;
+
+    void Set(const DReyeVRDwellAccumulator &Dwell);
+    void Read(std::ifstream &InFile) override;
+    void Write(std::ofstream &OutFile) const override;
+    FString ToString() const override;
+};
+
 struct CARLA_API EyeTracker : public DataSerializer
 {
     int64_t TimestampDevice = 0; // timestamp from the eye tracker device (with its own clock)
@@ -118,6 +175,11 @@ struct CARLA_API EyeTracker : public DataSerializer
     void Read(std::ifstream &InFile) override;
     void Write(std::ofstream &OutFile) const override;
     FString ToString() const override;
+    // compact encoding (same fields as in AggregateData), for the eye sample packets
+    void ReadCompact(DReyeVRFieldDecoder &Decoder);
+    void WriteCompact(DReyeVRFieldEncoder &Encoder) const;
+    // (also visited as part of AggregateData::VisitCompact)
+    template <typename DataT, typename CodecT> static void VisitCompact(DataT &Data, CodecT &Codec);
 };
 
 enum class Gaze
@@ -179,6 +241,7 @@ class CARLA_API AggregateData : public DataSerializer
     const FVector &GetFocusActorPoint() const;
     float GetFocusActorDistance() const;
     const DReyeVR::UserInputs &GetUserInputs() const;
+    const DReyeVR::FixationData &GetFixations() const;
 
     ////////////////////:SETTERS://////////////////////
     void UpdateCamera(const FVector &NewCameraLoc, const FRotator &NewCameraRot);
@@ -186,18 +249,24 @@ class CARLA_API AggregateData : public DataSerializer
     void UpdateVehicle(const FVector &NewVehicleLoc, const FRotator &NewVehicleRot);
     void Update(int64_t NewTimestamp, const struct EyeTracker &NewEyeData, const struct EgoVariables &NewEgoVars,
                 const struct FocusInfo &NewFocus, const struct UserInputs &NewInputs);
+    void UpdateFixations(const struct FixationData &NewFixations);
 
     ////////////////////:SERIALIZATION://////////////////////
     void Read(std::ifstream &InFile) override;
     void Write(std::ofstream &OutFile) const override;
     FString ToString() const override;
+    // compact (quantized delta) encoding, see DReyeVRRecorderCodec.h
+    void ReadCompact(DReyeVRFieldDecoder &Decoder);
+    void WriteCompact(DReyeVRFieldEncoder &Encoder) const;
 
   private:
+    template <typename DataT, typename CodecT> static void VisitCompact(DataT &Data, CodecT &Codec);
     int64_t TimestampCarlaUE4; // Carla Timestamp (EgoSensor Tick() event) in milliseconds
     struct EyeTracker EyeTrackerData;
     struct EgoVariables EgoVars;
     struct FocusInfo FocusData;
     struct UserInputs Inputs;
+    struct FixationData Fixations; // (not part of the DReyeVR packet, recorded on its own)
 };
 
 class CARLA_API CustomActorData : public DataSerializer
@@ -240,6 +309,57 @@ class CARLA_API CustomActorData : public DataSerializer
     void Write(std::ofstream &OutFile) const override;
     FString ToString() const override;
     std::string GetUniqueName() const;
+
+    // interned encoding (see CustomActorEncoder), only the fields that differ from Prev are written
+    void WriteInterned(DReyeVRCompactWriter &Out, DReyeVRStringTableWriter &Strings,
+                       const CustomActorData *Prev) const;
+    bool ReadInterned(DReyeVRCompactReader &In, const DReyeVRStringTableReader &Strings);
+    size_t GetRawSize() const; // size of this record in a regular custom actor packet
+};
+
+// Custom actor packets with a per-recording string table (DREYEVR_INTERNED_CUSTOM_ACTOR_PACKET_ID)
+//
+// Actor names and asset paths are interned (DReyeVRStringTableWriter) and every record only carries the fields that
+// changed since the last record of the same actor, behind a bitmask. Like the compact packets, a reset packet
+// (first frame, keyframes) starts over with an empty table and full records, so it is where decoding can start.
+class CARLA_API CustomActorEncoder
+{
+  public:
+    void Reset();
+    void BeginPacket(bool bReset);
+    void Add(const CustomActorData &Data);
+    // appends the packet body (without the packet header) to Out
+    void EndPacket(DReyeVRCompactWriter &Out);
+
+    uint64_t RawBytes = 0; // what the same records take in regular packets
+
+  private:
+    DReyeVRStringTableWriter Strings;
+    std::unordered_map<uint32_t, CustomActorData> Last; // last record written of each actor (by name id)
+    DReyeVRCompactWriter Body;
+    uint64_t NumRecords = 0;
+    bool bResetPacket = false;
+};
+
+class CARLA_API CustomActorDecoder
+{
+  public:
+    struct Record
+    {
+        const std::string *UniqueName; // (from the string table)
+        const CustomActorData *Data;
+    };
+
+    void Reset();
+    // decodes a packet body into the records of its actors (owned by the decoder: names are valid until the next
+    // Decode, records until the next Reset),
+    // false if it is malformed or depends on a packet that was not decoded
+    bool Decode(DReyeVRCompactReader &In, std::vector<Record> &OutRecords);
+
+  private:
+    DReyeVRStringTableReader Strings;
+    std::unordered_map<uint32_t, CustomActorData> Last;
+    bool bSynced = false;
 };
 
 }; // namespace DReyeVR
\ No newline at end of file
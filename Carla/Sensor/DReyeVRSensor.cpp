@@ -12,6 +12,10 @@
 #include "carla/geom/Vector3D.h"
 #include "carla/sensor/s11n/DReyeVRSerializer.h" // DReyeVRSerializer::Data
 
+#include <compiler/disable-ue4-macros.h>
+#include "carla/sensor/s11n/DReyeVRSharedMemory.h" // DReyeVRSharedMemoryWriter (boost::interprocess)
+#include <compiler/enable-ue4-macros.h>
+
 class DReyeVR::AggregateData *ADReyeVRSensor::Data = nullptr;
 class DReyeVR::ConfigFileData *ADReyeVRSensor::ConfigFile = nullptr;
 bool ADReyeVRSensor::bIsReplaying = false; // initially not replaying
@@ -20,6 +24,7 @@ ADReyeVRSensor::ADReyeVRSensor(const FObjectInitializer &ObjectInitializer) : Su
 {
     // no need for any other initialization
     PrimaryActorTick.bCanEverTick = true;
+    StreamFields = carla::sensor::s11n::DReyeVRSerializer::FIELDS_ALL;
     if (ADReyeVRSensor::Data == nullptr)
         ADReyeVRSensor::Data = new DReyeVR::AggregateData();
     if (ADReyeVRSensor::ConfigFile == nullptr)
@@ -34,8 +39,15 @@ FActorDefinition ADReyeVRSensor::GetSensorDefinition()
     /// NOTE: only has EActorAttributeType for bool, int, float, string, and RGBColor
     // see /Plugins/Carla/Source/Carla/Actor/ActorAttribute.h for the whole list
 
+    // groups of fields to stream (see DReyeVRSerializer::ParseFields), empty for [EgoSensor] StreamFields
+    FActorVariation Fields;
+    Fields.Id = TEXT("fields");
+    Fields.Type = EActorAttributeType::String;
+    Fields.RecommendedValues = {TEXT(""), TEXT("all"), TEXT("gaze"), TEXT("gaze,focus"), TEXT("none")};
+    Fields.bRestrictToRecommended = false;
+
     // append all Variable variations to the definition
-    // Definition.Variations.Append();
+    Definition.Variations.Append({Fields});
 
     return Definition;
 }
@@ -43,6 +55,24 @@ FActorDefinition ADReyeVRSensor::GetSensorDefinition()
 void ADReyeVRSensor::Set(const FActorDescription &Description)
 {
     Super::Set(Description);
+    const FActorAttribute *Fields = Description.Variations.Find(TEXT("fields"));
+    if (Fields != nullptr && !Fields->Value.IsEmpty())
+        SetStreamFields(Fields->Value);
+}
+
+bool ADReyeVRSensor::SetStreamFields(const FString &Fields)
+{
+    using Serializer = carla::sensor::s11n::DReyeVRSerializer;
+    uint32_t Mask = 0;
+    if (!Serializer::ParseFields(carla::rpc::FromFString(Fields), Mask))
+    {
+        DReyeVR_LOG_ERROR("Unknown DReyeVR sensor fields \"%s\", streaming all of them", *Fields);
+        StreamFields = Serializer::FIELDS_ALL;
+        return false;
+    }
+    StreamFields = Mask;
+    DReyeVR_LOG("Streaming DReyeVR sensor fields \"%s\" (0x%x)", *Fields, StreamFields);
+    return true;
 }
 
 void ADReyeVRSensor::SetOwner(AActor *Owner)
@@ -68,19 +98,41 @@ void ADReyeVRSensor::BeginPlay()
     UCarlaGameInstance *CarlaGame = UCarlaStatics::GetGameInstance(World);
     SetEpisode(*(CarlaGame->GetCarlaEpisode()));
     SetDataStream(CarlaGame->GetServer().OpenStream()); // initialize boost::optional<Stream>
+    const FGuid Guid = FGuid::NewGuid();                 // (unique across sensors and servers)
+    StreamId = ((static_cast<uint64>(Guid.A) << 32) | Guid.B) ^ ((static_cast<uint64>(Guid.C) << 32) | Guid.D);
+
+    if (bSharedMemory && SharedMemory == nullptr)
+    {
+        // ring of records for the local readers (see DReyeVRSharedMemory.h and PythonAPI/examples/DReyeVR_shm.py)
+        try
+        {
+            SharedMemory = new carla::sensor::s11n::DReyeVRSharedMemoryWriter(
+                carla::rpc::FromFString(SharedMemoryName), static_cast<uint32_t>(FMath::Max(SharedMemorySlots, 2)));
+            DReyeVR_LOG("Publishing DReyeVR sensor data to shared memory \"%s\" (%d slots)", *SharedMemoryName,
+                        SharedMemorySlots);
+        }
+        catch (const std::exception &Error)
+        {
+            DReyeVR_LOG_ERROR("Unable to create shared memory \"%s\": %s", *SharedMemoryName,
+                              UTF8_TO_TCHAR(Error.what()));
+        }
+    }
 }
 
 void ADReyeVRSensor::BeginDestroy()
 {
+    delete SharedMemory; // (readers get no new records)
+    SharedMemory = nullptr;
     Super::BeginDestroy();
 }
 
 void ADReyeVRSensor::PostPhysTick(UWorld *W, ELevelTick TickType, float DeltaSeconds)
 {
     /// NOTE: this function defines the routine for streaming data to the PythonAPI
-    if (!this->bStreamData) // param for enabling or disabling the data streaming
+    // param for enabling or disabling the data streaming, and nobody subscribed
+    const bool bStream = this->bStreamData && AreClientsListening();
+    if (!bStream && SharedMemory == nullptr) // don't build anything
         return;
-    auto Stream = GetDataStream(*this);
 
     struct // overloaded lambdas to convert UE4 types to carla::geom types
     {
@@ -102,50 +154,187 @@ void ADReyeVRSensor::PostPhysTick(UWorld *W, ELevelTick TickType, float DeltaSec
         };
     } ToGeom;
 
-    /// TODO: refactor this somehow
     /// to see where this is sent, see LibCarla/source/carla/sensor/s11n/DReyeVRSerializer.h
-    Stream.Send(*this,
-                carla::sensor::s11n::DReyeVRSerializer::Data{
-                    Data->GetTimestampCarla(),  // Timestamp of Carla (ms)
-                    Data->GetTimestampDevice(), // Timestamp of SRanipal (ms)
-                    Data->GetFrameSequence(),   // Frame sequence
-                    // camera
-                    ToGeom(Data->GetCameraLocation()), // HMD absolute location
-                    ToGeom(Data->GetCameraRotation()), // HMD absolute rotation
-                    // combined gaze
-                    ToGeom(Data->GetGazeDir()),    // Combined gaze ray direction
-                    ToGeom(Data->GetGazeOrigin()), // Stream EyeOrigin Vec3
-                    Data->GetGazeValidity(),       // Validity of combined gaze
-                    Data->GetGazeVergence(),       // Vergence (float) of combined ray
-                    // left gaze/eye
-                    ToGeom(Data->GetGazeDir(DReyeVR::Gaze::LEFT)),      // Left eye gaze ray direction
-                    ToGeom(Data->GetGazeOrigin(DReyeVR::Gaze::LEFT)),   // Left eye gaze origin
-                    Data->GetGazeValidity(DReyeVR::Gaze::LEFT),         // Validity of left gaze
-                    Data->GetEyeOpenness(DReyeVR::Eye::LEFT),           // Left eye openness
-                    Data->GetEyeOpennessValidity(DReyeVR::Eye::LEFT),   // Validity of left eye openness
-                    ToGeom(Data->GetPupilPosition(DReyeVR::Eye::LEFT)), // Left pupil position
-                    Data->GetPupilPositionValidity(DReyeVR::Eye::LEFT), // Validity of left eye posn
-                    Data->GetPupilDiameter(DReyeVR::Eye::LEFT),         // Left eye diameter (mm)
-                    // right gaze/eye
-                    ToGeom(Data->GetGazeDir(DReyeVR::Gaze::RIGHT)),      // Right eye gaze ray direction
-                    ToGeom(Data->GetGazeOrigin(DReyeVR::Gaze::RIGHT)),   // Dight eye gaze origin
-                    Data->GetGazeValidity(DReyeVR::Gaze::RIGHT),         // Validity of right gaze
-                    Data->GetEyeOpenness(DReyeVR::Eye::RIGHT),           // Right eye openness
-                    Data->GetEyeOpennessValidity(DReyeVR::Eye::RIGHT),   // Validity of right eye openness
-                    ToGeom(Data->GetPupilPosition(DReyeVR::Eye::RIGHT)), // Right pupil position
-                    Data->GetPupilPositionValidity(DReyeVR::Eye::RIGHT), // Validity of left eye posn
-                    Data->GetPupilDiameter(DReyeVR::Eye::RIGHT),         // Right eye diameter (mm)
-                    // focus
-                    ToGeom(Data->GetFocusActorName()),  // Focus Actor's name
-                    ToGeom(Data->GetFocusActorPoint()), // Focus Actor's location in world space
-                    Data->GetFocusActorDistance(),      // Focus Actor's distance to the sensor
-                    // user inputs
-                    Data->GetUserInputs().Throttle,       // Vehicle input throttle
-                    Data->GetUserInputs().Steering,       // Vehicle input steering
-                    Data->GetUserInputs().Brake,          // Vehicle input brake
-                    Data->GetUserInputs().ToggledReverse, // Vehicle input gear (reverse, fwd)
-                    Data->GetUserInputs().HoldHandbrake   // Vehicle input handbrake
-                });
+    // only the groups of fields the clients asked for (see the sensor's `fields` attribute), the rest stays zeroed
+    using Serializer = carla::sensor::s11n::DReyeVRSerializer;
+    Serializer::Data StreamData{};
+    StreamData.Fields = StreamFields;
+    StreamData.StreamSequence = RecordsSent; // so the clients can tell the events they missed
+    StreamData.TimestampCarla = Data->GetTimestampCarla();   // Timestamp of Carla (ms)
+    StreamData.TimestampDevice = Data->GetTimestampDevice(); // Timestamp of SRanipal (ms)
+    StreamData.FrameSequence = Data->GetFrameSequence();     // Frame sequence
+    if (StreamFields & Serializer::FIELD_CAMERA)
+    {
+        StreamData.CameraLocation = ToGeom(Data->GetCameraLocation()); // HMD absolute location
+        StreamData.CameraRotation = ToGeom(Data->GetCameraRotation()); // HMD absolute rotation
+    }
+    if (StreamFields & Serializer::FIELD_GAZE)
+    {
+        StreamData.GazeDir = ToGeom(Data->GetGazeDir());       // Combined gaze ray direction
+        StreamData.GazeOrigin = ToGeom(Data->GetGazeOrigin()); // Stream EyeOrigin Vec3
+        StreamData.GazeValid = Data->GetGazeValidity();        // Validity of combined gaze
+        StreamData.GazeVergence = Data->GetGazeVergence();     // Vergence (float) of combined ray
+    }
+    if (StreamFields & Serializer::FIELD_EYES)
+    {
+        StreamData.LGazeDir = ToGeom(Data->GetGazeDir(DReyeVR::Gaze::LEFT));       // Left eye gaze ray direction
+        StreamData.LGazeOrigin = ToGeom(Data->GetGazeOrigin(DReyeVR::Gaze::LEFT)); // Left eye gaze origin
+        StreamData.LGazeValid = Data->GetGazeValidity(DReyeVR::Gaze::LEFT);        // Validity of left gaze
+        StreamData.LEyeOpenness = Data->GetEyeOpenness(DReyeVR::Eye::LEFT);        // Left eye openness
+        StreamData.LEyeOpenValid = Data->GetEyeOpennessValidity(DReyeVR::Eye::LEFT);
+        StreamData.RGazeDir = ToGeom(Data->GetGazeDir(DReyeVR::Gaze::RIGHT));       // Right eye gaze ray direction
+        StreamData.RGazeOrigin = ToGeom(Data->GetGazeOrigin(DReyeVR::Gaze::RIGHT)); // Right eye gaze origin
+        StreamData.RGazeValid = Data->GetGazeValidity(DReyeVR::Gaze::RIGHT);        // Validity of right gaze
+        StreamData.REyeOpenness = Data->GetEyeOpenness(DReyeVR::Eye::RIGHT);        // Right eye openness
+        StreamData.REyeOpenValid = Data->GetEyeOpennessValidity(DReyeVR::Eye::RIGHT);
+    }
+    if (StreamFields & Serializer::FIELD_PUPILS)
+    {
+        StreamData.LPupilPos = ToGeom(Data->GetPupilPosition(DReyeVR::Eye::LEFT));      // Left pupil position
+        StreamData.LPupilPosValid = Data->GetPupilPositionValidity(DReyeVR::Eye::LEFT); // Validity of left eye posn
+        StreamData.LPupilDiameter = Data->GetPupilDiameter(DReyeVR::Eye::LEFT);         // Left eye diameter (mm)
+        StreamData.RPupilPos = ToGeom(Data->GetPupilPosition(DReyeVR::Eye::RIGHT));      // Right pupil position
+        StreamData.RPupilPosValid = Data->GetPupilPositionValidity(DReyeVR::Eye::RIGHT); // Validity of right eye posn
+        StreamData.RPupilDiameter = Data->GetPupilDiameter(DReyeVR::Eye::RIGHT);         // Right eye diameter (mm)
+    }
+    if (StreamFields & Serializer::FIELD_FOCUS)
+    {
+        StreamData.FocusActorName = ToGeom(Data->GetFocusActorName());   // Focus Actor's name
+        StreamData.FocusActorPoint = ToGeom(Data->GetFocusActorPoint()); // Focus Actor's location in world space
+        StreamData.FocusActorDist = Data->GetFocusActorDistance();       // Focus Actor's distance to the sensor
+    }
+    if (StreamFields & Serializer::FIELD_INPUTS)
+    {
+        const DReyeVR::UserInputs &Inputs = Data->GetUserInputs();
+        StreamData.Throttle = Inputs.Throttle;             // Vehicle input throttle
+        StreamData.Steering = Inputs.Steering;             // Vehicle input steering
+        StreamData.Brake = Inputs.Brake;                   // Vehicle input brake
+        StreamData.ToggledReverse = Inputs.ToggledReverse; // Vehicle input gear (reverse, fwd)
+        StreamData.HoldHandbrake = Inputs.HoldHandbrake;   // Vehicle input handbrake
+    }
+    // every eye-tracker reading since the previous tick (the fields above are of the latest one)
+    if (StreamFields & Serializer::FIELD_EYE_SAMPLES)
+    {
+        StreamData.EyeSamples.reserve(EyeTrackerSamples.Num());
+        for (const DReyeVR::EyeTracker &Eyes : EyeTrackerSamples)
+        {
+            Serializer::EyeSample Sample{};
+            Sample.TimestampDevice = Eyes.TimestampDevice;
+            Sample.FrameSequence = Eyes.FrameSequence;
+            Sample.GazeDir = ToGeom(Eyes.Combined.GazeDir);
+            Sample.GazeOrigin = ToGeom(Eyes.Combined.GazeOrigin);
+            Sample.GazeVergence = Eyes.Combined.Vergence;
+            Sample.GazeValid = Eyes.Combined.GazeValid;
+            Sample.LGazeDir = ToGeom(Eyes.Left.GazeDir);
+            Sample.LGazeOrigin = ToGeom(Eyes.Left.GazeOrigin);
+            Sample.LGazeValid = Eyes.Left.GazeValid;
+            Sample.LEyeOpenness = Eyes.Left.EyeOpenness;
+            Sample.LEyeOpenValid = Eyes.Left.EyeOpennessValid;
+            Sample.LPupilPos = ToGeom(Eyes.Left.PupilPosition);
+            Sample.LPupilPosValid = Eyes.Left.PupilPositionValid;
+            Sample.LPupilDiameter = Eyes.Left.PupilDiameter;
+            Sample.RGazeDir = ToGeom(Eyes.Right.GazeDir);
+            Sample.RGazeOrigin = ToGeom(Eyes.Right.GazeOrigin);
+            Sample.RGazeValid = Eyes.Right.GazeValid;
+            Sample.REyeOpenness = Eyes.Right.EyeOpenness;
+            Sample.REyeOpenValid = Eyes.Right.EyeOpennessValid;
+            Sample.RPupilPos = ToGeom(Eyes.Right.PupilPosition);
+            Sample.RPupilPosValid = Eyes.Right.PupilPositionValid;
+            Sample.RPupilDiameter = Eyes.Right.PupilDiameter;
+            StreamData.EyeSamples.push_back(Sample);
+        }
+    }
+    // the ongoing (or last) fixation and the fixations that started or ended since the previous tick
+    if (StreamFields & Serializer::FIELD_FIXATIONS)
+    {
+        const DReyeVR::FixationData &Fixations = Data->GetFixations();
+        StreamData.Fixating = Fixations.bFixating;
+        StreamData.FixationStart = Fixations.Current.Start;
+        StreamData.FixationEnd = Fixations.Current.End;
+        StreamData.FixationActorName = ToGeom(Fixations.Current.ActorNameTag);
+        StreamData.FixationEvents.reserve(Fixations.Events.Num());
+        for (const DReyeVR::FixationEvent &Fixation : Fixations.Events)
+        {
+            Serializer::FixationEvent Event{};
+            Event.IsStart = Fixation.bStart;
+            Event.Start = Fixation.Start;
+            Event.End = Fixation.End;
+            Event.Yaw = Fixation.Direction.X;
+            Event.Pitch = Fixation.Direction.Y;
+            Event.ActorName = ToGeom(Fixation.ActorNameTag);
+            StreamData.FixationEvents.push_back(Event);
+        }
+    }
+    // per-actor dwell statistics: only the actors that changed this tick, all of them every now and then
+    if (StreamFields & Serializer::FIELD_DWELL)
+    {
+        auto ToStats = [](const DReyeVRDwellStats &In) {
+            Serializer::DwellStats Out{};
+            Out.ActorId = In.ActorId;
+            Out.NumGlances = In.NumGlances;
+            Out.NumFixations = In.NumFixations;
+            Out.TotalDwell = In.TotalDwell;
+            Out.FirstGlance = In.FirstGlance;
+            Out.FirstFixation = In.FirstFixation;
+            Out.LastGlance = In.LastGlance;
+            Out.LongestGlance = In.LongestGlance;
+            return Out;
+        };
+        StreamData.DwellActorId = Dwell.GetCurrentActor();
+        StreamData.DwellComplete = (RecordsSent % DREYEVR_STREAM_NAME_INTERVAL == 0);
+        if (StreamData.DwellComplete)
+        {
+            StreamData.Dwell.reserve(Dwell.GetAll().size());
+            for (const DReyeVRDwellStats &Stats : Dwell.GetAll())
+                StreamData.Dwell.push_back(ToStats(Stats));
+        }
+        else
+            Dwell.ForEachChanged([&](const DReyeVRDwellStats &Stats) { StreamData.Dwell.push_back(ToStats(Stats)); });
+    }
+    if (StreamFields & Serializer::FIELD_GAZE_CONE)
+    {
+        StreamData.GazeCone.reserve(GazeConeHits.size());
+        for (const DReyeVRGazeConeHit &Hit : GazeConeHits)
+            StreamData.GazeCone.push_back({Hit.ActorId, Hit.Angle, Hit.EdgeAngle, Hit.Distance});
+    }
+
+    // fixed-layout record (binary stream and shared memory), the focused (and fixated) actors are interned
+    Serializer::Record Record{};
+    if (bStreamBinary || SharedMemory != nullptr)
+    {
+        Record = Serializer::ToRecord(StreamData);
+        Record.StreamId = StreamId;
+        auto GetActorId = [this](const FString &Name) {
+            uint32 *Id = FocusActorIds.Find(Name);
+            if (Id == nullptr)
+                Id = &FocusActorIds.Add(Name, FocusActorIds.Num() + 1); // 0 is "unknown"
+            return *Id;
+        };
+        if (StreamFields & Serializer::FIELD_FOCUS)
+            Record.FocusActorId = GetActorId(Data->GetFocusActorName());
+        if (StreamFields & Serializer::FIELD_FIXATIONS)
+            Record.FixationActorId = GetActorId(Data->GetFixations().Current.ActorNameTag);
+    }
+    if (SharedMemory != nullptr)
+        SharedMemory->Publish(Record, StreamData.EyeSamples, StreamData.FocusActorName);
+    if (!bStream)
+        return;
+
+    auto Stream = GetDataStream(*this);
+    if (!bStreamBinary)
+    {
+        Stream.Send(*this, std::move(StreamData));
+        RecordsSent++;
+        return;
+    }
+
+    // the focused actor's name is only sent when it changes (and every DREYEVR_STREAM_NAME_INTERVAL records for
+    // the clients that connect later)
+    const bool bSendName = (Record.FocusActorId != 0) && ((Record.FocusActorId != LastFocusActorId) ||
+                                                          (RecordsSent % DREYEVR_STREAM_NAME_INTERVAL == 0));
+    Stream.Send(*this, Record, StreamData.EyeSamples, bSendName ? StreamData.FocusActorName : std::string());
+    LastFocusActorId = Record.FocusActorId;
+    RecordsSent++;
 }
 
 void ADReyeVRSensor::UpdateData(const DReyeVR::AggregateData &RecorderData, const double Per)
@@ -207,6 +396,13 @@ void ADReyeVRSensor::UpdateData(const class DReyeVR::CustomActorData &RecorderDa
     unimplemented();
 }
 
+void ADReyeVRSensor::UpdateData(const struct DReyeVR::FixationData &RecorderData, const double Per)
+{
+    // recorded after the DReyeVR packet of the same frame, which resets them
+    if (ADReyeVRSensor::Data != nullptr)
+        ADReyeVRSensor::Data->UpdateFixations(RecorderData);
+}
+
 void ADReyeVRSensor::StopReplaying()
 {
     ADReyeVRSensor::bIsReplaying = false;
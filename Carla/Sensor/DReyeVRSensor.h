@@ -1,17 +1,28 @@
 #pragma once
 
-#include "Carla/Actor/ActorDefinition.h"  // FActorDefinition
-#include "Carla/Actor/ActorDescription.h" // FActorDescription
-#include "Carla/Game/CarlaEpisode.h"      // UCarlaEpisode
-#include "Carla/Sensor/Sensor.h"          // ASensor
-#include "DReyeVRData.h"                  // AggregateData, CustomActorData
-#include <cstdint>                        // int64_t
+#include "Carla/Actor/ActorDefinition.h"    // FActorDefinition
+#include "Carla/Actor/ActorDescription.h"   // FActorDescription
+#include "Carla/Game/CarlaEpisode.h"        // UCarlaEpisode
+#include "Carla/Recorder/DReyeVRGazeCone.h" // DReyeVRGazeConeHit
+#include "Carla/Sensor/Sensor.h"            // ASensor
+#include "DReyeVRData.h"                    // AggregateData, CustomActorData
+#include <cstdint>                          // int64_t
 #include <string>
 #include <vector>
 
 #include "DReyeVRSensor.generated.h"
 
 class UCarlaEpisode;
+namespace carla
+{
+namespace sensor
+{
+namespace s11n
+{
+class DReyeVRSharedMemoryWriter;
+}
+} // namespace sensor
+} // namespace carla
 
 UCLASS()
 class CARLA_API ADReyeVRSensor : public ASensor
@@ -27,6 +38,9 @@ class CARLA_API ADReyeVRSensor : public ASensor
 
     void SetOwner(AActor *Owner) override;
 
+    // groups of fields to stream ("gaze,focus", see DReyeVRSerializer::ParseFields), false if a name is unknown
+    bool SetStreamFields(const FString &Fields);
+
     virtual void PostPhysTick(UWorld *W, ELevelTick TickType, float DeltaSeconds) override;
 
     // everything stored in the sensor is held in this struct
@@ -45,16 +59,52 @@ class CARLA_API ADReyeVRSensor : public ASensor
         return const_cast<const class DReyeVR::AggregateData *>(ADReyeVRSensor::Data);
     }
 
+    // eye-tracker readings since the previous tick (oldest first, empty while replaying)
+    const TArray<DReyeVR::EyeTracker> &GetEyeTrackerSamples() const
+    {
+        return EyeTrackerSamples;
+    }
+
+    // when this tick's focus was traced (and the per-eye traces of that batch)
+    const DReyeVR::GazeTraces &GetGazeTraces() const
+    {
+        return GazeTraceData;
+    }
+
+    // per-actor gaze dwell statistics since the sensor was spawned (see DReyeVRDwellAccumulator.h)
+    const DReyeVRDwellAccumulator &GetDwell() const
+    {
+        return Dwell;
+    }
+
+    // actors around this tick's gaze ray, the closest to it first (see [EgoSensor] GazeConeAngle)
+    const std::vector<DReyeVRGazeConeHit> &GetGazeCone() const
+    {
+        return GazeConeHits;
+    }
+
     bool IsReplaying() const;
     virtual void UpdateData(const class DReyeVR::AggregateData &RecorderData, const double Per); // starts replaying
     virtual void UpdateData(const class DReyeVR::ConfigFileData &RecorderData, const double Per);
     virtual void UpdateData(const class DReyeVR::CustomActorData &RecorderData, const double Per);
+    virtual void UpdateData(const struct DReyeVR::FixationData &RecorderData, const double Per);
     void StopReplaying();
-    virtual void TakeScreenshot()
+    // ReplayFrame: id of the recorded frame being replayed (as in show_recorder_file_info)
+    virtual void TakeScreenshot(int64 ReplayFrame)
     {
         /// TODO: make this a pure virtual function (abstract class)
         DReyeVR_LOG_WARN("Not implemented! Implement in EgoSensor!");
     };
+    // false while the screenshots of the previous frames are still being read back (see [Replayer] FramesInFlight) or
+    // encoded (EncoderMemoryBudgetMB)
+    virtual bool IsReadyForScreenshot()
+    {
+        return true;
+    }
+    // blocks until every screenshot taken so far is written (ex. before the simulator quits after the replay)
+    virtual void FinishScreenshots()
+    {
+    }
 
     static class ADReyeVRSensor *GetDReyeVRSensor(class UWorld *World = nullptr);
     static bool bIsReplaying;
@@ -67,6 +117,22 @@ class CARLA_API ADReyeVRSensor : public ASensor
     static class UWorld *sWorld; // to get info about the world: time, frames, etc.
 
     bool bStreamData = true;
+    bool bStreamBinary = false; // fixed-layout records instead of MsgPack (see DReyeVRSerializer::Record)
+    uint32 StreamFields;        // DReyeVRSerializer::Field groups to fill
+    // local readers poll a shared-memory ring instead of the stream (see DReyeVRSharedMemory.h)
+    bool bSharedMemory = false;
+    FString SharedMemoryName = "DReyeVR";
+    int SharedMemorySlots = 256;
+    carla::sensor::s11n::DReyeVRSharedMemoryWriter *SharedMemory = nullptr;
+    TArray<DReyeVR::EyeTracker> EyeTrackerSamples; // filled by the EgoSensor every tick
+    DReyeVR::GazeTraces GazeTraceData;             // (also filled by the EgoSensor)
+    DReyeVRDwellAccumulator Dwell;                 // (also filled by the EgoSensor)
+    std::vector<DReyeVRGazeConeHit> GazeConeHits;  // (also filled by the EgoSensor)
+    // focused actor names interned for the binary stream
+    TMap<FString, uint32> FocusActorIds;
+    uint32 LastFocusActorId = 0;
+    uint64 StreamId = 0;    // random, the clients keep the interned names of every stream apart by it
+    uint64 RecordsSent = 0; // events sent on the stream (DReyeVRSerializer::Data::StreamSequence)
 
     static class ADReyeVRSensor *DReyeVRSensorPtr;
     static void InterpPositionAndRotation(const FVector &Pos1, const FRotator &Rot1, const FVector &Pos2,
@@ -79,6 +79,6 @@ public class CarlaUE4 : ModuleRules
             PublicDependencyModuleNames.AddRange(new string[] { "EyeTracker", "VRSPlugin" });
         }
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "ImageWriteQueue" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "ImageWrapper", "RenderCore", "RHI" });
     }
 }
@@ -138,6 +138,25 @@ struct ConfigFile
         bSuccessfulUpdate = true;
     }
 
+    void Override(const ConfigFile &Other)
+    {
+        // unlike Insert, the entries of Other replace the ones of this config (one by one, not whole sections)
+        if (!Other.bIsValid())
+            return;
+        FilePath += "+" + Other.FilePath;
+        for (const auto &SectionData : Other.Sections)
+        {
+            auto SectionIt = Sections.find(SectionData.first);
+            if (SectionIt == Sections.end())
+            {
+                Sections.insert(SectionData);
+                continue;
+            }
+            for (const auto &EntryData : SectionData.second.Entries)
+                SectionIt->second.Entries[EntryData.first] = EntryData.second;
+        }
+    }
+
     static ConfigFile Import(const std::string &Configuration)
     {
         // takes a flattened INI configuration file as parameter and reads it into a ConfigFile class
@@ -331,4 +350,15 @@ struct ConfigFile
     std::unordered_map<std::string, IniSection> Sections;
 };
 
-static ConfigFile GeneralParams(FPaths::Combine(CarlaUE4Path, TEXT("Config/DReyeVRConfig.ini")));
+static ConfigFile ReadGeneralParams()
+{
+    ConfigFile Params(FPaths::Combine(CarlaUE4Path, TEXT("Config/DReyeVRConfig.ini")));
+    // per-instance settings on top, ex. for several simulators from one install (Tools/ParallelCapture). Read from
+    // the environment since this runs during static initialization, possibly before the command line is set
+    const FString OverridesPath = FPlatformMisc::GetEnvironmentVariable(TEXT("DREYEVR_CONFIG_OVERRIDES"));
+    if (!OverridesPath.IsEmpty())
+        Params.Override(ConfigFile(OverridesPath));
+    return Params;
+}
+
+static ConfigFile GeneralParams = ReadGeneralParams();
@@ -103,6 +103,8 @@ void ADReyeVRFactory::MakeSensorDefinition(const FString &Id, FActorDefinition &
 {
     Definition = MakeGenericDefinition(DReyeVRCategory, TEXT("DReyeVR_Sensor"), Id);
     Definition.Class = AEgoSensor::StaticClass();
+    // same attributes as the sensor.dreyevr blueprint (ex. "fields")
+    Definition.Variations.Append(ADReyeVRSensor::GetSensorDefinition().Variations);
 }
 
 FActorSpawnResult ADReyeVRFactory::SpawnActor(const FTransform &SpawnAtTransform,
@@ -169,6 +171,10 @@ FActorSpawnResult ADReyeVRFactory::SpawnActor(const FTransform &SpawnAtTransform
         SpawnedActor = SpawnSingleton(ActorDescription.Class, ActorDescription.Id, SpawnAtTransform, [&]() {
             return World->SpawnActor<AEgoSensor>(ActorDescription.Class, SpawnAtTransform, SpawnParameters);
         });
+        // apply the requested attributes (ex. "fields") even if the sensor already existed
+        auto *Sensor = Cast<AEgoSensor>(SpawnedActor);
+        if (Sensor != nullptr)
+            Sensor->Set(ActorDescription);
     }
     else
     {
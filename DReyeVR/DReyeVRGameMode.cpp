@@ -1,7 +1,7 @@
 #include "DReyeVRGameMode.h"
 #include "Carla/AI/AIControllerFactory.h"      // AAIControllerFactory
 #include "Carla/Actor/StaticMeshFactory.h"     // AStaticMeshFactory
-#include "Carla/Game/CarlaStatics.h"           // GetReplayer, GetEpisode
+#include "Carla/Game/CarlaStatics.h"           // GetReplayer, GetRecorder, GetEpisode
 #include "Carla/Recorder/CarlaReplayer.h"      // ACarlaReplayer
 #include "Carla/Sensor/DReyeVRSensor.h"        // ADReyeVRSensor
 #include "Carla/Sensor/SensorFactory.h"        // ASensorFactory
@@ -63,6 +63,23 @@ ADReyeVRGameMode::ADReyeVRGameMode(FObjectInitializer const &FO) : Super(FO)
     bUseCarlaSpectator = GeneralParams.Get<bool>("Replayer", "UseCarlaSpectator");
     bool bEnableReplayInterpolation = GeneralParams.Get<bool>("Replayer", "ReplayInterpolation");
     bReplaySync = !bEnableReplayInterpolation; // synchronous => no interpolation!
+    bRecorderAsyncWrite = GeneralParams.Get<bool>("Recorder", "AsyncWrite");
+    RecorderWriterBuffers = GeneralParams.Get<int>("Recorder", "WriterBuffers");
+    RecorderKeyframeInterval = GeneralParams.Get<float>("Recorder", "KeyframeInterval");
+    bRecorderCompact = GeneralParams.Get<bool>("Recorder", "CompactEncoding");
+    RecorderCompactLocation = GeneralParams.Get<float>("Recorder", "CompactLocationPrecision");
+    RecorderCompactRotation = GeneralParams.Get<float>("Recorder", "CompactRotationPrecision");
+    RecorderCompactUnit = GeneralParams.Get<float>("Recorder", "CompactUnitPrecision");
+    bRecorderInternCustomActors = GeneralParams.Get<bool>("Recorder", "InternCustomActors");
+    bRecorderEyeSamples = GeneralParams.Get<bool>("Recorder", "EyeSamples");
+    bRecorderGazeTraces = GeneralParams.Get<bool>("Recorder", "GazeTraces");
+    bRecorderFixations = GeneralParams.Get<bool>("Recorder", "Fixations");
+    bRecorderDwell = GeneralParams.Get<bool>("Recorder", "Dwell");
+    bReplayMemoryMapped = GeneralParams.Get<bool>("Replayer", "MemoryMappedReads");
+    ReplayQueryThreads = GeneralParams.Get<int>("Replayer", "QueryThreads");
+    ReplayCaptureStartTime = GeneralParams.Get<float>("Replayer", "CaptureStartTime");
+    ReplayCaptureEndTime = GeneralParams.Get<float>("Replayer", "CaptureEndTime");
+    bReplayQuitWhenDone = GeneralParams.Get<bool>("Replayer", "QuitWhenDone");
 }
 
 void ADReyeVRGameMode::BeginPlay()
@@ -478,12 +495,40 @@ void ADReyeVRGameMode::SetupReplayer()
     if (Replayer != nullptr)
     {
         Replayer->SetSyncMode(bReplaySync);
+        Replayer->SetCaptureWindow(ReplayCaptureStartTime, ReplayCaptureEndTime);
+        Replayer->SetQuitWhenDone(bReplayQuitWhenDone);
         if (bReplaySync)
         {
             LOG("Replay operating in frame-wise (1:1) synchronous mode (no replay interpolation)");
         }
         bRecorderInitiated = true;
     }
+    auto *Recorder = UCarlaStatics::GetRecorder(GetWorld());
+    if (Recorder != nullptr)
+    {
+        Recorder->SetAsyncWrite(bRecorderAsyncWrite, RecorderWriterBuffers);
+        Recorder->SetKeyframeInterval(RecorderKeyframeInterval);
+        DReyeVRCompactPrecision CompactPrecision;
+        CompactPrecision.Location = RecorderCompactLocation;
+        CompactPrecision.Rotation = RecorderCompactRotation;
+        CompactPrecision.Unit = RecorderCompactUnit;
+        if (bRecorderCompact && !CompactPrecision.IsValid())
+        {
+            LOG_WARN("Compact precisions must be positive, using the defaults");
+        }
+        Recorder->SetCompactEncoding(bRecorderCompact, CompactPrecision);
+        Recorder->SetInternCustomActors(bRecorderInternCustomActors);
+        Recorder->SetRecordEyeSamples(bRecorderEyeSamples);
+        Recorder->SetRecordGazeTraces(bRecorderGazeTraces);
+        Recorder->SetRecordFixations(bRecorderFixations);
+        Recorder->SetRecordDwell(bRecorderDwell);
+        Recorder->SetMemoryMappedReads(bReplayMemoryMapped);
+        Recorder->SetQueryThreads(ReplayQueryThreads);
+        if (bRecorderAsyncWrite)
+        {
+            LOG("Recorder writing to disk asynchronously with %d buffers", RecorderWriterBuffers);
+        }
+    }
 }
 
 void ADReyeVRGameMode::DrawBBoxes()
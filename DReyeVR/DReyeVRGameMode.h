@@ -94,4 +94,21 @@ class ADReyeVRGameMode : public ACarlaGameModeBase
     bool bReplaySync = false;             // false allows for interpolation
     bool bUseCarlaSpectator = false;      // use the Carla spectator or spawn our own
     bool bRecorderInitiated = false;      // allows tick-wise checking for replayer/recorder
+    bool bRecorderAsyncWrite = false;     // write recordings to disk from a background thread
+    int RecorderWriterBuffers = 2;        // number of in-flight frame buffers for the async writer
+    float RecorderKeyframeInterval = 0.f; // seconds between recorded keyframes (0 disables them)
+    bool bRecorderCompact = false;        // delta encode the per-frame Position and DReyeVR packets
+    float RecorderCompactLocation = 0.1f; // quantization of the compact packets (cm, degrees, unitless)
+    float RecorderCompactRotation = 0.01f;
+    float RecorderCompactUnit = 0.0001f;
+    bool bRecorderInternCustomActors = false; // string table + changed fields for custom actor packets
+    bool bRecorderEyeSamples = false;     // record every eye-tracker reading between frames
+    bool bRecorderGazeTraces = false;     // record when the focus was traced (and the per-eye traces)
+    bool bRecorderFixations = false;      // record the EgoSensor's fixation classification
+    bool bRecorderDwell = false;          // record the EgoSensor's per-actor dwell statistics at the end
+    bool bReplayMemoryMapped = false;     // parse recordings from a memory mapping of the file
+    int ReplayQueryThreads = 0;           // threads for the recording file queries (0 = all hardware threads)
+    float ReplayCaptureStartTime = 0.f;   // recording time (s) of the frames that are captured in a synchronous
+    float ReplayCaptureEndTime = 0.f;     // replay (the end stops the replay, 0 for the end of the recording)
+    bool bReplayQuitWhenDone = false;     // quit the simulator once the synchronous replay is done
 };
\ No newline at end of file
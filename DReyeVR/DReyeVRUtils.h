@@ -5,9 +5,8 @@
 #include "ConfigFile.h"                     // ConfigFile class
 #include "CoreMinimal.h"
 #include "Engine/Texture2D.h"              // UTexture2D
-#include "HighResScreenshot.h"             // FHighResScreenshotConfig
-#include "ImageWriteQueue.h"               // TImagePixelData
-#include "ImageWriteTask.h"                // FImageWriteTask
+#include "Engine/TextureRenderTarget2D.h"  // UTextureRenderTarget2D
+#include "UnrealClient.h"                  // FReadSurfaceDataFlags
 #include <carla/image/CityScapesPalette.h> // CityScapesPalette
 
 // instead of vehicle.dreyevr.model3 or sensor.dreyevr.ego_sensor, we use "harplab" for category
@@ -233,40 +232,28 @@ static float CmPerSecondToXPerHour(const bool MilesPerHour)
     return 0.036f;
 }
 
-static void SaveFrameToDisk(UTextureRenderTarget2D &RenderTarget, const FString &FilePath, const bool FileFormatJPG)
+static bool ReadFramePixels(UTextureRenderTarget2D &RenderTarget, TArray<FColor> &Pixels, FIntPoint &Size)
 {
     FTextureRenderTargetResource *RTResource = RenderTarget.GameThread_GetRenderTargetResource();
-    const size_t H = RenderTarget.GetSurfaceHeight();
-    const size_t W = RenderTarget.GetSurfaceWidth();
-    const FIntPoint DestSize(W, H);
-    TImagePixelData<FColor> PixelData(DestSize);
+    Size = FIntPoint(RenderTarget.GetSurfaceWidth(), RenderTarget.GetSurfaceHeight());
 
-    // Read pixels into array
+    // Read pixels into array (blocks until the GPU is done, see FFrameReadback for the alternative)
     // heavily inspired by Carla's Carla/Sensor/PixelReader.cpp:WritePixelsToArray function
-    TArray<FColor> Pixels;
-    Pixels.AddUninitialized(H * W);
+    Pixels.Reset(Size.X * Size.Y);
+    Pixels.AddUninitialized(Size.X * Size.Y);
     FReadSurfaceDataFlags ReadPixelFlags(RCM_UNorm);
     ReadPixelFlags.SetLinearToGamma(true);
     if (RTResource == nullptr)
     {
         LOG_ERROR("Missing render target!");
-        return;
+        return false;
     }
     if (!RTResource->ReadPixels(Pixels, ReadPixelFlags))
+    {
         LOG_ERROR("Unable to read pixels!");
-
-    // dump pixel array to disk
-    PixelData.Pixels = Pixels;
-    TUniquePtr<FImageWriteTask> ImageTask = MakeUnique<FImageWriteTask>();
-    ImageTask->PixelData = MakeUnique<TImagePixelData<FColor>>(PixelData);
-    ImageTask->Filename = FilePath;
-    // LOG("Saving screenshot to %s", *FilePath);
-    ImageTask->Format = FileFormatJPG ? EImageFormat::JPEG : EImageFormat::PNG; // lower quality, less storage
-    ImageTask->CompressionQuality = (int32)EImageCompressionQuality::Default;
-    ImageTask->bOverwriteFile = true;
-    ImageTask->PixelPreProcessors.Add(TAsyncAlphaWrite<FColor>(255));
-    FHighResScreenshotConfig &HighResScreenshotConfig = GetHighResScreenshotConfig();
-    HighResScreenshotConfig.ImageWriteQueue->Enqueue(MoveTemp(ImageTask));
+        return false;
+    }
+    return true;
 }
 
 static UTexture2D *CreateTexture2DFromArray(const TArray<FColor> &Contents)
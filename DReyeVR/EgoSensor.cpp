@@ -1,12 +1,15 @@
 #include "EgoSensor.h"
 
-#include "Carla/Game/CarlaStatics.h"    // GetCurrentEpisode
-#include "DReyeVRUtils.h"               // GeneralParams.Get, ComputeClosestToRayIntersection
-#include "EgoVehicle.h"                 // AEgoVehicle
-#include "Kismet/GameplayStatics.h"     // UGameplayStatics::ProjectWorldToScreen
-#include "Kismet/KismetMathLibrary.h"   // Sin, Cos, Normalize
-#include "Misc/DateTime.h"              // FDateTime
-#include "UObject/UObjectBaseUtility.h" // GetName
+#include "Carla/Game/CarlaStatics.h"          // GetCurrentEpisode
+#include "Carla/Util/BoundingBoxCalculator.h" // UBoundingBoxCalculator::GetActorBoundingBox
+#include "DReyeVRUtils.h"                     // GeneralParams.Get, ComputeClosestToRayIntersection
+#include "EgoVehicle.h"                       // AEgoVehicle
+#include "HAL/PlatformTime.h"                 // FPlatformTime::Seconds
+#include "Kismet/GameplayStatics.h"           // UGameplayStatics::ProjectWorldToScreen
+#include "Kismet/KismetMathLibrary.h"         // Sin, Cos, Normalize
+#include "Misc/Compression.h"                 // FCompression
+#include "Misc/DateTime.h"                    // FDateTime
+#include "UObject/UObjectBaseUtility.h"       // GetName
 
 #if USE_SRANIPAL_PLUGIN
 #include "SRanipal_API.h" // SRanipal_GetVersion
@@ -44,8 +47,42 @@ AEgoSensor::AEgoSensor(const FObjectInitializer &ObjectInitializer) : Super(Obje
 void AEgoSensor::ReadConfigVariables()
 {
     GeneralParams.Get("EgoSensor", "StreamSensorData", bStreamData);
+    GeneralParams.Get("EgoSensor", "BinaryStream", bStreamBinary);
+    FString StreamFieldsStr; // (overridden by the sensor's "fields" attribute)
+    if (GeneralParams.Get("EgoSensor", "StreamFields", StreamFieldsStr))
+        SetStreamFields(StreamFieldsStr);
+    GeneralParams.Get("EgoSensor", "SharedMemory", bSharedMemory);
+    GeneralParams.Get("EgoSensor", "SharedMemoryName", SharedMemoryName);
+    GeneralParams.Get("EgoSensor", "SharedMemorySlots", SharedMemorySlots);
     GeneralParams.Get("EgoSensor", "MaxTraceLenM", MaxTraceLenM);
     GeneralParams.Get("EgoSensor", "DrawDebugFocusTrace", bDrawDebugFocusTrace);
+    GeneralParams.Get("EgoSensor", "AsyncFocusTrace", bAsyncFocusTrace);
+    GeneralParams.Get("EgoSensor", "AsyncEyeTracker", bAsyncEyeTracker);
+    GeneralParams.Get("EgoSensor", "EyeTrackerHz", EyeTrackerHz);
+    GeneralParams.Get("EgoSensor", "ClassifyFixations", bClassifyFixations);
+    {
+        DReyeVRGazeClassifierParams Params = GazeClassifier.GetParams();
+        FString Method;
+        if (GeneralParams.Get("EgoSensor", "FixationMethod", Method) &&
+            !DReyeVRGazeClassifierParams::ParseMethod(TCHAR_TO_UTF8(*Method), Params.Method))
+            LOG_WARN("Unknown [EgoSensor] FixationMethod \"%s\" (IVT or IDT), using %s", *Method,
+                     Params.Method == DReyeVRGazeClassifierParams::EMethod::Velocity ? TEXT("IVT") : TEXT("IDT"));
+        GeneralParams.Get("EgoSensor", "FixationVelocity", Params.VelocityThreshold);
+        GeneralParams.Get("EgoSensor", "FixationDispersion", Params.DispersionThreshold);
+        GeneralParams.Get("EgoSensor", "FixationMinDuration", Params.MinDuration);
+        GeneralParams.Get("EgoSensor", "FixationMaxGap", Params.MaxGap);
+        GazeClassifier.SetParams(Params);
+    }
+    GeneralParams.Get("EgoSensor", "AccumulateDwell", bAccumulateDwell);
+    int DwellMaxActors = static_cast<int>(Dwell.GetMaxActors());
+    if (GeneralParams.Get("EgoSensor", "DwellMaxActors", DwellMaxActors))
+        Dwell.SetMaxActors(static_cast<uint32_t>(FMath::Max(DwellMaxActors, 1)));
+    GeneralParams.Get("EgoSensor", "GazeConeAngle", GazeConeAngle);
+    GeneralParams.Get("EgoSensor", "GazeConeMaxActors", GazeConeMaxActors);
+    GeneralParams.Get("EgoSensor", "GazeConeBenchmark", bGazeConeBenchmark);
+    float GazeConeCellSizeM = GazeConeIndex.GetCellSize() / 100.f;
+    if (GeneralParams.Get("EgoSensor", "GazeConeCellSize", GazeConeCellSizeM))
+        GazeConeIndex.SetCellSize(100.f * GazeConeCellSizeM); // m to cm
 
     // variables corresponding to the action of screencapture during replay
     GeneralParams.Get("Replayer", "RecordAllShaders", bRecordAllShaders);
@@ -57,6 +94,13 @@ void AEgoSensor::ReadConfigVariables()
     GeneralParams.Get("Replayer", "FrameHeight", FrameCapHeight);
     GeneralParams.Get("Replayer", "FrameDir", FrameCapLocation);
     GeneralParams.Get("Replayer", "FrameName", FrameCapFilename);
+    GeneralParams.Get("Replayer", "FramesInFlight", FramesInFlight);
+    GeneralParams.Get("Replayer", "CaptureRig", bCaptureRig);
+    GeneralParams.Get("Replayer", "EncoderThreads", EncoderThreads);
+    GeneralParams.Get("Replayer", "EncoderMemoryBudgetMB", EncoderMemoryBudgetMB);
+    GeneralParams.Get("Replayer", "FrameOutput", FrameOutput);
+    GeneralParams.Get("Replayer", "FrameContainerCodec", FrameContainerCodec);
+    GeneralParams.Get("Replayer", "FrameContainerBuffers", FrameContainerBuffers);
 
 #if USE_FOVEATED_RENDER
     // foveated rendering variables
@@ -74,6 +118,14 @@ void AEgoSensor::BeginPlay()
 
     // Initialize the eye tracker hardware
     InitEyeTracker();
+    if (bAsyncEyeTracker)
+    {
+        /// NOTE: this assumes the SRanipal SDK (GetEyeData_ in SampleEyeTracker) is safe to call from a thread
+        /// other than the game thread, which is not documented. Hence off by default, in which case the eye tracker
+        /// is sampled on the game thread once per tick
+        EyeTrackerSampler = MakeUnique<FEyeTrackerSampler>(
+            [this](DReyeVR::EyeTracker &Out) { return SampleEyeTracker(Out); }, EyeTrackerHz);
+    }
 
 #if USE_FOVEATED_RENDER
     // Initialize VRS plugin (using our VRS fork!)
@@ -94,6 +146,10 @@ void AEgoSensor::BeginDestroy()
         delete RecordingCF;
     }
 
+    EyeTrackerSampler.Reset(); // joins the sampling thread before the eye tracker goes away
+    FrameReadback.Reset();     // writes the captures that are still in flight
+    CloseFrameContainer();     // (after the readback, which hands it the last frames)
+    FrameEncoder.Reset();      // encodes and writes the images that are still queued
     DestroyEyeTracker();
 
     LOG("EgoSensor has been destroyed");
@@ -101,13 +157,16 @@ void AEgoSensor::BeginDestroy()
 
 void AEgoSensor::ManualTick(float DeltaSeconds)
 {
+    EyeTrackerSamples.Reset(); // only the live sensor has readings to stream
     if (!ADReyeVRSensor::bIsReplaying) // only update the sensor with local values if not replaying
     {
         const float Timestamp = int64_t(1000.f * UGameplayStatics::GetRealTimeSeconds(World));
-        /// TODO: query the eye tracker hardware asynchronously (not limited to UE4 tick)
-        TickEyeTracker();   // query the eye-tracker hardware for current data
-        ComputeFocusInfo(); // compute gaze focus data
-        ComputeEgoVars();   // get all necessary ego-vehicle data
+        TickEyeTracker();              // readings of the eye-tracker hardware since the last tick
+        ComputeFocusInfo();            // compute gaze focus data
+        TickFixations();               // classify the eye-tracker readings into fixations/saccades
+        TickDwell(int64_t(Timestamp)); // accumulate the gaze dwell time on the focused actor
+        TickGazeCone();                // actors around the gaze ray
+        ComputeEgoVars();              // get all necessary ego-vehicle data
 
         // Update the internal sensor data that gets handed off to Carla (for recording/replaying/PythonAPI)
         const auto &Inputs = Vehicle.IsValid() ? Vehicle.Get()->GetVehicleInputs() : DReyeVR::UserInputs{};
@@ -117,8 +176,11 @@ void AEgoSensor::ManualTick(float DeltaSeconds)
                           FocusInfoData, // FocusData
                           Inputs         // User inputs
         );
+        GetData()->UpdateFixations(FixationInfoData);
         TickFoveatedRender();
     }
+    if (FrameReadback)
+        FrameReadback->Poll(); // write the replay frames whose pixels are back from the GPU
     TickCount++;
 }
 
@@ -192,16 +254,46 @@ void AEgoSensor::DestroyEyeTracker()
 
 void AEgoSensor::TickEyeTracker()
 {
-    /// TODO: move this function to an async thread to obtain 120hz data capture
-    auto Combined = &(EyeSensorData.Combined);
-    auto Left = &(EyeSensorData.Left);
-    auto Right = &(EyeSensorData.Right);
+    EyeTrackerSamples.Reset();
+    if (EyeTrackerSampler.IsValid())
+    {
+        // every reading taken by the sampling thread since the previous tick, the latest drives this tick
+        EyeTrackerSampler->Drain(EyeTrackerSamples);
+        if (EyeTrackerSamples.Num() > 0)
+            EyeSensorData = EyeTrackerSamples.Last();
+        return;
+    }
+    if (SampleEyeTracker(EyeSensorData))
+        EyeTrackerSamples.Add(EyeSensorData);
+}
+
+bool AEgoSensor::SampleEyeTracker(DReyeVR::EyeTracker &Out)
+{
+    /// NOTE: this is called from the eye tracker thread when AsyncEyeTracker is enabled, so it only touches Out
+    /// and the state of the sampling itself
+    auto Combined = &(Out.Combined);
+    auto Left = &(Out.Left);
+    auto Right = &(Out.Right);
 #if USE_SRANIPAL_PLUGIN
     if (bSRanipalEnabled)
     {
+        check(SRanipal != nullptr);
+        // Get the "EyeData" which holds useful information such as the timestamp
+        ViveSR::anipal::Eye::EyeData EyeData;
+        int EyeDataStatus = SRanipal->GetEyeData_(&EyeData);
+        if (EyeDataStatus == ViveSR::Error::WORK)
+        {
+            if (EyeData.frame_sequence == LastDeviceFrame)
+                return false; // the device has no new frame yet
+            LastDeviceFrame = EyeData.frame_sequence;
+            Out.TimestampDevice = EyeData.timestamp;
+            Out.FrameSequence = EyeData.frame_sequence;
+            // Assign Pupil Diameters
+            Left->PupilDiameter = EyeData.verbose_data.left.pupil_diameter_mm;
+            Right->PupilDiameter = EyeData.verbose_data.right.pupil_diameter_mm;
+        }
         /// NOTE: the GazeRay is the normalized direction vector of the actual gaze "ray"
         // Getting real eye tracker data
-        check(SRanipal != nullptr);
         // Assigns EyeOrigin and Gaze direction (normalized) of combined gaze
         Combined->GazeValid = SRanipal->GetGazeRay(GazeIndex::COMBINE, Combined->GazeOrigin, Combined->GazeDir);
         // Assign Left/Right Gaze direction
@@ -220,45 +312,33 @@ void AEgoSensor::TickEyeTracker()
         // Assign Pupil positions
         Left->PupilPositionValid = SRanipal->GetPupilPosition(EyeIndex::LEFT, Left->PupilPosition);
         Right->PupilPositionValid = SRanipal->GetPupilPosition(EyeIndex::RIGHT, Right->PupilPosition);
-
-        // Get the "EyeData" which holds useful information such as the timestamp
-        int EyeDataStatus = SRanipal->GetEyeData_(&EyeData);
-        if (EyeDataStatus == ViveSR::Error::WORK)
-        {
-            EyeSensorData.TimestampDevice = EyeData.timestamp;
-            EyeSensorData.FrameSequence = EyeData.frame_sequence;
-            // Assign Pupil Diameters
-            Left->PupilDiameter = EyeData.verbose_data.left.pupil_diameter_mm;
-            Right->PupilDiameter = EyeData.verbose_data.right.pupil_diameter_mm;
-        }
     }
     else
     {
-        ComputeDummyEyeData();
+        ComputeDummyEyeData(Out);
     }
 #else
-    ComputeDummyEyeData();
+    ComputeDummyEyeData(Out);
 #endif
     Combined->Vergence = ComputeVergence(Left->GazeOrigin, Left->GazeDir, Right->GazeOrigin, Right->GazeDir);
-
-    // FPlatformProcess::Sleep(0.00833f); // use in async thread to get 120hz
+    return true;
 }
 
-void AEgoSensor::ComputeDummyEyeData()
+void AEgoSensor::ComputeDummyEyeData(DReyeVR::EyeTracker &Out)
 {
     // Function to make "dummy" eye data where the eye gaze just looks around in a CCW circle.
     // Useful for when the eye data is unavailable (Plugin not initialized, on Linux, etc.)
-    auto Combined = &(EyeSensorData.Combined);
-    auto Left = &(EyeSensorData.Left);
-    auto Right = &(EyeSensorData.Right);
+    auto Combined = &(Out.Combined);
+    auto Left = &(Out.Left);
+    auto Right = &(Out.Right);
     // generate dummy values bc no hardware sensor is present
-    EyeSensorData.TimestampDevice = int64_t(
+    Out.TimestampDevice = int64_t(
         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - ChronoStartTime)
             .count());
-    EyeSensorData.FrameSequence = TickCount; // get the current tick
+    Out.FrameSequence = DummySampleCount++; // one "device frame" per reading
 
     // generate gaze that rotates in CCW fashion around the camera ray
-    const float TimeNow = EyeSensorData.TimestampDevice / 1000.f;
+    const float TimeNow = Out.TimestampDevice / 1000.f;
     Combined->GazeDir.X = 5.0;
     Combined->GazeDir.Y = UKismetMathLibrary::Cos(TimeNow);
     Combined->GazeDir.Z = UKismetMathLibrary::Sin(TimeNow);
@@ -281,23 +361,44 @@ void AEgoSensor::ComputeFocusInfo()
     // ECC_Camera: Usually used when tracing from the camera to something.
     // https://docs.unrealengine.com/4.27/en-US/API/Runtime/Engine/Engine/ECollisionChannel/
     // https://zompidev.blogspot.com/2021/08/visibility-vs-camera-trace-channels-in.html
-    ComputeTraceFocusInfo(ECC_Visibility);
+    if (bAsyncFocusTrace)
+    {
+        ComputeAsyncFocusInfo(ECC_Visibility);
+    }
+    else
+    {
+        ComputeTraceFocusInfo(ECC_Visibility);
+        GazeTraceData = DReyeVR::GazeTraces(); // (no per-eye traces)
+        GazeTraceData.IssuedFrame = GFrameCounter;
+        GazeTraceData.ConsumedFrame = GFrameCounter;
+    }
 }
 
-bool AEgoSensor::ComputeGazeTrace(FHitResult &Hit, const ECollisionChannel TraceChannel, float TraceRadius) const
+void AEgoSensor::GetGazeRay(DReyeVR::Gaze Index, FVector &Start, FVector &End) const
 {
     const float TraceLen = MaxTraceLenM * 100.f; // convert to m from cm
     const FRotator &WorldRot = GetData()->GetCameraRotationAbs();
     const FVector &WorldPos = GetData()->GetCameraLocationAbs();
-    const FVector GazeOrigin = WorldPos + WorldRot.RotateVector(GetData()->GetGazeOrigin());
-    const FVector GazeRay = TraceLen * WorldRot.RotateVector(GetData()->GetGazeDir()).GetSafeNormal();
+    Start = WorldPos + WorldRot.RotateVector(GetData()->GetGazeOrigin(Index));
+    End = Start + TraceLen * WorldRot.RotateVector(GetData()->GetGazeDir(Index)).GetSafeNormal();
+}
+
+FCollisionQueryParams AEgoSensor::GetGazeTraceParams() const
+{
     // Create collision information container.
-    FCollisionQueryParams TraceParam;
-    TraceParam = FCollisionQueryParams(FName("TraceParam"), true);
+    FCollisionQueryParams TraceParam = FCollisionQueryParams(FName("TraceParam"), true);
     if (Vehicle.IsValid())
         TraceParam.AddIgnoredActor(Vehicle.Get()); // don't collide with the vehicle since that would be useless
     TraceParam.bTraceComplex = true;
     TraceParam.bReturnPhysicalMaterial = false;
+    return TraceParam;
+}
+
+bool AEgoSensor::ComputeGazeTrace(FHitResult &Hit, const ECollisionChannel TraceChannel, float TraceRadius) const
+{
+    FVector GazeOrigin, GazeEnd;
+    GetGazeRay(DReyeVR::Gaze::COMBINED, GazeOrigin, GazeEnd);
+    const FCollisionQueryParams TraceParam = GetGazeTraceParams();
     Hit = FHitResult(EForceInit::ForceInit);
     bool bDidHit = false;
 
@@ -307,40 +408,37 @@ bool AEgoSensor::ComputeGazeTrace(FHitResult &Hit, const ECollisionChannel Trace
     ensure(World != nullptr);
     if (TraceRadius == 0.f) // Single ray/line trace
     {
-        bDidHit = World->LineTraceSingleByChannel(Hit, GazeOrigin, GazeOrigin + GazeRay, TraceChannel, TraceParam);
+        bDidHit = World->LineTraceSingleByChannel(Hit, GazeOrigin, GazeEnd, TraceChannel, TraceParam);
     }
     else // Sphear line trace
     {
         FCollisionShape Sphear = FCollisionShape();
         Sphear.SetSphere(TraceRadius);
-        bDidHit = World->SweepSingleByChannel(Hit, GazeOrigin, GazeOrigin + GazeRay, FQuat(0.f, 0.f, 0.f, 0.f),
-                                              TraceChannel, Sphear, TraceParam);
+        bDidHit = World->SweepSingleByChannel(Hit, GazeOrigin, GazeEnd, FQuat(0.f, 0.f, 0.f, 0.f), TraceChannel,
+                                              Sphear, TraceParam);
     }
 
     if (!bDidHit)
     {
         // focus point is just straight ahead to the maximum trace length
         Hit.Actor = nullptr;
-        Hit.Location = GazeOrigin + GazeRay;
-        Hit.Distance = TraceLen;
+        Hit.Location = GazeEnd;
+        Hit.Distance = MaxTraceLenM * 100.f;
     }
 
     if (bDrawDebugFocusTrace)
     {
         DrawDebugSphere(World, Hit.Location, 8.0f, 30, FColor::Blue);
         DrawDebugLine(World,
-                      GazeOrigin,           // start line
-                      GazeOrigin + GazeRay, // end line
+                      GazeOrigin, // start line
+                      GazeEnd,    // end line
                       FColor::Purple, false, -1, 0, 1);
     }
     return bDidHit;
 }
 
-void AEgoSensor::ComputeTraceFocusInfo(const ECollisionChannel TraceChannel, float TraceRadius)
+void AEgoSensor::ToFocusInfo(const FHitResult &Hit, bool bDidHit, DReyeVR::FocusInfo &Out) const
 {
-    FHitResult Hit;
-    bool bDidHit = ComputeGazeTrace(Hit, TraceChannel, TraceRadius);
-    // Update fields
     FString ActorName = "None";
     if (Hit.Actor != nullptr)
     {
@@ -357,12 +455,201 @@ void AEgoSensor::ComputeTraceFocusInfo(const ECollisionChannel TraceChannel, flo
     }
 
     // update internal data structure (see DReyeVRData::FocusInfo)
-    FocusInfoData.Actor = Hit.Actor;        // pointer to actor being hit (if any, else nullptr)
-    FocusInfoData.HitPoint = Hit.Location;  // absolute (world) location of hit
-    FocusInfoData.Normal = Hit.Normal;      // normal of hit surface (if hit)
-    FocusInfoData.ActorNameTag = ActorName; // name of the actor being hit (if any, else "None")
-    FocusInfoData.Distance = Hit.Distance;  // distance from ray start
-    FocusInfoData.bDidHit = bDidHit;        // whether or not there was a hit
+    Out.Actor = Hit.Actor;        // pointer to actor being hit (if any, else nullptr)
+    Out.HitPoint = Hit.Location;  // absolute (world) location of hit
+    Out.Normal = Hit.Normal;      // normal of hit surface (if hit)
+    Out.ActorNameTag = ActorName; // name of the actor being hit (if any, else "None")
+    Out.Distance = Hit.Distance;  // distance from ray start
+    Out.bDidHit = bDidHit;        // whether or not there was a hit
+}
+
+void AEgoSensor::ComputeTraceFocusInfo(const ECollisionChannel TraceChannel, float TraceRadius)
+{
+    FHitResult Hit;
+    bool bDidHit = ComputeGazeTrace(Hit, TraceChannel, TraceRadius);
+    ToFocusInfo(Hit, bDidHit, FocusInfoData);
+}
+
+void AEgoSensor::ComputeAsyncFocusInfo(const ECollisionChannel TraceChannel, float TraceRadius)
+{
+    ensure(World != nullptr);
+    FGazeTraceBatch &Batch = GazeTraceBatch;
+
+    // consume the batch issued on the previous tick (the engine ran it alongside the rest of that frame)
+    if (Batch.bPending)
+    {
+        Batch.bPending = false;
+        FHitResult Hits[FGazeTraceBatch::Num];
+        bool bDidHit[FGazeTraceBatch::Num];
+        bool bComplete = true;
+        for (int32 i = 0; i < FGazeTraceBatch::Num; i++)
+        {
+            FTraceDatum Datum;
+            if (!World->QueryTraceData(Batch.Handles[i], Datum)) // (only kept for the frame after it was issued)
+            {
+                bComplete = false;
+                break;
+            }
+            // single traces return at most the first blocking hit
+            bDidHit[i] = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+            Hits[i] = bDidHit[i] ? Datum.OutHits[0] : FHitResult(EForceInit::ForceInit);
+            if (!bDidHit[i])
+            {
+                // focus point is just straight ahead to the maximum trace length
+                Hits[i].Actor = nullptr;
+                Hits[i].Location = Batch.Ends[i];
+                Hits[i].Distance = MaxTraceLenM * 100.f;
+            }
+        }
+
+        if (bComplete)
+        {
+            ToFocusInfo(Hits[0], bDidHit[0], FocusInfoData);
+            GazeTraceData.IssuedFrame = Batch.IssuedFrame;
+            GazeTraceData.ConsumedFrame = GFrameCounter;
+            GazeTraceData.bAsync = true;
+            ToFocusInfo(Hits[1], bDidHit[1], GazeTraceData.Left);
+            ToFocusInfo(Hits[2], bDidHit[2], GazeTraceData.Right);
+            if (bDrawDebugFocusTrace)
+            {
+                DrawDebugSphere(World, Hits[0].Location, 8.0f, 30, FColor::Blue);
+                DrawDebugLine(World, Batch.Starts[0], Batch.Ends[0], FColor::Purple, false, -1, 0, 1);
+            }
+        }
+        else if (NumLostGazeTraces++ == 0) // (keeps the previous focus)
+        {
+            LOG_WARN("Async gaze traces issued on frame %llu were gone on frame %llu", Batch.IssuedFrame,
+                     GFrameCounter);
+        }
+    }
+
+    // and issue this tick's batch: combined, left, and right gaze rays
+    const DReyeVR::Gaze Rays[FGazeTraceBatch::Num] = {DReyeVR::Gaze::COMBINED, DReyeVR::Gaze::LEFT,
+                                                      DReyeVR::Gaze::RIGHT};
+    const FCollisionQueryParams TraceParam = GetGazeTraceParams();
+    TraceRadius = FMath::Max(TraceRadius, 0.f); // 0 for a point, >0 for a sphear trace
+    FCollisionShape Sphear = FCollisionShape();
+    Sphear.SetSphere(TraceRadius);
+    for (int32 i = 0; i < FGazeTraceBatch::Num; i++)
+    {
+        GetGazeRay(Rays[i], Batch.Starts[i], Batch.Ends[i]);
+        if (TraceRadius == 0.f) // Single ray/line trace
+            Batch.Handles[i] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Batch.Starts[i], Batch.Ends[i],
+                                                              TraceChannel, TraceParam);
+        else // Sphear line trace
+            Batch.Handles[i] = World->AsyncSweepByChannel(EAsyncTraceType::Single, Batch.Starts[i], Batch.Ends[i],
+                                                          FQuat::Identity, TraceChannel, Sphear, TraceParam);
+    }
+    Batch.IssuedFrame = GFrameCounter;
+    Batch.bPending = true;
+}
+
+namespace
+{
+DReyeVR::FixationEvent ToFixationEvent(const DReyeVRFixationEvent &In)
+{
+    DReyeVR::FixationEvent Out;
+    Out.bStart = In.bStart;
+    Out.Start = In.Start;
+    Out.End = In.End;
+    Out.Direction = FVector2D(In.Yaw, In.Pitch);
+    Out.ActorNameTag = In.Actor.empty() ? FString("None") : FString(UTF8_TO_TCHAR(In.Actor.c_str()));
+    return Out;
+}
+} // namespace
+
+void AEgoSensor::TickFixations()
+{
+    FixationInfoData.Events.Reset();
+    if (!bClassifyFixations)
+        return;
+    // every reading since the last tick (with this tick's focus, the traces are only done once per tick)
+    const std::string Actor = TCHAR_TO_UTF8(*FocusInfoData.ActorNameTag);
+    FixationEvents.clear();
+    for (const DReyeVR::EyeTracker &Eyes : EyeTrackerSamples)
+    {
+        const FVector &Dir = Eyes.Combined.GazeDir;
+        GazeClassifier.Add(Eyes.TimestampDevice, Dir.X, Dir.Y, Dir.Z, Eyes.Combined.GazeValid, Actor, FixationEvents);
+    }
+    for (const DReyeVRFixationEvent &Event : FixationEvents)
+        FixationInfoData.Events.Add(ToFixationEvent(Event));
+    FixationInfoData.bFixating = GazeClassifier.IsFixating();
+    FixationInfoData.Current = ToFixationEvent(GazeClassifier.GetFixation());
+}
+
+void AEgoSensor::TickDwell(int64_t Timestamp)
+{
+    if (!bAccumulateDwell)
+        return;
+    // keyed by the Carla actor id (the same as world.get_actor in the PythonAPI), 0 for the scenery
+    uint32_t ActorId = 0;
+    UCarlaEpisode *Episode = UCarlaStatics::GetCurrentEpisode(World);
+    if (Episode != nullptr && FocusInfoData.bDidHit && FocusInfoData.Actor.IsValid())
+    {
+        const FCarlaActor *CarlaActor = Episode->FindCarlaActor(FocusInfoData.Actor.Get());
+        if (CarlaActor != nullptr)
+            ActorId = CarlaActor->GetActorId();
+    }
+    Dwell.Add(Timestamp, ActorId);
+    // fixations confirmed this tick count for the actor focused now (the readings are of the device clock, so the
+    // start is moved back by the fixation's duration so far)
+    for (const DReyeVR::FixationEvent &Event : FixationInfoData.Events)
+        if (Event.bStart)
+            Dwell.AddFixation(Timestamp - (Event.End - Event.Start), ActorId);
+}
+
+void AEgoSensor::TickGazeCone()
+{
+    GazeConeHits.clear();
+    UCarlaEpisode *Episode = UCarlaStatics::GetCurrentEpisode(World);
+    if (GazeConeAngle <= 0.f || Episode == nullptr)
+        return;
+    const double StartTime = FPlatformTime::Seconds();
+
+    // move the actors in the grid (those that did not move cost a distance check)
+    GazeConeIndex.BeginUpdate();
+    const FActorRegistry &Registry = Episode->GetActorRegistry();
+    for (auto It = Registry.begin(); It != Registry.end(); ++It)
+    {
+        const FCarlaActor *View = It.Value().Get();
+        const AActor *Actor = View != nullptr ? View->GetActor() : nullptr;
+        if (Actor == nullptr || Actor == Vehicle.Get())
+            continue;
+        const uint32 Id = View->GetActorId();
+        FVector4 *Bounds = GazeConeBounds.Find(Id);
+        if (Bounds == nullptr)
+        {
+            // the bounding box is computed once per actor (from its meshes, too slow for every tick)
+            const FBoundingBox Box = UBoundingBoxCalculator::GetActorBoundingBox(Actor);
+            Bounds = &GazeConeBounds.Add(Id, FVector4(Box.Origin, Box.Extent.Size()));
+        }
+        if (Bounds->W <= 0.f) // (spectator, sensors)
+            continue;
+        const FVector Center = Actor->GetActorTransform().TransformPosition(FVector(*Bounds));
+        GazeConeIndex.Update(Id, {Center.X, Center.Y, Center.Z}, Bounds->W);
+    }
+    GazeConeIndex.RemoveStale([this](uint32_t Id) { GazeConeBounds.Remove(Id); });
+
+    FVector Start, End;
+    GetGazeRay(DReyeVR::Gaze::COMBINED, Start, End);
+    const FVector Dir = (End - Start).GetSafeNormal();
+    GazeConeIndex.Query({Start.X, Start.Y, Start.Z}, {Dir.X, Dir.Y, Dir.Z}, GazeConeAngle, MaxTraceLenM * 100.f,
+                        static_cast<size_t>(FMath::Max(GazeConeMaxActors, 0)), GazeConeHits);
+
+    if (bGazeConeBenchmark)
+    {
+        // against the physics alternative: a sphere sweep as wide as the cone is 10m ahead (only the first hit)
+        const double SweepStartTime = FPlatformTime::Seconds();
+        FHitResult Hit;
+        ComputeGazeTrace(Hit, ECC_Visibility, 1000.f * FMath::Tan(FMath::DegreesToRadians(GazeConeAngle)));
+        GazeConeSweepSeconds += FPlatformTime::Seconds() - SweepStartTime;
+        GazeConeSeconds += SweepStartTime - StartTime;
+        if (++GazeConeTicks % 600 == 0)
+        {
+            LOG("Gaze cone over %d actors: %.2f us/tick (sphere sweep %.2f us/tick)", int32(GazeConeIndex.Num()),
+                1e6 * GazeConeSeconds / GazeConeTicks, 1e6 * GazeConeSweepSeconds / GazeConeTicks);
+        }
+    }
 }
 
 float AEgoSensor::ComputeVergence(const FVector &L0, const FVector &LDir, const FVector &R0, const FVector &RDir) const
@@ -418,38 +705,49 @@ void AEgoSensor::ComputeEgoVars()
 /// ---------------:FRAMECAP:----------------- ///
 /// ========================================== ///
 
+static void InitFrameCaptureTarget(UTextureRenderTarget2D &Target, int Width, int Height, bool bForceLinearGamma)
+{
+    Target.CompressionSettings = TextureCompressionSettings::TC_Default;
+    Target.SRGB = false;
+    Target.bAutoGenerateMips = false;
+    Target.bGPUSharedFlag = true;
+    Target.ClearColor = FLinearColor::Black;
+    Target.UpdateResourceImmediate(true);
+    // Target.OverrideFormat = EPixelFormat::PF_FloatRGB;
+    Target.AddressX = TextureAddress::TA_Clamp;
+    Target.AddressY = TextureAddress::TA_Clamp;
+    Target.InitCustomFormat(Width, Height, PF_B8G8R8A8, bForceLinearGamma);
+    check(Target.GetSurfaceWidth() > 0 && Target.GetSurfaceHeight() > 0);
+}
+
+static void InitFrameCaptureComponent(USceneCaptureComponent2D &Capture, UTextureRenderTarget2D *Target,
+                                      size_t ShaderIdx)
+{
+    Capture.PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_RenderScenePrimitives;
+    Capture.bCaptureOnMovement = false;
+    Capture.bCaptureEveryFrame = false;
+    Capture.bAlwaysPersistRenderingState = true;
+    Capture.CaptureSource = ESceneCaptureSource::SCS_FinalColorLDR;
+
+    // apply postprocessing effects
+    Capture.PostProcessSettings = CreatePostProcessingEffect(ShaderIdx);
+
+    Capture.Deactivate();
+    Capture.TextureTarget = Target;
+    Capture.UpdateContent();
+    Capture.Activate();
+}
+
 void AEgoSensor::ConstructFrameCapture()
 {
     if (bCaptureFrameData)
     {
         // Frame capture
         CaptureRenderTarget = CreateDefaultSubobject<UTextureRenderTarget2D>(TEXT("CaptureRenderTarget_DReyeVR"));
-        CaptureRenderTarget->CompressionSettings = TextureCompressionSettings::TC_Default;
-        CaptureRenderTarget->SRGB = false;
-        CaptureRenderTarget->bAutoGenerateMips = false;
-        CaptureRenderTarget->bGPUSharedFlag = true;
-        CaptureRenderTarget->ClearColor = FLinearColor::Black;
-        CaptureRenderTarget->UpdateResourceImmediate(true);
-        // CaptureRenderTarget->OverrideFormat = EPixelFormat::PF_FloatRGB;
-        CaptureRenderTarget->AddressX = TextureAddress::TA_Clamp;
-        CaptureRenderTarget->AddressY = TextureAddress::TA_Clamp;
-        CaptureRenderTarget->InitCustomFormat(FrameCapWidth, FrameCapHeight, PF_B8G8R8A8, bFrameCapForceLinearGamma);
-        check(CaptureRenderTarget->GetSurfaceWidth() > 0 && CaptureRenderTarget->GetSurfaceHeight() > 0);
+        InitFrameCaptureTarget(*CaptureRenderTarget, FrameCapWidth, FrameCapHeight, bFrameCapForceLinearGamma);
 
         FrameCap = CreateDefaultSubobject<USceneCaptureComponent2D>(TEXT("FrameCap"));
-        FrameCap->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_RenderScenePrimitives;
-        FrameCap->bCaptureOnMovement = false;
-        FrameCap->bCaptureEveryFrame = false;
-        FrameCap->bAlwaysPersistRenderingState = true;
-        FrameCap->CaptureSource = ESceneCaptureSource::SCS_FinalColorLDR;
-
-        // apply postprocessing effects
-        FrameCap->PostProcessSettings = CreatePostProcessingEffect(0);
-
-        FrameCap->Deactivate();
-        FrameCap->TextureTarget = CaptureRenderTarget;
-        FrameCap->UpdateContent();
-        FrameCap->Activate();
+        InitFrameCaptureComponent(*FrameCap, CaptureRenderTarget, 0);
     }
     if (FrameCap && !bCaptureFrameData)
     {
@@ -466,8 +764,9 @@ void AEgoSensor::InitFrameCapture()
             FrameCap->SetupAttachment(Vehicle.Get()->GetCamera());
 
         // creates the directory for the frame capture to take place
-        /// TODO: add check for absolute paths
-        FrameCapLocation = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir() + FrameCapLocation);
+        // (relative to the project, or absolute ex. per instance with Tools/ParallelCapture)
+        if (FPaths::IsRelative(FrameCapLocation))
+            FrameCapLocation = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir() + FrameCapLocation);
         // The returned string has the following format: yyyy.mm.dd-hh.mm.ss
         FString DirName = FDateTime::Now().ToString(); // timestamp directory
         FrameCapLocation = FPaths::Combine(FrameCapLocation, DirName);
@@ -489,22 +788,62 @@ void AEgoSensor::InitFrameCapture()
     }
 }
 
-void AEgoSensor::TakeScreenshot()
+bool AEgoSensor::IsReadyForScreenshot()
+{
+    // the synchronous replayer waits (does not advance) while the frames in flight are not written yet, or while the
+    // images waiting to be encoded are over their memory budget
+    return (!FrameReadback || FrameReadback->HasRoom()) && (!FrameEncoder || FrameEncoder->HasRoom());
+}
+
+void AEgoSensor::FinishScreenshots()
+{
+    // like BeginDestroy, but the encoders keep running (they are stopped when the sensor is destroyed)
+    if (FrameReadback)
+        FrameReadback->Flush(); // hands the captures in flight to the encoders or the containers
+    if (FrameEncoder)
+        FrameEncoder->Flush(); // waits for the queued images to be written
+    CloseFrameContainer();     // writes the queued frames and the containers' indices
+}
+
+void AEgoSensor::TakeScreenshot(int64 ReplayFrame)
 {
     /// NOTE: this is a slow function that takes multiple high-res screenshots (with different shader params)
     // of the current scene and writes the images to disk immediately. The intention is to use this function
     // during synchronized replay with screen capture so that performance is not an issue since the simulator
-    // is not necessarily running in real-time.
+    // is not necessarily running in real-time. With [Replayer] FramesInFlight the pixels are read back a few frames
+    // later instead (FFrameReadback), so the game thread does not wait for the GPU on every capture.
 
     // create directory if necessary
     if (bCaptureFrameData && !bCreatedDirectory)
     {
         InitFrameCapture(); // Set up frame capture directory
+        if (FrameOutput.Equals("container", ESearchCase::IgnoreCase))
+            InitFrameContainer();
+        else
+            FrameEncoder =
+                MakeUnique<FFrameEncoder>(EncoderThreads, int64(EncoderMemoryBudgetMB) << 20, bFileFormatJPG);
+        if (FramesInFlight > 0)
+        {
+            FrameReadback = MakeUnique<FFrameReadback>(
+                FramesInFlight, [this](int32 Shader, int32 Pose, int64 Frame, int64 ReplayFrame, int64 Timestamp,
+                                       TArray<FColor> &&Pixels, const FIntPoint &Size) {
+                    WriteFrame(Shader, Pose, Frame, ReplayFrame, Timestamp, MoveTemp(Pixels), Size);
+                });
+        }
+        if (bCaptureRig)
+            InitCaptureRig();
     }
 
     // capture the screenshot to the directory
-    if (bCaptureFrameData && FrameCap && Vehicle.IsValid())
+    if (bCaptureFrameData && FrameCap && Vehicle.IsValid() && CaptureRig.Num() > 0)
     {
+        const double StartTime = FPlatformTime::Seconds();
+        CaptureRigFrame(ReplayFrame);
+        CaptureSeconds += FPlatformTime::Seconds() - StartTime;
+    }
+    else if (bCaptureFrameData && FrameCap && Vehicle.IsValid())
+    {
+        const double StartTime = FPlatformTime::Seconds();
         for (int i = 0; i < GetNumberOfShaders(); i++)
         {
             // apply the postprocessing effect
@@ -515,17 +854,24 @@ void AEgoSensor::TakeScreenshot()
                 // set this pose
                 Vehicle.Get()->SetCameraRootPose(j);
 
-                // using 5 digits to reach frame 99999 ~ 30m (assuming ~50fps frame capture)
-                // suffix is denoted as _s(hader)X_p(ose)Y_Z.png where X is the shader idx, Y is the pose idx, Z is tick
-                const FString Suffix = FString::Printf(TEXT("_s%d_p%d_%05d.png"), i, j, ScreenshotCount);
                 // apply the camera view (position & orientation)
                 FMinimalViewInfo DesiredView;
                 Vehicle.Get()->GetCamera()->GetCameraView(0, DesiredView);
                 FrameCap->SetCameraView(DesiredView); // move camera to the camera view
                 // capture the scene and save the screenshot to disk
                 FrameCap->CaptureScene(); // also available: CaptureSceneDeferred()
-                SaveFrameToDisk(*CaptureRenderTarget, FPaths::Combine(FrameCapLocation, FrameCapFilename + Suffix),
-                                bFileFormatJPG);
+                const int64 Timestamp = GetData()->GetTimestampCarla();
+                if (FrameReadback)
+                {
+                    FrameReadback->Enqueue(*CaptureRenderTarget, i, j, ScreenshotCount, ReplayFrame, Timestamp);
+                }
+                else
+                {
+                    TArray<FColor> Pixels;
+                    FIntPoint Size;
+                    if (ReadFramePixels(*CaptureRenderTarget, Pixels, Size))
+                        WriteFrame(i, j, ScreenshotCount, ReplayFrame, Timestamp, MoveTemp(Pixels), Size);
+                }
                 if (!bRecordAllPoses)
                 {
                     // exit after the first camera pose (seated)
@@ -540,8 +886,150 @@ void AEgoSensor::TakeScreenshot()
                 break;
             }
         }
+        CaptureSeconds += FPlatformTime::Seconds() - StartTime;
+    }
+    if (bCaptureFrameData && FrameCap && Vehicle.IsValid())
+    {
         ScreenshotCount++; // progress to next frame
+        if (ScreenshotCount % 300 == 0)
+        {
+            LOG("Frame capture: %.2f ms/frame on the game thread (%s)", 1e3 * CaptureSeconds / ScreenshotCount,
+                CaptureRig.Num() > 0 ? TEXT("capture rig") : TEXT("one capture at a time"));
+            if (FrameEncoder)
+                FrameEncoder->LogStats();
+        }
+    }
+}
+
+void AEgoSensor::InitCaptureRig()
+{
+    // one capture per shader and pose, their post-processing (which loads the shader materials) is set up once here
+    // instead of for every capture
+    if (!FrameCap || !Vehicle.IsValid())
+        return;
+    const int32 NumShaders = bRecordAllShaders ? static_cast<int32>(GetNumberOfShaders()) : 1;
+    const int32 NumPoses = bRecordAllPoses ? static_cast<int32>(Vehicle.Get()->GetNumCameraPoses()) : 1;
+    for (int32 i = 0; i < NumShaders; i++)
+    {
+        for (int32 j = 0; j < NumPoses; j++)
+        {
+            UTextureRenderTarget2D *Target = NewObject<UTextureRenderTarget2D>(this);
+            InitFrameCaptureTarget(*Target, FrameCapWidth, FrameCapHeight, bFrameCapForceLinearGamma);
+            USceneCaptureComponent2D *Capture = NewObject<USceneCaptureComponent2D>(
+                this, *FString::Printf(TEXT("FrameCapRig_s%d_p%d"), i, j));
+            Capture->SetupAttachment(GetRootComponent());
+            Capture->RegisterComponent();
+            InitFrameCaptureComponent(*Capture, Target, i);
+            CaptureRig.Add(FRigCapture{Capture, Target, i, j});
+            CaptureRigTargets.Add(Target);
+        }
     }
+    LOG("Frame capture rig of %d shaders and %d poses", NumShaders, NumPoses);
+}
+
+void AEgoSensor::CaptureRigFrame(int64 ReplayFrame)
+{
+    // every pose's camera view (moving the camera root is cheap, it does not render)
+    TArray<FMinimalViewInfo> Views;
+    for (const FRigCapture &Rig : CaptureRig)
+    {
+        if (Rig.Pose < Views.Num())
+            continue;
+        Vehicle.Get()->SetCameraRootPose(static_cast<size_t>(Rig.Pose));
+        Vehicle.Get()->GetCamera()->GetCameraView(0, Views.AddDefaulted_GetRef());
+    }
+    Vehicle.Get()->SetCameraRootPose(static_cast<size_t>(0));
+
+    // with asynchronous readbacks every capture is rendered together with the scene at the end of the frame (one
+    // submission), else each one is rendered now so it can be read back immediately
+    const int64 Timestamp = GetData()->GetTimestampCarla();
+    for (const FRigCapture &Rig : CaptureRig)
+    {
+        Rig.Capture->SetCameraView(Views[Rig.Pose]);
+        if (FrameReadback)
+        {
+            Rig.Capture->CaptureSceneDeferred();
+            FrameReadback->Enqueue(*Rig.Target, Rig.Shader, Rig.Pose, ScreenshotCount, ReplayFrame, Timestamp,
+                                   Rig.Capture);
+        }
+        else
+        {
+            Rig.Capture->CaptureScene();
+            TArray<FColor> Pixels;
+            FIntPoint Size;
+            if (ReadFramePixels(*Rig.Target, Pixels, Size))
+                WriteFrame(Rig.Shader, Rig.Pose, ScreenshotCount, ReplayFrame, Timestamp, MoveTemp(Pixels), Size);
+        }
+    }
+}
+
+void AEgoSensor::WriteFrame(int32 Shader, int32 Pose, int64 Frame, int64 ReplayFrame, int64 Timestamp,
+                            TArray<FColor> &&Pixels, const FIntPoint &Size)
+{
+    if (FrameContainer)
+    {
+        // the shader and pose's container is created with its first frame
+        const FIntPoint Key(Shader, Pose);
+        int32 *Stream = FrameContainerStreams.Find(Key);
+        if (Stream == nullptr)
+        {
+            const FString Suffix = FString::Printf(TEXT("_s%d_p%d.dvrf"), Shader, Pose);
+            const FString FilePath = FPaths::Combine(FrameCapLocation, FrameCapFilename + Suffix);
+            const int32 NewStream = FrameContainer->AddStream(TCHAR_TO_UTF8(*FilePath), Size.X, Size.Y, Shader, Pose);
+            if (NewStream < 0)
+                LOG_ERROR("Unable to create frame container %s", *FilePath);
+            Stream = &FrameContainerStreams.Add(Key, NewStream);
+        }
+        // copied to one of the writer's frame buffers (waits for the writer when every buffer is in use)
+        if (*Stream >= 0)
+            FrameContainer->Add(*Stream, ReplayFrame, Timestamp, Pixels.GetData(), Pixels.Num() * sizeof(FColor));
+        return;
+    }
+    // using 5 digits to reach frame 99999 ~ 30m (assuming ~50fps frame capture)
+    // suffix is denoted as _s(hader)X_p(ose)Y_Z.jpg (or .png) where X is the shader idx, Y is the pose idx, Z is
+    // tick, the extension matches what the encoder writes (FileFormatJPG)
+    const FString Suffix = FString::Printf(TEXT("_s%d_p%d_%05lld.%s"), Shader, Pose, Frame,
+                                           bFileFormatJPG ? TEXT("jpg") : TEXT("png"));
+    const FString FilePath = FPaths::Combine(FrameCapLocation, FrameCapFilename + Suffix);
+    if (FrameEncoder)
+        FrameEncoder->Enqueue(MoveTemp(Pixels), Size, FilePath);
+}
+
+void AEgoSensor::InitFrameContainer()
+{
+    // one container per shader and pose, written (and compressed) on the container writer's thread
+    const bool bZlib = FrameContainerCodec.Equals("zlib", ESearchCase::IgnoreCase);
+    DReyeVRFrameContainerWriter::FCompressor Compressor = nullptr;
+    if (bZlib)
+    {
+        Compressor = [](const std::vector<uint8_t> &In, std::vector<uint8_t> &Out) {
+            int32 Size = FCompression::CompressMemoryBound(NAME_Zlib, static_cast<int32>(In.size()));
+            Out.resize(Size);
+            if (!FCompression::CompressMemory(NAME_Zlib, Out.data(), Size, In.data(), static_cast<int32>(In.size())))
+                return false;
+            Out.resize(Size);
+            return true;
+        };
+    }
+    FrameContainer = MakeUnique<DReyeVRFrameContainerWriter>();
+    FrameContainer->Start(FMath::Max(FrameContainerBuffers, 1),
+                          bZlib ? DReyeVRFrameContainerWriter::CODEC_ZLIB : DReyeVRFrameContainerWriter::CODEC_RAW,
+                          Compressor);
+    LOG("Writing frame capture to one %s container per shader and pose", bZlib ? TEXT("zlib") : TEXT("raw"));
+}
+
+void AEgoSensor::CloseFrameContainer()
+{
+    if (!FrameContainer)
+        return;
+    FrameContainer->Close(); // writes the queued frames and the containers' indices
+    const DReyeVRFrameContainerStats Stats = FrameContainer->GetStats();
+    LOG("Frame containers: %llu frames written (%llu dropped), %.1f MB (%.1f MB of pixels), the replayer waited "
+        "%.1f ms for the writer (max queue depth %llu)",
+        static_cast<uint64>(Stats.FramesWritten), static_cast<uint64>(Stats.FramesDropped), Stats.BytesWritten / 1e6,
+        Stats.BytesIn / 1e6, 1e3 * Stats.StallSeconds, static_cast<uint64>(Stats.MaxQueueDepth));
+    FrameContainer.Reset();
+    FrameContainerStreams.Empty();
 }
 
 /// ========================================== ///
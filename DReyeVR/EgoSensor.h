@@ -1,10 +1,18 @@
 #pragma once
 
-#include "Carla/Sensor/DReyeVRData.h"           // DReyeVR namespace
-#include "Carla/Sensor/DReyeVRSensor.h"         // ADReyeVRSensor
-#include "Components/SceneCaptureComponent2D.h" // USceneCaptureComponent2D
-#include <chrono>                               // timing threads
+#include "Carla/Recorder/DReyeVRFrameContainer.h" // DReyeVRFrameContainerWriter
+#include "Carla/Recorder/DReyeVRGazeClassifier.h" // DReyeVRGazeClassifier
+#include "Carla/Recorder/DReyeVRGazeCone.h"       // DReyeVRGazeConeIndex
+#include "Carla/Sensor/DReyeVRData.h"             // DReyeVR namespace
+#include "Carla/Sensor/DReyeVRSensor.h"           // ADReyeVRSensor
+#include "Components/SceneCaptureComponent2D.h"   // USceneCaptureComponent2D
+#include "EyeTrackerSampler.h"                    // FEyeTrackerSampler
+#include "FrameEncoder.h"                         // FFrameEncoder
+#include "FrameReadback.h"                        // FFrameReadback
+#include "WorldCollision.h"                       // FTraceHandle
+#include <chrono>                                 // timing threads
 #include <cstdint>
+#include <vector>
 
 #if USE_SRANIPAL_PLUGIN
 
@@ -42,7 +50,9 @@ class CARLAUE4_API AEgoSensor : public ADReyeVRSensor
     void UpdateData(const DReyeVR::CustomActorData &RecorderData, const double Per) override;
 
     // function where replayer requests a screenshot
-    void TakeScreenshot() override;
+    void TakeScreenshot(int64 ReplayFrame) override;
+    bool IsReadyForScreenshot() override;
+    void FinishScreenshots() override;
     bool ComputeGazeTrace(FHitResult &Hit, const ECollisionChannel TraceChannel, float TraceRadius = 0.f) const;
 
   protected:
@@ -58,19 +68,60 @@ class CARLAUE4_API AEgoSensor : public ADReyeVRSensor
   private: // eye tracker
     void InitEyeTracker();
     void DestroyEyeTracker();
-    void ComputeDummyEyeData(); // when no hardware sensor is present
-    void TickEyeTracker();      // tick hardware sensor
+    void ComputeDummyEyeData(DReyeVR::EyeTracker &Out); // when no hardware sensor is present
+    bool SampleEyeTracker(DReyeVR::EyeTracker &Out);    // one reading of the hardware sensor (false if not new)
+    void TickEyeTracker();                              // readings since the last tick into EyeTrackerSamples
     void ComputeFocusInfo();
     void ComputeTraceFocusInfo(const ECollisionChannel TraceChannel, float TraceRadius = 0.f);
+    void ComputeAsyncFocusInfo(const ECollisionChannel TraceChannel, float TraceRadius = 0.f);
+    void GetGazeRay(DReyeVR::Gaze Index, FVector &Start, FVector &End) const; // in world space
+    FCollisionQueryParams GetGazeTraceParams() const;
+    void ToFocusInfo(const FHitResult &Hit, bool bDidHit, DReyeVR::FocusInfo &Out) const;
     float MaxTraceLenM = 100.f;        // maximum trace length in m
     bool bDrawDebugFocusTrace = false; // draw the trace ray and hit point or not
+    // async focus traces: the combined and per-eye rays are issued together with the engine's async trace API and
+    // their results are consumed on the next tick (the focus lags one frame, but the game thread never waits)
+    bool bAsyncFocusTrace = false;
+    struct FGazeTraceBatch
+    {
+        static constexpr int32 Num = 3; // combined, left, right
+        FTraceHandle Handles[Num];
+        FVector Starts[Num];
+        FVector Ends[Num];
+        uint64 IssuedFrame = 0;
+        bool bPending = false;
+    } GazeTraceBatch;
+    int64 NumLostGazeTraces = 0; // batches whose results were gone when consumed (ex. a frame without a tick)
     float ComputeVergence(const FVector &L0, const FVector &LDir, const FVector &R0, const FVector &RDir) const;
+    // online fixation/saccade classification of every eye-tracker reading (see DReyeVRGazeClassifier.h)
+    void TickFixations();
+    bool bClassifyFixations = false;
+    DReyeVRGazeClassifier GazeClassifier;
+    std::vector<DReyeVRFixationEvent> FixationEvents; // (reused every tick)
+    struct DReyeVR::FixationData FixationInfoData;
+    // per-actor gaze dwell time (ADReyeVRSensor::Dwell, see [EgoSensor] DwellMaxActors)
+    void TickDwell(int64_t Timestamp);
+    bool bAccumulateDwell = false;
+    // actors within GazeConeAngle of the gaze ray (ADReyeVRSensor::GazeConeHits), from a grid of their bounding
+    // spheres that is only updated for the actors that moved (see DReyeVRGazeCone.h)
+    void TickGazeCone();
+    float GazeConeAngle = 0.f;       // degrees, 0 to disable
+    int GazeConeMaxActors = 8;       // closest to the gaze ray first
+    bool bGazeConeBenchmark = false; // also time a sphere sweep of the same cone and log both
+    DReyeVRGazeConeIndex GazeConeIndex;
+    TMap<uint32, FVector4> GazeConeBounds; // per actor id: bounding box origin (local) and radius (W)
+    double GazeConeSeconds = 0.0, GazeConeSweepSeconds = 0.0;
+    int64 GazeConeTicks = 0;
 #if USE_SRANIPAL_PLUGIN
     SRanipalEye_Core *SRanipal;               // SRanipalEye_Core.h
     SRanipalEye_Framework *SRanipalFramework; // SRanipalEye_Framework.h
-    ViveSR::anipal::Eye::EyeData EyeData;     // SRanipal_Eyes_Enums.h
     bool bSRanipalEnabled;                    // Whether or not the framework has been loaded
+    int LastDeviceFrame = -1;                 // frame_sequence of the last reading
 #endif
+    bool bAsyncEyeTracker = false; // sample the eye tracker on its own thread (not limited to the game tick)
+    float EyeTrackerHz = 120.f;    // rate of the eye tracker thread
+    TUniquePtr<FEyeTrackerSampler> EyeTrackerSampler;
+    int64_t DummySampleCount = 0; // frame sequence of the dummy readings
     struct DReyeVR::EyeTracker EyeSensorData;                           // data from eye tracker
     struct DReyeVR::FocusInfo FocusInfoData;                            // data from the focus computed from eye gaze
     std::chrono::time_point<std::chrono::system_clock> ChronoStartTime; // std::chrono time at BeginPlay
@@ -97,6 +148,37 @@ class CARLAUE4_API AEgoSensor : public ADReyeVRSensor
     bool bCreatedDirectory = false;
     bool bFileFormatJPG = true;
     bool bFrameCapForceLinearGamma = true;
+    int FramesInFlight = 0; // captures read back asynchronously (FFrameReadback), 0 to block on every capture
+    TUniquePtr<FFrameReadback> FrameReadback;
+    // where the pixels of every capture go: an image file (FileFormatJPG) or the shader and pose's frame container
+    // (images are numbered by Frame, the captures so far, container frames by ReplayFrame, the recorded frame's id)
+    void WriteFrame(int32 Shader, int32 Pose, int64 Frame, int64 ReplayFrame, int64 Timestamp, TArray<FColor> &&Pixels,
+                    const FIntPoint &Size);
+    void InitFrameContainer();
+    void CloseFrameContainer();
+    TUniquePtr<FFrameEncoder> FrameEncoder; // (images)
+    int EncoderThreads = 0;                 // 0 for every core but two
+    int EncoderMemoryBudgetMB = 1024;       // pixels of the images waiting to be encoded
+    FString FrameOutput = "images";         // or "container"
+    FString FrameContainerCodec = "raw";    // or "zlib"
+    int FrameContainerBuffers = 8;
+    TUniquePtr<DReyeVRFrameContainerWriter> FrameContainer;
+    TMap<FIntPoint, int32> FrameContainerStreams; // (shader, pose) to its stream in FrameContainer
+    // capture rig: one capture component (and render target) per shader and pose, with its post-processing set
+    // once, all captured together with the scene (CaptureSceneDeferred) when the readbacks are asynchronous
+    void InitCaptureRig();
+    void CaptureRigFrame(int64 ReplayFrame);
+    bool bCaptureRig = false;
+    struct FRigCapture
+    {
+        class USceneCaptureComponent2D *Capture;
+        class UTextureRenderTarget2D *Target;
+        int32 Shader, Pose;
+    };
+    TArray<FRigCapture> CaptureRig;
+    UPROPERTY()
+    TArray<class UTextureRenderTarget2D *> CaptureRigTargets; // (referenced for the garbage collector)
+    double CaptureSeconds = 0.0; // game thread time in TakeScreenshot
 
   private: // foveated rendering
     void TickFoveatedRender();
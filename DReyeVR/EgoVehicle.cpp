@@ -416,6 +416,17 @@ void AEgoVehicle::InitSensor()
             {
                 Description.Variations.Add(A.Id, std::move(A));
             }
+            // and the defaults of the modifiable ones (ex. "fields")
+            for (const FActorVariation &V : EgoSensorDef.Variations)
+            {
+                if (V.RecommendedValues.Num() == 0)
+                    continue;
+                FActorAttribute A;
+                A.Id = V.Id;
+                A.Type = V.Type;
+                A.Value = V.RecommendedValues[0];
+                Description.Variations.Add(A.Id, std::move(A));
+            }
         }
         // calls Episode::SpawnActor => SpawnActorWithInfo => ActorDispatcher->SpawnActor => SpawnFunctions[UId]
         FTransform SpawnPt = FTransform(FRotator::ZeroRotator, GetCameraPosn(), FVector::OneVector);
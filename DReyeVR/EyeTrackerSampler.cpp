@@ -0,0 +1,61 @@
+#include "EyeTrackerSampler.h"
+
+#include "DReyeVRUtils.h"             // LOG
+#include "HAL/PlatformProcess.h"      // FPlatformProcess::Sleep
+#include "HAL/PlatformTime.h"         // FPlatformTime::Seconds
+
+FEyeTrackerSampler::FEyeTrackerSampler(FSampleFn SampleFn, float SampleHz, uint32 Capacity)
+    : SampleFn(MoveTemp(SampleFn)), Period(1.0 / FMath::Max(SampleHz, 1.f)), Queue(Capacity)
+{
+    Thread = FRunnableThread::Create(this, TEXT("DReyeVREyeTracker"), 0, TPri_AboveNormal);
+    LOG("Sampling the eye tracker at %.0fhz on a dedicated thread", 1.0 / Period);
+}
+
+FEyeTrackerSampler::~FEyeTrackerSampler()
+{
+    if (Thread != nullptr)
+    {
+        Thread->Kill(true); // calls Stop() and waits for Run() to return
+        delete Thread;
+        Thread = nullptr;
+    }
+    if (NumDropped.GetValue() > 0)
+        LOG_WARN("Dropped %lld eye tracker readings (the game thread fell behind)", NumDropped.GetValue());
+}
+
+uint32 FEyeTrackerSampler::Run()
+{
+    double NextSample = FPlatformTime::Seconds();
+    DReyeVR::EyeTracker Reading;
+    while (!bStopping)
+    {
+        if (SampleFn(Reading) && !Queue.Enqueue(Reading))
+            NumDropped.Increment();
+
+        // fixed schedule (no drift), but don't try to catch up after a stall
+        NextSample += Period;
+        const double Now = FPlatformTime::Seconds();
+        if (NextSample > Now)
+            FPlatformProcess::Sleep(static_cast<float>(NextSample - Now));
+        else if (Now - NextSample > Period)
+            NextSample = Now;
+    }
+    return 0;
+}
+
+void FEyeTrackerSampler::Stop()
+{
+    bStopping = true;
+}
+
+int32 FEyeTrackerSampler::Drain(TArray<DReyeVR::EyeTracker> &Out)
+{
+    int32 NumDrained = 0;
+    DReyeVR::EyeTracker Reading;
+    while (Queue.Dequeue(Reading))
+    {
+        Out.Add(Reading);
+        NumDrained++;
+    }
+    return NumDrained;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Carla/Sensor/DReyeVRData.h" // DReyeVR::EyeTracker
+#include "Containers/CircularQueue.h" // TCircularQueue
+#include "HAL/Runnable.h"             // FRunnable
+#include "HAL/RunnableThread.h"       // FRunnableThread
+#include "HAL/ThreadSafeBool.h"       // FThreadSafeBool
+#include "HAL/ThreadSafeCounter64.h"  // FThreadSafeCounter64
+#include "Templates/Function.h"       // TFunction
+
+// Reads the eye tracker at its own rate (ex. 120hz for the Vive Pro Eye) on a dedicated thread, independent of the
+// game tick (usually 60-90hz). Readings go into a lock-free single-producer single-consumer ring that the game
+// thread drains once per tick, so no reading between two frames is lost (see [EgoSensor] AsyncEyeTracker)
+class FEyeTrackerSampler : public FRunnable
+{
+  public:
+    // fills a reading, called from the sampling thread only. Returns false if there is no new reading (ex. the
+    // device has not produced a new frame yet)
+    using FSampleFn = TFunction<bool(DReyeVR::EyeTracker &)>;
+
+    FEyeTrackerSampler(FSampleFn SampleFn, float SampleHz, uint32 Capacity = 1024);
+    ~FEyeTrackerSampler() override;
+
+    uint32 Run() override;
+    void Stop() override;
+
+    // (game thread) appends every reading since the previous call to Out, oldest first. Returns how many
+    int32 Drain(TArray<DReyeVR::EyeTracker> &Out);
+
+    // readings dropped because the game thread did not drain the ring in time
+    int64 GetNumDropped() const
+    {
+        return NumDropped.GetValue();
+    }
+
+  private:
+    FSampleFn SampleFn;
+    double Period; // seconds between two readings
+    TCircularQueue<DReyeVR::EyeTracker> Queue;
+    FThreadSafeBool bStopping = false;
+    FThreadSafeCounter64 NumDropped;
+    FRunnableThread *Thread = nullptr;
+};
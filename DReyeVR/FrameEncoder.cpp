@@ -0,0 +1,168 @@
+#include "FrameEncoder.h"
+
+#include "DReyeVRUtils.h"          // LOG
+#include "HAL/Event.h"             // FEvent
+#include "HAL/PlatformProcess.h"   // FPlatformProcess::GetSynchEventFromPool
+#include "HAL/PlatformTime.h"      // FPlatformTime::Seconds
+#include "HAL/RunnableThread.h"    // FRunnableThread
+#include "IImageWrapper.h"         // IImageWrapper
+#include "IImageWrapperModule.h"   // IImageWrapperModule
+#include "Misc/FileHelper.h"       // FFileHelper::SaveArrayToFile
+#include "Misc/ScopeLock.h"        // FScopeLock
+#include "Modules/ModuleManager.h" // FModuleManager
+
+FFrameEncoder::FFrameEncoder(int32 NumThreads, int64 MemoryBudget, bool bFileFormatJPG)
+    : MemoryBudget(FMath::Max<int64>(MemoryBudget, 1)), bFileFormatJPG(bFileFormatJPG)
+{
+    ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+    WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    if (NumThreads <= 0)
+        NumThreads = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 2, 1);
+    for (int32 i = 0; i < NumThreads; i++)
+    {
+        Workers.Add(MakeUnique<FWorker>(*this));
+        Threads.Add(FRunnableThread::Create(Workers.Last().Get(), *FString::Printf(TEXT("DReyeVRFrameEncoder%d"), i),
+                                            0, TPri_BelowNormal));
+    }
+    StartTime = FPlatformTime::Seconds();
+    LOG("Encoding frame capture images on %d threads (memory budget %lld MB)", NumThreads, this->MemoryBudget >> 20);
+}
+
+FFrameEncoder::~FFrameEncoder()
+{
+    // the encoders only exit once the queue is drained
+    bStopping = true;
+    for (FRunnableThread *Thread : Threads)
+    {
+        if (Thread != nullptr)
+        {
+            WorkEvent->Trigger(); // (an auto-reset event wakes one encoder at a time)
+            Thread->WaitForCompletion();
+            delete Thread;
+        }
+    }
+    Threads.Empty();
+    Workers.Empty();
+    FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+    LogStats();
+}
+
+void FFrameEncoder::Enqueue(TArray<FColor> &&Pixels, const FIntPoint &Size, const FString &FilePath)
+{
+    const int64 Bytes = Pixels.Num() * sizeof(FColor);
+    {
+        FScopeLock Lock(&Mutex);
+        Jobs.Add(FJob{MoveTemp(Pixels), Size, FilePath});
+        Stats.NumQueued++;
+        Stats.QueueDepth++;
+        Stats.MaxQueueDepth = FMath::Max(Stats.MaxQueueDepth, Stats.QueueDepth);
+        Stats.QueuedBytes += Bytes;
+        Stats.MaxQueuedBytes = FMath::Max(Stats.MaxQueuedBytes, Stats.QueuedBytes);
+    }
+    WorkEvent->Trigger();
+}
+
+bool FFrameEncoder::HasRoom()
+{
+    // the images of one replay frame (every shader and pose) are queued together, so the budget can be exceeded by
+    // up to one replay frame
+    FScopeLock Lock(&Mutex);
+    if (Stats.QueuedBytes < MemoryBudget)
+        return true;
+    Stats.NumStalls++;
+    return false;
+}
+
+void FFrameEncoder::Flush()
+{
+    while (GetStats().QueueDepth > 0)
+    {
+        WorkEvent->Trigger();
+        FPlatformProcess::Sleep(0.005f); // (s)
+    }
+}
+
+FFrameEncoder::FStats FFrameEncoder::GetStats() const
+{
+    FScopeLock Lock(&Mutex);
+    return Stats;
+}
+
+void FFrameEncoder::LogStats() const
+{
+    const FStats S = GetStats();
+    const int64 NumEncoded = S.NumWritten + S.NumFailed;
+    if (NumEncoded == 0)
+        return;
+    const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-6);
+    LOG("Frame encoder: %lld images (%lld failed) at %.1f images/s, %.1f ms to encode and %.1f ms to write each, %.1f "
+        "MB written, queue depth %d (max %d, %.1f MB of pixels), the replayer waited %lld ticks for the budget",
+        S.NumWritten, S.NumFailed, S.NumWritten / Seconds, 1e3 * (S.EncodeSeconds - S.WriteSeconds) / NumEncoded,
+        1e3 * S.WriteSeconds / NumEncoded, S.BytesWritten / 1e6, S.QueueDepth, S.MaxQueueDepth,
+        S.MaxQueuedBytes / 1e6, S.NumStalls);
+}
+
+void FFrameEncoder::WorkerLoop()
+{
+    while (true)
+    {
+        FJob Job;
+        {
+            FScopeLock Lock(&Mutex);
+            if (Jobs.Num() > 0)
+            {
+                Job = MoveTemp(Jobs[0]);
+                Jobs.RemoveAt(0, 1, false);
+            }
+        }
+        if (Job.Pixels.Num() == 0)
+        {
+            if (bStopping)
+                break;
+            WorkEvent->Wait(100); // (ms, also catches a trigger that woke another encoder)
+            continue;
+        }
+
+        const int64 Bytes = Job.Pixels.Num() * sizeof(FColor);
+        const double Start = FPlatformTime::Seconds();
+        int64 BytesWritten = 0;
+        double WriteSeconds = 0.0;
+        const bool bWritten = Encode(Job, BytesWritten, WriteSeconds);
+        const double Seconds = FPlatformTime::Seconds() - Start;
+
+        FScopeLock Lock(&Mutex);
+        Stats.QueueDepth--;
+        Stats.QueuedBytes -= Bytes;
+        Stats.EncodeSeconds += Seconds;
+        Stats.WriteSeconds += WriteSeconds;
+        if (bWritten)
+        {
+            Stats.NumWritten++;
+            Stats.BytesWritten += BytesWritten;
+        }
+        else
+        {
+            Stats.NumFailed++;
+        }
+    }
+}
+
+bool FFrameEncoder::Encode(FJob &Job, int64 &BytesWritten, double &WriteSeconds) const
+{
+    for (FColor &Pixel : Job.Pixels)
+        Pixel.A = 255; // (the captures' alpha is not opacity)
+    TSharedPtr<IImageWrapper> ImageWrapper =
+        ImageWrapperModule->CreateImageWrapper(bFileFormatJPG ? EImageFormat::JPEG : EImageFormat::PNG);
+    if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Job.Pixels.GetData(), Job.Pixels.Num() * sizeof(FColor),
+                                                          Job.Size.X, Job.Size.Y, ERGBFormat::BGRA, 8))
+        return false;
+    // lower quality JPG, less storage (PNG is lossless either way)
+    const TArray64<uint8> &Compressed = ImageWrapper->GetCompressed((int32)EImageCompressionQuality::Default);
+    if (Compressed.Num() == 0)
+        return false;
+    const double Start = FPlatformTime::Seconds();
+    const bool bSaved = FFileHelper::SaveArrayToFile(Compressed, *Job.FilePath);
+    WriteSeconds = FPlatformTime::Seconds() - Start;
+    BytesWritten = Compressed.Num();
+    return bSaved;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h" // FCriticalSection
+#include "HAL/Runnable.h"        // FRunnable
+#include "HAL/ThreadSafeBool.h"  // FThreadSafeBool
+
+class FEvent;
+class FRunnableThread;
+class IImageWrapperModule;
+
+// Encodes the replay frame capture images (JPG or PNG) and writes them to disk on a fixed pool of threads (see
+// [Replayer] EncoderThreads), instead of the engine's image write queue, which takes every frame without limit. The
+// pixels of the queued images are bounded by a memory budget ([Replayer] EncoderMemoryBudgetMB): once it is reached
+// the synchronous replayer waits (IsReadyForScreenshot) until the encoders catch up
+class FFrameEncoder
+{
+  public:
+    struct FStats
+    {
+        int64 NumQueued = 0;      // images handed to the encoders
+        int64 NumWritten = 0;     // images encoded and written
+        int64 NumFailed = 0;      // images that could not be encoded or written
+        int32 QueueDepth = 0;     // images waiting for (or being) encoded
+        int32 MaxQueueDepth = 0;
+        int64 QueuedBytes = 0;    // pixels of those images (what the budget limits)
+        int64 MaxQueuedBytes = 0;
+        double EncodeSeconds = 0; // total time the encoders spent (on all threads)
+        double WriteSeconds = 0;  // (of which writing the files)
+        int64 BytesWritten = 0;   // encoded bytes
+        int64 NumStalls = 0;      // HasRoom calls that held the replayer back
+    };
+
+    FFrameEncoder(int32 NumThreads, int64 MemoryBudget, bool bFileFormatJPG);
+    ~FFrameEncoder(); // encodes and writes every queued image before the threads exit
+
+    // (game thread) queues the image to be encoded and written to FilePath
+    void Enqueue(TArray<FColor> &&Pixels, const FIntPoint &Size, const FString &FilePath);
+
+    // (game thread) whether the queued images are within the memory budget (counts the times they were not)
+    bool HasRoom();
+
+    // (game thread) blocks until every queued image is written
+    void Flush();
+
+    FStats GetStats() const;
+    void LogStats() const;
+
+  private:
+    struct FJob
+    {
+        TArray<FColor> Pixels;
+        FIntPoint Size;
+        FString FilePath;
+    };
+    class FWorker : public FRunnable
+    {
+      public:
+        explicit FWorker(FFrameEncoder &Encoder) : Encoder(Encoder)
+        {
+        }
+        uint32 Run() override
+        {
+            Encoder.WorkerLoop();
+            return 0;
+        }
+
+      private:
+        FFrameEncoder &Encoder;
+    };
+
+    void WorkerLoop();
+    bool Encode(FJob &Job, int64 &BytesWritten, double &WriteSeconds) const;
+
+    const int64 MemoryBudget;
+    const bool bFileFormatJPG;
+    IImageWrapperModule *ImageWrapperModule = nullptr; // (loaded on the game thread)
+    TArray<TUniquePtr<FWorker>> Workers;
+    TArray<FRunnableThread *> Threads;
+
+    mutable FCriticalSection Mutex;
+    FEvent *WorkEvent = nullptr; // signals the encoders that there is work (or to exit)
+    TArray<FJob> Jobs;           // oldest first
+    FThreadSafeBool bStopping = false;
+    FStats Stats;
+    double StartTime = 0.0;
+};
@@ -0,0 +1,224 @@
+#include "FrameReadback.h"
+
+#include "Components/SceneCaptureComponent2D.h" // USceneCaptureComponent2D
+#include "DReyeVRUtils.h"                         // LOG
+#include "Engine/TextureRenderTarget2D.h"         // UTextureRenderTarget2D
+#include "HAL/PlatformTime.h"                     // FPlatformTime::Seconds
+#include "RHICommandList.h"                       // FRHICommandListImmediate
+#include "RenderingThread.h"                      // ENQUEUE_RENDER_COMMAND, FlushRenderingCommands
+#include "TextureResource.h"                      // FTextureRenderTargetResource
+
+FFrameReadback::FFrameReadback(int32 FramesInFlight, FOutput Output)
+    : FramesInFlight(FMath::Max(FramesInFlight, 1)), Output(MoveTemp(Output))
+{
+    LOG("Capturing replay frames with up to %d frames in flight", this->FramesInFlight);
+}
+
+FFrameReadback::~FFrameReadback()
+{
+    Flush(); // (the render thread is done with the staging textures after it, so they can be released)
+    LogStats();
+}
+
+void FFrameReadback::Enqueue(UTextureRenderTarget2D &RenderTarget, int32 Shader, int32 Pose, int64 Frame,
+                             int64 ReplayFrame, int64 Timestamp, USceneCaptureComponent2D *DeferredCapture)
+{
+    FTextureRenderTargetResource *RTResource = RenderTarget.GameThread_GetRenderTargetResource();
+    if (RTResource == nullptr)
+    {
+        LOG_ERROR("Missing render target!");
+        return;
+    }
+    TUniquePtr<FPending> Capture = MakeUnique<FPending>();
+    Capture->Staging = (FreeStaging.Num() > 0) ? FreeStaging.Pop(false) : MakeUnique<FStaging>();
+    Capture->Source = RTResource;
+    Capture->DeferredCapture = DeferredCapture;
+    Capture->Shader = Shader;
+    Capture->Pose = Pose;
+    Capture->Size = FIntPoint(RenderTarget.GetSurfaceWidth(), RenderTarget.GetSurfaceHeight());
+    Capture->Frame = Frame;
+    Capture->ReplayFrame = ReplayFrame;
+    Capture->Timestamp = Timestamp;
+    Capture->EnqueueTime = FPlatformTime::Seconds();
+    Capture->EnqueueFrame = GFrameCounter;
+    if (FirstEnqueueTime < 0.0)
+        FirstEnqueueTime = Capture->EnqueueTime;
+
+    if (DeferredCapture == nullptr)
+        Copy(*Capture);
+    Pending.Add(MoveTemp(Capture));
+}
+
+void FFrameReadback::Copy(FPending &Capture)
+{
+    // the capture was enqueued on the render thread before this, and the next capture into the same render target
+    // after it, so the copy gets exactly this capture
+    Capture.bCopyEnqueued = true;
+    FPending *CapturePtr = &Capture;
+    ENQUEUE_RENDER_COMMAND(DReyeVRFrameReadbackCopy)
+    ([CapturePtr](FRHICommandListImmediate &RHICmdList) {
+        FStaging &Staging = *CapturePtr->Staging;
+        FRHITexture2D *Source = CapturePtr->Source->GetRenderTargetTexture();
+        if (!Staging.Texture.IsValid() || Staging.Texture->GetSizeXY() != Source->GetSizeXY())
+        {
+            FRHIResourceCreateInfo CreateInfo;
+            Staging.Texture = RHICreateTexture2D(Source->GetSizeX(), Source->GetSizeY(), Source->GetFormat(), 1, 1,
+                                                 TexCreate_CPUReadback, CreateInfo);
+        }
+        if (!Staging.Fence.IsValid())
+            Staging.Fence = RHICreateGPUFence(TEXT("DReyeVRFrameReadback"));
+        Staging.Fence->Clear();
+        RHICmdList.CopyToResolveTarget(Source, Staging.Texture, FResolveParams());
+        RHICmdList.WriteGPUFence(Staging.Fence);
+        CapturePtr->bIssued = true;
+    });
+}
+
+void FFrameReadback::ReadPixels(FPending &Capture)
+{
+    // (render thread) copies the staging texture out, the render target is B8G8R8A8 so the bytes are FColors. The
+    // mapped rows are RowPitch pixels apart, which is more than the width unless the RHI packs them (ex. D3D12 aligns
+    // them to 256 bytes, so any [Replayer] FrameWidth that is not a multiple of 64)
+    Capture.bCopying = true;
+    FPending *CapturePtr = &Capture;
+    ENQUEUE_RENDER_COMMAND(DReyeVRFrameReadbackRead)
+    ([CapturePtr](FRHICommandListImmediate &RHICmdList) {
+        FStaging &Staging = *CapturePtr->Staging;
+        const FIntPoint &Size = CapturePtr->Size;
+        void *Data = nullptr;
+        int32 RowPitch = 0; // (in pixels)
+        int32 NumRows = 0;
+        RHICmdList.MapStagingSurface(Staging.Texture, Staging.Fence, Data, RowPitch, NumRows);
+        if (Data != nullptr)
+        {
+            if (RowPitch >= Size.X && NumRows >= Size.Y)
+            {
+                CapturePtr->Pixels.SetNumUninitialized(Size.X * Size.Y);
+                for (int32 Row = 0; Row < Size.Y; Row++)
+                    FMemory::Memcpy(CapturePtr->Pixels.GetData() + Row * Size.X,
+                                    static_cast<const FColor *>(Data) + Row * RowPitch, Size.X * sizeof(FColor));
+            }
+            RHICmdList.UnmapStagingSurface(Staging.Texture);
+        }
+        CapturePtr->bCopied = true;
+    });
+}
+
+void FFrameReadback::Write(FPending &Capture)
+{
+    const double Now = FPlatformTime::Seconds();
+    const double Latency = Now - Capture.EnqueueTime;
+    TotalLatency += Latency;
+    TotalLatencyFrames += GFrameCounter - Capture.EnqueueFrame;
+    MaxLatency = FMath::Max(MaxLatency, Latency);
+    LastWriteTime = Now;
+    NumWritten++;
+    if (Capture.Frame != LastFrameWritten)
+    {
+        NumFramesWritten++;
+        LastFrameWritten = Capture.Frame;
+    }
+    if (Capture.Pixels.Num() != Capture.Size.X * Capture.Size.Y)
+    {
+        LOG_ERROR("Unable to read pixels!");
+        return;
+    }
+    Output(Capture.Shader, Capture.Pose, Capture.Frame, Capture.ReplayFrame, Capture.Timestamp,
+           MoveTemp(Capture.Pixels), Capture.Size);
+}
+
+void FFrameReadback::Poll()
+{
+    // the deferred captures of the previous frames were rendered by now (their render commands were enqueued at the
+    // end of those frames)
+    for (TUniquePtr<FPending> &Capture : Pending)
+        if (!Capture->bCopyEnqueued && Capture->EnqueueFrame < GFrameCounter)
+            Copy(*Capture);
+
+    // the copies complete in order, so stop at the first one that is not done
+    while (Pending.Num() > 0)
+    {
+        FPending &Capture = *Pending[0];
+        if (!Capture.bCopying)
+        {
+            if (!Capture.bIssued || !Capture.Staging->Fence->Poll())
+                break;
+            ReadPixels(Capture);
+        }
+        if (!Capture.bCopied)
+            break;
+        Write(Capture);
+        // the next copy into this staging texture is enqueued on the render thread after the read, so it is reused
+        FreeStaging.Add(MoveTemp(Capture.Staging));
+        Pending.RemoveAt(0, 1, false);
+        if (NumWritten % 300 == 0)
+            LogStats();
+    }
+    // the reads of the other copies that are done already (so they are ready by the next poll)
+    for (int32 i = 1; i < Pending.Num(); i++)
+    {
+        FPending &Capture = *Pending[i];
+        if (Capture.bCopying)
+            continue;
+        if (!Capture.bIssued || !Capture.Staging->Fence->Poll())
+            break;
+        ReadPixels(Capture);
+    }
+}
+
+bool FFrameReadback::HasRoom()
+{
+    Poll();
+    const int64 NumFramesPending = (Pending.Num() == 0) ? 0 : Pending.Last()->Frame - Pending[0]->Frame + 1;
+    if (NumFramesPending < FramesInFlight)
+        return true;
+    NumStalls++;
+    return false;
+}
+
+void FFrameReadback::Flush()
+{
+    // the deferred captures of this frame are only rendered at its end, so they are rendered now (the scene is still
+    // the one they were captured in) and copied after that. Captures whose component is gone already are dropped
+    bool bRendered = false;
+    for (int32 i = 0; i < Pending.Num(); i++)
+    {
+        FPending &Capture = *Pending[i];
+        if (Capture.bCopyEnqueued || Capture.EnqueueFrame < GFrameCounter)
+            continue;
+        if (!Capture.DeferredCapture.IsValid())
+        {
+            LOG_WARN("Dropping capture (shader %d, pose %d) of frame %lld, it was never rendered", Capture.Shader,
+                     Capture.Pose, Capture.Frame);
+            FreeStaging.Add(MoveTemp(Capture.Staging));
+            Pending.RemoveAt(i--, 1, false);
+            continue;
+        }
+        Capture.DeferredCapture->CaptureScene();
+        bRendered = true;
+    }
+    if (bRendered)
+        FlushRenderingCommands(); // (the captures are rendered before anything is copied)
+    // mapping waits for the GPU, so one round of reads is enough
+    for (TUniquePtr<FPending> &Capture : Pending)
+    {
+        if (!Capture->bCopyEnqueued)
+            Copy(*Capture);
+        if (!Capture->bCopying)
+            ReadPixels(*Capture);
+    }
+    FlushRenderingCommands();
+    Poll();
+    ensure(Pending.Num() == 0);
+}
+
+void FFrameReadback::LogStats() const
+{
+    if (NumWritten == 0)
+        return;
+    const double Seconds = FMath::Max(LastWriteTime - FirstEnqueueTime, 1e-6);
+    LOG("Frame capture: %lld frames (%lld images) at %.1f fps, readback latency %.1f ms (%.1f game frames, max "
+        "%.1f ms), the replayer waited %lld ticks for room",
+        NumFramesWritten, NumWritten, NumFramesWritten / Seconds, 1e3 * TotalLatency / NumWritten,
+        static_cast<double>(TotalLatencyFrames) / NumWritten, 1e3 * MaxLatency, NumStalls);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"             // FThreadSafeBool
+#include "RHIResources.h"                   // FTexture2DRHIRef, FGPUFenceRHIRef
+#include "Templates/Function.h"             // TFunction
+#include "Templates/UniquePtr.h"            // TUniquePtr
+#include "UObject/WeakObjectPtrTemplates.h" // TWeakObjectPtr
+
+class USceneCaptureComponent2D;
+class UTextureRenderTarget2D;
+
+// Replay frame capture without stalling the game thread on the GPU (see [Replayer] FramesInFlight): every capture is
+// copied to a staging texture on the GPU, the pixels are only read a few frames later once the copy is done, and
+// handed to the output (ex. the image encoders, or a frame container). At most FramesInFlight replay frames are
+// pending at once, the synchronous replayer waits for room before advancing (IsReadyForScreenshot)
+class FFrameReadback
+{
+  public:
+    // (game thread) receives the pixels of every capture, in the order they were enqueued
+    using FOutput = TFunction<void(int32 Shader, int32 Pose, int64 Frame, int64 ReplayFrame, int64 Timestamp,
+                                   TArray<FColor> &&Pixels, const FIntPoint &Size)>;
+
+    FFrameReadback(int32 FramesInFlight, FOutput Output);
+    ~FFrameReadback(); // writes every pending capture (blocks until the GPU is done)
+
+    // (game thread) the render target was just captured (shader and pose) as the Frame-th captured frame, of the
+    // recorded frame ReplayFrame at Timestamp (TimestampCarla): copy it and hand it to the output. DeferredCapture for
+    // CaptureSceneDeferred, which renders with the scene at the end of the frame: the copy is only enqueued from the
+    // next frame on (or the capture is rendered right away if it is flushed before that)
+    void Enqueue(UTextureRenderTarget2D &RenderTarget, int32 Shader, int32 Pose, int64 Frame, int64 ReplayFrame,
+                 int64 Timestamp, USceneCaptureComponent2D *DeferredCapture = nullptr);
+
+    // (game thread) reads the copies that are done and hands them to the output, oldest first
+    void Poll();
+
+    // (game thread) whether another replay frame can be captured (counts the times it could not)
+    bool HasRoom();
+
+    // (game thread) blocks until every pending capture is handed to the output
+    void Flush();
+
+    void LogStats() const;
+
+  private:
+    // CPU-readable copy of a render target, mapped with its row pitch (which is not the width for every RHI and
+    // resolution, so the rows are copied one by one)
+    struct FStaging
+    {
+        FTexture2DRHIRef Texture; // (created on the render thread, for the size of the first copy into it)
+        FGPUFenceRHIRef Fence;    // written after the copy
+    };
+    struct FPending
+    {
+        TUniquePtr<FStaging> Staging;
+        class FTextureRenderTargetResource *Source = nullptr;
+        TWeakObjectPtr<USceneCaptureComponent2D> DeferredCapture;
+        int32 Shader = 0;
+        int32 Pose = 0;
+        FIntPoint Size;
+        int64 Frame = 0;            // captured frames before this one (what FramesInFlight counts)
+        int64 ReplayFrame = 0;      // id of the recorded frame
+        int64 Timestamp = 0;        // TimestampCarla (ms)
+        double EnqueueTime = 0.0;   // FPlatformTime::Seconds
+        uint64 EnqueueFrame = 0;    // GFrameCounter
+        bool bCopyEnqueued = false; // the copy was enqueued on the render thread
+        FThreadSafeBool bIssued;    // (render thread) the copy was enqueued on the GPU
+        FThreadSafeBool bCopied;    // (render thread) Pixels were read back
+        bool bCopying = false;      // the read of Pixels was enqueued on the render thread
+        TArray<FColor> Pixels;
+    };
+
+    void Copy(FPending &Capture);
+    void ReadPixels(FPending &Capture);
+    void Write(FPending &Capture);
+
+    int32 FramesInFlight;
+    FOutput Output;
+    TArray<TUniquePtr<FPending>> Pending;     // oldest first
+    TArray<TUniquePtr<FStaging>> FreeStaging; // (their textures are reused)
+
+    // stats
+    int64 NumWritten = 0;
+    int64 NumFramesWritten = 0;
+    int64 LastFrameWritten = -1;
+    double FirstEnqueueTime = -1.0;
+    double LastWriteTime = 0.0;
+    double TotalLatency = 0.0;     // seconds from the capture to its pixels
+    uint64 TotalLatencyFrames = 0; // (in game frames)
+    double MaxLatency = 0.0;
+    int64 NumStalls = 0; // HasRoom calls that held the replayer back
+};
@@ -4,7 +4,11 @@
 #include "carla/sensor/SensorData.h"
 #include "carla/sensor/s11n/DReyeVRSerializer.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 
 namespace carla
 {
@@ -19,145 +23,280 @@ class DReyeVREvent : public SensorData
   protected:
     explicit DReyeVREvent(const RawData &data) : SensorData(data)
     {
-        InternalData = s11n::DReyeVRSerializer::DeserializeRawData(data);
+        using Serializer = s11n::DReyeVRSerializer;
+        if (Serializer::IsRecord(data))
+        {
+            // fixed layout, one copy of the fields we know (a newer writer may have appended more)
+            Serializer::Record Header;
+            std::memcpy(&Header, data.begin(), sizeof(Header.Magic) + sizeof(Header.Version) + sizeof(Header.Size));
+            const size_t Known = std::min<size_t>(std::min<size_t>(Header.Size, sizeof(Record)), data.size());
+            std::memcpy(&Record, data.begin(), Known);
+            if (Header.Version < 3) // (before field groups, every field was sent)
+                Record.Fields = Serializer::FIELDS_ALL;
+            size_t NameBegin = Header.Size;
+            if (Record.NumEyeSamples > 0 && Record.EyeSampleSize > 0 &&
+                NameBegin + size_t(Record.NumEyeSamples) * Record.EyeSampleSize <= data.size())
+            {
+                EyeSamples.resize(Record.NumEyeSamples);
+                const size_t SampleKnown = std::min<size_t>(Record.EyeSampleSize, sizeof(Serializer::EyeSample));
+                if (Record.EyeSampleSize == sizeof(Serializer::EyeSample))
+                    std::memcpy(EyeSamples.data(), data.begin() + NameBegin, EyeSamples.size() * SampleKnown);
+                else
+                    for (size_t i = 0; i < EyeSamples.size(); i++)
+                        std::memcpy(&EyeSamples[i], data.begin() + NameBegin + i * Record.EyeSampleSize, SampleKnown);
+                NameBegin += EyeSamples.size() * Record.EyeSampleSize;
+            }
+            if (Record.FocusNameLength > 0 && NameBegin + Record.FocusNameLength <= data.size())
+            {
+                FocusActorName.assign(reinterpret_cast<const char *>(data.begin()) + NameBegin, Record.FocusNameLength);
+                Serializer::SetFocusActorName(Record.StreamId, Record.FocusActorId, FocusActorName);
+            }
+            else
+            {
+                FocusActorName = Serializer::GetFocusActorName(Record.StreamId, Record.FocusActorId);
+            }
+            // (it was focused before)
+            FixationActorName = Serializer::GetFocusActorName(Record.StreamId, Record.FixationActorId);
+        }
+        else
+        {
+            Serializer::Data InternalData = Serializer::DeserializeRawData(data);
+            Record = Serializer::ToRecord(InternalData);
+            FocusActorName = std::move(InternalData.FocusActorName);
+            EyeSamples = std::move(InternalData.EyeSamples);
+            FixationActorName = std::move(InternalData.FixationActorName);
+            FixationEvents = std::move(InternalData.FixationEvents);
+            DwellActorId = InternalData.DwellActorId;
+            Dwell = std::move(InternalData.Dwell);
+            bDwellComplete = InternalData.DwellComplete;
+            GazeCone = std::move(InternalData.GazeCone);
+            Record.NumEyeSamples = static_cast<uint16_t>(EyeSamples.size());
+            Record.EyeSampleSize = sizeof(Serializer::EyeSample);
+        }
     }
 
   public:
     int64_t GetTimestampCarla() const
     {
-        return InternalData.TimestampCarla;
+        return Record.TimestampCarla;
     }
     int64_t GetTimestampDevice() const
     {
-        return InternalData.TimestampDevice;
+        return Record.TimestampDevice;
     }
     int64_t GetFrameSequence() const
     {
-        return InternalData.FrameSequence;
+        return Record.FrameSequence;
     }
     const geom::Vector3D &GetGazeDir() const
     {
-        return InternalData.GazeDir;
+        return Record.GazeDir;
     }
     const geom::Vector3D &GetGazeOrigin() const
     {
-        return InternalData.GazeOrigin;
+        return Record.GazeOrigin;
     }
     bool GetGazeValid() const
     {
-        return InternalData.GazeValid;
+        return Record.GazeValid != 0;
     }
     float GetGazeVergence() const
     {
-        return InternalData.GazeVergence;
+        return Record.GazeVergence;
     }
     const geom::Vector3D &GetCameraLocation() const
     {
-        return InternalData.CameraLocation;
+        return Record.CameraLocation;
     }
     const geom::Vector3D &GetCameraRotation() const
     {
-        return InternalData.CameraRotation;
+        return Record.CameraRotation;
     }
     const geom::Vector3D &GetLGazeDir() const
     {
-        return InternalData.LGazeDir;
+        return Record.LGazeDir;
     }
     const geom::Vector3D &GetLGazeOrigin() const
     {
-        return InternalData.LGazeOrigin;
+        return Record.LGazeOrigin;
     }
     bool GetLGazeValid() const
     {
-        return InternalData.LGazeValid;
+        return Record.LGazeValid != 0;
     }
     const geom::Vector3D &GetRGazeDir() const
     {
-        return InternalData.RGazeDir;
+        return Record.RGazeDir;
     }
     const geom::Vector3D &GetRGazeOrigin() const
     {
-        return InternalData.RGazeOrigin;
+        return Record.RGazeOrigin;
     }
     bool GetRGazeValid() const
     {
-        return InternalData.RGazeValid;
+        return Record.RGazeValid != 0;
     }
     float GetLEyeOpenness() const
     {
-        return InternalData.LEyeOpenness;
+        return Record.LEyeOpenness;
     }
     bool GetLEyeOpenValid() const
     {
-        return InternalData.LEyeOpenValid;
+        return Record.LEyeOpenValid != 0;
     }
     float GetREyeOpenness() const
     {
-        return InternalData.REyeOpenness;
+        return Record.REyeOpenness;
     }
     bool GetREyeOpenValid() const
     {
-        return InternalData.REyeOpenValid;
+        return Record.REyeOpenValid != 0;
     }
     const geom::Vector2D &GetLPupilPos() const
     {
-        return InternalData.LPupilPos;
+        return Record.LPupilPos;
     }
     bool GetLPupilPosValid() const
     {
-        return InternalData.LPupilPosValid;
+        return Record.LPupilPosValid != 0;
     }
     const geom::Vector2D &GetRPupilPos() const
     {
-        return InternalData.RPupilPos;
+        return Record.RPupilPos;
     }
     bool GetRPupilPosValid() const
     {
-        return InternalData.RPupilPosValid;
+        return Record.RPupilPosValid != 0;
     }
     float GetLPupilDiam() const
     {
-        return InternalData.LPupilDiameter;
+        return Record.LPupilDiameter;
     }
     float GetRPupilDiam() const
     {
-        return InternalData.RPupilDiameter;
+        return Record.RPupilDiameter;
     }
     const std::string &GetFocusActorName() const
     {
-        return InternalData.FocusActorName;
+        return FocusActorName;
     }
     const geom::Vector3D &GetFocusActorPoint() const
     {
-        return InternalData.FocusActorPoint;
+        return Record.FocusActorPoint;
     }
     float GetFocusActorDist() const
     {
-        return InternalData.FocusActorDist;
+        return Record.FocusActorDist;
     }
     float GetThrottle() const
     {
-        return InternalData.Throttle;
+        return Record.Throttle;
     }
     float GetSteering() const
     {
-        return InternalData.Steering;
+        return Record.Steering;
     }
     float GetBrake() const
     {
-        return InternalData.Brake;
+        return Record.Brake;
     }
     bool GetToggledReverse() const
     {
-        return InternalData.ToggledReverse;
+        return Record.ToggledReverse != 0;
     }
     bool GetHandbrake() const
     {
-        return InternalData.HoldHandbrake;
+        return Record.HoldHandbrake != 0;
+    }
+    /// id of the focused actor interned by the server (0 when the event was sent as MsgPack)
+    uint32_t GetFocusActorId() const
+    {
+        return Record.FocusActorId;
+    }
+    /// groups of fields the server filled (DReyeVRSerializer::Field), the others are zero
+    uint32_t GetFields() const
+    {
+        return Record.Fields;
+    }
+    /// true if every group of Fields was filled
+    bool HasFields(uint32_t Fields) const
+    {
+        return (Record.Fields & Fields) == Fields;
+    }
+    /// events the server sent on this stream before this one, a gap between two events means some were missed
+    uint64_t GetStreamSequence() const
+    {
+        return Record.StreamSequence;
+    }
+    uint64_t GetStreamId() const
+    {
+        return Record.StreamId;
+    }
+    /// whether the eye-tracker readings up to this event are a fixation (see [EgoSensor] Fixation* on the server)
+    bool GetFixating() const
+    {
+        return Record.Fixating != 0;
+    }
+    /// TimestampDevice of the first and last readings of the ongoing fixation (or of the last one)
+    int64_t GetFixationStart() const
+    {
+        return Record.FixationStart;
+    }
+    int64_t GetFixationEnd() const
+    {
+        return Record.FixationEnd;
+    }
+    /// actor that fixation is on (the focused actor of the majority of its readings)
+    const std::string &GetFixationActorName() const
+    {
+        return FixationActorName;
+    }
+    /// fixations that started or ended since the previous event (only sent in the MsgPack stream, the binary one
+    /// has their number in the record)
+    const std::vector<s11n::DReyeVRSerializer::FixationEvent> &GetFixationEvents() const
+    {
+        return FixationEvents;
+    }
+    /// Carla id of the actor the gaze is on (0 for none) and the dwell statistics of the actors that changed since
+    /// the previous event, or of all of them if IsDwellComplete (only sent in the MsgPack stream)
+    uint32_t GetDwellActorId() const
+    {
+        return DwellActorId;
+    }
+    const std::vector<s11n::DReyeVRSerializer::DwellStats> &GetDwell() const
+    {
+        return Dwell;
+    }
+    bool IsDwellComplete() const
+    {
+        return bDwellComplete;
+    }
+    /// the actors around the gaze ray, the closest to it first (only sent in the MsgPack stream)
+    const std::vector<s11n::DReyeVRSerializer::GazeConeHit> &GetGazeCone() const
+    {
+        return GazeCone;
+    }
+    /// every eye-tracker reading since the previous event (oldest first), the fields above are of the latest one
+    const std::vector<s11n::DReyeVRSerializer::EyeSample> &GetEyeSamples() const
+    {
+        return EyeSamples;
+    }
+    /// all the fields above in the fixed layout of the binary stream (see DREYEVR_STREAM_DTYPE for NumPy)
+    const s11n::DReyeVRSerializer::Record &GetRecord() const
+    {
+        return Record;
     }
 
   private:
-    carla::sensor::s11n::DReyeVRSerializer::Data InternalData;
+    s11n::DReyeVRSerializer::Record Record{};
+    std::string FocusActorName;
+    std::vector<s11n::DReyeVRSerializer::EyeSample> EyeSamples;
+    std::string FixationActorName;
+    std::vector<s11n::DReyeVRSerializer::FixationEvent> FixationEvents;
+    uint32_t DwellActorId = 0;
+    std::vector<s11n::DReyeVRSerializer::DwellStats> Dwell;
+    bool bDwellComplete = false;
+    std::vector<s11n::DReyeVRSerializer::GazeConeHit> GazeCone;
 };
 } // namespace data
 } // namespace sensor
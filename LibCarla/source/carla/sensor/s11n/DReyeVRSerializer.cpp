@@ -1,6 +1,11 @@
 #include "carla/sensor/s11n/DReyeVRSerializer.h"
 #include "carla/sensor/data/DReyeVREvent.h"
 
+#include <cctype>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
 namespace carla
 {
     namespace sensor
@@ -11,6 +16,67 @@ namespace carla
             {
                 return SharedPtr<SensorData>(new data::DReyeVREvent(std::move(data)));
             }
+
+            // (events are deserialized on the streaming threads) every sensor interns the ids of its own stream
+            static std::mutex FocusActorNamesMutex;
+            static std::unordered_map<uint64_t, std::unordered_map<uint32_t, std::string>> FocusActorNames;
+
+            std::string DReyeVRSerializer::GetFocusActorName(uint64_t StreamId, uint32_t Id)
+            {
+                std::lock_guard<std::mutex> Lock(FocusActorNamesMutex);
+                auto Stream = FocusActorNames.find(StreamId);
+                if (Stream == FocusActorNames.end())
+                    return std::string();
+                auto It = Stream->second.find(Id);
+                return It != Stream->second.end() ? It->second : std::string();
+            }
+
+            void DReyeVRSerializer::SetFocusActorName(uint64_t StreamId, uint32_t Id, const std::string &Name)
+            {
+                std::lock_guard<std::mutex> Lock(FocusActorNamesMutex);
+                FocusActorNames[StreamId][Id] = Name;
+            }
+
+            bool DReyeVRSerializer::ParseFields(const std::string &In, uint32_t &Out)
+            {
+                static const std::unordered_map<std::string, uint32_t> Groups = {
+                    {"all", FIELDS_ALL},      {"none", 0u},           {"camera", FIELD_CAMERA},
+                    {"gaze", FIELD_GAZE},     {"eyes", FIELD_EYES},   {"pupils", FIELD_PUPILS},
+                    {"focus", FIELD_FOCUS},   {"inputs", FIELD_INPUTS}, {"eye_samples", FIELD_EYE_SAMPLES},
+                    {"fixations", FIELD_FIXATIONS}, {"dwell", FIELD_DWELL}, {"gaze_cone", FIELD_GAZE_CONE},
+                };
+                uint32_t Fields = 0;
+                size_t Begin = 0;
+                while (Begin <= In.size())
+                {
+                    size_t End = In.find_first_of(",|", Begin);
+                    if (End == std::string::npos)
+                        End = In.size();
+                    // trimmed, lower case name
+                    std::string Name;
+                    for (size_t i = Begin; i < End; i++)
+                        if (!std::isspace(static_cast<unsigned char>(In[i])))
+                            Name += static_cast<char>(std::tolower(static_cast<unsigned char>(In[i])));
+                    Begin = End + 1;
+                    if (Name.empty())
+                        continue;
+                    if (std::isdigit(static_cast<unsigned char>(Name[0])))
+                    {
+                        char *NumEnd = nullptr;
+                        const unsigned long Mask = std::strtoul(Name.c_str(), &NumEnd, 0);
+                        if (*NumEnd != '\0')
+                            return false;
+                        Fields |= static_cast<uint32_t>(Mask) & FIELDS_ALL;
+                        continue;
+                    }
+                    auto It = Groups.find(Name);
+                    if (It == Groups.end())
+                        return false;
+                    Fields |= It->second;
+                }
+                Out = Fields;
+                return true;
+            }
         } // namespace s11n
     }     // namespace sensor
 } // namespace carla
\ No newline at end of file
@@ -7,8 +7,12 @@
 #include "carla/geom/Vector3D.h"
 #include "carla/sensor/RawData.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace carla
 {
@@ -18,9 +22,118 @@ class SensorData;
 
 namespace s11n
 {
+
+// fixed-layout records of the DReyeVR sensor stream ([EgoSensor] BinaryStream in DReyeVRConfig.ini)
+#define DREYEVR_STREAM_MAGIC 0x53565244u // "DRVS" (little endian), never the start of a MsgPack array
+// 2: eye-tracker samples (NumEyeSamples), 3: field groups (Fields), 4: StreamSequence, 5: fixations, 6: StreamId
+#define DREYEVR_STREAM_VERSION 6
+// records between two resends of the focused actor's name (for listeners that connect later)
+#define DREYEVR_STREAM_NAME_INTERVAL 90
+
 class DReyeVRSerializer
 {
   public:
+    /// Groups of fields the sensor fills, chosen with its `fields` attribute ([EgoSensor] StreamFields by default).
+    /// The timestamps and frame sequence are always sent, the fields of the groups that are not are left zeroed
+    enum Field : uint32_t
+    {
+        FIELD_CAMERA = 1u << 0,      // CameraLocation, CameraRotation
+        FIELD_GAZE = 1u << 1,        // combined gaze
+        FIELD_EYES = 1u << 2,        // left and right gaze and eye openness
+        FIELD_PUPILS = 1u << 3,      // left and right pupil position and diameter
+        FIELD_FOCUS = 1u << 4,       // focused actor
+        FIELD_INPUTS = 1u << 5,      // vehicle inputs
+        FIELD_EYE_SAMPLES = 1u << 6, // EyeSamples
+        FIELD_FIXATIONS = 1u << 7,   // fixation classification (Fixating, Fixation*)
+        FIELD_DWELL = 1u << 8,       // per-actor gaze dwell statistics (DwellActorId, Dwell)
+        FIELD_GAZE_CONE = 1u << 9,   // actors around the gaze ray (GazeCone)
+        FIELDS_ALL = (1u << 10) - 1,
+    };
+
+    /// One reading of the eye tracker, the sensor sends every reading since the previous tick (the device samples
+    /// faster than the game ticks, see [EgoSensor] AsyncEyeTracker). Fixed layout, the NumPy dtype is
+    /// DREYEVR_EYE_SAMPLE_DTYPE in PythonAPI/examples/DReyeVR_utils.py
+    struct EyeSample
+    {
+        int64_t TimestampDevice;
+        int64_t FrameSequence;
+        // combined gaze
+        geom::Vector3D GazeDir;
+        geom::Vector3D GazeOrigin;
+        float GazeVergence;
+        // left gaze/eye
+        geom::Vector3D LGazeDir;
+        geom::Vector3D LGazeOrigin;
+        float LEyeOpenness;
+        geom::Vector2D LPupilPos;
+        float LPupilDiameter;
+        // right gaze/eye
+        geom::Vector3D RGazeDir;
+        geom::Vector3D RGazeOrigin;
+        float REyeOpenness;
+        geom::Vector2D RPupilPos;
+        float RPupilDiameter;
+        // validity flags (0 or 1)
+        uint8_t GazeValid;
+        uint8_t LGazeValid;
+        uint8_t LEyeOpenValid;
+        uint8_t LPupilPosValid;
+        uint8_t RGazeValid;
+        uint8_t REyeOpenValid;
+        uint8_t RPupilPosValid;
+        uint8_t Reserved[5];
+
+        MSGPACK_DEFINE_ARRAY(TimestampDevice, FrameSequence, GazeDir, GazeOrigin, GazeVergence, // combined gaze
+                             LGazeDir, LGazeOrigin, LEyeOpenness, LPupilPos, LPupilDiameter,   // left gaze/eye
+                             RGazeDir, RGazeOrigin, REyeOpenness, RPupilPos, RPupilDiameter,   // right gaze/eye
+                             GazeValid, LGazeValid, LEyeOpenValid, LPupilPosValid, RGazeValid, REyeOpenValid,
+                             RPupilPosValid)
+    };
+    static_assert(std::is_trivially_copyable<EyeSample>::value, "eye samples are copied as bytes");
+    static_assert(sizeof(EyeSample) == 136, "the eye sample layout changed, update DREYEVR_EYE_SAMPLE_DTYPE");
+
+    /// A fixation that started or ended since the previous tick (see DReyeVRGazeClassifier.h on the server)
+    struct FixationEvent
+    {
+        bool IsStart;          // a fixation started (else it ended)
+        int64_t Start;         // TimestampDevice of its first eye-tracker reading
+        int64_t End;           // and of its last one (so far, for starts)
+        float Yaw;             // mean combined gaze direction (degrees, in the camera frame)
+        float Pitch;
+        std::string ActorName; // focused actor of the majority of its readings
+
+        MSGPACK_DEFINE_ARRAY(IsStart, Start, End, Yaw, Pitch, ActorName)
+    };
+
+    /// Gaze dwell statistics of one Carla actor since the sensor was spawned (see DReyeVRDwellAccumulator.h in
+    /// the Carla plugin), timestamps are TimestampCarla (ms)
+    struct DwellStats
+    {
+        uint32_t ActorId;       // Carla actor id (world.get_actor)
+        uint32_t NumGlances;    // separate visits of the gaze to this actor
+        uint32_t NumFixations;  // fixations that were confirmed on it
+        int64_t TotalDwell;     // ms of gaze on it
+        int64_t FirstGlance;    // start of its first glance
+        int64_t FirstFixation;  // start of its first fixation (-1 if none)
+        int64_t LastGlance;     // start of its latest glance
+        int64_t LongestGlance;  // ms
+
+        MSGPACK_DEFINE_ARRAY(ActorId, NumGlances, NumFixations, TotalDwell, FirstGlance, FirstFixation, LastGlance,
+                             LongestGlance)
+    };
+
+    /// An actor within [EgoSensor] GazeConeAngle of the combined gaze ray (see DReyeVRGazeCone.h in the Carla
+    /// plugin), the closest to the ray first
+    struct GazeConeHit
+    {
+        uint32_t ActorId; // Carla actor id (world.get_actor)
+        float Angle;      // degrees between the gaze ray and the direction to the actor's center
+        float EdgeAngle;  // degrees between the gaze ray and the actor's bounding sphere (0 if the ray goes through)
+        float Distance;   // to the actor's center (cm)
+
+        MSGPACK_DEFINE_ARRAY(ActorId, Angle, EdgeAngle, Distance)
+    };
+
     struct Data
     {
         /// TODO: refactor this struct to contain smaller structs similar to DReyeVR::AggregateData
@@ -68,6 +181,25 @@ class DReyeVRSerializer
         float Brake;
         bool ToggledReverse;
         bool HoldHandbrake;
+        // eye-tracker readings since the previous tick (oldest first)
+        std::vector<EyeSample> EyeSamples;
+        // groups of fields that were filled (Field), older servers did not send it
+        uint32_t Fields = FIELDS_ALL;
+        // events sent on this stream before this one, a gap means the client missed events
+        uint64_t StreamSequence = 0;
+        // fixations: the ongoing one (or the last one if not Fixating) and the events since the previous tick
+        bool Fixating = false;
+        int64_t FixationStart = 0;
+        int64_t FixationEnd = 0;
+        std::string FixationActorName;
+        std::vector<FixationEvent> FixationEvents;
+        // dwell: the actor the gaze is on (0 for none) and the actors whose statistics changed this tick, or all of
+        // them every DREYEVR_STREAM_NAME_INTERVAL events (DwellComplete, for the clients that connect later)
+        uint32_t DwellActorId = 0;
+        std::vector<DwellStats> Dwell;
+        bool DwellComplete = false;
+        // actors around the gaze ray
+        std::vector<GazeConeHit> GazeCone;
 
         MSGPACK_DEFINE_ARRAY(TimestampCarla, TimestampDevice, FrameSequence, // timings
                              CameraLocation, CameraRotation,                 // camera
@@ -75,20 +207,186 @@ class DReyeVRSerializer
                              LGazeDir, LGazeOrigin, LGazeValid, LEyeOpenness, LEyeOpenValid, LPupilPos, LPupilPosValid, LPupilDiameter, // left gaze/eye
                              RGazeDir, RGazeOrigin, RGazeValid, REyeOpenness, REyeOpenValid, RPupilPos, RPupilPosValid, RPupilDiameter, // right gaze/eye
                              FocusActorName, FocusActorPoint, FocusActorDist,         // focus info
-                             Throttle, Steering, Brake, ToggledReverse, HoldHandbrake // user inputs
+                             Throttle, Steering, Brake, ToggledReverse, HoldHandbrake, // user inputs
+                             EyeSamples,                                               // eye-tracker samples
+                             Fields, StreamSequence,                                   // field groups, sequence
+                             Fixating, FixationStart, FixationEnd, FixationActorName, FixationEvents, // fixations
+                             DwellActorId, Dwell, DwellComplete,                                       // dwell
+                             GazeCone                                                                  // gaze cone
         )
     };
 
+    /// Alternative to Data that is a fixed-size POD: the same fields (bools as bytes) and the focused actor as an
+    /// id interned by the server. The record is followed by NumEyeSamples EyeSamples (of EyeSampleSize bytes) and
+    /// then by the focused actor's name (FocusNameLength bytes), which is only sent when the id changes and every
+    /// DREYEVR_STREAM_NAME_INTERVAL records. New fields are only ever appended (bumping the version), so a
+    /// reader can always use the first Size bytes it knows. The NumPy dtype of this layout is in
+    /// PythonAPI/examples/DReyeVR_utils.py (DREYEVR_STREAM_DTYPE), keep both in sync
+    struct Record
+    {
+        uint32_t Magic = DREYEVR_STREAM_MAGIC;
+        uint16_t Version = DREYEVR_STREAM_VERSION;
+        uint16_t Size = 0; // sizeof(Record) of the writer
+        int64_t TimestampCarla;
+        int64_t TimestampDevice;
+        int64_t FrameSequence;
+        // camera
+        geom::Vector3D CameraLocation;
+        geom::Vector3D CameraRotation;
+        // combined gaze
+        geom::Vector3D GazeDir;
+        geom::Vector3D GazeOrigin;
+        float GazeVergence;
+        // left gaze/eye
+        geom::Vector3D LGazeDir;
+        geom::Vector3D LGazeOrigin;
+        float LEyeOpenness;
+        geom::Vector2D LPupilPos;
+        float LPupilDiameter;
+        // right gaze/eye
+        geom::Vector3D RGazeDir;
+        geom::Vector3D RGazeOrigin;
+        float REyeOpenness;
+        geom::Vector2D RPupilPos;
+        float RPupilDiameter;
+        // focus
+        geom::Vector3D FocusActorPoint;
+        float FocusActorDist;
+        // inputs
+        float Throttle;
+        float Steering;
+        float Brake;
+        // focus (interned)
+        uint32_t FocusActorId; // 0 if unknown
+        // validity and button flags (0 or 1)
+        uint8_t GazeValid;
+        uint8_t LGazeValid;
+        uint8_t LEyeOpenValid;
+        uint8_t LPupilPosValid;
+        uint8_t RGazeValid;
+        uint8_t REyeOpenValid;
+        uint8_t RPupilPosValid;
+        uint8_t ToggledReverse;
+        uint8_t HoldHandbrake;
+        uint8_t Reserved = 0;
+        uint16_t FocusNameLength = 0; // bytes of the focused actor's name after the eye samples
+        // (version 2)
+        uint16_t NumEyeSamples = 0;
+        uint16_t EyeSampleSize = 0; // sizeof(EyeSample) of the writer
+        // (version 3)
+        uint32_t Fields = FIELDS_ALL; // groups of fields that were filled (Field)
+        // (version 4)
+        uint64_t StreamSequence = 0; // events sent on this stream before this one
+        // (version 5) the events themselves are only in the MsgPack stream
+        int64_t FixationStart = 0;
+        int64_t FixationEnd = 0;
+        uint32_t FixationActorId = 0; // interned like FocusActorId
+        uint8_t Fixating = 0;
+        uint8_t NumFixationEvents = 0; // fixations that started or ended since the previous tick
+        uint16_t Reserved2 = 0;
+        // (version 6)
+        uint64_t StreamId = 0; // random id of the sensor sending the stream, which interns its own actor ids
+    };
+    static_assert(std::is_trivially_copyable<Record>::value, "DReyeVR stream records are copied as bytes");
+    static_assert(sizeof(Record) == 256, "the DReyeVR stream record layout changed, update DREYEVR_STREAM_DTYPE");
+
     static Data DeserializeRawData(const RawData &message)
     {
         return MsgPack::UnPack<Data>(message.begin(), message.size());
     }
 
+    static bool IsRecord(const RawData &message)
+    {
+        uint32_t Magic = 0;
+        if (message.size() < sizeof(uint32_t) + 2 * sizeof(uint16_t)) // Magic, Version, Size
+            return false;
+        std::memcpy(&Magic, message.begin(), sizeof(Magic));
+        return Magic == DREYEVR_STREAM_MAGIC;
+    }
+
+    // (FocusActorName is left to the caller)
+    static Record ToRecord(const Data &In)
+    {
+        Record Out;
+        Out.Size = sizeof(Record);
+        Out.TimestampCarla = In.TimestampCarla;
+        Out.TimestampDevice = In.TimestampDevice;
+        Out.FrameSequence = In.FrameSequence;
+        Out.CameraLocation = In.CameraLocation;
+        Out.CameraRotation = In.CameraRotation;
+        Out.GazeDir = In.GazeDir;
+        Out.GazeOrigin = In.GazeOrigin;
+        Out.GazeVergence = In.GazeVergence;
+        Out.LGazeDir = In.LGazeDir;
+        Out.LGazeOrigin = In.LGazeOrigin;
+        Out.LEyeOpenness = In.LEyeOpenness;
+        Out.LPupilPos = In.LPupilPos;
+        Out.LPupilDiameter = In.LPupilDiameter;
+        Out.RGazeDir = In.RGazeDir;
+        Out.RGazeOrigin = In.RGazeOrigin;
+        Out.REyeOpenness = In.REyeOpenness;
+        Out.RPupilPos = In.RPupilPos;
+        Out.RPupilDiameter = In.RPupilDiameter;
+        Out.FocusActorPoint = In.FocusActorPoint;
+        Out.FocusActorDist = In.FocusActorDist;
+        Out.Throttle = In.Throttle;
+        Out.Steering = In.Steering;
+        Out.Brake = In.Brake;
+        Out.FocusActorId = 0;
+        Out.GazeValid = In.GazeValid;
+        Out.LGazeValid = In.LGazeValid;
+        Out.LEyeOpenValid = In.LEyeOpenValid;
+        Out.LPupilPosValid = In.LPupilPosValid;
+        Out.RGazeValid = In.RGazeValid;
+        Out.REyeOpenValid = In.REyeOpenValid;
+        Out.RPupilPosValid = In.RPupilPosValid;
+        Out.ToggledReverse = In.ToggledReverse;
+        Out.HoldHandbrake = In.HoldHandbrake;
+        Out.Fields = In.Fields;
+        Out.StreamSequence = In.StreamSequence;
+        Out.FixationStart = In.FixationStart;
+        Out.FixationEnd = In.FixationEnd;
+        Out.FixationActorId = 0;
+        Out.Fixating = In.Fixating;
+        Out.NumFixationEvents = static_cast<uint8_t>(std::min<size_t>(In.FixationEvents.size(), UINT8_MAX));
+        return Out;
+    }
+
     template <typename SensorT> static Buffer Serialize(const SensorT &, struct Data &&DataIn)
     {
         return MsgPack::Pack(DataIn);
     }
+
+    // FocusName is only sent when the client may not know the name of RecordIn.FocusActorId yet
+    template <typename SensorT>
+    static Buffer Serialize(const SensorT &, const Record &RecordIn, const std::vector<EyeSample> &Samples,
+                            const std::string &FocusName)
+    {
+        Record Header = RecordIn;
+        Header.Size = sizeof(Record);
+        Header.NumEyeSamples = static_cast<uint16_t>(std::min<size_t>(Samples.size(), UINT16_MAX));
+        Header.EyeSampleSize = sizeof(EyeSample);
+        Header.FocusNameLength = static_cast<uint16_t>(FocusName.size());
+        const size_t SamplesSize = Header.NumEyeSamples * sizeof(EyeSample);
+        Buffer Out(static_cast<Buffer::size_type>(sizeof(Record) + SamplesSize + FocusName.size()));
+        std::memcpy(Out.data(), &Header, sizeof(Record));
+        if (SamplesSize > 0)
+            std::memcpy(Out.data() + sizeof(Record), Samples.data(), SamplesSize);
+        if (!FocusName.empty())
+            std::memcpy(Out.data() + sizeof(Record) + SamplesSize, FocusName.data(), FocusName.size());
+        return Out;
+    }
+
     static SharedPtr<SensorData> Deserialize(RawData &&data);
+
+    // "all", "none" (only the timings), a number, or names of Field groups separated by commas (ex. "gaze,focus"
+    // for camera, gaze, eyes, pupils, focus, inputs, eye_samples, fixations). Returns false if a name is unknown
+    static bool ParseFields(const std::string &In, uint32_t &Out);
+
+    // names of the interned focus actor ids seen so far by this client, per stream (writers before version 6 all
+    // share StreamId 0)
+    static std::string GetFocusActorName(uint64_t StreamId, uint32_t Id);
+    static void SetFocusActorName(uint64_t StreamId, uint32_t Id, const std::string &Name);
 };
 
 } // namespace s11n
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "carla/sensor/s11n/DReyeVRSerializer.h"
+
+#include <boost/interprocess/mapped_region.hpp>
+#ifdef _WIN32
+#include <boost/interprocess/windows_shared_memory.hpp>
+#else
+#include <boost/interprocess/shared_memory_object.hpp>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace carla
+{
+namespace sensor
+{
+namespace s11n
+{
+
+// shared-memory ring of DReyeVR records for readers on the same machine ([EgoSensor] SharedMemory)
+#define DREYEVR_SHM_MAGIC 0x4D565244u // "DRVM" (little endian)
+#define DREYEVR_SHM_VERSION 2
+#define DREYEVR_SHM_NAME_SIZE 64       // bytes of the focused actor's name (truncated)
+#define DREYEVR_SHM_MAX_EYE_SAMPLES 16 // eye-tracker samples per record (the oldest are dropped)
+
+/// Layout of the shared memory, a header followed by NumSlots slots. The server publishes record i into slot
+/// i % NumSlots and never waits for the readers: each slot is a seqlock whose sequence is 2i+1 while record i is
+/// written and 2i+2 once it is complete, so a reader copies a slot and checks that the sequence did not change
+/// (without any syscall or lock). Readers that fall more than NumSlots records behind lose the oldest ones. The
+/// NumPy view of this layout is in PythonAPI/examples/DReyeVR_shm.py, keep both in sync
+struct DReyeVRSharedMemoryLayout
+{
+    using Record = DReyeVRSerializer::Record;
+    using EyeSample = DReyeVRSerializer::EyeSample;
+
+    struct Header
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t HeaderSize; // sizeof(Header)
+        uint32_t SlotSize;   // sizeof(Slot)
+        uint32_t NumSlots;
+        uint32_t MaxEyeSamples;
+        uint32_t Reserved;
+        std::atomic<uint64_t> NumPublished; // records published so far (the latest is NumPublished - 1)
+        uint64_t Reserved2[4];
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> Sequence; // 2i+1 while record i is written, 2i+2 once it is complete
+        uint64_t Reserved;
+        DReyeVRSerializer::Record Record; // NumEyeSamples and FocusNameLength are clipped to the arrays below
+        char FocusActorName[DREYEVR_SHM_NAME_SIZE];
+        EyeSample EyeSamples[DREYEVR_SHM_MAX_EYE_SAMPLES];
+    };
+
+    static_assert(sizeof(Header) == 64, "the shared memory header layout changed, update DReyeVR_shm.py");
+    static_assert(sizeof(Slot) == 16 + sizeof(Record) + DREYEVR_SHM_NAME_SIZE +
+                                      DREYEVR_SHM_MAX_EYE_SAMPLES * sizeof(EyeSample),
+                  "the shared memory slot layout changed, update DReyeVR_shm.py");
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "the seqlock counters are shared as plain words");
+
+    static size_t GetSize(uint32_t NumSlots)
+    {
+        return sizeof(Header) + size_t(NumSlots) * sizeof(Slot);
+    }
+
+    static Slot *GetSlots(Header *H)
+    {
+        return reinterpret_cast<Slot *>(reinterpret_cast<char *>(H) + sizeof(Header));
+    }
+
+    static void Init(void *Memory, uint32_t NumSlots)
+    {
+        std::memset(Memory, 0, GetSize(NumSlots));
+        Header *H = new (Memory) Header{};
+        H->Magic = DREYEVR_SHM_MAGIC;
+        H->Version = DREYEVR_SHM_VERSION;
+        H->HeaderSize = sizeof(Header);
+        H->SlotSize = sizeof(Slot);
+        H->NumSlots = NumSlots;
+        H->MaxEyeSamples = DREYEVR_SHM_MAX_EYE_SAMPLES;
+        H->NumPublished.store(0, std::memory_order_release);
+    }
+
+    // (single writer)
+    static void Publish(Header *H, const Record &RecordIn, const std::vector<EyeSample> &Samples,
+                        const std::string &FocusName)
+    {
+        const uint64_t Index = H->NumPublished.load(std::memory_order_relaxed);
+        Slot &S = GetSlots(H)[Index % H->NumSlots];
+        S.Sequence.store(2 * Index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // the odd sequence is visible before any data
+        S.Record = RecordIn;
+        S.Record.Size = sizeof(Record);
+        S.Record.EyeSampleSize = sizeof(EyeSample);
+        S.Record.NumEyeSamples = static_cast<uint16_t>(std::min<size_t>(Samples.size(), DREYEVR_SHM_MAX_EYE_SAMPLES));
+        const size_t FirstSample = Samples.size() - S.Record.NumEyeSamples; // keep the latest ones
+        if (S.Record.NumEyeSamples > 0)
+            std::memcpy(S.EyeSamples, Samples.data() + FirstSample, S.Record.NumEyeSamples * sizeof(EyeSample));
+        S.Record.FocusNameLength = static_cast<uint16_t>(std::min<size_t>(FocusName.size(), DREYEVR_SHM_NAME_SIZE));
+        std::memcpy(S.FocusActorName, FocusName.data(), S.Record.FocusNameLength);
+        S.Sequence.store(2 * Index + 2, std::memory_order_release);
+        H->NumPublished.store(Index + 1, std::memory_order_release);
+    }
+
+    // copies record Index, false if it is not complete (being written) or was already overwritten
+    static bool TryRead(const Header *H, uint64_t Index, Slot &Out)
+    {
+        const Slot &S = GetSlots(const_cast<Header *>(H))[Index % H->NumSlots];
+        const uint64_t Expected = 2 * Index + 2;
+        if (S.Sequence.load(std::memory_order_acquire) != Expected)
+            return false;
+        constexpr size_t Begin = offsetof(Slot, Record); // everything after the sequence
+        std::memcpy(reinterpret_cast<char *>(&Out) + Begin, reinterpret_cast<const char *>(&S) + Begin,
+                    sizeof(Slot) - Begin);
+        std::atomic_thread_fence(std::memory_order_acquire); // the copy is done before checking again
+        return S.Sequence.load(std::memory_order_relaxed) == Expected;
+    }
+};
+
+/// Creates the shared memory and publishes records into it (the server side)
+class DReyeVRSharedMemoryWriter
+{
+  public:
+    // throws boost::interprocess::interprocess_exception if the shared memory cannot be created
+    DReyeVRSharedMemoryWriter(const std::string &Name, uint32_t NumSlots) : Name(Name)
+    {
+        NumSlots = std::max<uint32_t>(NumSlots, 2);
+        const size_t Size = DReyeVRSharedMemoryLayout::GetSize(NumSlots);
+        using namespace boost::interprocess;
+#ifdef _WIN32
+        // native named mapping (ex. mmap.mmap(-1, size, tagname) in Python), gone with its last handle
+        Memory = windows_shared_memory(create_only, Name.c_str(), read_write, Size);
+#else
+        shared_memory_object::remove(Name.c_str()); // left over by a crash
+        Memory = shared_memory_object(create_only, Name.c_str(), read_write);
+        Memory.truncate(static_cast<offset_t>(Size));
+#endif
+        Region = mapped_region(Memory, read_write, 0, Size);
+        DReyeVRSharedMemoryLayout::Init(Region.get_address(), NumSlots);
+    }
+
+    ~DReyeVRSharedMemoryWriter()
+    {
+#ifndef _WIN32
+        boost::interprocess::shared_memory_object::remove(Name.c_str());
+#endif
+    }
+
+    DReyeVRSharedMemoryWriter(const DReyeVRSharedMemoryWriter &) = delete;
+    DReyeVRSharedMemoryWriter &operator=(const DReyeVRSharedMemoryWriter &) = delete;
+
+    void Publish(const DReyeVRSerializer::Record &Record, const std::vector<DReyeVRSerializer::EyeSample> &Samples,
+                 const std::string &FocusName)
+    {
+        DReyeVRSharedMemoryLayout::Publish(GetHeader(), Record, Samples, FocusName);
+    }
+
+    uint64_t GetNumPublished() const
+    {
+        return GetHeader()->NumPublished.load(std::memory_order_relaxed);
+    }
+
+  private:
+    DReyeVRSharedMemoryLayout::Header *GetHeader() const
+    {
+        return static_cast<DReyeVRSharedMemoryLayout::Header *>(Region.get_address());
+    }
+
+    std::string Name;
+#ifdef _WIN32
+    boost::interprocess::windows_shared_memory Memory;
+#else
+    boost::interprocess::shared_memory_object Memory;
+#endif
+    boost::interprocess::mapped_region Region;
+};
+
+/// Polls the shared memory of a DReyeVRSharedMemoryWriter (the local clients), one reader per thread
+class DReyeVRSharedMemoryReader
+{
+  public:
+    struct Sample
+    {
+        DReyeVRSerializer::Record Record;
+        std::string FocusActorName;
+        std::vector<DReyeVRSerializer::EyeSample> EyeSamples;
+    };
+
+    // throws boost::interprocess::interprocess_exception if there is no such shared memory, and
+    // std::runtime_error if it is not a DReyeVR ring this reader understands
+    explicit DReyeVRSharedMemoryReader(const std::string &Name)
+    {
+        using namespace boost::interprocess;
+#ifdef _WIN32
+        Memory = windows_shared_memory(open_only, Name.c_str(), read_only);
+#else
+        Memory = shared_memory_object(open_only, Name.c_str(), read_only);
+#endif
+        Region = mapped_region(Memory, read_only);
+        const auto *H = GetHeader();
+        if (Region.get_size() < sizeof(*H) || H->Magic != DREYEVR_SHM_MAGIC || H->Version != DREYEVR_SHM_VERSION ||
+            H->HeaderSize != sizeof(*H) || H->SlotSize != sizeof(DReyeVRSharedMemoryLayout::Slot) ||
+            Region.get_size() < DReyeVRSharedMemoryLayout::GetSize(H->NumSlots))
+            throw std::runtime_error("\"" + Name + "\" is not a DReyeVR shared memory ring of this version");
+        NextIndex = H->NumPublished.load(std::memory_order_acquire); // only what is published from now on
+    }
+
+    // the oldest record not read yet, false if there is none. Records overwritten before they were read are
+    // skipped (see GetNumLost)
+    bool Next(Sample &Out)
+    {
+        const auto *H = GetHeader();
+        while (true)
+        {
+            const uint64_t NumPublished = H->NumPublished.load(std::memory_order_acquire);
+            if (NextIndex >= NumPublished)
+                return false;
+            if (NumPublished - NextIndex > H->NumSlots) // overwritten already
+            {
+                NumLost += NumPublished - H->NumSlots - NextIndex;
+                NextIndex = NumPublished - H->NumSlots;
+            }
+            if (Read(NextIndex++, Out))
+                return true;
+            NumLost++; // overwritten while reading it
+        }
+    }
+
+    // the most recent record (skipping the ones in between), false if nothing new was published
+    bool Latest(Sample &Out)
+    {
+        const uint64_t NumPublished = GetHeader()->NumPublished.load(std::memory_order_acquire);
+        if (NextIndex >= NumPublished)
+            return false;
+        NextIndex = NumPublished - 1;
+        return Next(Out);
+    }
+
+    uint64_t GetNumLost() const
+    {
+        return NumLost;
+    }
+
+  private:
+    const DReyeVRSharedMemoryLayout::Header *GetHeader() const
+    {
+        return static_cast<const DReyeVRSharedMemoryLayout::Header *>(Region.get_address());
+    }
+
+    bool Read(uint64_t Index, Sample &Out)
+    {
+        if (!DReyeVRSharedMemoryLayout::TryRead(GetHeader(), Index, Slot))
+            return false;
+        Out.Record = Slot.Record;
+        Out.FocusActorName.assign(Slot.FocusActorName, Slot.Record.FocusNameLength);
+        Out.EyeSamples.assign(Slot.EyeSamples, Slot.EyeSamples + Slot.Record.NumEyeSamples);
+        return true;
+    }
+
+#ifdef _WIN32
+    boost::interprocess::windows_shared_memory Memory;
+#else
+    boost::interprocess::shared_memory_object Memory;
+#endif
+    boost::interprocess::mapped_region Region;
+    DReyeVRSharedMemoryLayout::Slot Slot; // copy of the slot being read
+    uint64_t NextIndex = 0;
+    uint64_t NumLost = 0;
+};
+
+} // namespace s11n
+} // namespace sensor
+} // namespace carla
@@ -0,0 +1,200 @@
+#include "test.h"
+
+#include <carla/Buffer.h>
+#include <carla/MsgPack.h>
+#include <carla/sensor/s11n/DReyeVRSerializer.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using Serializer = carla::sensor::s11n::DReyeVRSerializer;
+
+// what ADReyeVRSensor::PostPhysTick fills every tick for these fields
+static Serializer::Data MakeData(uint32_t Fields, int64_t Tick, size_t NumEyeSamples) {
+  using carla::geom::Vector2D;
+  using carla::geom::Vector3D;
+  const float t = static_cast<float>(Tick);
+  Serializer::Data Data{};
+  Data.Fields = Fields;
+  Data.TimestampCarla = 1000 * Tick;
+  Data.TimestampDevice = 5000000 + 8333 * Tick;
+  Data.FrameSequence = Tick;
+  Data.StreamSequence = static_cast<uint64_t>(Tick);
+  if (Fields & Serializer::FIELD_CAMERA) {
+    Data.CameraLocation = Vector3D{t, 2.f * t, 120.f};
+    Data.CameraRotation = Vector3D{0.f, t, 0.f};
+  }
+  if (Fields & Serializer::FIELD_GAZE) {
+    Data.GazeDir = Vector3D{0.98f, 0.1f, -0.05f};
+    Data.GazeOrigin = Vector3D{0.f, 0.f, 0.f};
+    Data.GazeValid = true;
+    Data.GazeVergence = 250.f;
+  }
+  if (Fields & Serializer::FIELD_EYES) {
+    Data.LGazeDir = Data.RGazeDir = Vector3D{0.98f, 0.1f, -0.05f};
+    Data.LGazeOrigin = Vector3D{0.f, -3.f, 0.f};
+    Data.RGazeOrigin = Vector3D{0.f, 3.f, 0.f};
+    Data.LGazeValid = Data.RGazeValid = true;
+    Data.LEyeOpenness = Data.REyeOpenness = 0.9f;
+    Data.LEyeOpenValid = Data.REyeOpenValid = true;
+  }
+  if (Fields & Serializer::FIELD_PUPILS) {
+    Data.LPupilPos = Data.RPupilPos = Vector2D{0.25f, -0.5f};
+    Data.LPupilPosValid = Data.RPupilPosValid = true;
+    Data.LPupilDiameter = Data.RPupilDiameter = 3.5f;
+  }
+  if (Fields & Serializer::FIELD_FOCUS) {
+    Data.FocusActorName = "Vehicle_TeslaM3_C_" + std::to_string(Tick % 8);
+    Data.FocusActorPoint = Vector3D{t, 0.f, 100.f};
+    Data.FocusActorDist = 1500.f;
+  }
+  if (Fields & Serializer::FIELD_INPUTS) {
+    Data.Throttle = 0.5f;
+    Data.Steering = -0.1f;
+    Data.Brake = 0.f;
+  }
+  if (Fields & Serializer::FIELD_EYE_SAMPLES) {
+    Data.EyeSamples.resize(NumEyeSamples);
+    for (size_t i = 0; i < NumEyeSamples; i++) {
+      Data.EyeSamples[i].TimestampDevice = Data.TimestampDevice + 8 * static_cast<int64_t>(i);
+      Data.EyeSamples[i].GazeDir = Vector3D{0.98f, 0.1f, -0.05f};
+    }
+  }
+  if (Fields & Serializer::FIELD_FIXATIONS) {
+    Data.Fixating = true;
+    Data.FixationStart = Data.TimestampDevice - 8333 * (Tick % 30);
+    Data.FixationEnd = Data.TimestampDevice;
+    Data.FixationActorName = "Vehicle_TeslaM3_C_" + std::to_string(Tick % 8);
+    if (Tick % 30 == 0) {
+      Data.FixationEvents.push_back({true, Data.FixationStart, Data.FixationEnd, 5.8f, -2.9f, Data.FixationActorName});
+    }
+  }
+  if (Fields & Serializer::FIELD_DWELL) {
+    Data.DwellActorId = 24u + static_cast<uint32_t>(Tick % 8);
+    Data.Dwell.push_back({Data.DwellActorId, 2u, 1u, 16 * Tick, 1000, 1100, 1000 * Tick, 400});
+  }
+  if (Fields & Serializer::FIELD_GAZE_CONE) {
+    Data.GazeCone.push_back({24u, 1.5f, 0.f, 1800.f});
+    Data.GazeCone.push_back({31u, 4.2f, 2.9f, 5200.f});
+  }
+  return Data;
+}
+
+TEST(dreyevr_serializer, parse_fields) {
+  uint32_t Fields = 0u;
+  ASSERT_TRUE(Serializer::ParseFields("all", Fields));
+  ASSERT_EQ(Fields, static_cast<uint32_t>(Serializer::FIELDS_ALL));
+  ASSERT_TRUE(Serializer::ParseFields("Gaze, focus", Fields));
+  ASSERT_EQ(Fields, static_cast<uint32_t>(Serializer::FIELD_GAZE | Serializer::FIELD_FOCUS));
+  ASSERT_TRUE(Serializer::ParseFields("none", Fields));
+  ASSERT_EQ(Fields, 0u);
+  ASSERT_TRUE(Serializer::ParseFields("3|eye_samples", Fields));
+  ASSERT_EQ(Fields, static_cast<uint32_t>(Serializer::FIELD_CAMERA | Serializer::FIELD_GAZE |
+                                          Serializer::FIELD_EYE_SAMPLES));
+  Fields = 42u;
+  ASSERT_FALSE(Serializer::ParseFields("gaze,bogus", Fields));
+  ASSERT_EQ(Fields, 42u); // (untouched)
+}
+
+TEST(dreyevr_serializer, fields_round_trip) {
+  const int Sensor = 0;
+  const uint32_t Fields = Serializer::FIELD_GAZE | Serializer::FIELD_EYE_SAMPLES | Serializer::FIELD_FIXATIONS |
+                          Serializer::FIELD_DWELL | Serializer::FIELD_GAZE_CONE;
+  // MsgPack
+  {
+    carla::Buffer Buf = Serializer::Serialize(Sensor, MakeData(Fields, 30, 2));
+    auto Got = carla::MsgPack::UnPack<Serializer::Data>(Buf.data(), Buf.size());
+    ASSERT_TRUE(Got.Fixating);
+    ASSERT_EQ(Got.FixationActorName, "Vehicle_TeslaM3_C_6");
+    ASSERT_EQ(Got.FixationEvents.size(), 1u);
+    ASSERT_TRUE(Got.FixationEvents[0].IsStart);
+    ASSERT_EQ(Got.FixationEvents[0].End, Got.FixationEnd);
+    ASSERT_EQ(Got.DwellActorId, 30u);
+    ASSERT_EQ(Got.Dwell.size(), 1u);
+    ASSERT_EQ(Got.Dwell[0].TotalDwell, 480);
+    ASSERT_EQ(Got.Dwell[0].FirstFixation, 1100);
+    ASSERT_EQ(Got.GazeCone.size(), 2u);
+    ASSERT_EQ(Got.GazeCone[1].ActorId, 31u);
+    ASSERT_EQ(Got.GazeCone[1].EdgeAngle, 2.9f);
+  }
+  {
+    carla::Buffer Buf = Serializer::Serialize(Sensor, MakeData(Fields, 7, 2));
+    auto Got = carla::MsgPack::UnPack<Serializer::Data>(Buf.data(), Buf.size());
+    ASSERT_EQ(Got.Fields, Fields);
+    ASSERT_EQ(Got.FrameSequence, 7);
+    ASSERT_EQ(Got.StreamSequence, 7u);
+    ASSERT_TRUE(Got.GazeValid);
+    ASSERT_TRUE(Got.FocusActorName.empty());
+    ASSERT_EQ(Got.EyeSamples.size(), 2u);
+  }
+  // fixed-layout records
+  {
+    Serializer::Data Data = MakeData(Fields, 7, 2);
+    carla::Buffer Buf = Serializer::Serialize(Sensor, Serializer::ToRecord(Data), Data.EyeSamples, "");
+    ASSERT_EQ(Buf.size(), sizeof(Serializer::Record) + 2u * sizeof(Serializer::EyeSample));
+    Serializer::Record Got;
+    std::memcpy(&Got, Buf.data(), sizeof(Got));
+    ASSERT_EQ(Got.Fields, Fields);
+    ASSERT_EQ(Got.StreamSequence, 7u);
+    ASSERT_EQ(Got.NumEyeSamples, 2u);
+    ASSERT_EQ(Got.FocusNameLength, 0u);
+    ASSERT_EQ(Got.Fixating, 1u);
+    ASSERT_EQ(Got.FixationEnd, Data.TimestampDevice);
+    ASSERT_EQ(Got.NumFixationEvents, 0u);
+  }
+}
+
+// two sensors (or servers) intern their actor names independently, the same id keeps its name in each stream
+TEST(dreyevr_serializer, focus_actor_names_per_stream) {
+  const uint64_t StreamA = 0x1111222233334444u, StreamB = 0x5555666677778888u;
+  Serializer::SetFocusActorName(StreamA, 1u, "Vehicle_TeslaM3_C_0");
+  Serializer::SetFocusActorName(StreamB, 1u, "Walker_C_3");
+  ASSERT_EQ(Serializer::GetFocusActorName(StreamA, 1u), "Vehicle_TeslaM3_C_0");
+  ASSERT_EQ(Serializer::GetFocusActorName(StreamB, 1u), "Walker_C_3");
+  ASSERT_TRUE(Serializer::GetFocusActorName(StreamA, 2u).empty());
+  ASSERT_TRUE(Serializer::GetFocusActorName(0u, 1u).empty()); // (older writers, no names sent yet)
+
+  Serializer::Record Record = Serializer::ToRecord(MakeData(Serializer::FIELD_FOCUS, 1, 0));
+  Record.StreamId = StreamB;
+  carla::Buffer Buf = Serializer::Serialize(0, Record, {}, "");
+  Serializer::Record Got;
+  std::memcpy(&Got, Buf.data(), sizeof(Got));
+  ASSERT_EQ(Got.Version, DREYEVR_STREAM_VERSION);
+  ASSERT_EQ(Got.StreamId, StreamB);
+}
+
+// per-tick cost on the server (building the data and serializing it) of the full and a minimal (combined gaze)
+// mask, as a reference when choosing the sensor's "fields". Like the other benchmark* tests, it only runs with
+// `make benchmark`, not with the unit tests
+TEST(benchmark_dreyevr_serializer, fields) {
+  constexpr int64_t NumTicks = 20000;
+  constexpr size_t NumEyeSamples = 2u; // ex. 120hz eye tracker, 60hz game
+  const int Sensor = 0;
+  struct Case {
+    const char *Name;
+    uint32_t Fields;
+  };
+  const Case Cases[] = {{"all", Serializer::FIELDS_ALL}, {"gaze", Serializer::FIELD_GAZE}};
+
+  for (const Case &C : Cases) {
+    for (const bool bBinary : {false, true}) {
+      size_t Bytes = 0u;
+      const auto Begin = std::chrono::steady_clock::now();
+      for (int64_t Tick = 0; Tick < NumTicks; Tick++) {
+        Serializer::Data Data = MakeData(C.Fields, Tick, NumEyeSamples);
+        if (bBinary) {
+          Bytes += Serializer::Serialize(Sensor, Serializer::ToRecord(Data), Data.EyeSamples,
+                                         Data.FocusActorName).size();
+        } else {
+          Bytes += Serializer::Serialize(Sensor, std::move(Data)).size();
+        }
+      }
+      const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Begin).count();
+      std::cout << "DReyeVR fields \"" << C.Name << "\" (" << (bBinary ? "binary" : "msgpack") << "): "
+                << 1e6 * Seconds / NumTicks << " us/tick, " << Bytes / NumTicks << " bytes/tick" << std::endl;
+      ASSERT_GT(Bytes, 0u);
+    }
+  }
+}
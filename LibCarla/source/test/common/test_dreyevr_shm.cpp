@@ -0,0 +1,143 @@
+#include "test.h"
+
+#include <carla/sensor/s11n/DReyeVRSharedMemory.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Serializer = carla::sensor::s11n::DReyeVRSerializer;
+using carla::sensor::s11n::DReyeVRSharedMemoryReader;
+using carla::sensor::s11n::DReyeVRSharedMemoryWriter;
+
+// every field of record i is derived from i, so a torn read (half of two records) is detected
+static Serializer::Record MakeRecord(uint64_t i) {
+  Serializer::Record Record{};
+  const float f = static_cast<float>(i % 100000);
+  Record.TimestampCarla = static_cast<int64_t>(i);
+  Record.TimestampDevice = 3 * static_cast<int64_t>(i);
+  Record.FrameSequence = static_cast<int64_t>(i);
+  Record.CameraLocation = carla::geom::Vector3D{f, f, f};
+  Record.GazeDir = carla::geom::Vector3D{f, -f, 2.f * f};
+  Record.Throttle = f;
+  return Record;
+}
+
+static std::vector<Serializer::EyeSample> MakeSamples(uint64_t i) {
+  std::vector<Serializer::EyeSample> Samples(i % 4);
+  for (size_t s = 0; s < Samples.size(); s++) {
+    Samples[s] = Serializer::EyeSample{};
+    Samples[s].FrameSequence = static_cast<int64_t>(i);
+    Samples[s].TimestampDevice = 3 * static_cast<int64_t>(i) + static_cast<int64_t>(s);
+  }
+  return Samples;
+}
+
+static std::string MakeName(uint64_t i) {
+  return "actor_" + std::to_string(i);
+}
+
+static bool IsConsistent(const DReyeVRSharedMemoryReader::Sample &Got) {
+  const uint64_t i = static_cast<uint64_t>(Got.Record.FrameSequence);
+  const Serializer::Record Want = MakeRecord(i);
+  if (Got.Record.TimestampCarla != Want.TimestampCarla || Got.Record.TimestampDevice != Want.TimestampDevice ||
+      Got.Record.CameraLocation.x != Want.CameraLocation.x || Got.Record.GazeDir.z != Want.GazeDir.z ||
+      Got.Record.Throttle != Want.Throttle || Got.FocusActorName != MakeName(i) ||
+      Got.EyeSamples.size() != i % 4) {
+    return false;
+  }
+  for (size_t s = 0; s < Got.EyeSamples.size(); s++) {
+    if (Got.EyeSamples[s].TimestampDevice != 3 * static_cast<int64_t>(i) + static_cast<int64_t>(s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(dreyevr_shm, in_order) {
+  const std::string Name = "dreyevr_test_in_order_" + std::to_string(TESTING_PORT);
+  DReyeVRSharedMemoryWriter Writer(Name, 8u);
+  DReyeVRSharedMemoryReader Reader(Name);
+  DReyeVRSharedMemoryReader::Sample Got;
+  ASSERT_FALSE(Reader.Next(Got));
+
+  for (uint64_t i = 0u; i < 5u; i++) {
+    Writer.Publish(MakeRecord(i), MakeSamples(i), MakeName(i));
+  }
+  for (uint64_t i = 0u; i < 5u; i++) {
+    ASSERT_TRUE(Reader.Next(Got));
+    ASSERT_EQ(static_cast<uint64_t>(Got.Record.FrameSequence), i);
+    ASSERT_TRUE(IsConsistent(Got));
+  }
+  ASSERT_FALSE(Reader.Next(Got));
+  ASSERT_EQ(Reader.GetNumLost(), 0u);
+
+  // the writer laps the reader: only the last 8 are left
+  for (uint64_t i = 5u; i < 25u; i++) {
+    Writer.Publish(MakeRecord(i), MakeSamples(i), MakeName(i));
+  }
+  ASSERT_TRUE(Reader.Next(Got));
+  ASSERT_EQ(Got.Record.FrameSequence, 17);
+  ASSERT_EQ(Reader.GetNumLost(), 12u);
+  ASSERT_TRUE(Reader.Latest(Got));
+  ASSERT_EQ(Got.Record.FrameSequence, 24);
+  ASSERT_FALSE(Reader.Latest(Got));
+}
+
+TEST(dreyevr_shm, concurrent_readers) {
+  const std::string Name = "dreyevr_test_concurrent_" + std::to_string(TESTING_PORT);
+  constexpr uint64_t NumRecords = 200000u;
+  constexpr size_t NumReaders = 4u;
+  DReyeVRSharedMemoryWriter Writer(Name, 16u); // small, so the readers are lapped often
+
+  std::atomic_bool bDone{false};
+  std::atomic_size_t NumReady{0u};
+  std::vector<uint64_t> NumRead(NumReaders, 0u), NumLost(NumReaders, 0u), NumTorn(NumReaders, 0u);
+  std::vector<uint64_t> NumOutOfOrder(NumReaders, 0u);
+  std::vector<std::thread> Readers;
+  for (size_t r = 0u; r < NumReaders; r++) {
+    Readers.emplace_back([&, r]() {
+      DReyeVRSharedMemoryReader Reader(Name);
+      NumReady++;
+      DReyeVRSharedMemoryReader::Sample Got;
+      int64_t Last = -1;
+      auto Poll = [&]() {
+        while (Reader.Next(Got)) {
+          NumRead[r]++;
+          NumTorn[r] += IsConsistent(Got) ? 0u : 1u;
+          NumOutOfOrder[r] += (Got.Record.FrameSequence > Last) ? 0u : 1u;
+          Last = Got.Record.FrameSequence;
+          // readers slower than the writer
+          for (volatile int Spin = 0; Spin < 200 * static_cast<int>(r + 1); Spin++) {
+          }
+        }
+      };
+      while (!bDone) {
+        Poll();
+      }
+      Poll();
+      NumLost[r] = Reader.GetNumLost();
+    });
+  }
+  while (NumReady < NumReaders) {
+    std::this_thread::yield();
+  }
+
+  for (uint64_t i = 0u; i < NumRecords; i++) {
+    Writer.Publish(MakeRecord(i), MakeSamples(i), MakeName(i));
+  }
+  bDone = true;
+  for (std::thread &Reader : Readers) {
+    Reader.join();
+  }
+
+  ASSERT_EQ(Writer.GetNumPublished(), NumRecords);
+  for (size_t r = 0u; r < NumReaders; r++) {
+    ASSERT_EQ(NumTorn[r], 0u) << "reader " << r;
+    ASSERT_EQ(NumOutOfOrder[r], 0u) << "reader " << r;
+    ASSERT_GT(NumRead[r], 0u) << "reader " << r;
+    // every record was either read or reported lost
+    ASSERT_EQ(NumRead[r] + NumLost[r], NumRecords) << "reader " << r;
+  }
+}
@@ -32,6 +32,7 @@
 #include <vector>
 #include <algorithm>
 #include <thread>
+#include <stdexcept>
 
 namespace carla {
 namespace sensor {
@@ -207,6 +208,89 @@ static auto GetRawDataAsBuffer(T &self) {
   return boost::python::object(boost::python::handle<>(ptr));
 }
 
+// fixed-layout record of a DReyeVR event, ex. np.frombuffer(event.raw_data, dtype=DREYEVR_STREAM_DTYPE)
+static auto GetDReyeVRRecordAsBuffer(const carla::sensor::data::DReyeVREvent &self) {
+  const auto &record = self.GetRecord();
+  auto *data = reinterpret_cast<const unsigned char *>(&record);
+  auto size = static_cast<Py_ssize_t>(sizeof(record));
+#if PY_MAJOR_VERSION >= 3
+  auto *ptr = PyMemoryView_FromMemory(reinterpret_cast<char *>(const_cast<unsigned char *>(data)), size, PyBUF_READ);
+#else
+  auto *ptr = PyBuffer_FromMemory(const_cast<unsigned char *>(data), size);
+#endif
+  return boost::python::object(boost::python::handle<>(ptr));
+}
+
+// ex. event.has_fields("gaze,focus"), see DReyeVRSerializer::ParseFields for the names
+static bool DReyeVREventHasFields(const carla::sensor::data::DReyeVREvent &self, const std::string &fields) {
+  uint32_t mask = 0u;
+  if (!carla::sensor::s11n::DReyeVRSerializer::ParseFields(fields, mask)) {
+    throw std::invalid_argument("unknown DReyeVR field group in \"" + fields + "\"");
+  }
+  return self.HasFields(mask);
+}
+
+// eye-tracker samples of a DReyeVR event, ex. np.frombuffer(event.eye_samples, dtype=DREYEVR_EYE_SAMPLE_DTYPE)
+static auto GetDReyeVREyeSamplesAsBuffer(const carla::sensor::data::DReyeVREvent &self) {
+  const auto &samples = self.GetEyeSamples();
+  auto *data = reinterpret_cast<const unsigned char *>(samples.data());
+  auto size = static_cast<Py_ssize_t>(sizeof(samples[0]) * samples.size());
+#if PY_MAJOR_VERSION >= 3
+  auto *ptr = PyMemoryView_FromMemory(reinterpret_cast<char *>(const_cast<unsigned char *>(data)), size, PyBUF_READ);
+#else
+  auto *ptr = PyBuffer_FromMemory(const_cast<unsigned char *>(data), size);
+#endif
+  return boost::python::object(boost::python::handle<>(ptr));
+}
+
+// fixations that started or ended since the previous DReyeVR event, as a list of dicts
+static boost::python::list GetDReyeVRFixationEvents(const carla::sensor::data::DReyeVREvent &self) {
+  boost::python::list result;
+  for (const auto &event : self.GetFixationEvents()) {
+    boost::python::dict fixation;
+    fixation["is_start"] = event.IsStart;
+    fixation["start"] = event.Start;
+    fixation["end"] = event.End;
+    fixation["yaw"] = event.Yaw;
+    fixation["pitch"] = event.Pitch;
+    fixation["actor_name"] = event.ActorName;
+    result.append(fixation);
+  }
+  return result;
+}
+
+// dwell statistics of the actors that changed since the previous DReyeVR event (or all), as a list of dicts
+static boost::python::list GetDReyeVRDwell(const carla::sensor::data::DReyeVREvent &self) {
+  boost::python::list result;
+  for (const auto &stats : self.GetDwell()) {
+    boost::python::dict dwell;
+    dwell["actor_id"] = stats.ActorId;
+    dwell["num_glances"] = stats.NumGlances;
+    dwell["num_fixations"] = stats.NumFixations;
+    dwell["total_dwell"] = stats.TotalDwell;
+    dwell["first_glance"] = stats.FirstGlance;
+    dwell["first_fixation"] = stats.FirstFixation;
+    dwell["last_glance"] = stats.LastGlance;
+    dwell["longest_glance"] = stats.LongestGlance;
+    result.append(dwell);
+  }
+  return result;
+}
+
+// actors around the gaze ray of a DReyeVR event (the closest to it first), as a list of dicts
+static boost::python::list GetDReyeVRGazeCone(const carla::sensor::data::DReyeVREvent &self) {
+  boost::python::list result;
+  for (const auto &hit : self.GetGazeCone()) {
+    boost::python::dict cone;
+    cone["actor_id"] = hit.ActorId;
+    cone["angle"] = hit.Angle;
+    cone["edge_angle"] = hit.EdgeAngle;
+    cone["distance"] = hit.Distance;
+    result.append(cone);
+  }
+  return result;
+}
+
 template <typename T>
 static void ConvertImage(T &self, EColorConverter cc) {
   carla::PythonUtil::ReleaseGIL unlock;
@@ -606,6 +690,7 @@ void export_sensor_data() {
       .add_property("right_pupil_diam", CALL_RETURNING_COPY(csd::DReyeVREvent, GetRPupilDiam))
       // focus info attributes
       .add_property("focus_actor_name", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFocusActorName))
+      .add_property("focus_actor_id", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFocusActorId))
       .add_property("focus_actor_pt", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFocusActorPoint))
       .add_property("focus_actor_dist", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFocusActorDist))
       // user inputs attributes
@@ -614,6 +699,25 @@ void export_sensor_data() {
       .add_property("brake_input", CALL_RETURNING_COPY(csd::DReyeVREvent, GetBrake))
       .add_property("current_gear_input", CALL_RETURNING_COPY(csd::DReyeVREvent, GetToggledReverse))
       .add_property("handbrake_input", CALL_RETURNING_COPY(csd::DReyeVREvent, GetHandbrake))
+      // fixation classification attributes
+      .add_property("fixating", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFixating))
+      .add_property("fixation_start", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFixationStart))
+      .add_property("fixation_end", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFixationEnd))
+      .add_property("fixation_actor_name", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFixationActorName))
+      .add_property("fixation_events", &GetDReyeVRFixationEvents)
+      // per-actor gaze dwell attributes
+      .add_property("dwell_actor_id", CALL_RETURNING_COPY(csd::DReyeVREvent, GetDwellActorId))
+      .add_property("dwell", &GetDReyeVRDwell)
+      .add_property("dwell_complete", CALL_RETURNING_COPY(csd::DReyeVREvent, IsDwellComplete))
+      .add_property("gaze_cone", &GetDReyeVRGazeCone)
+      // every attribute above in one buffer (no per-field copies), see DREYEVR_STREAM_DTYPE in DReyeVR_utils.py
+      .add_property("raw_data", &GetDReyeVRRecordAsBuffer)
+      .add_property("eye_samples", &GetDReyeVREyeSamplesAsBuffer)
+      // groups of fields the server filled (the sensor's `fields` attribute), the others are zero
+      .add_property("fields", CALL_RETURNING_COPY(csd::DReyeVREvent, GetFields))
+      .add_property("stream_sequence", CALL_RETURNING_COPY(csd::DReyeVREvent, GetStreamSequence))
+      .add_property("stream_id", CALL_RETURNING_COPY(csd::DReyeVREvent, GetStreamId))
+      .def("has_fields", &DReyeVREventHasFields, (arg("fields")))
       .def(self_ns::str(self_ns::self))
   ;
 }
@@ -3,7 +3,7 @@ import numpy as np
 import time
 import sys
 import os
-from DReyeVR_utils import DReyeVRSensor
+from DReyeVR_utils import DReyeVRDelivery, DReyeVRListener, DReyeVRSensor
 
 try:
     import rospy
@@ -78,6 +78,18 @@ def main():
         default="192.168.86.123",
         help="IP of the ROS node (this machine) (default: 192.168.86.123)",
     )
+    argparser.add_argument(
+        "--policy",
+        default="drop_oldest",
+        choices=DReyeVRListener.POLICIES,
+        help="what to do with the events that arrive while publishing (default: drop_oldest)",
+    )
+    argparser.add_argument(
+        "--max-hz",
+        default=None,
+        type=float,
+        help="maximum rate at which events are published (default: every event)",
+    )
 
     args = argparser.parse_args()
 
@@ -98,7 +110,9 @@ def main():
     world = client.get_world()
     sensor = DReyeVRSensor(world)
 
-    def publish_and_print(data):
+    def publish_and_print(data, delivery: DReyeVRDelivery):
+        if delivery.coalesced + delivery.dropped + delivery.missed > 0:
+            print(f"[WARN] before frame {data.frame}: {delivery}")
         sensor.update(data)
         if rospy is not None:
             msg: String = create_ros_msg(sensor)
@@ -107,7 +121,7 @@ def main():
         # print(data) # this print is defined in LibCarla/source/carla/data/DReyeVREvent.h
 
     # subscribe to DReyeVR sensor
-    sensor.ego_sensor.listen(publish_and_print)
+    listener = DReyeVRListener(sensor.ego_sensor, publish_and_print, policy=args.policy, max_hz=args.max_hz)
     try:
         while True:
             if sync_mode:
@@ -115,6 +129,8 @@ def main():
             else:
                 world.wait_for_tick()
     finally:
+        listener.stop()
+        print(f"DReyeVR events: {listener.totals}")
         if sync_mode:
             settings = world.get_settings()
             settings.synchronous_mode = False
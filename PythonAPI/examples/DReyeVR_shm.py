@@ -0,0 +1,150 @@
+import argparse
+import mmap
+import os
+import sys
+import time
+from typing import Optional
+
+import numpy as np
+
+from DReyeVR_utils import DREYEVR_EYE_SAMPLE_DTYPE, DREYEVR_STREAM_DTYPE
+
+# Reads the DReyeVR sensor records that the server publishes to shared memory ([EgoSensor] SharedMemory=True), for
+# loggers and dashboards on the same machine: polling is a few memory reads, no socket or syscall per record.
+# Layout and protocol in LibCarla/source/carla/sensor/s11n/DReyeVRSharedMemory.h, keep both in sync
+
+DREYEVR_SHM_MAGIC: int = 0x4D565244
+DREYEVR_SHM_VERSION: int = 2
+DREYEVR_SHM_NAME_SIZE: int = 64
+DREYEVR_SHM_MAX_EYE_SAMPLES: int = 16
+
+DREYEVR_SHM_HEADER_DTYPE = np.dtype(
+    [
+        ("magic", np.uint32),
+        ("version", np.uint16),
+        ("header_size", np.uint16),
+        ("slot_size", np.uint32),
+        ("num_slots", np.uint32),
+        ("max_eye_samples", np.uint32),
+        ("reserved", np.uint32),
+        ("num_published", np.uint64),
+        ("reserved2", np.uint64, (4,)),
+    ]
+)
+assert DREYEVR_SHM_HEADER_DTYPE.itemsize == 64
+
+DREYEVR_SHM_SLOT_DTYPE = np.dtype(
+    [
+        ("sequence", np.uint64),  # 2i+1 while record i is written, 2i+2 once it is complete
+        ("reserved", np.uint64),
+        ("record", DREYEVR_STREAM_DTYPE),
+        ("focus_actor_name", f"S{DREYEVR_SHM_NAME_SIZE}"),
+        ("eye_samples", DREYEVR_EYE_SAMPLE_DTYPE, (DREYEVR_SHM_MAX_EYE_SAMPLES,)),
+    ]
+)
+
+
+class DReyeVRSharedMemoryReader:
+    def __init__(self, name: str = "DReyeVR"):
+        self.mm: mmap.mmap = self._open(name)
+        header = np.frombuffer(self.mm, dtype=DREYEVR_SHM_HEADER_DTYPE, count=1)
+        if (
+            header["magic"][0] != DREYEVR_SHM_MAGIC
+            or header["version"][0] != DREYEVR_SHM_VERSION
+            or header["slot_size"][0] != DREYEVR_SHM_SLOT_DTYPE.itemsize
+        ):
+            raise RuntimeError(f'"{name}" is not a DReyeVR shared memory ring of this version')
+        self.num_slots: int = int(header["num_slots"][0])
+        if sys.platform == "win32":  # (the size of a named mapping is only known once the header is read)
+            self.mm.close()
+            size = DREYEVR_SHM_HEADER_DTYPE.itemsize + self.num_slots * DREYEVR_SHM_SLOT_DTYPE.itemsize
+            self.mm = self._open(name, size)
+        # views of the shared memory (every access reads the current values)
+        num_published_offset: int = DREYEVR_SHM_HEADER_DTYPE.fields["num_published"][1]
+        self.num_published = np.frombuffer(self.mm, dtype=np.uint64, count=1, offset=num_published_offset)
+        self.slots = np.frombuffer(
+            self.mm, dtype=DREYEVR_SHM_SLOT_DTYPE, count=self.num_slots, offset=DREYEVR_SHM_HEADER_DTYPE.itemsize
+        )
+        self.sequences = self.slots["sequence"]
+        self.next_index: int = int(self.num_published[0])  # only what is published from now on
+        self.num_lost: int = 0
+
+    @staticmethod
+    def _open(name: str, size: int = DREYEVR_SHM_HEADER_DTYPE.itemsize) -> mmap.mmap:
+        if sys.platform == "win32":
+            # boost::interprocess::windows_shared_memory is a named file mapping
+            return mmap.mmap(-1, size, tagname=name, access=mmap.ACCESS_READ)
+        # boost::interprocess::shared_memory_object is a POSIX shared memory object
+        with open(os.path.join("/dev/shm", name), "rb") as f:
+            return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    def _read(self, index: int) -> Optional[np.void]:
+        # seqlock: copy the slot and check that it was not being (re)written in the meantime
+        k = index % self.num_slots
+        expected = 2 * index + 2
+        if int(self.sequences[k]) != expected:
+            return None
+        slot = self.slots[k].copy()
+        if int(self.sequences[k]) != expected:
+            return None
+        return slot
+
+    def next(self) -> Optional[np.void]:
+        # the oldest slot not read yet (None if there is none), records overwritten before they were read are
+        # skipped and counted in num_lost. slot["record"] is a DREYEVR_STREAM_DTYPE record, the eye samples are
+        # slot["eye_samples"][:slot["record"]["num_eye_samples"]]
+        while True:
+            num_published = int(self.num_published[0])
+            if self.next_index >= num_published:
+                return None
+            if num_published - self.next_index > self.num_slots:  # overwritten already
+                self.num_lost += num_published - self.num_slots - self.next_index
+                self.next_index = num_published - self.num_slots
+            slot = self._read(self.next_index)
+            self.next_index += 1
+            if slot is not None:
+                return slot
+            self.num_lost += 1  # overwritten while reading it
+
+    def latest(self) -> Optional[np.void]:
+        # the most recent slot (skipping the ones in between), None if nothing new was published
+        num_published = int(self.num_published[0])
+        if self.next_index >= num_published:
+            return None
+        self.next_index = num_published - 1
+        return self.next()
+
+
+def focus_actor_name(slot: np.void) -> str:
+    length = int(slot["record"]["focus_name_length"])
+    return bytes(slot["focus_actor_name"])[:length].decode("utf-8", errors="replace")
+
+
+def main():
+    argparser = argparse.ArgumentParser(description="Print the DReyeVR records published to shared memory")
+    argparser.add_argument("-n", "--name", type=str, default="DReyeVR", help="[EgoSensor] SharedMemoryName")
+    argparser.add_argument("--poll", type=float, default=0.001, help="seconds between two polls (default 0.001)")
+    args = argparser.parse_args()
+
+    reader = DReyeVRSharedMemoryReader(args.name)
+    print(f'reading "{args.name}" ({reader.num_slots} slots)')
+    num_read, last_print = 0, time.time()
+    slot = None
+    while True:
+        got = reader.next()
+        if got is None:
+            time.sleep(args.poll)
+        else:
+            slot, num_read = got, num_read + 1
+        now = time.time()
+        if now - last_print >= 1.0 and slot is not None:
+            record = slot["record"]
+            print(
+                f"{num_read / (now - last_print):.1f} records/s (lost {reader.num_lost}), "
+                f"frame {record['framesequence']}, gaze {record['gaze_dir']}, focus {focus_actor_name(slot)!r}"
+            )
+            num_read, last_print = 0, now
+
+
+if __name__ == "__main__":
+    main()
@@ -1,6 +1,8 @@
-from typing import Optional, Any, Dict, List
+from typing import Optional, Any, Callable, Deque, Dict, List, NamedTuple
+from collections import deque
 import carla
 import numpy as np
+import threading
 import time
 
 import sys, os
@@ -72,10 +74,204 @@ def find_ego_sensor(world: carla.libcarla.World) -> Optional[carla.libcarla.Sens
     return ego_sensors[0]  # always return the first one?
 
 
+# fixed-layout record of every DReyeVR event (event.raw_data), see DReyeVRSerializer::Record in LibCarla
+# the server streams records instead of MsgPack with [EgoSensor] BinaryStream=True, but raw_data works either way
+DREYEVR_STREAM_VERSION: int = 6
+_vec3 = (np.float32, (3,))
+_vec2 = (np.float32, (2,))
+DREYEVR_STREAM_DTYPE = np.dtype(
+    [
+        ("magic", np.uint32),
+        ("version", np.uint16),
+        ("size", np.uint16),
+        ("timestamp_carla", np.int64),
+        ("timestamp_device", np.int64),
+        ("framesequence", np.int64),
+        ("camera_location", _vec3),
+        ("camera_rotation", _vec3),
+        ("gaze_dir", _vec3),
+        ("gaze_origin", _vec3),
+        ("gaze_vergence", np.float32),
+        ("left_gaze_dir", _vec3),
+        ("left_gaze_origin", _vec3),
+        ("left_eye_openness", np.float32),
+        ("left_pupil_posn", _vec2),
+        ("left_pupil_diam", np.float32),
+        ("right_gaze_dir", _vec3),
+        ("right_gaze_origin", _vec3),
+        ("right_eye_openness", np.float32),
+        ("right_pupil_posn", _vec2),
+        ("right_pupil_diam", np.float32),
+        ("focus_actor_pt", _vec3),
+        ("focus_actor_dist", np.float32),
+        ("throttle_input", np.float32),
+        ("steering_input", np.float32),
+        ("brake_input", np.float32),
+        ("focus_actor_id", np.uint32),
+        ("gaze_valid", np.uint8),
+        ("left_gaze_valid", np.uint8),
+        ("left_eye_openness_valid", np.uint8),
+        ("left_pupil_posn_valid", np.uint8),
+        ("right_gaze_valid", np.uint8),
+        ("right_eye_openness_valid", np.uint8),
+        ("right_pupil_posn_valid", np.uint8),
+        ("current_gear_input", np.uint8),
+        ("handbrake_input", np.uint8),
+        ("reserved", np.uint8),
+        ("focus_name_length", np.uint16),
+        ("num_eye_samples", np.uint16),
+        ("eye_sample_size", np.uint16),
+        ("fields", np.uint32),  # groups of fields the server filled, see data.has_fields("gaze,focus")
+        ("stream_sequence", np.uint64),  # events sent before this one (a gap means some were missed)
+        ("fixation_start", np.int64),  # timestamp_device of the first reading of the ongoing (or last) fixation
+        ("fixation_end", np.int64),  # and of its last one
+        ("fixation_actor_id", np.uint32),  # interned like focus_actor_id
+        ("fixating", np.uint8),
+        ("num_fixation_events", np.uint8),  # fixations that started or ended since the previous event
+        ("reserved2", np.uint16),
+        ("stream_id", np.uint64),  # random id of the sensor, focus_actor_id and fixation_actor_id are its own
+    ]
+)
+assert DREYEVR_STREAM_DTYPE.itemsize == 256
+
+# every eye-tracker reading since the previous event (event.eye_samples), see DReyeVRSerializer::EyeSample
+DREYEVR_EYE_SAMPLE_DTYPE = np.dtype(
+    [
+        ("timestamp_device", np.int64),
+        ("framesequence", np.int64),
+        ("gaze_dir", _vec3),
+        ("gaze_origin", _vec3),
+        ("gaze_vergence", np.float32),
+        ("left_gaze_dir", _vec3),
+        ("left_gaze_origin", _vec3),
+        ("left_eye_openness", np.float32),
+        ("left_pupil_posn", _vec2),
+        ("left_pupil_diam", np.float32),
+        ("right_gaze_dir", _vec3),
+        ("right_gaze_origin", _vec3),
+        ("right_eye_openness", np.float32),
+        ("right_pupil_posn", _vec2),
+        ("right_pupil_diam", np.float32),
+        ("gaze_valid", np.uint8),
+        ("left_gaze_valid", np.uint8),
+        ("left_eye_openness_valid", np.uint8),
+        ("left_pupil_posn_valid", np.uint8),
+        ("right_gaze_valid", np.uint8),
+        ("right_eye_openness_valid", np.uint8),
+        ("right_pupil_posn_valid", np.uint8),
+        ("reserved", np.uint8, (5,)),
+    ]
+)
+assert DREYEVR_EYE_SAMPLE_DTYPE.itemsize == 136
+
+
+def dreyevr_record(data) -> np.ndarray:
+    # all the fields of a DReyeVR event as a (1,) structured array, without a copy (only valid inside the callback,
+    # use .copy() to keep it). Names are not part of the record, see data.focus_actor_name/focus_actor_id
+    record = np.frombuffer(data.raw_data, dtype=DREYEVR_STREAM_DTYPE)
+    # (newer versions only append fields)
+    assert record["version"][0] >= DREYEVR_STREAM_VERSION, "LibCarla is older than DReyeVR_utils"
+    return record
+
+
+def dreyevr_eye_samples(data) -> np.ndarray:
+    # every eye-tracker reading since the previous event, oldest first (same lifetime as dreyevr_record)
+    return np.frombuffer(data.eye_samples, dtype=DREYEVR_EYE_SAMPLE_DTYPE)
+
+
+class DReyeVRDelivery(NamedTuple):
+    # what happened to the events between the previous delivery of a DReyeVRListener and this one
+    coalesced: int  # replaced by a newer event (policy "latest")
+    dropped: int  # dropped from the full queue (policy "drop_oldest")
+    missed: int  # sent by the server but never received (gaps in data.stream_sequence)
+
+
+class DReyeVRListener:
+    # Subscribes to a DReyeVR sensor and calls callback(data, delivery) on its own thread, so a slow callback
+    # (ex. logging to ROS) neither blocks the streaming thread nor falls behind silently. Policies for the events that
+    # arrive while the callback is busy (or before the next delivery allowed by max_hz):
+    #   "queue": keep all of them (unbounded, the previous behaviour)
+    #   "latest": keep only the newest one, the others are coalesced
+    #   "drop_oldest": keep the newest queue_size ones, older ones are dropped
+    # Each delivery reports how many events were coalesced, dropped or missed since the previous one (DReyeVRDelivery)
+    POLICIES = ("queue", "latest", "drop_oldest")
+
+    def __init__(
+        self,
+        ego_sensor: carla.libcarla.Sensor,
+        callback: Callable[[Any, DReyeVRDelivery], None],
+        policy: str = "drop_oldest",
+        max_hz: Optional[float] = None,
+        queue_size: int = 64,
+    ):
+        assert policy in DReyeVRListener.POLICIES, f"unknown policy {policy}, use one of {DReyeVRListener.POLICIES}"
+        assert max_hz is None or max_hz > 0
+        self.ego_sensor = ego_sensor
+        self.callback = callback
+        self.policy: str = policy
+        self.period: float = 0.0 if max_hz is None else 1.0 / max_hz
+        self.queue_size: int = max(queue_size, 1)
+        self.cv = threading.Condition()
+        self.pending: Deque[Any] = deque()
+        self.last_sequence: Optional[int] = None
+        self.stopping: bool = False
+        # since the previous delivery, and since the start
+        self.coalesced, self.dropped, self.missed = 0, 0, 0
+        self.totals: Dict[str, int] = {"delivered": 0, "coalesced": 0, "dropped": 0, "missed": 0}
+        self.thread = threading.Thread(target=self._deliver, name="DReyeVRListener", daemon=True)
+        self.thread.start()
+        self.ego_sensor.listen(self._on_event)
+
+    def _on_event(self, data) -> None:
+        # (streaming thread) only queues the event, so the client keeps reading the stream
+        with self.cv:
+            sequence = int(data.stream_sequence)
+            if self.last_sequence is not None and sequence > self.last_sequence + 1:
+                self.missed += sequence - self.last_sequence - 1
+            self.last_sequence = sequence
+            if self.policy == "latest" and len(self.pending) > 0:
+                self.coalesced += len(self.pending)
+                self.pending.clear()
+            elif self.policy == "drop_oldest" and len(self.pending) >= self.queue_size:
+                self.pending.popleft()
+                self.dropped += 1
+            self.pending.append(data)
+            self.cv.notify()
+
+    def _deliver(self) -> None:
+        next_delivery: float = 0.0
+        while True:
+            with self.cv:
+                self.cv.wait_for(lambda: self.stopping or len(self.pending) > 0)
+                if self.stopping:
+                    return
+            wait = next_delivery - time.time()
+            if wait > 0:  # (events arriving meanwhile are coalesced or dropped)
+                time.sleep(wait)
+            with self.cv:
+                data = self.pending.popleft()
+                delivery = DReyeVRDelivery(self.coalesced, self.dropped, self.missed)
+                self.coalesced, self.dropped, self.missed = 0, 0, 0
+                self.totals["delivered"] += 1
+                self.totals["coalesced"] += delivery.coalesced
+                self.totals["dropped"] += delivery.dropped
+                self.totals["missed"] += delivery.missed
+            next_delivery = time.time() + self.period
+            self.callback(data, delivery)
+
+    def stop(self) -> None:
+        self.ego_sensor.stop()
+        with self.cv:
+            self.stopping = True
+            self.cv.notify()
+        self.thread.join()
+
+
 class DReyeVRSensor:
     def __init__(self, world: carla.libcarla.World):
         self.ego_sensor: carla.sensor.dreyevrsensor = find_ego_sensor(world)
         self.data: Dict[str, Any] = {}
+        self.dwell: Dict[int, Dict[str, int]] = {}  # per-actor gaze dwell statistics, by carla actor id
         print("initialized DReyeVRSensor PythonAPI client")
 
     def preprocess(self, obj: Any) -> Any:
@@ -95,9 +291,31 @@ class DReyeVRSensor:
         elements: List[str] = [key for key in dir(data) if "__" not in key]
         for key in elements:
             self.data[key] = self.preprocess(getattr(data, key))
+        self._update_dwell(data)
+
+    def update_record(self, data) -> None:
+        # faster alternative to update() with one copy of the whole event (self.record) instead of one per field
+        self.record: np.ndarray = dreyevr_record(data).copy()
+        self.eye_samples: np.ndarray = dreyevr_eye_samples(data).copy()
+        self.data["focus_actor_name"] = data.focus_actor_name
+        self.data["fixation_actor_name"] = data.fixation_actor_name
+        self.data["fixation_events"] = data.fixation_events  # (only in the MsgPack stream)
+        self.data["gaze_cone"] = data.gaze_cone  # (same)
+        self._update_dwell(data)
+
+    def _update_dwell(self, data) -> None:
+        # the events only carry the actors that changed (and all of them every now and then)
+        for stats in data.dwell:
+            self.dwell[stats["actor_id"]] = stats
+
+    def get_dwell(self, actor_id: Optional[int] = None) -> Any:
+        # dwell statistics of one actor (None if never looked at) or of all of them, as of the latest event
+        if actor_id is None:
+            return self.dwell
+        return self.dwell.get(actor_id)
 
     @classmethod
-    def spawn(cls, world: carla.libcarla.World):
+    def spawn(cls, world: carla.libcarla.World, fields: Optional[str] = None):
         # TODO: check if dreyevr sensor already exsists, then use it
         # spawn a DReyeVR sensor and begin listening
         if find_ego_sensor(world) is None:
@@ -107,6 +325,9 @@ class DReyeVRSensor:
             except IndexError:
                 print("no eye tracker in blueprint library?!")
                 return None
+            if fields is not None:
+                # only stream these groups, ex. "gaze,focus" (see DReyeVRSerializer::ParseFields)
+                bp.set_attribute("fields", fields)
             ego_vehicle = find_ego_vehicle()
             ego_sensor = world.spawn_actor(
                 bp, ego_vehicle.get_transform(), attach_to=ego_vehicle
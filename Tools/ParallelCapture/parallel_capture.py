@@ -0,0 +1,255 @@
+#!/usr/bin/env python
+
+import argparse
+import json
+import os
+import queue
+import re
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, List, NamedTuple, Optional, Tuple
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Recordings", "python"))
+from dreyevr_frames import FrameContainer, merge_containers  # noqa: E402
+
+# Captures the frames of one recording with several simulator instances at once (synchronous replay with
+# [Replayer] RecordFrames): the recording is split into time segments, every instance replays its segment with a
+# warm-up prefix before it (replayed but not captured, so the actors are in the right state) and quits, and the
+# frames of the segments are merged in order as if they came from one replay. Every instance gets its own settings
+# through DREYEVR_CONFIG_OVERRIDES (see ReadGeneralParams in DReyeVR/ConfigFile.h)
+
+IMAGE_NAME = re.compile(r"^(?P<name>.+)_s(?P<shader>\d+)_p(?P<pose>\d+)_(?P<frame>\d+)\.(?P<ext>png|jpg)$")
+CONTAINER_NAME = re.compile(r"^(?P<name>.+)_s(?P<shader>\d+)_p(?P<pose>\d+)\.dvrf$")
+
+
+class Segment(NamedTuple):
+    index: int
+    capture_start: float  # recording time (s) of the first captured frame
+    capture_end: float  # (excluded) 0 for the end of the recording
+    replay_start: float  # capture_start minus the warm-up
+
+
+def plan_segments(duration: float, num_segments: int, warmup: float) -> List[Segment]:
+    # equal segments that cover the recording once: every frame is captured by exactly one segment (the capture
+    # windows are [start, end) in the same recording time as the replayer's frame times)
+    num_segments = max(1, min(num_segments, int(duration)))  # (at least a second per segment)
+    bounds = [round(duration * i / num_segments, 3) for i in range(num_segments)] + [0.0]
+    return [
+        Segment(i, bounds[i], bounds[i + 1], max(bounds[i] - warmup, 0.0)) for i in range(num_segments)
+    ]
+
+
+def parse_settings(settings: List[str]) -> Dict[str, Dict[str, str]]:
+    # ["Replayer.FrameOutput=container", ...] to {"Replayer": {"FrameOutput": "container"}}
+    sections: Dict[str, Dict[str, str]] = {}
+    for setting in settings:
+        key, sep, value = setting.partition("=")
+        section, dot, variable = key.partition(".")
+        if not sep or not dot:
+            raise ValueError(f'expected Section.Variable=Value, got "{setting}"')
+        sections.setdefault(section, {})[variable] = value
+    return sections
+
+
+def write_overrides(path: str, segment: Segment, frame_dir: str, settings: Dict[str, Dict[str, str]]) -> None:
+    sections = {section: dict(variables) for section, variables in settings.items()}
+    replayer = sections.setdefault("Replayer", {})
+    replayer.update(
+        {
+            "ReplayInterpolation": "False",  # (synchronous replay)
+            "RecordFrames": "True",
+            "QuitWhenDone": "True",
+            "FrameDir": f'"{frame_dir}"',
+            "CaptureStartTime": f"{segment.capture_start:.3f}",
+            "CaptureEndTime": f"{segment.capture_end:.3f}",
+        }
+    )
+    with open(path, "w") as f:
+        f.write(f"# segment {segment.index}, written by parallel_capture.py\n")
+        for section, variables in sections.items():
+            f.write(f"[{section}]\n")
+            for variable, value in variables.items():
+                f.write(f"{variable}={value}\n")
+
+
+def launch(args: argparse.Namespace, port: int, overrides: Optional[str], log_path: str) -> subprocess.Popen:
+    env = dict(os.environ)
+    if overrides is not None:
+        env["DREYEVR_CONFIG_OVERRIDES"] = overrides
+    command = [args.carla, f"-carla-rpc-port={port}", "-nosound"] + (["-RenderOffScreen"] if args.offscreen else [])
+    with open(log_path, "w") as log:
+        return subprocess.Popen(command + args.server_args, env=env, stdout=log, stderr=subprocess.STDOUT)
+
+
+def connect(host: str, port: int, process: subprocess.Popen, timeout: float):
+    import carla  # (only needed to run the captures, not to plan or merge them)
+
+    deadline = time.time() + timeout
+    while True:
+        if process.poll() is not None:
+            raise RuntimeError(f"the simulator on port {port} exited ({process.returncode}) before it was ready")
+        try:
+            client = carla.Client(host, port)
+            client.set_timeout(10.0)
+            client.get_server_version()
+            return client
+        except RuntimeError:
+            if time.time() > deadline:
+                raise
+            time.sleep(2.0)
+
+
+def stop(process: subprocess.Popen) -> None:
+    if process.poll() is None:
+        process.terminate()
+        try:
+            process.wait(30)
+        except subprocess.TimeoutExpired:
+            process.kill()
+
+
+def recording_duration(args: argparse.Namespace, port: int) -> float:
+    # from a simulator of its own (the segments' settings depend on it)
+    process = launch(args, port, None, os.path.join(args.out_dir, "probe.log"))
+    try:
+        info = connect(args.host, port, process, args.startup_timeout).show_recorder_file_info(args.recording, False)
+    finally:
+        stop(process)
+    match = re.search(r"Duration: ([\d.]+) seconds", info)
+    if match is None:
+        raise RuntimeError(f"unable to read the duration of {args.recording}:\n{info}")
+    return float(match.group(1))
+
+
+def run_segment(args: argparse.Namespace, segment: Segment, ports: "queue.Queue[int]") -> Dict:
+    segment_dir = os.path.join(args.out_dir, "segments", f"segment_{segment.index:03d}")
+    frame_dir = os.path.join(segment_dir, "frames")
+    os.makedirs(frame_dir, exist_ok=True)
+    overrides = os.path.join(segment_dir, "overrides.ini")
+    write_overrides(overrides, segment, frame_dir, parse_settings(args.set))
+
+    port = ports.get()
+    start = time.time()
+    process = launch(args, port, overrides, os.path.join(segment_dir, "server.log"))
+    try:
+        client = connect(args.host, port, process, args.startup_timeout)
+        # replays to the end of the capture window, then the simulator quits ([Replayer] QuitWhenDone)
+        client.replay_file(args.recording, segment.replay_start, 0.0, 0)
+        process.wait(args.segment_timeout if args.segment_timeout > 0 else None)
+    finally:
+        stop(process)
+        ports.put(port)
+    seconds = time.time() - start
+    print(f"segment {segment.index}: {segment.capture_start:.1f}-{segment.capture_end or 'end'} s on port {port} "
+          f"in {seconds:.0f} s (exit {process.returncode})")
+    return {"segment": segment._asdict(), "dir": segment_dir, "port": port, "seconds": seconds,
+            "exit_code": process.returncode}
+
+
+def capture_dir(frame_dir: str) -> str:
+    # the EgoSensor captures into a subdirectory named after the time it started
+    subdirs = sorted(d for d in os.listdir(frame_dir) if os.path.isdir(os.path.join(frame_dir, d)))
+    return os.path.join(frame_dir, subdirs[-1]) if subdirs else frame_dir
+
+
+def merge_outputs(frame_dirs: List[str], out_dir: str) -> List[int]:
+    # moves the images (and merges the containers) of the segments into out_dir as if they came from one replay: the
+    # images are numbered by the frames captured before them, so they are renumbered in segment order, the container
+    # frames are the recorded frames' ids already. Returns the frames captured by every segment
+    os.makedirs(out_dir, exist_ok=True)
+    images: List[List[Tuple[str, re.Match]]] = []
+    containers: Dict[Tuple[str, int, int], List[str]] = {}
+    num_frames: List[int] = []
+    for frame_dir in frame_dirs:
+        directory = capture_dir(frame_dir)
+        segment_images, segment_frames = [], 0
+        for filename in sorted(os.listdir(directory)):
+            path = os.path.join(directory, filename)
+            image, container = IMAGE_NAME.match(filename), CONTAINER_NAME.match(filename)
+            if image is not None:
+                segment_images.append((path, image))
+                segment_frames = max(segment_frames, int(image["frame"]) + 1)
+            elif container is not None:
+                key = (container["name"], int(container["shader"]), int(container["pose"]))
+                containers.setdefault(key, []).append(path)
+                segment_frames = max(segment_frames, len(FrameContainer(path)))
+        images.append(segment_images)
+        num_frames.append(segment_frames)
+
+    offsets = [sum(num_frames[:i]) for i in range(len(num_frames))]
+    for segment_images, offset in zip(images, offsets):
+        for path, image in segment_images:
+            frame = int(image["frame"]) + offset
+            name = f"{image['name']}_s{image['shader']}_p{image['pose']}_{frame:05d}.{image['ext']}"
+            os.replace(path, os.path.join(out_dir, name))
+    for (name, shader, pose), paths in sorted(containers.items()):
+        merge_containers(paths, os.path.join(out_dir, f"{name}_s{shader}_p{pose}.dvrf"))
+    return num_frames
+
+
+def build_argparser() -> argparse.ArgumentParser:
+    argparser = argparse.ArgumentParser(description="Parallel frame capture of a DReyeVR recording")
+    argparser.add_argument("recording", type=str, help="recording to replay (as passed to client.replay_file)")
+    argparser.add_argument("--carla", type=str, required=True, help="simulator to launch (ex. CarlaUE4.sh)")
+    argparser.add_argument("-o", "--out-dir", type=str, required=True, help="directory for the merged frames")
+    argparser.add_argument("-n", "--instances", type=int, default=2, help="simulators at once (default: 2)")
+    argparser.add_argument(
+        "-s", "--segments", type=int, default=0, help="segments to split the recording into (default: instances)"
+    )
+    argparser.add_argument(
+        "-w", "--warmup", type=float, default=5.0, help="s replayed before every segment (default: 5)"
+    )
+    argparser.add_argument(
+        "-d", "--duration", type=float, default=0.0, help="s of the recording (default: ask a simulator)"
+    )
+    argparser.add_argument("--host", type=str, default="127.0.0.1")
+    argparser.add_argument("-p", "--port", type=int, default=2000, help="rpc port of the first instance")
+    argparser.add_argument(
+        "--port-step", type=int, default=4, help="between the instances' rpc ports (carla also uses port+1, +2)"
+    )
+    argparser.add_argument(
+        "--set", type=str, action="append", default=[], help="Section.Variable=Value for DReyeVRConfig.ini"
+    )
+    argparser.add_argument("--offscreen", action="store_true", help="render offscreen (-RenderOffScreen)")
+    argparser.add_argument("--startup-timeout", type=float, default=300.0, help="s for a simulator to start")
+    argparser.add_argument("--segment-timeout", type=float, default=0.0, help="s for a segment (0: no limit)")
+    argparser.add_argument("--server-args", nargs=argparse.REMAINDER, default=[], help="for every simulator")
+    return argparser
+
+
+def main(argv: Optional[List[str]] = None) -> Dict:
+    args = build_argparser().parse_args(argv)
+    args.carla = os.path.abspath(args.carla)
+    args.out_dir = os.path.abspath(args.out_dir)
+    os.makedirs(args.out_dir, exist_ok=True)
+    ports: "queue.Queue[int]" = queue.Queue()
+    for i in range(max(args.instances, 1)):
+        ports.put(args.port + i * args.port_step)
+
+    start = time.time()
+    duration = args.duration if args.duration > 0 else recording_duration(args, args.port)
+    segments = plan_segments(duration, args.segments if args.segments > 0 else args.instances, args.warmup)
+    print(f"capturing {duration:.1f} s of {args.recording} in {len(segments)} segments on {args.instances} "
+          "instances")
+    with ThreadPoolExecutor(max_workers=max(args.instances, 1)) as pool:
+        results = list(pool.map(lambda segment: run_segment(args, segment, ports), segments))
+    failed = [r for r in results if r["exit_code"] != 0]
+    if failed:
+        raise RuntimeError(f"segments {[r['segment']['index'] for r in failed]} failed, see their server.log")
+
+    frame_dir = os.path.join(args.out_dir, "frames")
+    num_frames = merge_outputs([os.path.join(r["dir"], "frames") for r in results], frame_dir)
+    for result, frames in zip(results, num_frames):
+        result["frames"] = frames
+    manifest = {"recording": args.recording, "duration": duration, "instances": args.instances,
+                "warmup": args.warmup, "seconds": time.time() - start, "segments": results}
+    with open(os.path.join(args.out_dir, "segments.json"), "w") as f:
+        json.dump(manifest, f, indent=2)
+    print(f"{sum(num_frames)} frames in {manifest['seconds']:.0f} s, merged into {frame_dir}")
+    return manifest
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+import os
+import sys
+import tempfile
+import unittest
+
+import numpy as np
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+import parallel_capture as pc  # noqa: E402
+from dreyevr_frames import CHUNK, FOOTER, HEADER, INDEX, FrameContainer  # noqa: E402
+
+# python3 -m unittest discover -s Tools/ParallelCapture/tests
+# The end-to-end test launches the simulator, it runs only with DREYEVR_CARLA (ex. /path/to/CarlaUE4.sh) and
+# DREYEVR_TEST_RECORDING (a short recording, as passed to client.replay_file) set
+
+
+def write_container(path: str, frames, timestamps, width=4, height=2, indexed=True):
+    header = np.zeros(1, dtype=HEADER)
+    header[0] = (b"DRVF", 1, HEADER.itemsize, width, height, 1, 0, 0, 0, b"\0" * 32)
+    index = []
+    with open(path, "wb") as f:
+        f.write(header.tobytes())
+        offset = HEADER.itemsize
+        for frame, timestamp in zip(frames, timestamps):
+            pixels = np.full(width * height * 4, frame % 256, dtype=np.uint8).tobytes()
+            f.write(np.array([(b"FRAM", len(pixels), frame, timestamp)], dtype=CHUNK).tobytes())
+            f.write(pixels)
+            index.append((frame, timestamp, offset, len(pixels), 0))
+            offset += CHUNK.itemsize + len(pixels)
+        if indexed:
+            f.write(np.array(index, dtype=INDEX).tobytes())
+            f.write(np.array([(offset, len(index), b"DRVFIDX1")], dtype=FOOTER).tobytes())
+
+
+class TestPlan(unittest.TestCase):
+    def test_segments_cover_the_recording(self):
+        segments = pc.plan_segments(60.0, 4, 5.0)
+        self.assertEqual([s.capture_start for s in segments], [0.0, 15.0, 30.0, 45.0])
+        self.assertEqual([s.capture_end for s in segments], [15.0, 30.0, 45.0, 0.0])  # (last one to the end)
+        self.assertEqual([s.replay_start for s in segments], [0.0, 10.0, 25.0, 40.0])
+
+    def test_warmup_and_segment_count_are_clamped(self):
+        segments = pc.plan_segments(2.5, 8, 10.0)
+        self.assertEqual(len(segments), 2)
+        self.assertTrue(all(s.replay_start == 0.0 for s in segments))
+        self.assertEqual(len(pc.plan_segments(0.5, 4, 1.0)), 1)
+
+    def test_overrides(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "overrides.ini")
+            settings = pc.parse_settings(["Replayer.FrameOutput=container", "Replayer.RecordFrames=False",
+                                          "CameraParams.FieldOfView=60"])
+            pc.write_overrides(path, pc.Segment(1, 15.0, 30.0, 10.0), "/tmp/frames", settings)
+            with open(path) as f:
+                lines = f.read().splitlines()
+        self.assertIn("[Replayer]", lines)
+        self.assertIn("[CameraParams]", lines)
+        self.assertIn("FrameOutput=container", lines)
+        self.assertIn("RecordFrames=True", lines)  # (the capture cannot be turned off)
+        self.assertIn("CaptureStartTime=15.000", lines)
+        self.assertIn("CaptureEndTime=30.000", lines)
+        self.assertIn('FrameDir="/tmp/frames"', lines)
+        with self.assertRaises(ValueError):
+            pc.parse_settings(["FrameOutput=container"])
+
+
+class TestMerge(unittest.TestCase):
+    def test_images_are_renumbered_in_segment_order(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            frame_dirs = []
+            for segment, ticks in enumerate([3, 2]):
+                directory = os.path.join(tmp, f"segment_{segment}", "frames", "2026-01-01-00-00-00")
+                os.makedirs(directory)
+                for tick in range(ticks):
+                    for pose in range(2):
+                        with open(os.path.join(directory, f"tick_s0_p{pose}_{tick:05d}.png"), "w") as f:
+                            f.write(f"{segment}/{tick}")
+                frame_dirs.append(os.path.dirname(directory))
+            out = os.path.join(tmp, "out")
+            self.assertEqual(pc.merge_outputs(frame_dirs, out), [3, 2])
+            self.assertEqual(len(os.listdir(out)), 10)
+            with open(os.path.join(out, "tick_s0_p1_00003.png")) as f:
+                self.assertEqual(f.read(), "1/0")
+            with open(os.path.join(out, "tick_s0_p0_00004.png")) as f:
+                self.assertEqual(f.read(), "1/1")
+
+    def test_containers_are_concatenated(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            frame_dirs = []
+            for segment, (frames, timestamps, indexed) in enumerate(
+                [([30, 31, 32], [1000, 1033, 1066], True), ([33, 34], [1100, 1133], False)]
+            ):
+                directory = os.path.join(tmp, f"segment_{segment}", "frames")
+                os.makedirs(directory)
+                write_container(os.path.join(directory, "tick_s0_p0.dvrf"), frames, timestamps, indexed=indexed)
+                frame_dirs.append(directory)
+            out = os.path.join(tmp, "out")
+            self.assertEqual(pc.merge_outputs(frame_dirs, out), [3, 2])
+            merged = FrameContainer(os.path.join(out, "tick_s0_p0.dvrf"))
+            self.assertTrue(merged.indexed)
+            self.assertEqual(list(merged.frames), [30, 31, 32, 33, 34])  # (the recorded frames' ids, as they were)
+            self.assertEqual(list(merged.timestamps), [1000, 1033, 1066, 1100, 1133])
+            self.assertEqual(int(merged.frame(4)[0, 0, 0]), 34)  # (pixels of segment 1's second frame)
+
+
+@unittest.skipUnless(
+    os.environ.get("DREYEVR_CARLA") and os.environ.get("DREYEVR_TEST_RECORDING"),
+    "needs DREYEVR_CARLA and DREYEVR_TEST_RECORDING",
+)
+class TestParallelCapture(unittest.TestCase):
+    def capture(self, out_dir: str, instances: int):
+        return pc.main(
+            [os.environ["DREYEVR_TEST_RECORDING"], "--carla", os.environ["DREYEVR_CARLA"], "-o", out_dir,
+             "-n", str(instances), "-w", "2", "--offscreen", "--set", "Replayer.FrameOutput=container",
+             "--set", "Replayer.FrameWidth=320", "--set", "Replayer.FrameHeight=192"]
+        )
+
+    def test_segments_match_a_single_replay(self):
+        # the same recorded frames (and timestamps) as one simulator replaying the whole recording
+        with tempfile.TemporaryDirectory() as tmp:
+            self.capture(os.path.join(tmp, "single"), 1)
+            self.capture(os.path.join(tmp, "parallel"), 2)
+            single_dir, parallel_dir = os.path.join(tmp, "single", "frames"), os.path.join(tmp, "parallel", "frames")
+            self.assertEqual(sorted(os.listdir(single_dir)), sorted(os.listdir(parallel_dir)))
+            for filename in os.listdir(single_dir):
+                single = FrameContainer(os.path.join(single_dir, filename))
+                parallel = FrameContainer(os.path.join(parallel_dir, filename))
+                np.testing.assert_array_equal(single.timestamps, parallel.timestamps)
+                np.testing.assert_array_equal(single.frames, parallel.frames)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,330 @@
+#include "DReyeVRColumns.h"
+
+#include <cstdio>        // std::FILE
+#include <cstring>       // std::memcpy
+#include <memory>        // std::unique_ptr
+#include <unordered_map> // std::unordered_map
+
+namespace DReyeVRRec
+{
+
+namespace
+{
+// one sensor sample of a frame
+struct Sample
+{
+    const FrameData *Frame;
+    const AggregateData *Data;
+    int32_t FocusCode; // index of Data->FocusData.ActorNameTag in the categories
+};
+
+struct ColumnDef
+{
+    ColumnInfo Info;
+    size_t Size;
+    void (*Extract)(const Sample &S, char *Out);
+};
+
+template <typename T> void Store(char *Out, T Value)
+{
+    std::memcpy(Out, &Value, sizeof(T));
+}
+
+#define DREYEVR_COLUMN(Name, DType, T, Unit, Expr)                                                                     \
+    ColumnDef                                                                                                          \
+    {                                                                                                                  \
+        {Name, DType, Unit}, sizeof(T), [](const Sample &S, char *Out) { Store<T>(Out, static_cast<T>(Expr)); }        \
+    }
+#define DREYEVR_FLOAT(Name, Unit, Expr) DREYEVR_COLUMN(Name, "<f4", float, Unit, Expr)
+#define DREYEVR_BOOL(Name, Expr) DREYEVR_COLUMN(Name, "|b1", bool, "", Expr)
+#define DREYEVR_VEC3(Name, Unit, Expr)                                                                                 \
+    DREYEVR_FLOAT(Name ".X", Unit, (Expr).X), DREYEVR_FLOAT(Name ".Y", Unit, (Expr).Y),                               \
+        DREYEVR_FLOAT(Name ".Z", Unit, (Expr).Z)
+#define DREYEVR_ROT(Name, Expr)                                                                                        \
+    DREYEVR_FLOAT(Name ".Pitch", "deg", (Expr).Pitch), DREYEVR_FLOAT(Name ".Roll", "deg", (Expr).Roll),               \
+        DREYEVR_FLOAT(Name ".Yaw", "deg", (Expr).Yaw)
+#define DREYEVR_EYE(Name, Expr)                                                                                        \
+    DREYEVR_VEC3(Name ".GazeDir", "", (Expr).GazeDir), DREYEVR_VEC3(Name ".GazeOrigin", "cm", (Expr).GazeOrigin),     \
+        DREYEVR_BOOL(Name ".GazeValid", (Expr).GazeValid)
+#define DREYEVR_SINGLE_EYE(Name, Expr)                                                                                 \
+    DREYEVR_EYE(Name, Expr), DREYEVR_FLOAT(Name ".EyeOpenness", "", (Expr).EyeOpenness),                              \
+        DREYEVR_BOOL(Name ".EyeOpennessValid", (Expr).EyeOpennessValid),                                               \
+        DREYEVR_FLOAT(Name ".PupilDiameter", "mm", (Expr).PupilDiameter),                                              \
+        DREYEVR_FLOAT(Name ".PupilPosition.X", "", (Expr).PupilPosition.X),                                            \
+        DREYEVR_FLOAT(Name ".PupilPosition.Y", "", (Expr).PupilPosition.Y),                                            \
+        DREYEVR_BOOL(Name ".PupilPositionValid", (Expr).PupilPositionValid)
+
+const std::vector<ColumnDef> &GetColumnDefs()
+{
+    static const std::vector<ColumnDef> Defs = {
+        DREYEVR_COLUMN("Frame", "<u8", uint64_t, "", S.Frame->Header.Id),
+        DREYEVR_COLUMN("Elapsed", "<f8", double, "s", S.Frame->Header.Elapsed),
+        DREYEVR_COLUMN("TimestampCarla", "<i8", int64_t, "ms", S.Data->TimestampCarla),
+        DREYEVR_COLUMN("TimestampDevice", "<i8", int64_t, "ms", S.Data->EyeTrackerData.TimestampDevice),
+        DREYEVR_COLUMN("FrameSequence", "<i8", int64_t, "", S.Data->EyeTrackerData.FrameSequence),
+        // ego
+        DREYEVR_VEC3("CameraLocation", "cm", S.Data->EgoVars.CameraLocation),
+        DREYEVR_ROT("CameraRotation", S.Data->EgoVars.CameraRotation),
+        DREYEVR_VEC3("CameraLocationAbs", "cm", S.Data->EgoVars.CameraLocationAbs),
+        DREYEVR_ROT("CameraRotationAbs", S.Data->EgoVars.CameraRotationAbs),
+        DREYEVR_VEC3("VehicleLocation", "cm", S.Data->EgoVars.VehicleLocation),
+        DREYEVR_ROT("VehicleRotation", S.Data->EgoVars.VehicleRotation),
+        DREYEVR_FLOAT("Velocity", "cm/s", S.Data->EgoVars.Velocity),
+        // eye tracker
+        DREYEVR_EYE("Combined", S.Data->EyeTrackerData.Combined),
+        DREYEVR_FLOAT("Combined.Vergence", "cm", S.Data->EyeTrackerData.Combined.Vergence),
+        DREYEVR_SINGLE_EYE("Left", S.Data->EyeTrackerData.Left),
+        DREYEVR_SINGLE_EYE("Right", S.Data->EyeTrackerData.Right),
+        // focus
+        DREYEVR_COLUMN("Focus.ActorNameTag", "<i4", int32_t, "category", S.FocusCode),
+        DREYEVR_BOOL("Focus.bDidHit", S.Data->FocusData.bDidHit),
+        DREYEVR_VEC3("Focus.HitPoint", "cm", S.Data->FocusData.HitPoint),
+        DREYEVR_VEC3("Focus.Normal", "", S.Data->FocusData.Normal),
+        DREYEVR_FLOAT("Focus.Distance", "cm", S.Data->FocusData.Distance),
+        // inputs
+        DREYEVR_FLOAT("Inputs.Throttle", "", S.Data->Inputs.Throttle),
+        DREYEVR_FLOAT("Inputs.Steering", "", S.Data->Inputs.Steering),
+        DREYEVR_FLOAT("Inputs.Brake", "", S.Data->Inputs.Brake),
+        DREYEVR_BOOL("Inputs.ToggledReverse", S.Data->Inputs.ToggledReverse),
+        DREYEVR_BOOL("Inputs.TurnSignalLeft", S.Data->Inputs.TurnSignalLeft),
+        DREYEVR_BOOL("Inputs.TurnSignalRight", S.Data->Inputs.TurnSignalRight),
+        DREYEVR_BOOL("Inputs.HoldHandbrake", S.Data->Inputs.HoldHandbrake),
+    };
+    return Defs;
+}
+
+#undef DREYEVR_SINGLE_EYE
+#undef DREYEVR_EYE
+#undef DREYEVR_ROT
+#undef DREYEVR_VEC3
+#undef DREYEVR_BOOL
+#undef DREYEVR_FLOAT
+#undef DREYEVR_COLUMN
+
+/// ========================================== ///
+/// ------------------:NPY:------------------- ///
+/// ========================================== ///
+
+// NumPy format 1.0: magic, version, header length, then a python dict padded so the data starts 64-byte aligned.
+// The header is always written with the same (padded) length so the row count can be patched in on Close.
+constexpr size_t NpyHeaderSize = 128;
+
+std::string NpyHeader(const std::string &DType, uint64_t Rows)
+{
+    std::string Dict =
+        "{'descr': '" + DType + "', 'fortran_order': False, 'shape': (" + std::to_string(Rows) + ",), }";
+    const size_t Prefix = 6 + 2 + 2; // magic + version + header length
+    Dict.resize(NpyHeaderSize - Prefix - 1, ' ');
+    Dict += '\n';
+    std::string Header("\x93NUMPY\x01\x00", 8);
+    const uint16_t Length = static_cast<uint16_t>(Dict.size());
+    Header.append(reinterpret_cast<const char *>(&Length), sizeof(Length));
+    return Header + Dict;
+}
+
+class NpyColumnWriter
+{
+  public:
+    NpyColumnWriter(const ColumnDef &Def, size_t BufferRows) : Def(Def), BufferRows(BufferRows)
+    {
+        Buffer.reserve(BufferRows * Def.Size);
+    }
+
+    ~NpyColumnWriter()
+    {
+        if (File != nullptr)
+            std::fclose(File);
+    }
+
+    bool Open(const std::string &Filename)
+    {
+        File = std::fopen(Filename.c_str(), "wb");
+        if (File == nullptr)
+            return false;
+        const std::string Header = NpyHeader(Def.Info.DType, 0);
+        return std::fwrite(Header.data(), 1, Header.size(), File) == Header.size();
+    }
+
+    void Add(const Sample &S)
+    {
+        const size_t At = Buffer.size();
+        Buffer.resize(At + Def.Size);
+        Def.Extract(S, &Buffer[At]);
+        Rows++;
+        if (Buffer.size() >= BufferRows * Def.Size)
+            Flush();
+    }
+
+    // writes the buffered rows and the final row count, false on any write error
+    bool Close()
+    {
+        Flush();
+        const std::string Header = NpyHeader(Def.Info.DType, Rows);
+        bFailed |= std::fseek(File, 0, SEEK_SET) != 0;
+        bFailed |= std::fwrite(Header.data(), 1, Header.size(), File) != Header.size();
+        bFailed |= std::fclose(File) != 0;
+        File = nullptr;
+        return !bFailed;
+    }
+
+    uint64_t GetBytes() const
+    {
+        return NpyHeaderSize + Rows * Def.Size;
+    }
+
+  private:
+    void Flush()
+    {
+        bFailed |= std::fwrite(Buffer.data(), 1, Buffer.size(), File) != Buffer.size();
+        Buffer.clear();
+    }
+
+    const ColumnDef &Def;
+    const size_t BufferRows;
+    std::FILE *File = nullptr;
+    std::vector<char> Buffer;
+    uint64_t Rows = 0;
+    bool bFailed = false;
+};
+
+std::string JsonString(const std::string &Str)
+{
+    std::string Out = "\"";
+    for (const char C : Str)
+    {
+        if (C == '"' || C == '\\')
+        {
+            Out += '\\';
+            Out += C;
+        }
+        else if (static_cast<unsigned char>(C) < 0x20)
+        {
+            char Escaped[8];
+            std::snprintf(Escaped, sizeof(Escaped), "\\u%04x", C);
+            Out += Escaped;
+        }
+        else
+        {
+            Out += C;
+        }
+    }
+    return Out + "\"";
+}
+} // namespace
+
+const std::vector<ColumnInfo> &GetDReyeVRColumns()
+{
+    static const std::vector<ColumnInfo> Columns = [] {
+        std::vector<ColumnInfo> Out;
+        for (const ColumnDef &Def : GetColumnDefs())
+            Out.push_back(Def.Info);
+        return Out;
+    }();
+    return Columns;
+}
+
+ExportResult ExportColumns(RecordingReader &Reader, const std::string &OutDir, const ExportOptions &Options)
+{
+    ExportResult Result;
+
+    // selected columns, in schema order
+    std::vector<const ColumnDef *> Selected;
+    for (const ColumnDef &Def : GetColumnDefs())
+    {
+        bool bWanted = Options.Columns.empty();
+        for (const std::string &Name : Options.Columns)
+            bWanted = bWanted || (Name == Def.Info.Name);
+        if (bWanted)
+            Selected.push_back(&Def);
+    }
+    for (const std::string &Name : Options.Columns)
+    {
+        bool bKnown = false;
+        for (const ColumnDef &Def : GetColumnDefs())
+            bKnown = bKnown || (Name == Def.Info.Name);
+        if (!bKnown)
+        {
+            Result.Error = "unknown column " + Name;
+            return Result;
+        }
+    }
+
+    std::vector<std::unique_ptr<NpyColumnWriter>> Writers;
+    for (const ColumnDef *Def : Selected)
+    {
+        Writers.emplace_back(new NpyColumnWriter(*Def, Options.BufferRows > 0 ? Options.BufferRows : 1));
+        if (!Writers.back()->Open(OutDir + "/" + Def->Info.Name + ".npy"))
+        {
+            Result.Error = "could not create " + OutDir + "/" + Def->Info.Name + ".npy";
+            return Result;
+        }
+    }
+
+    std::vector<std::string> Categories;
+    std::unordered_map<std::string, int32_t> CategoryCodes;
+    FrameData Frame;
+    while (Reader.NextFrame(Frame))
+    {
+        Result.Frames++;
+        for (const AggregateData &Data : Frame.DReyeVR)
+        {
+            auto It = CategoryCodes.find(Data.FocusData.ActorNameTag);
+            if (It == CategoryCodes.end())
+            {
+                It = CategoryCodes.emplace(Data.FocusData.ActorNameTag, static_cast<int32_t>(Categories.size())).first;
+                Categories.push_back(Data.FocusData.ActorNameTag);
+            }
+            const Sample S{&Frame, &Data, It->second};
+            for (auto &Writer : Writers)
+                Writer->Add(S);
+            Result.Rows++;
+        }
+    }
+
+    bool bWritten = true;
+    for (auto &Writer : Writers)
+    {
+        bWritten = Writer->Close() && bWritten;
+        Result.Bytes += Writer->GetBytes();
+    }
+    if (!bWritten)
+    {
+        Result.Error = "could not write the columns to " + OutDir;
+        return Result;
+    }
+
+    // schema.json
+    const Info &Header = Reader.GetInfo();
+    std::string Schema = "{\n";
+    Schema += "  \"format\": \"dreyevr-columns\",\n  \"version\": 1,\n";
+    Schema += "  \"map\": " + JsonString(Header.Map) + ",\n";
+    Schema += "  \"date\": " + std::to_string(Header.Date) + ",\n";
+    Schema += "  \"frames\": " + std::to_string(Result.Frames) + ",\n";
+    Schema += "  \"rows\": " + std::to_string(Result.Rows) + ",\n";
+    Schema += "  \"columns\": [\n";
+    for (size_t i = 0; i < Selected.size(); i++)
+    {
+        const ColumnInfo &Column = Selected[i]->Info;
+        Schema += "    {\"name\": " + JsonString(Column.Name) + ", \"dtype\": " + JsonString(Column.DType) +
+                  ", \"unit\": " + JsonString(Column.Unit) + ", \"file\": " + JsonString(Column.Name + ".npy") + "}";
+        Schema += (i + 1 < Selected.size()) ? ",\n" : "\n";
+    }
+    Schema += "  ],\n  \"categories\": {\n    \"Focus.ActorNameTag\": [";
+    for (size_t i = 0; i < Categories.size(); i++)
+        Schema += (i > 0 ? ", " : "") + JsonString(Categories[i]);
+    Schema += "]\n  }\n}\n";
+
+    std::FILE *File = std::fopen((OutDir + "/schema.json").c_str(), "wb");
+    const bool bSchema = File != nullptr && std::fwrite(Schema.data(), 1, Schema.size(), File) == Schema.size();
+    if (File != nullptr)
+        std::fclose(File);
+    if (!bSchema)
+    {
+        Result.Error = "could not write " + OutDir + "/schema.json";
+        return Result;
+    }
+    Result.bSuccess = true;
+    return Result;
+}
+
+} // namespace DReyeVRRec
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "DReyeVRRecording.h"
+
+#include <cstdint> // uint64_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+// Columnar export of the DReyeVR sensor data of a recording (packets 139/145)
+//
+// Every field of DReyeVR::AggregateData becomes one contiguous typed array in its own NumPy .npy file (one row per
+// sensor sample, indexed by the Frame and Elapsed columns), described by a schema.json next to them. Each column can
+// be memory-mapped on its own (numpy.load(..., mmap_mode="r")), so reading 3 columns out of 60 only touches their
+// bytes. Strings (the focused actor) are stored as int32 codes into a category list in the schema.
+
+namespace DReyeVRRec
+{
+
+struct ColumnInfo
+{
+    std::string Name;  // ex. "Combined.GazeDir.X" (path of the field in DReyeVR::AggregateData)
+    std::string DType; // numpy type string, ex. "<f4"
+    std::string Unit;  // ex. "cm", "deg", "" if unitless
+};
+
+// every column of an export, in schema order
+const std::vector<ColumnInfo> &GetDReyeVRColumns();
+
+struct ExportOptions
+{
+    std::vector<std::string> Columns; // (all if empty)
+    size_t BufferRows = 1 << 16;      // rows buffered per column between writes
+};
+
+struct ExportResult
+{
+    bool bSuccess = false;
+    std::string Error;
+    uint64_t Frames = 0;
+    uint64_t Rows = 0;
+    uint64_t Bytes = 0; // written to the column files
+};
+
+// reads the rest of the recording and writes <OutDir>/schema.json and one <Name>.npy per column (OutDir must exist)
+ExportResult ExportColumns(RecordingReader &Reader, const std::string &OutDir, const ExportOptions &Options);
+
+} // namespace DReyeVRRec
@@ -0,0 +1,923 @@
+#include "DReyeVRRecording.h"
+#include "DReyeVRRecordingFormat.h"
+
+#include <fstream>       // std::ifstream
+#include <unordered_map> // std::unordered_map
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DREYEVR_REC_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define DREYEVR_REC_MMAP 0
+#endif
+
+namespace DReyeVRRec
+{
+using namespace Format;
+
+const char *GetPacketName(uint8_t Id)
+{
+    switch (static_cast<PacketId>(Id))
+    {
+    case PacketId::FrameStart:
+        return "FrameStart";
+    case PacketId::FrameEnd:
+        return "FrameEnd";
+    case PacketId::EventAdd:
+        return "EventAdd";
+    case PacketId::EventDel:
+        return "EventDel";
+    case PacketId::EventParent:
+        return "EventParent";
+    case PacketId::Collision:
+        return "Collision";
+    case PacketId::Position:
+        return "Position";
+    case PacketId::State:
+        return "State";
+    case PacketId::AnimVehicle:
+        return "AnimVehicle";
+    case PacketId::AnimWalker:
+        return "AnimWalker";
+    case PacketId::VehicleLight:
+        return "VehicleLight";
+    case PacketId::SceneLight:
+        return "SceneLight";
+    case PacketId::Kinematics:
+        return "Kinematics";
+    case PacketId::BoundingBox:
+        return "BoundingBox";
+    case PacketId::PlatformTime:
+        return "PlatformTime";
+    case PacketId::PhysicsControl:
+        return "PhysicsControl";
+    case PacketId::TrafficLightTime:
+        return "TrafficLightTime";
+    case PacketId::TriggerVolume:
+        return "TriggerVolume";
+    case PacketId::Weather:
+        return "Weather";
+    case PacketId::DReyeVR:
+        return "DReyeVR";
+    case PacketId::DReyeVRCustomActor:
+        return "DReyeVRCustomActor";
+    case PacketId::DReyeVRConfigFile:
+        return "DReyeVRConfigFile";
+    case PacketId::DReyeVRFrameIndex:
+        return "DReyeVRFrameIndex";
+    case PacketId::DReyeVRKeyframe:
+        return "DReyeVRKeyframe";
+    case PacketId::DReyeVRCompactPosition:
+        return "DReyeVRCompactPosition";
+    case PacketId::DReyeVRCompactDReyeVR:
+        return "DReyeVRCompactDReyeVR";
+    case PacketId::DReyeVRInternedCustomActor:
+        return "DReyeVRInternedCustomActor";
+    case PacketId::DReyeVREyeSamples:
+        return "DReyeVREyeSamples";
+    case PacketId::DReyeVRGazeTraces:
+        return "DReyeVRGazeTraces";
+    case PacketId::DReyeVRFixations:
+        return "DReyeVRFixations";
+    case PacketId::DReyeVRDwell:
+        return "DReyeVRDwell";
+    default:
+        return "Unknown";
+    }
+}
+
+void FrameData::Clear()
+{
+    *this = FrameData();
+}
+
+/// ========================================== ///
+/// ------------:PACKET CONTENTS:------------- ///
+/// ========================================== ///
+
+namespace
+{
+// uint16 count + Total records, each of exactly RecordSize bytes (false if the packet has any other size)
+template <typename T, typename ReadFn>
+bool GetRecords(DReyeVRCompactReader &In, std::vector<T> &Out, size_t RecordSize, ReadFn &&Read)
+{
+    const uint16_t Total = In.Raw<uint16_t>();
+    if (In.Failed() || In.Remaining() != Total * RecordSize)
+        return false;
+    Out.reserve(Out.size() + Total);
+    for (uint16_t i = 0; i < Total; i++)
+    {
+        T Record;
+        Read(In, Record);
+        Out.push_back(std::move(Record));
+    }
+    return !In.Failed();
+}
+
+// uint16 count + Total variable sized records
+template <typename T, typename ReadFn> bool GetVariableRecords(DReyeVRCompactReader &In, std::vector<T> &Out, ReadFn &&Read)
+{
+    const uint16_t Total = In.Raw<uint16_t>();
+    for (uint16_t i = 0; i < Total && !In.Failed(); i++)
+    {
+        T Record;
+        Read(In, Record);
+        Out.push_back(std::move(Record));
+    }
+    return !In.Failed();
+}
+
+void GetEventAdd(DReyeVRCompactReader &In, struct EventAdd &Out)
+{
+    Get(In, Out.DatabaseId);
+    Get(In, Out.Type);
+    Get(In, Out.Location);
+    Get(In, Out.Rotation);
+    Get(In, Out.UId);
+    Get(In, Out.Id);
+    const uint16_t NumAttributes = In.Raw<uint16_t>();
+    for (uint16_t i = 0; i < NumAttributes && !In.Failed(); i++)
+    {
+        ActorAttribute Attribute;
+        Get(In, Attribute.Type);
+        Get(In, Attribute.Id);
+        Get(In, Attribute.Value);
+        Out.Attributes.push_back(std::move(Attribute));
+    }
+}
+
+void GetSceneLight(DReyeVRCompactReader &In, SceneLightState &Out)
+{
+    Get(In, Out.LightId);
+    Get(In, Out.Intensity);
+    GetColorRGBA(In, Out.LightColor);
+    Get(In, Out.On);
+    Get(In, Out.Type);
+}
+
+void GetEye(DReyeVRCompactReader &In, EyeData &Out)
+{
+    Get(In, Out.GazeDir);
+    Get(In, Out.GazeOrigin);
+    Get(In, Out.GazeValid);
+}
+
+void GetSingleEye(DReyeVRCompactReader &In, SingleEyeData &Out)
+{
+    GetEye(In, Out);
+    Get(In, Out.EyeOpenness);
+    Get(In, Out.EyeOpennessValid);
+    Get(In, Out.PupilDiameter);
+    Get(In, Out.PupilPosition);
+    Get(In, Out.PupilPositionValid);
+}
+
+// DReyeVR::FocusInfo::Read
+void GetFocus(DReyeVRCompactReader &In, FocusInfo &Out)
+{
+    Get(In, Out.ActorNameTag);
+    Get(In, Out.bDidHit);
+    Get(In, Out.HitPoint);
+    Get(In, Out.Normal);
+    Get(In, Out.Distance);
+}
+
+// DReyeVR::FixationEvent::Read
+void GetFixationEvent(DReyeVRCompactReader &In, FixationEvent &Out)
+{
+    Get(In, Out.bStart);
+    Get(In, Out.Start);
+    Get(In, Out.End);
+    Get(In, Out.Direction);
+    Get(In, Out.ActorNameTag);
+}
+
+// DReyeVR::FixationData::Read
+void GetFixations(DReyeVRCompactReader &In, FixationData &Out)
+{
+    Get(In, Out.bFixating);
+    GetFixationEvent(In, Out.Current);
+    const uint32_t NumEvents = In.Raw<uint32_t>();
+    for (uint32_t i = 0; i < NumEvents && !In.Failed(); i++)
+    {
+        Out.Events.emplace_back();
+        GetFixationEvent(In, Out.Events.back());
+    }
+}
+
+// DReyeVR::DwellData::Read
+void GetDwellData(DReyeVRCompactReader &In, DwellData &Out)
+{
+    Get(In, Out.UntrackedDwell);
+    Get(In, Out.DroppedDwell);
+    Get(In, Out.NumDroppedActors);
+    const uint32_t NumActors = In.Raw<uint32_t>();
+    for (uint32_t i = 0; i < NumActors && !In.Failed(); i++)
+    {
+        DwellStats Stats;
+        Get(In, Stats.ActorId);
+        Get(In, Stats.NumGlances);
+        Get(In, Stats.NumFixations);
+        Get(In, Stats.TotalDwell);
+        Get(In, Stats.FirstGlance);
+        Get(In, Stats.FirstFixation);
+        Get(In, Stats.LastGlance);
+        Get(In, Stats.LongestGlance);
+        Out.Actors.push_back(Stats);
+    }
+}
+
+// DReyeVR::AggregateData::Read
+void GetAggregate(DReyeVRCompactReader &In, AggregateData &Out)
+{
+    Get(In, Out.TimestampCarla);
+    EgoVariables &Ego = Out.EgoVars;
+    Get(In, Ego.CameraLocation);
+    Get(In, Ego.CameraRotation);
+    Get(In, Ego.CameraLocationAbs);
+    Get(In, Ego.CameraRotationAbs);
+    Get(In, Ego.VehicleLocation);
+    Get(In, Ego.VehicleRotation);
+    Get(In, Ego.Velocity);
+    EyeTracker &Eyes = Out.EyeTrackerData;
+    Get(In, Eyes.TimestampDevice);
+    Get(In, Eyes.FrameSequence);
+    GetEye(In, Eyes.Combined);
+    Get(In, Eyes.Combined.Vergence);
+    GetSingleEye(In, Eyes.Left);
+    GetSingleEye(In, Eyes.Right);
+    GetFocus(In, Out.FocusData);
+    UserInputs &Inputs = Out.Inputs;
+    Get(In, Inputs.Throttle);
+    Get(In, Inputs.Steering);
+    Get(In, Inputs.Brake);
+    Get(In, Inputs.ToggledReverse);
+    Get(In, Inputs.TurnSignalLeft);
+    Get(In, Inputs.TurnSignalRight);
+    Get(In, Inputs.HoldHandbrake);
+}
+
+// DReyeVR::CustomActorData::Read
+void GetCustomActor(DReyeVRCompactReader &In, CustomActorData &Out)
+{
+    Get(In, Out.Location);
+    Get(In, Out.Rotation);
+    Get(In, Out.Scale3D);
+    Get(In, Out.MeshPath);
+    Get(In, Out.Metallic);
+    Get(In, Out.Specular);
+    Get(In, Out.Roughness);
+    Get(In, Out.Anisotropy);
+    Get(In, Out.Opacity);
+    GetColorABGR(In, Out.BaseColor);
+    GetColorABGR(In, Out.Emissive);
+    Get(In, Out.MaterialPath);
+    Get(In, Out.Other);
+    Get(In, Out.Name);
+}
+
+bool GetInternedString(DReyeVRCompactReader &In, const DReyeVRStringTableReader &Strings, std::string &Out)
+{
+    const std::string *Str = Strings.Get(In.Varint());
+    if (Str == nullptr)
+        return false;
+    Out = *Str;
+    return true;
+}
+
+// DReyeVR::CustomActorData::ReadInterned
+bool GetInternedCustomActor(DReyeVRCompactReader &In, const DReyeVRStringTableReader &Strings, CustomActorData &Out)
+{
+    const uint64_t Changed = In.Varint();
+    if (Changed & CA_LOCATION)
+        Get(In, Out.Location);
+    if (Changed & CA_ROTATION)
+        Get(In, Out.Rotation);
+    if (Changed & CA_SCALE3D)
+        Get(In, Out.Scale3D);
+    if ((Changed & CA_MESH_PATH) && !GetInternedString(In, Strings, Out.MeshPath))
+        return false;
+    if (Changed & CA_MATERIAL_SCALARS)
+    {
+        Get(In, Out.Metallic);
+        Get(In, Out.Specular);
+        Get(In, Out.Roughness);
+        Get(In, Out.Anisotropy);
+        Get(In, Out.Opacity);
+    }
+    if (Changed & CA_BASE_COLOR)
+        GetColorRGBA(In, Out.BaseColor);
+    if (Changed & CA_EMISSIVE)
+        GetColorRGBA(In, Out.Emissive);
+    if ((Changed & CA_MATERIAL_PATH) && !GetInternedString(In, Strings, Out.MaterialPath))
+        return false;
+    if ((Changed & CA_OTHER) && !GetInternedString(In, Strings, Out.Other))
+        return false;
+    return !In.Failed();
+}
+} // namespace
+
+/// ========================================== ///
+/// ----------------:READER:------------------ ///
+/// ========================================== ///
+
+struct RecordingReader::FImpl
+{
+    const char *Data = nullptr;
+    size_t Size = 0;
+    size_t Pos = 0;
+    size_t FirstPacket = 0; // right after the info header
+
+    std::string Owned; // file contents when they could not be mapped
+#if DREYEVR_REC_MMAP
+    void *Mapped = nullptr;
+#endif
+
+    Info Header;
+    FrameIndex Index;
+    std::optional<DwellData> Dwell;
+    FileStats Stats;
+    std::string Error;
+
+    // delta state of the compact and interned packets
+    DReyeVRPositionDecoder PositionDecoder;
+    DReyeVRFieldDecoder FieldDecoder;
+    DReyeVRFieldDecoder EyeSampleDecoder;
+    DReyeVRStringTableReader Strings;
+    std::unordered_map<uint32_t, CustomActorData> LastActors;
+    bool bActorsSynced = false;
+    std::vector<DReyeVRCompactPosition> CompactPositions;
+
+    void Unmap()
+    {
+#if DREYEVR_REC_MMAP
+        if (Mapped != nullptr)
+            munmap(Mapped, Size);
+        Mapped = nullptr;
+#endif
+        Owned.clear();
+        Data = nullptr;
+        Size = 0;
+        Pos = 0;
+    }
+
+    void ResetState()
+    {
+        Pos = FirstPacket;
+        Stats = FileStats();
+        PositionDecoder.Reset();
+        FieldDecoder.Reset();
+        EyeSampleDecoder.Reset();
+        Strings.Reset();
+        LastActors.clear();
+        bActorsSynced = false;
+    }
+
+    bool ParseInfo()
+    {
+        DReyeVRCompactReader In(Data, Size);
+        Get(In, Header.Version);
+        Get(In, Header.Magic);
+        Get(In, Header.Date);
+        Get(In, Header.Map);
+        if (In.Failed() || Header.Magic != "CARLA_RECORDER")
+        {
+            Error = "not a CARLA recording";
+            return false;
+        }
+        FirstPacket = Size - In.Remaining();
+        return true;
+    }
+
+    // DReyeVRFrameIndex::Load
+    void LoadIndex()
+    {
+        Index = FrameIndex();
+        if (Size < FirstPacket + HeaderSize + IndexFooterSize)
+            return;
+        const char *Footer = Data + Size - IndexFooterSize;
+        if (std::memcmp(Footer + sizeof(uint64_t), IndexMagic, IndexMagicSize) != 0)
+            return;
+        uint64_t Offset = 0;
+        std::memcpy(&Offset, Footer, sizeof(Offset));
+        if (Offset < FirstPacket || Offset + HeaderSize > Size - IndexFooterSize)
+            return;
+
+        DReyeVRCompactReader In(Data + Offset, Size - Offset);
+        const PacketId Id = static_cast<PacketId>(In.Raw<uint8_t>());
+        const uint32_t PacketSize = In.Raw<uint32_t>();
+        if (Id != PacketId::DReyeVRFrameIndex || PacketSize != In.Remaining())
+            return;
+        FrameIndex Loaded;
+        Get(In, Loaded.Version);
+        const uint32_t NumFrames = In.Raw<uint32_t>();
+        for (uint32_t i = 0; i < NumFrames && !In.Failed(); i++)
+        {
+            FrameIndexEntry Entry;
+            Get(In, Entry.FrameId);
+            Get(In, Entry.Elapsed);
+            Get(In, Entry.Offset);
+            Loaded.Frames.push_back(Entry);
+        }
+        if (Loaded.Version >= 2)
+        {
+            const uint32_t NumKeyframes = In.Raw<uint32_t>();
+            for (uint32_t i = 0; i < NumKeyframes && !In.Failed(); i++)
+            {
+                const uint32_t FrameNumber = In.Raw<uint32_t>();
+                const uint64_t KeyframeOffset = In.Raw<uint64_t>();
+                Loaded.Keyframes.emplace_back(FrameNumber, KeyframeOffset);
+            }
+        }
+        if (!In.Failed() && In.Remaining() == IndexFooterSize)
+            Index = std::move(Loaded);
+        if (!Index.Frames.empty() && Index.Frames.back().Offset < Offset)
+            LoadDwell(static_cast<size_t>(Index.Frames.back().Offset), static_cast<size_t>(Offset));
+    }
+
+    // the dwell statistics are between the last frame and the frame index (see ACarlaRecorder::Stop)
+    void LoadDwell(size_t Begin, size_t End)
+    {
+        while (Begin + HeaderSize <= End)
+        {
+            const PacketId Id = static_cast<PacketId>(Data[Begin]);
+            uint32_t PacketSize = 0;
+            std::memcpy(&PacketSize, Data + Begin + 1, sizeof(PacketSize));
+            if (PacketSize > End - Begin - HeaderSize)
+                return;
+            if (Id == PacketId::DReyeVRDwell)
+            {
+                DReyeVRCompactReader In(Data + Begin + HeaderSize, PacketSize);
+                ParseDwell(In);
+                return;
+            }
+            Begin += HeaderSize + PacketSize;
+        }
+    }
+
+    bool ParseDwell(DReyeVRCompactReader &In)
+    {
+        std::vector<DwellData> Records;
+        if (!GetVariableRecords(In, Records, GetDwellData))
+            return false;
+        if (!Records.empty())
+            Dwell = std::move(Records.back());
+        return true;
+    }
+
+    void ParseKeyframe(DReyeVRCompactReader &In, Keyframe &Out)
+    {
+        while (In.Remaining() > 0 && !In.Failed())
+        {
+            const PacketId Id = static_cast<PacketId>(In.Raw<uint8_t>());
+            const uint32_t PacketSize = In.Raw<uint32_t>();
+            const char *Body = In.View(PacketSize);
+            if (Body == nullptr)
+                break;
+            DReyeVRCompactReader Nested(Body, PacketSize);
+            bool bValid = true;
+            switch (Id)
+            {
+            case PacketId::EventAdd:
+                bValid = GetVariableRecords(Nested, Out.Actors, GetEventAdd);
+                break;
+            case PacketId::EventParent:
+                bValid = GetRecords(Nested, Out.Parents, 8, [](DReyeVRCompactReader &R, struct EventParent &E) {
+                    Get(R, E.DatabaseId);
+                    Get(R, E.ParentId);
+                });
+                break;
+            case PacketId::SceneLight:
+                bValid = GetRecords(Nested, Out.SceneLights, 26, GetSceneLight);
+                break;
+            default:
+                Out.Other.push_back(RawPacket{Id, std::string(Body, PacketSize)});
+                continue;
+            }
+            if (!bValid || Nested.Remaining() != 0)
+                Stats.Mismatched++;
+        }
+    }
+
+    void ParseCompactPositions(DReyeVRCompactReader &In, FrameData &Out)
+    {
+        if (!PositionDecoder.Decode(In, CompactPositions))
+        {
+            Stats.Undecodable++;
+            return;
+        }
+        Out.Positions.reserve(Out.Positions.size() + CompactPositions.size());
+        for (const DReyeVRCompactPosition &Compact : CompactPositions)
+        {
+            struct Position Pos;
+            Pos.DatabaseId = Compact.DatabaseId;
+            Pos.Location = {Compact.Location[0], Compact.Location[1], Compact.Location[2]};
+            Pos.Rotation = {Compact.Rotation[0], Compact.Rotation[1], Compact.Rotation[2]};
+            Out.Positions.push_back(Pos);
+        }
+    }
+
+    void ParseCompactDReyeVR(DReyeVRCompactReader &In, FrameData &Out)
+    {
+        bool bDecoded = FieldDecoder.BeginPacket(In);
+        const uint64_t Total = In.Varint();
+        for (uint64_t i = 0; i < Total && bDecoded; i++)
+        {
+            AggregateData Data;
+            FieldDecoder.BeginRecord(In);
+            VisitAggregate(Data, FieldDecoder);
+            bDecoded = FieldDecoder.EndRecord();
+            if (bDecoded)
+                Out.DReyeVR.push_back(std::move(Data));
+        }
+        if (!bDecoded)
+            Stats.Undecodable++;
+    }
+
+    void ParseEyeSamples(DReyeVRCompactReader &In, FrameData &Out)
+    {
+        bool bDecoded = EyeSampleDecoder.BeginPacket(In);
+        const uint64_t Total = In.Varint();
+        for (uint64_t i = 0; i < Total && bDecoded; i++)
+        {
+            EyeTracker Sample;
+            EyeSampleDecoder.BeginRecord(In);
+            VisitEyeTracker(Sample, EyeSampleDecoder);
+            bDecoded = EyeSampleDecoder.EndRecord();
+            if (bDecoded)
+                Out.EyeSamples.push_back(Sample);
+        }
+        if (!bDecoded)
+            Stats.Undecodable++;
+    }
+
+    // DReyeVR::CustomActorDecoder::Decode
+    void ParseInternedCustomActors(DReyeVRCompactReader &In, FrameData &Out)
+    {
+        const uint8_t Flags = In.Raw<uint8_t>();
+        if (Flags & DREYEVR_COMPACT_FLAG_RESET)
+        {
+            Strings.Reset();
+            LastActors.clear();
+            bActorsSynced = true;
+        }
+        bActorsSynced = bActorsSynced && Strings.ReadDefinitions(In);
+        const uint64_t Num = bActorsSynced ? In.Varint() : 0;
+        for (uint64_t n = 0; n < Num && bActorsSynced; n++)
+        {
+            const uint32_t NameId = static_cast<uint32_t>(In.Varint());
+            const std::string *Name = Strings.Get(NameId);
+            if (Name == nullptr)
+            {
+                bActorsSynced = false;
+                break;
+            }
+            CustomActorData &Actor = LastActors[NameId];
+            Actor.Name = *Name;
+            bActorsSynced = GetInternedCustomActor(In, Strings, Actor);
+            Out.CustomActors.push_back(Actor);
+        }
+        if (!bActorsSynced)
+            Stats.Undecodable++;
+    }
+
+    // parses the body of one packet into Out, false if its contents do not match its size
+    bool ParsePacket(PacketId Id, DReyeVRCompactReader &In, FrameData &Out)
+    {
+        switch (Id)
+        {
+        case PacketId::EventAdd:
+            return GetVariableRecords(In, Out.Adds, GetEventAdd);
+        case PacketId::EventDel:
+            return GetRecords(In, Out.Dels, 4, [](DReyeVRCompactReader &R, struct EventDel &E) { Get(R, E.DatabaseId); });
+        case PacketId::EventParent:
+            return GetRecords(In, Out.Parents, 8, [](DReyeVRCompactReader &R, struct EventParent &E) {
+                Get(R, E.DatabaseId);
+                Get(R, E.ParentId);
+            });
+        case PacketId::Collision: {
+            // hero flags as two bools, or one bit field in some Carla versions
+            const uint16_t Total = In.Raw<uint16_t>();
+            const size_t RecordSize = Total > 0 ? In.Remaining() / Total : 0;
+            if (Total > 0 && (RecordSize < 13 || RecordSize > 14 || In.Remaining() != Total * RecordSize))
+                return false;
+            for (uint16_t i = 0; i < Total; i++)
+            {
+                struct Collision C;
+                Get(In, C.Id);
+                Get(In, C.DatabaseId1);
+                Get(In, C.DatabaseId2);
+                if (RecordSize == 14)
+                {
+                    Get(In, C.IsActor1Hero);
+                    Get(In, C.IsActor2Hero);
+                }
+                else
+                {
+                    const uint8_t Flags = In.Raw<uint8_t>();
+                    C.IsActor1Hero = Flags & 1;
+                    C.IsActor2Hero = Flags & 2;
+                }
+                Out.Collisions.push_back(C);
+            }
+            return !In.Failed();
+        }
+        case PacketId::Position:
+            return GetRecords(In, Out.Positions, 28, [](DReyeVRCompactReader &R, struct Position &P) {
+                Get(R, P.DatabaseId);
+                Get(R, P.Location);
+                Get(R, P.Rotation);
+            });
+        case PacketId::State:
+            return GetRecords(In, Out.TrafficLights, 10, [](DReyeVRCompactReader &R, TrafficLightState &S) {
+                Get(R, S.DatabaseId);
+                Get(R, S.IsFrozen);
+                Get(R, S.ElapsedTime);
+                Get(R, S.State);
+            });
+        case PacketId::AnimVehicle:
+            return GetRecords(In, Out.Vehicles, 21, [](DReyeVRCompactReader &R, VehicleAnimation &V) {
+                Get(R, V.DatabaseId);
+                Get(R, V.Steering);
+                Get(R, V.Throttle);
+                Get(R, V.Brake);
+                Get(R, V.Handbrake);
+                Get(R, V.Gear);
+            });
+        case PacketId::AnimWalker:
+            return GetRecords(In, Out.Walkers, 8, [](DReyeVRCompactReader &R, WalkerAnimation &W) {
+                Get(R, W.DatabaseId);
+                Get(R, W.Speed);
+            });
+        case PacketId::VehicleLight:
+            return GetRecords(In, Out.VehicleLights, 8, [](DReyeVRCompactReader &R, VehicleLightState &L) {
+                Get(R, L.DatabaseId);
+                Get(R, L.State);
+            });
+        case PacketId::SceneLight:
+            return GetRecords(In, Out.SceneLights, 26, GetSceneLight);
+        case PacketId::Kinematics:
+            return GetRecords(In, Out.Kinematics, 28, [](DReyeVRCompactReader &R, ActorKinematics &K) {
+                Get(R, K.DatabaseId);
+                Get(R, K.LinearVelocity);
+                Get(R, K.AngularVelocity);
+            });
+        case PacketId::BoundingBox:
+        case PacketId::TriggerVolume:
+            return GetRecords(In, Id == PacketId::BoundingBox ? Out.BoundingBoxes : Out.TriggerVolumes, 28,
+                              [](DReyeVRCompactReader &R, ActorBoundingBox &B) {
+                                  Get(R, B.DatabaseId);
+                                  Get(R, B.Origin);
+                                  Get(R, B.Extent);
+                              });
+        case PacketId::PlatformTime:
+            Out.PlatformTime = In.Raw<double>();
+            return !In.Failed();
+        case PacketId::TrafficLightTime:
+            return GetRecords(In, Out.TrafficLightTimes, 16, [](DReyeVRCompactReader &R, TrafficLightTime &T) {
+                Get(R, T.DatabaseId);
+                Get(R, T.GreenTime);
+                Get(R, T.YellowTime);
+                Get(R, T.RedTime);
+            });
+        case PacketId::DReyeVR:
+            return GetVariableRecords(In, Out.DReyeVR, GetAggregate);
+        case PacketId::DReyeVRCustomActor:
+            return GetVariableRecords(In, Out.CustomActors, GetCustomActor);
+        case PacketId::DReyeVRConfigFile: {
+            std::vector<std::string> Configs;
+            const bool bValid = GetVariableRecords(In, Configs, [](DReyeVRCompactReader &R, std::string &S) { Get(R, S); });
+            for (std::string &Config : Configs)
+                Out.ConfigFile = Out.ConfigFile.value_or("") + Config;
+            return bValid;
+        }
+        case PacketId::DReyeVRKeyframe:
+            Out.KeyframeData.emplace();
+            ParseKeyframe(In, *Out.KeyframeData);
+            return !In.Failed();
+        case PacketId::DReyeVRCompactPosition:
+            ParseCompactPositions(In, Out);
+            return true; // (undecodable packets are counted separately)
+        case PacketId::DReyeVRCompactDReyeVR:
+            ParseCompactDReyeVR(In, Out);
+            return true;
+        case PacketId::DReyeVRInternedCustomActor:
+            ParseInternedCustomActors(In, Out);
+            return true;
+        case PacketId::DReyeVREyeSamples:
+            ParseEyeSamples(In, Out);
+            return true;
+        case PacketId::DReyeVRGazeTraces:
+            return GetVariableRecords(In, Out.GazeTraceData, [](DReyeVRCompactReader &R, GazeTraces &G) {
+                Get(R, G.IssuedFrame);
+                Get(R, G.ConsumedFrame);
+                Get(R, G.bAsync);
+                GetFocus(R, G.Left);
+                GetFocus(R, G.Right);
+            });
+        case PacketId::DReyeVRFixations:
+            return GetVariableRecords(In, Out.Fixations, GetFixations);
+        case PacketId::DReyeVRDwell: // (not part of a frame)
+            return ParseDwell(In);
+        default: // weather, physics control, unknown
+            Out.Raw.push_back(RawPacket{Id, std::string(In.View(In.Remaining()), In.Remaining())});
+            return true;
+        }
+    }
+};
+
+RecordingReader::RecordingReader() : Impl(new FImpl)
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    Close();
+}
+
+bool RecordingReader::Open(const std::string &Filename)
+{
+    Close();
+#if DREYEVR_REC_MMAP
+    const int Fd = open(Filename.c_str(), O_RDONLY);
+    struct stat Stat;
+    if (Fd >= 0 && fstat(Fd, &Stat) == 0 && Stat.st_size > 0)
+    {
+        void *Mapped = mmap(nullptr, static_cast<size_t>(Stat.st_size), PROT_READ, MAP_PRIVATE, Fd, 0);
+        if (Mapped != MAP_FAILED)
+        {
+            madvise(Mapped, static_cast<size_t>(Stat.st_size), MADV_SEQUENTIAL);
+            Impl->Mapped = Mapped;
+            Impl->Data = static_cast<const char *>(Mapped);
+            Impl->Size = static_cast<size_t>(Stat.st_size);
+        }
+    }
+    if (Fd >= 0)
+        close(Fd);
+#endif
+    if (Impl->Data == nullptr)
+    {
+        std::ifstream In(Filename, std::ios::binary);
+        if (!In)
+        {
+            Impl->Error = "could not open " + Filename;
+            return false;
+        }
+        Impl->Owned.assign(std::istreambuf_iterator<char>(In), std::istreambuf_iterator<char>());
+        Impl->Data = Impl->Owned.data();
+        Impl->Size = Impl->Owned.size();
+    }
+    if (!Impl->ParseInfo())
+    {
+        const std::string Error = Impl->Error;
+        Close();
+        Impl->Error = Error;
+        return false;
+    }
+    Impl->LoadIndex();
+    Impl->ResetState();
+    return true;
+}
+
+bool RecordingReader::OpenBuffer(const char *Data, size_t Size)
+{
+    Close();
+    Impl->Data = Data;
+    Impl->Size = Size;
+    if (!Impl->ParseInfo())
+    {
+        Impl->Data = nullptr;
+        Impl->Size = 0;
+        return false;
+    }
+    Impl->LoadIndex();
+    Impl->ResetState();
+    return true;
+}
+
+void RecordingReader::Close()
+{
+    Impl->Unmap();
+    Impl->Header = Info();
+    Impl->Index = FrameIndex();
+    Impl->Dwell.reset();
+    Impl->Error.clear();
+    Impl->FirstPacket = 0;
+    Impl->ResetState();
+}
+
+const Info &RecordingReader::GetInfo() const
+{
+    return Impl->Header;
+}
+
+const std::string &RecordingReader::GetError() const
+{
+    return Impl->Error;
+}
+
+const FrameIndex &RecordingReader::GetFrameIndex() const
+{
+    return Impl->Index;
+}
+
+const std::optional<DwellData> &RecordingReader::GetDwell() const
+{
+    return Impl->Dwell;
+}
+
+const FileStats &RecordingReader::GetStats() const
+{
+    return Impl->Stats;
+}
+
+uint64_t RecordingReader::GetSize() const
+{
+    return Impl->Size;
+}
+
+uint64_t RecordingReader::GetPosition() const
+{
+    return Impl->Pos;
+}
+
+void RecordingReader::Rewind()
+{
+    Impl->ResetState();
+}
+
+bool RecordingReader::Seek(uint64_t Offset)
+{
+    FImpl &R = *Impl;
+    if (R.Data == nullptr || Offset < R.FirstPacket || Offset + HeaderSize > R.Size ||
+        static_cast<PacketId>(R.Data[Offset]) != PacketId::FrameStart)
+        return false;
+    R.ResetState();
+    R.Pos = static_cast<size_t>(Offset);
+    return true;
+}
+
+bool RecordingReader::NextFrame(FrameData &Out)
+{
+    FImpl &R = *Impl;
+    Out.Clear();
+    bool bInFrame = false;
+    while (R.Data != nullptr && R.Pos < R.Size)
+    {
+        if (R.Size - R.Pos < HeaderSize)
+        {
+            R.Stats.bTruncated = true;
+            R.Pos = R.Size;
+            break;
+        }
+        const size_t PacketStart = R.Pos;
+        const PacketId Id = static_cast<PacketId>(R.Data[R.Pos]);
+        uint32_t PacketSize = 0;
+        std::memcpy(&PacketSize, R.Data + R.Pos + 1, sizeof(PacketSize));
+        if (PacketSize > R.Size - R.Pos - HeaderSize)
+        {
+            R.Stats.bTruncated = true; // (interrupted recording)
+            R.Pos = R.Size;
+            break;
+        }
+        if (Id == PacketId::FrameStart && bInFrame)
+            return true; // frame without a FrameEnd, this packet starts the next one
+
+        R.Pos += HeaderSize + PacketSize;
+        PacketStats &Stats = R.Stats.Packets[static_cast<uint8_t>(Id)];
+        Stats.Count++;
+        Stats.Bytes += HeaderSize + PacketSize;
+
+        DReyeVRCompactReader In(R.Data + PacketStart + HeaderSize, PacketSize);
+        if (Id == PacketId::FrameStart)
+        {
+            Get(In, Out.Header.Id);
+            Get(In, Out.Header.Duration);
+            Get(In, Out.Header.Elapsed);
+            Out.Offset = PacketStart;
+            bInFrame = true;
+        }
+        else if (Id == PacketId::FrameEnd)
+        {
+            if (bInFrame)
+                return true;
+        }
+        else if (Id == PacketId::DReyeVRFrameIndex)
+        {
+            continue; // (loaded on Open)
+        }
+        else if (!R.ParsePacket(Id, In, Out))
+        {
+            R.Stats.Mismatched++;
+            continue;
+        }
+        if (In.Failed() || In.Remaining() != 0)
+            R.Stats.Mismatched++;
+    }
+    return bInFrame;
+}
+
+} // namespace DReyeVRRec
@@ -0,0 +1,518 @@
+#pragma once
+
+#include <array>    // std::array
+#include <cstdint>  // uint64_t
+#include <map>      // std::map
+#include <memory>   // std::unique_ptr
+#include <optional> // std::optional
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+// Unreal-free reader (and minimal writer) for DReyeVR/Carla recordings (.rec)
+//
+// Plain structs mirror the packets written by ACarlaRecorder (see CarlaRecorderPacketId), including the DReyeVR
+// packets (sensor data, custom actors, config files, frame index, keyframes, compact and interned packets), so
+// recordings can be analyzed without UE4. Every packet is checked against the size in its header: a packet whose
+// layout does not match (ex. from a newer Carla) is counted in FileStats::Mismatched and skipped, never misread.
+
+namespace DReyeVRRec
+{
+
+/// ========================================== ///
+/// ----------------:PACKETS:----------------- ///
+/// ========================================== ///
+
+enum class PacketId : uint8_t
+{
+    FrameStart = 0,
+    FrameEnd,
+    EventAdd,
+    EventDel,
+    EventParent,
+    Collision,
+    Position,
+    State,
+    AnimVehicle,
+    AnimWalker,
+    VehicleLight,
+    SceneLight,
+    Kinematics,
+    BoundingBox,
+    PlatformTime,
+    PhysicsControl,
+    TrafficLightTime,
+    TriggerVolume,
+    Weather,
+    // DReyeVR (see CarlaRecorder.h, DReyeVRRecorderIndex.h, DReyeVRRecorderCodec.h)
+    DReyeVR = 139,
+    DReyeVRCustomActor = 140,
+    DReyeVRConfigFile = 141,
+    DReyeVRFrameIndex = 142,
+    DReyeVRKeyframe = 143,
+    DReyeVRCompactPosition = 144,
+    DReyeVRCompactDReyeVR = 145,
+    DReyeVRInternedCustomActor = 146,
+    DReyeVREyeSamples = 147,
+    DReyeVRGazeTraces = 148,
+    DReyeVRFixations = 149,
+    DReyeVRDwell = 150,
+};
+
+const char *GetPacketName(uint8_t Id);
+
+struct Vec2
+{
+    float X = 0.f, Y = 0.f;
+};
+
+struct Vec3
+{
+    float X = 0.f, Y = 0.f, Z = 0.f;
+};
+
+struct Rot
+{
+    float Pitch = 0.f, Roll = 0.f, Yaw = 0.f; // (order they are written in)
+};
+
+struct Color
+{
+    float R = 0.f, G = 0.f, B = 0.f, A = 0.f;
+};
+
+// CarlaRecorderInfo
+struct Info
+{
+    uint16_t Version = 0;
+    std::string Magic; // "CARLA_RECORDER"
+    int64_t Date = 0;  // std::time_t
+    std::string Map;
+};
+
+// CarlaRecorderFrame
+struct Frame
+{
+    uint64_t Id = 0;
+    double Duration = 0.0;
+    double Elapsed = 0.0;
+};
+
+struct ActorAttribute
+{
+    uint8_t Type = 0;
+    std::string Id;
+    std::string Value;
+};
+
+struct EventAdd
+{
+    uint32_t DatabaseId = 0;
+    uint8_t Type = 0; // other, vehicle, walker, traffic light...
+    Vec3 Location;
+    Vec3 Rotation;
+    uint32_t UId = 0;
+    std::string Id; // blueprint id
+    std::vector<ActorAttribute> Attributes;
+};
+
+struct EventDel
+{
+    uint32_t DatabaseId = 0;
+};
+
+struct EventParent
+{
+    uint32_t DatabaseId = 0;
+    uint32_t ParentId = 0;
+};
+
+struct Collision
+{
+    uint32_t Id = 0;
+    uint32_t DatabaseId1 = 0;
+    uint32_t DatabaseId2 = 0;
+    bool IsActor1Hero = false;
+    bool IsActor2Hero = false;
+};
+
+struct Position
+{
+    uint32_t DatabaseId = 0;
+    Vec3 Location;
+    Vec3 Rotation; // X=roll, Y=pitch, Z=yaw (as CarlaRecorderPosition)
+};
+
+struct TrafficLightState
+{
+    uint32_t DatabaseId = 0;
+    bool IsFrozen = false;
+    float ElapsedTime = 0.f;
+    char State = 0;
+};
+
+struct VehicleAnimation
+{
+    uint32_t DatabaseId = 0;
+    float Steering = 0.f;
+    float Throttle = 0.f;
+    float Brake = 0.f;
+    bool Handbrake = false;
+    int32_t Gear = 0;
+};
+
+struct WalkerAnimation
+{
+    uint32_t DatabaseId = 0;
+    float Speed = 0.f;
+};
+
+struct VehicleLightState
+{
+    uint32_t DatabaseId = 0;
+    uint32_t State = 0; // bit flags
+};
+
+struct SceneLightState
+{
+    int32_t LightId = 0;
+    float Intensity = 0.f;
+    Color LightColor;
+    bool On = false;
+    uint8_t Type = 0;
+};
+
+struct ActorKinematics
+{
+    uint32_t DatabaseId = 0;
+    Vec3 LinearVelocity;
+    Vec3 AngularVelocity;
+};
+
+struct ActorBoundingBox
+{
+    uint32_t DatabaseId = 0;
+    Vec3 Origin;
+    Vec3 Extent;
+};
+
+struct TrafficLightTime
+{
+    uint32_t DatabaseId = 0;
+    float GreenTime = 0.f;
+    float YellowTime = 0.f;
+    float RedTime = 0.f;
+};
+
+// packets kept as bytes (layouts that change between Carla versions: weather, physics control)
+struct RawPacket
+{
+    PacketId Id = PacketId::FrameStart;
+    std::string Bytes;
+};
+
+/// ========================================== ///
+/// ----------------:DREYEVR:----------------- ///
+/// ========================================== ///
+
+// DReyeVR::EyeData, CombinedEyeData, SingleEyeData
+struct EyeData
+{
+    Vec3 GazeDir;
+    Vec3 GazeOrigin;
+    bool GazeValid = false;
+};
+
+struct CombinedEyeData : EyeData
+{
+    float Vergence = 0.f; // cm
+};
+
+struct SingleEyeData : EyeData
+{
+    float EyeOpenness = 0.f;
+    bool EyeOpennessValid = false;
+    float PupilDiameter = 0.f; // mm
+    Vec2 PupilPosition;
+    bool PupilPositionValid = false;
+};
+
+// DReyeVR::EgoVariables
+struct EgoVariables
+{
+    Vec3 CameraLocation;
+    Rot CameraRotation;
+    Vec3 CameraLocationAbs;
+    Rot CameraRotationAbs;
+    Vec3 VehicleLocation;
+    Rot VehicleRotation;
+    float Velocity = 0.f; // cm/s
+};
+
+// DReyeVR::EyeTracker
+struct EyeTracker
+{
+    int64_t TimestampDevice = 0;
+    int64_t FrameSequence = 0;
+    CombinedEyeData Combined;
+    SingleEyeData Left;
+    SingleEyeData Right;
+};
+
+// DReyeVR::FocusInfo
+struct FocusInfo
+{
+    std::string ActorNameTag;
+    bool bDidHit = false;
+    Vec3 HitPoint;
+    Vec3 Normal;
+    float Distance = 0.f;
+};
+
+// DReyeVR::GazeTraces (packet 148)
+struct GazeTraces
+{
+    uint64_t IssuedFrame = 0;   // game frame the focus of this frame was traced on
+    uint64_t ConsumedFrame = 0; // game frame it became the focus on (ConsumedFrame - IssuedFrame is the latency)
+    bool bAsync = false;        // ([EgoSensor] AsyncFocusTrace)
+    FocusInfo Left;
+    FocusInfo Right;
+};
+
+// DReyeVR::FixationEvent
+struct FixationEvent
+{
+    bool bStart = false; // a fixation started (else it ended)
+    int64_t Start = 0;   // device timestamp (ms) of its first eye-tracker reading
+    int64_t End = 0;     // and of its last one
+    Vec2 Direction;      // mean combined gaze yaw and pitch (degrees)
+    std::string ActorNameTag;
+};
+
+// DReyeVR::FixationData (packet 149)
+struct FixationData
+{
+    bool bFixating = false;
+    FixationEvent Current;             // the ongoing fixation, or the last one
+    std::vector<FixationEvent> Events; // fixations that started or ended this frame
+};
+
+// DReyeVRDwellStats (see DReyeVRDwellAccumulator.h), timestamps are TimestampCarla (ms)
+struct DwellStats
+{
+    uint32_t ActorId = 0; // Carla actor id
+    uint32_t NumGlances = 0;
+    uint32_t NumFixations = 0;
+    int64_t TotalDwell = 0; // ms
+    int64_t FirstGlance = -1;
+    int64_t FirstFixation = -1; // (-1 if none)
+    int64_t LastGlance = -1;
+    int64_t LongestGlance = 0; // ms
+};
+
+// DReyeVR::DwellData (packet 150, once at the end of the recording before the frame index)
+struct DwellData
+{
+    std::vector<DwellStats> Actors;
+    int64_t UntrackedDwell = 0; // ms of gaze on no Carla actor
+    int64_t DroppedDwell = 0;   // ms of gaze on actors beyond [EgoSensor] DwellMaxActors
+    uint64_t NumDroppedActors = 0;
+};
+
+// DReyeVR::UserInputs
+struct UserInputs
+{
+    float Throttle = 0.f;
+    float Steering = 0.f;
+    float Brake = 0.f;
+    bool ToggledReverse = false;
+    bool TurnSignalLeft = false;
+    bool TurnSignalRight = false;
+    bool HoldHandbrake = false;
+};
+
+// DReyeVR::AggregateData (packets 139 and 145)
+struct AggregateData
+{
+    int64_t TimestampCarla = 0; // ms
+    EgoVariables EgoVars;
+    EyeTracker EyeTrackerData;
+    FocusInfo FocusData;
+    UserInputs Inputs;
+};
+
+// DReyeVR::CustomActorData (packets 140 and 146)
+struct CustomActorData
+{
+    std::string Name;
+    Vec3 Location;
+    Rot Rotation;
+    Vec3 Scale3D;
+    std::string MeshPath;
+    float Metallic = 1.f;
+    float Specular = 0.f;
+    float Roughness = 1.f;
+    float Anisotropy = 1.f;
+    float Opacity = 1.f;
+    Color BaseColor;
+    Color Emissive;
+    std::string MaterialPath;
+    std::string Other;
+};
+
+// DReyeVR keyframe (packet 143): the live actor set when it was written
+struct Keyframe
+{
+    std::vector<EventAdd> Actors;
+    std::vector<EventParent> Parents;
+    std::vector<SceneLightState> SceneLights;
+    std::vector<RawPacket> Other; // (weather)
+};
+
+// trailing frame offset index (packet 142)
+struct FrameIndexEntry
+{
+    uint64_t FrameId = 0;
+    double Elapsed = 0.0;
+    uint64_t Offset = 0;
+};
+
+struct FrameIndex
+{
+    uint16_t Version = 0;
+    std::vector<FrameIndexEntry> Frames;
+    std::vector<std::pair<uint32_t, uint64_t>> Keyframes; // (frame number, packet offset)
+};
+
+// everything recorded in one frame (FrameStart ... FrameEnd)
+struct FrameData
+{
+    Frame Header;
+    uint64_t Offset = 0; // of the FrameStart packet
+    std::vector<EventAdd> Adds;
+    std::vector<EventDel> Dels;
+    std::vector<EventParent> Parents;
+    std::vector<Collision> Collisions;
+    std::vector<Position> Positions;
+    std::vector<TrafficLightState> TrafficLights;
+    std::vector<VehicleAnimation> Vehicles;
+    std::vector<WalkerAnimation> Walkers;
+    std::vector<VehicleLightState> VehicleLights;
+    std::vector<SceneLightState> SceneLights;
+    std::vector<ActorKinematics> Kinematics;
+    std::vector<ActorBoundingBox> BoundingBoxes;
+    std::vector<ActorBoundingBox> TriggerVolumes;
+    std::optional<double> PlatformTime;
+    std::vector<TrafficLightTime> TrafficLightTimes;
+    std::vector<AggregateData> DReyeVR;
+    std::vector<EyeTracker> EyeSamples; // every eye-tracker reading since the previous frame (packet 147)
+    std::vector<GazeTraces> GazeTraceData;
+    std::vector<FixationData> Fixations;
+    std::vector<CustomActorData> CustomActors;
+    std::optional<std::string> ConfigFile;
+    std::optional<Keyframe> KeyframeData;
+    std::vector<RawPacket> Raw; // weather, physics control and unknown packets
+
+    void Clear();
+};
+
+struct PacketStats
+{
+    uint64_t Count = 0;
+    uint64_t Bytes = 0; // including the packet headers
+};
+
+struct FileStats
+{
+    std::map<uint8_t, PacketStats> Packets;
+    uint64_t Mismatched = 0;   // packets whose contents did not match their size (skipped)
+    uint64_t Undecodable = 0;  // compact/interned packets that could not be decoded (no reset packet before them)
+    bool bTruncated = false;   // the file ends in the middle of a packet
+};
+
+/// ========================================== ///
+/// ----------------:READER:------------------ ///
+/// ========================================== ///
+
+class RecordingReader
+{
+  public:
+    RecordingReader();
+    ~RecordingReader();
+    RecordingReader(const RecordingReader &) = delete;
+    RecordingReader &operator=(const RecordingReader &) = delete;
+
+    // maps (or reads) the whole file and parses its info header, false with GetError() otherwise
+    bool Open(const std::string &Filename);
+    // parses a recording that is already in memory (Data must outlive the reader)
+    bool OpenBuffer(const char *Data, size_t Size);
+    void Close();
+
+    const Info &GetInfo() const;
+    const std::string &GetError() const;
+
+    // parses the next frame (all of its packets), false at the end of the recording
+    bool NextFrame(FrameData &Out);
+
+    // back to the first frame
+    void Rewind();
+
+    // continues from the frame whose FrameStart packet is at Offset (ex. from the frame index), false if there is
+    // none. Like the replayer, compact packets can only be decoded after seeking to the first frame or a keyframe
+    bool Seek(uint64_t Offset);
+
+    // the trailing frame index (loaded on Open), empty for recordings without one
+    const FrameIndex &GetFrameIndex() const;
+
+    // the per-actor dwell statistics written when the recording stopped: loaded on Open along with the frame
+    // index, or once NextFrame reached them (empty for recordings without them)
+    const std::optional<DwellData> &GetDwell() const;
+
+    // statistics of the packets read so far
+    const FileStats &GetStats() const;
+
+    uint64_t GetSize() const;
+    uint64_t GetPosition() const;
+
+  private:
+    struct FImpl;
+    std::unique_ptr<FImpl> Impl;
+};
+
+/// ========================================== ///
+/// ----------------:WRITER:------------------ ///
+/// ========================================== ///
+
+// writes recordings with the same layout as ACarlaRecorder (for tests and synthetic data)
+class RecordingWriter
+{
+  public:
+    struct Options
+    {
+        bool bCompact = false;           // packets 144/145 instead of 6/139 ([Recorder] CompactEncoding)
+        bool bInternCustomActors = false; // packet 146 instead of 140 ([Recorder] InternCustomActors)
+        bool bEyeSamples = false;         // packet 147 in every frame ([Recorder] EyeSamples)
+        bool bGazeTraces = false;         // packet 148 in every frame ([Recorder] GazeTraces)
+        bool bFixations = false;          // packet 149 in every frame ([Recorder] Fixations)
+        bool bFrameIndex = true;         // trailing frame index on Close
+        float LocationPrecision = 0.1f;
+        float RotationPrecision = 0.01f;
+        float UnitPrecision = 0.0001f;
+    };
+
+    RecordingWriter();
+    ~RecordingWriter();
+
+    bool Open(const std::string &Filename, const Info &Header, const Options &Opts);
+    bool Open(const std::string &Filename, const Info &Header);
+    // writes one frame (the packets ACarlaRecorder writes, for the fields that are set)
+    void WriteFrame(const FrameData &Data);
+    // packet 150 written on Close, before the frame index ([Recorder] Dwell)
+    void SetDwell(const DwellData &Dwell);
+    void Close();
+
+  private:
+    struct FImpl;
+    std::unique_ptr<FImpl> Impl;
+};
+
+} // namespace DReyeVRRec
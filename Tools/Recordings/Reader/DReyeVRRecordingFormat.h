@@ -0,0 +1,214 @@
+#pragma once
+
+// internals shared by the reader and the writer (not part of the library interface)
+
+#include "DReyeVRRecording.h"
+#include "DReyeVRRecorderCodec.h" // compact/interned packets, same code as the recorder
+
+#include <cstring> // std::memcpy
+#include <string>  // std::string
+
+namespace DReyeVRRec
+{
+namespace Format
+{
+
+constexpr size_t HeaderSize = sizeof(char) + sizeof(uint32_t); // packet id + size
+
+// DReyeVRRecorderIndex.h
+constexpr char IndexMagic[] = "DRVRIDX1";
+constexpr size_t IndexMagicSize = 8;
+constexpr size_t IndexFooterSize = sizeof(uint64_t) + IndexMagicSize;
+
+// fields of an interned custom actor record (same bits as DReyeVRData.cpp)
+enum CustomActorField : uint32_t
+{
+    CA_LOCATION = 1 << 0,
+    CA_ROTATION = 1 << 1,
+    CA_SCALE3D = 1 << 2,
+    CA_MESH_PATH = 1 << 3,
+    CA_MATERIAL_SCALARS = 1 << 4,
+    CA_BASE_COLOR = 1 << 5,
+    CA_EMISSIVE = 1 << 6,
+    CA_MATERIAL_PATH = 1 << 7,
+    CA_OTHER = 1 << 8,
+    CA_ALL = (1 << 9) - 1,
+};
+
+/// ----------------:READING:----------------- ///
+
+inline void Get(DReyeVRCompactReader &In, std::string &Out) // FString: uint16 length + UTF8
+{
+    const uint16_t Length = In.Raw<uint16_t>();
+    const char *Text = In.View(Length);
+    if (Text != nullptr)
+        Out.assign(Text, Length);
+    else
+        Out.clear();
+}
+
+template <typename T> inline void Get(DReyeVRCompactReader &In, T &Out)
+{
+    Out = In.Raw<T>();
+}
+
+inline void Get(DReyeVRCompactReader &In, Vec2 &Out)
+{
+    Get(In, Out.X);
+    Get(In, Out.Y);
+}
+
+inline void Get(DReyeVRCompactReader &In, Vec3 &Out)
+{
+    Get(In, Out.X);
+    Get(In, Out.Y);
+    Get(In, Out.Z);
+}
+
+inline void Get(DReyeVRCompactReader &In, Rot &Out)
+{
+    Get(In, Out.Pitch);
+    Get(In, Out.Roll);
+    Get(In, Out.Yaw);
+}
+
+// ReadFLinearColor (A, B, G, R)
+inline void GetColorABGR(DReyeVRCompactReader &In, Color &Out)
+{
+    Get(In, Out.A);
+    Get(In, Out.B);
+    Get(In, Out.G);
+    Get(In, Out.R);
+}
+
+// raw FLinearColor (R, G, B, A)
+inline void GetColorRGBA(DReyeVRCompactReader &In, Color &Out)
+{
+    Get(In, Out.R);
+    Get(In, Out.G);
+    Get(In, Out.B);
+    Get(In, Out.A);
+}
+
+/// ----------------:WRITING:----------------- ///
+
+template <typename T> inline void Put(std::string &Out, const T &Value)
+{
+    Out.append(reinterpret_cast<const char *>(&Value), sizeof(T));
+}
+
+inline void Put(std::string &Out, const std::string &Str)
+{
+    Put<uint16_t>(Out, static_cast<uint16_t>(Str.size()));
+    Out.append(Str);
+}
+
+inline void Put(std::string &Out, const Vec2 &V)
+{
+    Put(Out, V.X);
+    Put(Out, V.Y);
+}
+
+inline void Put(std::string &Out, const Vec3 &V)
+{
+    Put(Out, V.X);
+    Put(Out, V.Y);
+    Put(Out, V.Z);
+}
+
+inline void Put(std::string &Out, const Rot &R)
+{
+    Put(Out, R.Pitch);
+    Put(Out, R.Roll);
+    Put(Out, R.Yaw);
+}
+
+inline void PutColorABGR(std::string &Out, const Color &C)
+{
+    Put(Out, C.A);
+    Put(Out, C.B);
+    Put(Out, C.G);
+    Put(Out, C.R);
+}
+
+inline void PutColorRGBA(std::string &Out, const Color &C)
+{
+    Put(Out, C.R);
+    Put(Out, C.G);
+    Put(Out, C.B);
+    Put(Out, C.A);
+}
+
+/// -------------:COMPACT FIELDS:------------- ///
+
+// same field order as DReyeVR::AggregateData::VisitCompact (DReyeVRData.cpp)
+template <typename VecT, typename CodecT> void VisitVec3(VecT &V, CodecT &Codec, DReyeVRCompactPrecision::Kind Kind)
+{
+    Codec.Float(V.X, Kind);
+    Codec.Float(V.Y, Kind);
+    Codec.Float(V.Z, Kind);
+}
+
+template <typename RotT, typename CodecT> void VisitRot(RotT &R, CodecT &Codec)
+{
+    Codec.Float(R.Pitch, DReyeVRCompactPrecision::ROTATION);
+    Codec.Float(R.Roll, DReyeVRCompactPrecision::ROTATION);
+    Codec.Float(R.Yaw, DReyeVRCompactPrecision::ROTATION);
+}
+
+template <typename EyeT, typename CodecT> void VisitEye(EyeT &Eye, CodecT &Codec)
+{
+    VisitVec3(Eye.GazeDir, Codec, DReyeVRCompactPrecision::UNIT);
+    VisitVec3(Eye.GazeOrigin, Codec, DReyeVRCompactPrecision::LOCATION);
+    Codec.Bool(Eye.GazeValid);
+}
+
+template <typename EyeT, typename CodecT> void VisitSingleEye(EyeT &Eye, CodecT &Codec)
+{
+    VisitEye(Eye, Codec);
+    Codec.Float(Eye.EyeOpenness, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Eye.EyeOpennessValid);
+    Codec.Float(Eye.PupilDiameter, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Eye.PupilPosition.X, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Eye.PupilPosition.Y, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Eye.PupilPositionValid);
+}
+
+// DReyeVR::EyeTracker::VisitCompact (also the records of packet 147)
+template <typename DataT, typename CodecT> void VisitEyeTracker(DataT &Data, CodecT &Codec)
+{
+    Codec.Int(Data.TimestampDevice);
+    Codec.Int(Data.FrameSequence);
+    VisitEye(Data.Combined, Codec);
+    Codec.Float(Data.Combined.Vergence, DReyeVRCompactPrecision::LOCATION);
+    VisitSingleEye(Data.Left, Codec);
+    VisitSingleEye(Data.Right, Codec);
+}
+
+template <typename DataT, typename CodecT> void VisitAggregate(DataT &Data, CodecT &Codec)
+{
+    Codec.Int(Data.TimestampCarla);
+    VisitVec3(Data.EgoVars.CameraLocation, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitRot(Data.EgoVars.CameraRotation, Codec);
+    VisitVec3(Data.EgoVars.CameraLocationAbs, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitRot(Data.EgoVars.CameraRotationAbs, Codec);
+    VisitVec3(Data.EgoVars.VehicleLocation, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitRot(Data.EgoVars.VehicleRotation, Codec);
+    Codec.Float(Data.EgoVars.Velocity, DReyeVRCompactPrecision::LOCATION);
+    VisitEyeTracker(Data.EyeTrackerData, Codec);
+    Codec.String(Data.FocusData.ActorNameTag);
+    Codec.Bool(Data.FocusData.bDidHit);
+    VisitVec3(Data.FocusData.HitPoint, Codec, DReyeVRCompactPrecision::LOCATION);
+    VisitVec3(Data.FocusData.Normal, Codec, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.FocusData.Distance, DReyeVRCompactPrecision::LOCATION);
+    Codec.Float(Data.Inputs.Throttle, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.Inputs.Steering, DReyeVRCompactPrecision::UNIT);
+    Codec.Float(Data.Inputs.Brake, DReyeVRCompactPrecision::UNIT);
+    Codec.Bool(Data.Inputs.ToggledReverse);
+    Codec.Bool(Data.Inputs.TurnSignalLeft);
+    Codec.Bool(Data.Inputs.TurnSignalRight);
+    Codec.Bool(Data.Inputs.HoldHandbrake);
+}
+
+} // namespace Format
+} // namespace DReyeVRRec
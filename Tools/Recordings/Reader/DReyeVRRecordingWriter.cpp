@@ -0,0 +1,595 @@
+#include "DReyeVRRecording.h"
+#include "DReyeVRRecordingFormat.h"
+
+#include <fstream>       // std::ofstream
+#include <unordered_map> // std::unordered_map
+
+namespace DReyeVRRec
+{
+using namespace Format;
+
+namespace
+{
+// packet id + size, then the body appended by Write
+template <typename WriteFn> void PutPacket(std::string &Out, PacketId Id, WriteFn &&Write)
+{
+    Put<uint8_t>(Out, static_cast<uint8_t>(Id));
+    const size_t SizeAt = Out.size();
+    Put<uint32_t>(Out, 0); // (patched below)
+    const size_t BodyStart = Out.size();
+    Write(Out);
+    const uint32_t Size = static_cast<uint32_t>(Out.size() - BodyStart);
+    std::memcpy(&Out[SizeAt], &Size, sizeof(Size));
+}
+
+// uint16 count + records (the regular Carla/DReyeVR packet layout)
+template <typename T, typename WriteFn>
+void PutRecords(std::string &Out, PacketId Id, const std::vector<T> &Records, WriteFn &&Write)
+{
+    PutPacket(Out, Id, [&](std::string &Body) {
+        Put<uint16_t>(Body, static_cast<uint16_t>(Records.size()));
+        for (const T &Record : Records)
+            Write(Body, Record);
+    });
+}
+
+void PutEventAdd(std::string &Out, const struct EventAdd &E)
+{
+    Put(Out, E.DatabaseId);
+    Put(Out, E.Type);
+    Put(Out, E.Location);
+    Put(Out, E.Rotation);
+    Put(Out, E.UId);
+    Put(Out, E.Id);
+    Put<uint16_t>(Out, static_cast<uint16_t>(E.Attributes.size()));
+    for (const ActorAttribute &Attribute : E.Attributes)
+    {
+        Put(Out, Attribute.Type);
+        Put(Out, Attribute.Id);
+        Put(Out, Attribute.Value);
+    }
+}
+
+void PutEventParent(std::string &Out, const struct EventParent &E)
+{
+    Put(Out, E.DatabaseId);
+    Put(Out, E.ParentId);
+}
+
+void PutSceneLight(std::string &Out, const SceneLightState &L)
+{
+    Put(Out, L.LightId);
+    Put(Out, L.Intensity);
+    PutColorRGBA(Out, L.LightColor);
+    Put(Out, L.On);
+    Put(Out, L.Type);
+}
+
+void PutBoundingBox(std::string &Out, const ActorBoundingBox &B)
+{
+    Put(Out, B.DatabaseId);
+    Put(Out, B.Origin);
+    Put(Out, B.Extent);
+}
+
+void PutEye(std::string &Out, const EyeData &Eye)
+{
+    Put(Out, Eye.GazeDir);
+    Put(Out, Eye.GazeOrigin);
+    Put(Out, Eye.GazeValid);
+}
+
+void PutSingleEye(std::string &Out, const SingleEyeData &Eye)
+{
+    PutEye(Out, Eye);
+    Put(Out, Eye.EyeOpenness);
+    Put(Out, Eye.EyeOpennessValid);
+    Put(Out, Eye.PupilDiameter);
+    Put(Out, Eye.PupilPosition);
+    Put(Out, Eye.PupilPositionValid);
+}
+
+// DReyeVR::FocusInfo::Write
+void PutFocus(std::string &Out, const FocusInfo &Focus)
+{
+    Put(Out, Focus.ActorNameTag);
+    Put(Out, Focus.bDidHit);
+    Put(Out, Focus.HitPoint);
+    Put(Out, Focus.Normal);
+    Put(Out, Focus.Distance);
+}
+
+// DReyeVR::AggregateData::Write
+void PutAggregate(std::string &Out, const AggregateData &Data)
+{
+    Put(Out, Data.TimestampCarla);
+    const EgoVariables &Ego = Data.EgoVars;
+    Put(Out, Ego.CameraLocation);
+    Put(Out, Ego.CameraRotation);
+    Put(Out, Ego.CameraLocationAbs);
+    Put(Out, Ego.CameraRotationAbs);
+    Put(Out, Ego.VehicleLocation);
+    Put(Out, Ego.VehicleRotation);
+    Put(Out, Ego.Velocity);
+    const EyeTracker &Eyes = Data.EyeTrackerData;
+    Put(Out, Eyes.TimestampDevice);
+    Put(Out, Eyes.FrameSequence);
+    PutEye(Out, Eyes.Combined);
+    Put(Out, Eyes.Combined.Vergence);
+    PutSingleEye(Out, Eyes.Left);
+    PutSingleEye(Out, Eyes.Right);
+    PutFocus(Out, Data.FocusData);
+    const UserInputs &Inputs = Data.Inputs;
+    Put(Out, Inputs.Throttle);
+    Put(Out, Inputs.Steering);
+    Put(Out, Inputs.Brake);
+    Put(Out, Inputs.ToggledReverse);
+    Put(Out, Inputs.TurnSignalLeft);
+    Put(Out, Inputs.TurnSignalRight);
+    Put(Out, Inputs.HoldHandbrake);
+}
+
+// DReyeVR::GazeTraces::Write
+void PutGazeTraces(std::string &Out, const GazeTraces &Traces)
+{
+    Put(Out, Traces.IssuedFrame);
+    Put(Out, Traces.ConsumedFrame);
+    Put(Out, Traces.bAsync);
+    PutFocus(Out, Traces.Left);
+    PutFocus(Out, Traces.Right);
+}
+
+// DReyeVR::FixationEvent::Write
+void PutFixationEvent(std::string &Out, const FixationEvent &Event)
+{
+    Put(Out, Event.bStart);
+    Put(Out, Event.Start);
+    Put(Out, Event.End);
+    Put(Out, Event.Direction);
+    Put(Out, Event.ActorNameTag);
+}
+
+// DReyeVR::FixationData::Write
+void PutFixations(std::string &Out, const FixationData &Fixations)
+{
+    Put(Out, Fixations.bFixating);
+    PutFixationEvent(Out, Fixations.Current);
+    Put<uint32_t>(Out, static_cast<uint32_t>(Fixations.Events.size()));
+    for (const FixationEvent &Event : Fixations.Events)
+        PutFixationEvent(Out, Event);
+}
+
+// DReyeVR::DwellData::Write
+void PutDwell(std::string &Out, const DwellData &Dwell)
+{
+    Put(Out, Dwell.UntrackedDwell);
+    Put(Out, Dwell.DroppedDwell);
+    Put(Out, Dwell.NumDroppedActors);
+    Put<uint32_t>(Out, static_cast<uint32_t>(Dwell.Actors.size()));
+    for (const DwellStats &Stats : Dwell.Actors)
+    {
+        Put(Out, Stats.ActorId);
+        Put(Out, Stats.NumGlances);
+        Put(Out, Stats.NumFixations);
+        Put(Out, Stats.TotalDwell);
+        Put(Out, Stats.FirstGlance);
+        Put(Out, Stats.FirstFixation);
+        Put(Out, Stats.LastGlance);
+        Put(Out, Stats.LongestGlance);
+    }
+}
+
+// DReyeVR::CustomActorData::Write
+void PutCustomActor(std::string &Out, const CustomActorData &Data)
+{
+    Put(Out, Data.Location);
+    Put(Out, Data.Rotation);
+    Put(Out, Data.Scale3D);
+    Put(Out, Data.MeshPath);
+    Put(Out, Data.Metallic);
+    Put(Out, Data.Specular);
+    Put(Out, Data.Roughness);
+    Put(Out, Data.Anisotropy);
+    Put(Out, Data.Opacity);
+    PutColorABGR(Out, Data.BaseColor);
+    PutColorABGR(Out, Data.Emissive);
+    Put(Out, Data.MaterialPath);
+    Put(Out, Data.Other);
+    Put(Out, Data.Name);
+}
+
+bool SameVec(const Vec3 &A, const Vec3 &B)
+{
+    return A.X == B.X && A.Y == B.Y && A.Z == B.Z;
+}
+
+bool SameRot(const Rot &A, const Rot &B)
+{
+    return A.Pitch == B.Pitch && A.Roll == B.Roll && A.Yaw == B.Yaw;
+}
+
+bool SameColor(const Color &A, const Color &B)
+{
+    return A.R == B.R && A.G == B.G && A.B == B.B && A.A == B.A;
+}
+
+// DReyeVR::CustomActorData::WriteInterned
+void PutInternedCustomActor(DReyeVRCompactWriter &Out, DReyeVRStringTableWriter &Strings, const CustomActorData &Data,
+                            const CustomActorData *Prev)
+{
+    uint32_t Changed = CA_ALL;
+    if (Prev != nullptr)
+    {
+        Changed = 0;
+        Changed |= !SameVec(Data.Location, Prev->Location) ? uint32_t(CA_LOCATION) : 0u;
+        Changed |= !SameRot(Data.Rotation, Prev->Rotation) ? uint32_t(CA_ROTATION) : 0u;
+        Changed |= !SameVec(Data.Scale3D, Prev->Scale3D) ? uint32_t(CA_SCALE3D) : 0u;
+        Changed |= (Data.MeshPath != Prev->MeshPath) ? uint32_t(CA_MESH_PATH) : 0u;
+        const bool bSameScalars = Data.Metallic == Prev->Metallic && Data.Specular == Prev->Specular &&
+                                  Data.Roughness == Prev->Roughness && Data.Anisotropy == Prev->Anisotropy &&
+                                  Data.Opacity == Prev->Opacity;
+        Changed |= !bSameScalars ? uint32_t(CA_MATERIAL_SCALARS) : 0u;
+        Changed |= !SameColor(Data.BaseColor, Prev->BaseColor) ? uint32_t(CA_BASE_COLOR) : 0u;
+        Changed |= !SameColor(Data.Emissive, Prev->Emissive) ? uint32_t(CA_EMISSIVE) : 0u;
+        Changed |= (Data.MaterialPath != Prev->MaterialPath) ? uint32_t(CA_MATERIAL_PATH) : 0u;
+        Changed |= (Data.Other != Prev->Other) ? uint32_t(CA_OTHER) : 0u;
+    }
+
+    auto PutVec = [&Out](const Vec3 &V) {
+        Out.Raw<float>(V.X);
+        Out.Raw<float>(V.Y);
+        Out.Raw<float>(V.Z);
+    };
+    auto PutColor = [&Out](const Color &C) {
+        Out.Raw<float>(C.R);
+        Out.Raw<float>(C.G);
+        Out.Raw<float>(C.B);
+        Out.Raw<float>(C.A);
+    };
+    Out.Varint(Changed);
+    if (Changed & CA_LOCATION)
+        PutVec(Data.Location);
+    if (Changed & CA_ROTATION)
+    {
+        Out.Raw<float>(Data.Rotation.Pitch);
+        Out.Raw<float>(Data.Rotation.Roll);
+        Out.Raw<float>(Data.Rotation.Yaw);
+    }
+    if (Changed & CA_SCALE3D)
+        PutVec(Data.Scale3D);
+    if (Changed & CA_MESH_PATH)
+        Out.Varint(Strings.Intern(Data.MeshPath));
+    if (Changed & CA_MATERIAL_SCALARS)
+    {
+        Out.Raw<float>(Data.Metallic);
+        Out.Raw<float>(Data.Specular);
+        Out.Raw<float>(Data.Roughness);
+        Out.Raw<float>(Data.Anisotropy);
+        Out.Raw<float>(Data.Opacity);
+    }
+    if (Changed & CA_BASE_COLOR)
+        PutColor(Data.BaseColor);
+    if (Changed & CA_EMISSIVE)
+        PutColor(Data.Emissive);
+    if (Changed & CA_MATERIAL_PATH)
+        Out.Varint(Strings.Intern(Data.MaterialPath));
+    if (Changed & CA_OTHER)
+        Out.Varint(Strings.Intern(Data.Other));
+}
+} // namespace
+
+/// ========================================== ///
+/// ----------------:WRITER:------------------ ///
+/// ========================================== ///
+
+struct RecordingWriter::FImpl
+{
+    std::ofstream File;
+    Options Opts;
+    uint64_t Position = 0; // bytes written so far
+    std::string Frame;     // packets of the frame being written (reused)
+    FrameIndex Index;
+    std::optional<DwellData> Dwell;
+
+    DReyeVRPositionEncoder PositionEncoder;
+    DReyeVRFieldEncoder FieldEncoder;
+    DReyeVRFieldEncoder EyeSampleEncoder;
+    DReyeVRStringTableWriter Strings;
+    std::unordered_map<uint32_t, CustomActorData> LastActors;
+    DReyeVRCompactWriter Compact; // (reused)
+    DReyeVRCompactWriter Body;
+    std::vector<DReyeVRCompactPosition> CompactPositions;
+
+    void PutCompactPositions(const std::vector<struct Position> &Positions, bool bReset)
+    {
+        CompactPositions.clear();
+        for (const struct Position &Pos : Positions)
+        {
+            DReyeVRCompactPosition P;
+            P.DatabaseId = Pos.DatabaseId;
+            P.Location = {Pos.Location.X, Pos.Location.Y, Pos.Location.Z};
+            P.Rotation = {Pos.Rotation.X, Pos.Rotation.Y, Pos.Rotation.Z};
+            CompactPositions.push_back(P);
+        }
+        Compact.Clear();
+        PositionEncoder.Encode(CompactPositions, bReset, Compact);
+        PutPacket(Frame, PacketId::DReyeVRCompactPosition, [&](std::string &Out) { Out.append(Compact.GetBytes()); });
+    }
+
+    void PutCompactDReyeVR(const std::vector<AggregateData> &Records, bool bReset)
+    {
+        Compact.Clear();
+        FieldEncoder.BeginPacket(Compact, bReset);
+        Compact.Varint(Records.size());
+        for (const AggregateData &Data : Records)
+        {
+            FieldEncoder.BeginRecord();
+            VisitAggregate(Data, FieldEncoder);
+            FieldEncoder.EndRecord(Compact);
+        }
+        PutPacket(Frame, PacketId::DReyeVRCompactDReyeVR, [&](std::string &Out) { Out.append(Compact.GetBytes()); });
+    }
+
+    // ACarlaRecorder::WriteEyeSamples
+    void PutEyeSamples(const std::vector<EyeTracker> &Samples, bool bReset)
+    {
+        Compact.Clear();
+        EyeSampleEncoder.BeginPacket(Compact, bReset);
+        Compact.Varint(Samples.size());
+        for (const EyeTracker &Sample : Samples)
+        {
+            EyeSampleEncoder.BeginRecord();
+            VisitEyeTracker(Sample, EyeSampleEncoder);
+            EyeSampleEncoder.EndRecord(Compact);
+        }
+        PutPacket(Frame, PacketId::DReyeVREyeSamples, [&](std::string &Out) { Out.append(Compact.GetBytes()); });
+    }
+
+    // DReyeVR::CustomActorEncoder
+    void PutInternedCustomActors(const std::vector<CustomActorData> &Actors, bool bReset)
+    {
+        if (bReset)
+        {
+            Strings.Reset();
+            LastActors.clear();
+        }
+        Body.Clear();
+        for (const CustomActorData &Data : Actors)
+        {
+            const uint32_t NameId = Strings.Intern(Data.Name);
+            Body.Varint(NameId);
+            auto It = LastActors.find(NameId);
+            PutInternedCustomActor(Body, Strings, Data, It != LastActors.end() ? &It->second : nullptr);
+            LastActors[NameId] = Data;
+        }
+        Compact.Clear();
+        Compact.Raw<uint8_t>(bReset ? DREYEVR_COMPACT_FLAG_RESET : 0);
+        Strings.WriteDefinitions(Compact);
+        Compact.Varint(Actors.size());
+        Compact.Append(Body.GetBytes().data(), Body.Size());
+        PutPacket(Frame, PacketId::DReyeVRInternedCustomActor, [&](std::string &Out) { Out.append(Compact.GetBytes()); });
+    }
+
+    void PutKeyframe(const Keyframe &Data)
+    {
+        PutPacket(Frame, PacketId::DReyeVRKeyframe, [&](std::string &Out) {
+            PutRecords(Out, PacketId::EventAdd, Data.Actors, PutEventAdd);
+            PutRecords(Out, PacketId::EventParent, Data.Parents, PutEventParent);
+            for (const RawPacket &Raw : Data.Other)
+                PutPacket(Out, Raw.Id, [&](std::string &Body) { Body.append(Raw.Bytes); });
+            PutRecords(Out, PacketId::SceneLight, Data.SceneLights, PutSceneLight);
+        });
+    }
+
+    // DReyeVRFrameIndex::Write
+    void PutIndex()
+    {
+        Frame.clear();
+        const uint64_t PacketOffset = Position;
+        PutPacket(Frame, PacketId::DReyeVRFrameIndex, [&](std::string &Out) {
+            Put<uint16_t>(Out, 2);
+            Put<uint32_t>(Out, static_cast<uint32_t>(Index.Frames.size()));
+            for (const FrameIndexEntry &Entry : Index.Frames)
+            {
+                Put(Out, Entry.FrameId);
+                Put(Out, Entry.Elapsed);
+                Put(Out, Entry.Offset);
+            }
+            Put<uint32_t>(Out, static_cast<uint32_t>(Index.Keyframes.size()));
+            for (const auto &Keyframe : Index.Keyframes)
+            {
+                Put(Out, Keyframe.first);
+                Put(Out, Keyframe.second);
+            }
+            Put(Out, PacketOffset);
+            Out.append(IndexMagic, IndexMagicSize);
+        });
+        File.write(Frame.data(), Frame.size());
+    }
+};
+
+RecordingWriter::RecordingWriter() : Impl(new FImpl)
+{
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    Close();
+}
+
+bool RecordingWriter::Open(const std::string &Filename, const Info &Header)
+{
+    return Open(Filename, Header, Options());
+}
+
+bool RecordingWriter::Open(const std::string &Filename, const Info &Header, const Options &Opts)
+{
+    Close();
+    Impl->File.open(Filename, std::ios::binary | std::ios::trunc);
+    if (!Impl->File)
+        return false;
+    Impl->Opts = Opts;
+    Impl->Index = FrameIndex();
+    DReyeVRCompactPrecision Precision;
+    Precision.Location = Opts.LocationPrecision;
+    Precision.Rotation = Opts.RotationPrecision;
+    Precision.Unit = Opts.UnitPrecision;
+    Impl->PositionEncoder.SetPrecision(Precision);
+    Impl->FieldEncoder.SetPrecision(Precision);
+    Impl->EyeSampleEncoder.SetPrecision(Precision);
+
+    // CarlaRecorderInfo
+    std::string Out;
+    Put(Out, Header.Version);
+    Put(Out, Header.Magic.empty() ? std::string("CARLA_RECORDER") : Header.Magic);
+    Put(Out, Header.Date);
+    Put(Out, Header.Map);
+    Impl->File.write(Out.data(), Out.size());
+    Impl->Position = Out.size();
+    return static_cast<bool>(Impl->File);
+}
+
+void RecordingWriter::WriteFrame(const FrameData &Data)
+{
+    FImpl &W = *Impl;
+    if (!W.File.is_open())
+        return;
+    std::string &Out = W.Frame;
+    Out.clear();
+
+    // same packet order as ACarlaRecorder::Write
+    W.Index.Frames.push_back({Data.Header.Id, Data.Header.Elapsed, W.Position});
+    PutPacket(Out, PacketId::FrameStart, [&](std::string &Body) {
+        Put(Body, Data.Header.Id);
+        Put(Body, Data.Header.Duration);
+        Put(Body, Data.Header.Elapsed);
+    });
+    PutRecords(Out, PacketId::EventAdd, Data.Adds, PutEventAdd);
+    PutRecords(Out, PacketId::EventDel, Data.Dels, [](std::string &Body, const struct EventDel &E) { Put(Body, E.DatabaseId); });
+    PutRecords(Out, PacketId::EventParent, Data.Parents, PutEventParent);
+    PutRecords(Out, PacketId::Collision, Data.Collisions, [](std::string &Body, const struct Collision &C) {
+        Put(Body, C.Id);
+        Put(Body, C.DatabaseId1);
+        Put(Body, C.DatabaseId2);
+        Put(Body, C.IsActor1Hero);
+        Put(Body, C.IsActor2Hero);
+    });
+
+    if (Data.KeyframeData)
+    {
+        W.Index.Keyframes.emplace_back(static_cast<uint32_t>(W.Index.Frames.size() - 1), W.Position + Out.size());
+        W.PutKeyframe(*Data.KeyframeData);
+    }
+    const bool bResetDeltas = Data.KeyframeData.has_value() || W.Index.Frames.size() == 1;
+
+    if (W.Opts.bCompact)
+        W.PutCompactPositions(Data.Positions, bResetDeltas);
+    else
+        PutRecords(Out, PacketId::Position, Data.Positions, [](std::string &Body, const struct Position &P) {
+            Put(Body, P.DatabaseId);
+            Put(Body, P.Location);
+            Put(Body, P.Rotation);
+        });
+    PutRecords(Out, PacketId::State, Data.TrafficLights, [](std::string &Body, const TrafficLightState &S) {
+        Put(Body, S.DatabaseId);
+        Put(Body, S.IsFrozen);
+        Put(Body, S.ElapsedTime);
+        Put(Body, S.State);
+    });
+    PutRecords(Out, PacketId::AnimVehicle, Data.Vehicles, [](std::string &Body, const VehicleAnimation &V) {
+        Put(Body, V.DatabaseId);
+        Put(Body, V.Steering);
+        Put(Body, V.Throttle);
+        Put(Body, V.Brake);
+        Put(Body, V.Handbrake);
+        Put(Body, V.Gear);
+    });
+    PutRecords(Out, PacketId::AnimWalker, Data.Walkers, [](std::string &Body, const WalkerAnimation &A) {
+        Put(Body, A.DatabaseId);
+        Put(Body, A.Speed);
+    });
+    PutRecords(Out, PacketId::VehicleLight, Data.VehicleLights, [](std::string &Body, const VehicleLightState &L) {
+        Put(Body, L.DatabaseId);
+        Put(Body, L.State);
+    });
+    PutRecords(Out, PacketId::SceneLight, Data.SceneLights, PutSceneLight);
+
+    // additional info (only recorded with additional data enabled)
+    if (!Data.Kinematics.empty())
+        PutRecords(Out, PacketId::Kinematics, Data.Kinematics, [](std::string &Body, const ActorKinematics &K) {
+            Put(Body, K.DatabaseId);
+            Put(Body, K.LinearVelocity);
+            Put(Body, K.AngularVelocity);
+        });
+    if (!Data.BoundingBoxes.empty())
+        PutRecords(Out, PacketId::BoundingBox, Data.BoundingBoxes, PutBoundingBox);
+    if (!Data.TriggerVolumes.empty())
+        PutRecords(Out, PacketId::TriggerVolume, Data.TriggerVolumes, PutBoundingBox);
+    if (Data.PlatformTime)
+        PutPacket(Out, PacketId::PlatformTime, [&](std::string &Body) { Put(Body, *Data.PlatformTime); });
+    if (!Data.TrafficLightTimes.empty())
+        PutRecords(Out, PacketId::TrafficLightTime, Data.TrafficLightTimes, [](std::string &Body, const TrafficLightTime &T) {
+            Put(Body, T.DatabaseId);
+            Put(Body, T.GreenTime);
+            Put(Body, T.YellowTime);
+            Put(Body, T.RedTime);
+        });
+
+    if (W.Opts.bCompact)
+        W.PutCompactDReyeVR(Data.DReyeVR, bResetDeltas);
+    else
+        PutRecords(Out, PacketId::DReyeVR, Data.DReyeVR, PutAggregate);
+    if (W.Opts.bEyeSamples)
+        W.PutEyeSamples(Data.EyeSamples, bResetDeltas);
+    if (W.Opts.bGazeTraces)
+        PutRecords(Out, PacketId::DReyeVRGazeTraces, Data.GazeTraceData, PutGazeTraces);
+    if (W.Opts.bFixations)
+        PutRecords(Out, PacketId::DReyeVRFixations, Data.Fixations, PutFixations);
+    if (W.Opts.bInternCustomActors)
+        W.PutInternedCustomActors(Data.CustomActors, bResetDeltas);
+    else
+        PutRecords(Out, PacketId::DReyeVRCustomActor, Data.CustomActors, PutCustomActor);
+    if (Data.ConfigFile)
+        PutPacket(Out, PacketId::DReyeVRConfigFile, [&](std::string &Body) {
+            Put<uint16_t>(Body, 1);
+            Put(Body, *Data.ConfigFile);
+        });
+
+    // weather, physics control and unknown packets as they were read
+    for (const RawPacket &Raw : Data.Raw)
+        PutPacket(Out, Raw.Id, [&](std::string &Body) { Body.append(Raw.Bytes); });
+
+    PutPacket(Out, PacketId::FrameEnd, [](std::string &) {});
+    W.File.write(Out.data(), Out.size());
+    W.Position += Out.size();
+}
+
+void RecordingWriter::SetDwell(const DwellData &Dwell)
+{
+    Impl->Dwell = Dwell;
+}
+
+void RecordingWriter::Close()
+{
+    FImpl &W = *Impl;
+    if (!W.File.is_open())
+        return;
+    if (W.Dwell && !W.Index.Frames.empty())
+    {
+        W.Frame.clear();
+        PutRecords(W.Frame, PacketId::DReyeVRDwell, std::vector<DwellData>{*W.Dwell}, PutDwell);
+        W.File.write(W.Frame.data(), W.Frame.size());
+        W.Position += W.Frame.size();
+    }
+    if (W.Opts.bFrameIndex && !W.Index.Frames.empty())
+        W.PutIndex();
+    W.File.close();
+    W.Dwell.reset();
+    W.PositionEncoder.Reset();
+    W.FieldEncoder.Reset();
+    W.EyeSampleEncoder.Reset();
+    W.Strings.Reset();
+    W.LastActors.clear();
+}
+
+} // namespace DReyeVRRec
@@ -0,0 +1,260 @@
+// Benchmark of the compact (delta + varint) encoding of the per-frame packets ([Recorder] CompactEncoding)
+//
+// Encodes synthetic trajectories like the recorder does every frame and decodes them again like the replayer:
+//   positions - CarlaRecorderPositions (id + location + rotation per actor) vs packet 144
+//   dreyevr   - an ego sensor sample with the same kinds of fields as DReyeVR::AggregateData vs packet 145
+// and reports the compression ratio, the encode/decode cost per frame, and the worst quantization error.
+//
+// usage: bench_codec [--frames N] [--actors N] [--keyframe N]
+
+#include "DReyeVRRecorderCodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point Start)
+{
+    return std::chrono::duration<double>(Clock::now() - Start).count();
+}
+
+// roughly the fields of DReyeVR::AggregateData (vectors, rotators, eye data, focus, inputs)
+struct SyntheticSample
+{
+    int64_t Timestamp = 0;
+    float Ego[21] = {};    // camera, absolute camera and vehicle locations/rotations, velocity
+    int64_t Device[2] = {};
+    float Gaze[24] = {};   // combined/left/right gaze origins and directions, vergence
+    float Eyes[6] = {};    // openness and pupil diameters/positions
+    bool Valid[6] = {};
+    std::string FocusName;
+    bool bDidHit = false;
+    float Focus[7] = {};   // hit point, normal, distance
+    float Inputs[3] = {};  // throttle, steering, brake
+    bool Buttons[4] = {};
+
+    template <typename DataT, typename CodecT> static void Visit(DataT &Data, CodecT &Codec)
+    {
+        using P = DReyeVRCompactPrecision;
+        Codec.Int(Data.Timestamp);
+        for (int i = 0; i < 21; i++)
+            Codec.Float(Data.Ego[i], (i % 6) < 3 || i >= 18 ? P::LOCATION : P::ROTATION);
+        for (auto &Value : Data.Device)
+            Codec.Int(Value);
+        for (int i = 0; i < 24; i++)
+            Codec.Float(Data.Gaze[i], (i % 6) < 3 ? P::LOCATION : P::UNIT);
+        for (auto &Value : Data.Eyes)
+            Codec.Float(Value, P::UNIT);
+        for (auto &Value : Data.Valid)
+            Codec.Bool(Value);
+        Codec.String(Data.FocusName);
+        Codec.Bool(Data.bDidHit);
+        for (int i = 0; i < 7; i++)
+            Codec.Float(Data.Focus[i], i >= 3 && i < 6 ? P::UNIT : P::LOCATION);
+        for (auto &Value : Data.Inputs)
+            Codec.Float(Value, P::UNIT);
+        for (auto &Value : Data.Buttons)
+            Codec.Bool(Value);
+    }
+};
+
+// size of the same sample in a regular DReyeVR packet (raw fields, FString as uint16 length + bytes)
+size_t RawSampleSize(const SyntheticSample &Sample)
+{
+    return sizeof(int64_t) * 3 + sizeof(float) * (21 + 24 + 6 + 7 + 3) + 11 + sizeof(uint16_t) +
+           Sample.FocusName.size();
+}
+
+struct Result
+{
+    uint64_t RawBytes = 0;
+    uint64_t CompactBytes = 0;
+    double EncodeSeconds = 0.0;
+    double DecodeSeconds = 0.0;
+    double MaxLocationError = 0.0;
+    double MaxRotationError = 0.0;
+    double MaxUnitError = 0.0;
+    bool bDecoded = true;
+
+    void Report(const char *Name, uint32_t Frames) const
+    {
+        std::printf("%-9s %10.1f KB -> %9.1f KB (%5.2fx)  encode %7.2f us/frame  decode %7.2f us/frame\n", Name,
+                    RawBytes / 1e3, CompactBytes / 1e3, static_cast<double>(RawBytes) / CompactBytes,
+                    1e6 * EncodeSeconds / Frames, 1e6 * DecodeSeconds / Frames);
+        std::printf("%-9s max error: location %.4f cm, rotation %.4f deg, unit %.6f\n", "", MaxLocationError,
+                    MaxRotationError, MaxUnitError);
+    }
+};
+
+Result BenchPositions(uint32_t NumFrames, uint32_t NumActors, uint32_t KeyframeEvery)
+{
+    std::mt19937 Rng(42);
+    std::uniform_real_distribution<float> Unit(0.f, 1.f);
+    std::vector<DReyeVRCompactPosition> Positions(NumActors), Decoded;
+    std::vector<float> Speeds(NumActors);
+    for (uint32_t A = 0; A < NumActors; A++)
+    {
+        Positions[A].DatabaseId = 100 + 3 * A;
+        Positions[A].Location = {Unit(Rng) * 40000.f, Unit(Rng) * 40000.f, 30.f};
+        Positions[A].Rotation = {0.f, Unit(Rng) * 360.f, 0.f};
+        Speeds[A] = (A % 3 == 0) ? 0.f : Unit(Rng) * 25.f; // a third of the actors are parked (cm/frame)
+    }
+
+    Result Res;
+    DReyeVRPositionEncoder Encoder;
+    DReyeVRPositionDecoder Decoder;
+    DReyeVRCompactWriter Bytes;
+    for (uint32_t F = 0; F < NumFrames; F++)
+    {
+        for (uint32_t A = 0; A < NumActors; A++)
+        {
+            auto &Pos = Positions[A];
+            const float Yaw = Pos.Rotation[1] * 3.14159265f / 180.f;
+            Pos.Location[0] = std::fmod(Pos.Location[0] + Speeds[A] * std::cos(Yaw) + 40000.f, 40000.f); // (400m map)
+            Pos.Location[1] = std::fmod(Pos.Location[1] + Speeds[A] * std::sin(Yaw) + 40000.f, 40000.f);
+            Pos.Location[2] = 30.f + 0.5f * std::sin(F * 0.05f + A); // suspension
+            Pos.Rotation[1] += Speeds[A] > 0.f ? 0.02f * std::sin(F * 0.01f + A) : 0.f;
+        }
+
+        const bool bReset = (F == 0) || (KeyframeEvery > 0 && F % KeyframeEvery == 0);
+        auto Start = Clock::now();
+        Bytes.Clear();
+        Encoder.Encode(Positions, bReset, Bytes);
+        Res.EncodeSeconds += Seconds(Start);
+
+        Start = Clock::now();
+        DReyeVRCompactReader Reader(Bytes.GetBytes().data(), Bytes.Size());
+        Res.bDecoded &= Decoder.Decode(Reader, Decoded);
+        Res.DecodeSeconds += Seconds(Start);
+
+        Res.RawBytes += 1 + 4 + 2 + NumActors * (4 + 6 * 4);
+        Res.CompactBytes += 1 + 4 + Bytes.Size();
+        Res.bDecoded &= Decoded.size() == Positions.size();
+        for (size_t A = 0; A < Decoded.size() && A < Positions.size(); A++)
+        {
+            Res.bDecoded &= Decoded[A].DatabaseId == Positions[A].DatabaseId;
+            for (size_t i = 0; i < 3; i++)
+            {
+                Res.MaxLocationError =
+                    std::max<double>(Res.MaxLocationError, std::abs(Decoded[A].Location[i] - Positions[A].Location[i]));
+                Res.MaxRotationError =
+                    std::max<double>(Res.MaxRotationError, std::abs(Decoded[A].Rotation[i] - Positions[A].Rotation[i]));
+            }
+        }
+    }
+    return Res;
+}
+
+Result BenchDReyeVR(uint32_t NumFrames, uint32_t KeyframeEvery)
+{
+    std::mt19937 Rng(7);
+    std::normal_distribution<float> Noise(0.f, 1.f);
+    SyntheticSample Sample, Decoded;
+    Sample.FocusName = "Road_Marking_42";
+
+    Result Res;
+    DReyeVRFieldEncoder Encoder;
+    DReyeVRFieldDecoder Decoder;
+    DReyeVRCompactWriter Bytes;
+    for (uint32_t F = 0; F < NumFrames; F++)
+    {
+        Sample.Timestamp = 1000 + F * 16;
+        for (int i = 0; i < 21; i++)
+            Sample.Ego[i] = 100.f * i + F * ((i % 6) < 3 ? 20.f : 0.01f);
+        Sample.Device[0] = 5000 + F * 8;
+        Sample.Device[1] = 2 * F;
+        for (int i = 0; i < 24; i++) // eye tracker noise
+            Sample.Gaze[i] = (i % 6) < 3 ? 3.f + 0.05f * Noise(Rng) : 0.57f + 0.002f * Noise(Rng);
+        for (int i = 0; i < 6; i++)
+            Sample.Eyes[i] = 0.9f + 0.01f * Noise(Rng);
+        for (int i = 0; i < 6; i++)
+            Sample.Valid[i] = (F % 200) != 0; // blinks
+        if (F % 90 == 0)
+            Sample.FocusName = "Actor_" + std::to_string(F / 90);
+        Sample.bDidHit = true;
+        for (int i = 0; i < 7; i++)
+            Sample.Focus[i] = 500.f * i + 3.f * Noise(Rng);
+        Sample.Inputs[0] = 0.3f + 0.01f * std::sin(F * 0.1f);
+        Sample.Inputs[1] = 0.05f * std::sin(F * 0.02f);
+        Sample.Inputs[2] = 0.f;
+
+        const bool bReset = (F == 0) || (KeyframeEvery > 0 && F % KeyframeEvery == 0);
+        auto Start = Clock::now();
+        Bytes.Clear();
+        Encoder.BeginPacket(Bytes, bReset);
+        Bytes.Varint(1);
+        Encoder.BeginRecord();
+        SyntheticSample::Visit(Sample, Encoder);
+        Encoder.EndRecord(Bytes);
+        Res.EncodeSeconds += Seconds(Start);
+
+        Start = Clock::now();
+        DReyeVRCompactReader Reader(Bytes.GetBytes().data(), Bytes.Size());
+        bool bDecoded = Decoder.BeginPacket(Reader) && Reader.Varint() == 1;
+        Decoder.BeginRecord(Reader);
+        SyntheticSample::Visit(Decoded, Decoder);
+        Res.bDecoded &= bDecoded && Decoder.EndRecord();
+        Res.DecodeSeconds += Seconds(Start);
+
+        Res.RawBytes += 1 + 4 + 2 + RawSampleSize(Sample);
+        Res.CompactBytes += 1 + 4 + Bytes.Size();
+        Res.bDecoded &= Decoded.Timestamp == Sample.Timestamp && Decoded.FocusName == Sample.FocusName &&
+                        std::equal(Sample.Valid, Sample.Valid + 6, Decoded.Valid);
+        for (int i = 0; i < 24; i++)
+        {
+            double &MaxError = (i % 6) < 3 ? Res.MaxLocationError : Res.MaxUnitError;
+            MaxError = std::max<double>(MaxError, std::abs(Decoded.Gaze[i] - Sample.Gaze[i]));
+        }
+    }
+    return Res;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t NumFrames = 36000; // 10 minutes at 60 Hz
+    uint32_t NumActors = 100;
+    uint32_t KeyframeEvery = 600; // [Recorder] KeyframeInterval=10.0 at 60 Hz
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string Arg = argv[i];
+        if (Arg == "--frames" && i + 1 < argc)
+            NumFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--actors" && i + 1 < argc)
+            NumActors = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--keyframe" && i + 1 < argc)
+            KeyframeEvery = static_cast<uint32_t>(std::atoi(argv[++i]));
+    }
+    if (NumFrames == 0)
+    {
+        std::fprintf(stderr, "Need at least one frame\n");
+        return 1;
+    }
+    std::printf("%u frames, %u actors, reset every %u frames\n", NumFrames, NumActors, KeyframeEvery);
+
+    const Result Positions = BenchPositions(NumFrames, NumActors, KeyframeEvery);
+    const Result DReyeVR = BenchDReyeVR(NumFrames, KeyframeEvery);
+    Positions.Report("positions", NumFrames);
+    DReyeVR.Report("dreyevr", NumFrames);
+
+    // decoded values must be within half a quantization step of the originals
+    const DReyeVRCompactPrecision Precision;
+    const double Slack = 1e-2; // (float rounding of map sized coordinates)
+    const bool bValid = Positions.bDecoded && DReyeVR.bDecoded &&
+                        Positions.MaxLocationError <= Precision.Location / 2 + Slack &&
+                        Positions.MaxRotationError <= Precision.Rotation / 2 + Slack &&
+                        DReyeVR.MaxUnitError <= Precision.Unit / 2 + 1e-6;
+    if (!bValid)
+        std::fprintf(stderr, "Decoded values do not match!\n");
+    return bValid ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// Benchmark of the columnar export of DReyeVR recordings (dreyevr_rec export, Reader/DReyeVRColumns.h)
+//
+// Writes a multi-hour synthetic recording (one DReyeVR sample and the positions of a few actors every frame),
+// exports it to NumPy columns and compares reading 3 channels from the memory-mapped columns against parsing the
+// whole recording for them. Reports the export throughput and the bytes each way has to touch.
+//
+// usage: bench_export [--hours H] [--hz N] [--actors N] [--dir DIR] [--keep]
+
+#include "DReyeVRColumns.h"
+#include "DReyeVRRecording.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace DReyeVRRec;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point Start)
+{
+    return std::chrono::duration<double>(Clock::now() - Start).count();
+}
+
+const char *Channels[] = {"Combined.GazeDir.X", "Left.PupilDiameter", "Inputs.Throttle"};
+
+void WriteSynthetic(const std::string &Filename, uint64_t NumFrames, uint32_t Hz, uint32_t NumActors)
+{
+    RecordingWriter Writer;
+    Info Header;
+    Header.Map = "Town03";
+    Writer.Open(Filename, Header);
+    FrameData Frame;
+    AggregateData &Data = Frame.DReyeVR.emplace_back();
+    Frame.Positions.resize(NumActors);
+    for (uint64_t i = 0; i < NumFrames; i++)
+    {
+        const float t = static_cast<float>(i) / Hz;
+        Frame.Header.Id = i + 1;
+        Frame.Header.Duration = 1.0 / Hz;
+        Frame.Header.Elapsed = static_cast<double>(i) / Hz;
+        for (uint32_t a = 0; a < NumActors; a++)
+        {
+            Frame.Positions[a].DatabaseId = a + 1;
+            Frame.Positions[a].Location = {100.f * a + 500.f * std::sin(0.01f * t), 800.f * std::cos(0.01f * t), 0.f};
+            Frame.Positions[a].Rotation = {0.f, 0.f, std::fmod(t, 360.f)};
+        }
+        Data.TimestampCarla = static_cast<int64_t>(1000.0 * i / Hz);
+        Data.EgoVars.VehicleLocation = {1000.f * std::sin(0.001f * t), 1000.f * std::cos(0.001f * t), 10.f};
+        Data.EgoVars.CameraLocationAbs = Data.EgoVars.VehicleLocation;
+        Data.EgoVars.Velocity = 1000.f + 200.f * std::sin(0.1f * t);
+        Data.EyeTrackerData.TimestampDevice = Data.TimestampCarla;
+        Data.EyeTrackerData.FrameSequence = static_cast<int64_t>(i);
+        Data.EyeTrackerData.Combined.GazeDir = {1.f, 0.2f * std::sin(3.f * t), 0.1f * std::cos(2.f * t)};
+        Data.EyeTrackerData.Combined.GazeValid = (i % 50) != 0;
+        Data.EyeTrackerData.Left.PupilDiameter = 3.f + 0.5f * std::sin(0.5f * t);
+        Data.EyeTrackerData.Right.PupilDiameter = 3.f + 0.5f * std::cos(0.5f * t);
+        Data.FocusData.ActorNameTag = ((i / 200) % 4 == 0) ? "None" : "Vehicle_" + std::to_string((i / 200) % 7);
+        Data.FocusData.Distance = 1000.f + 100.f * std::sin(t);
+        Data.Inputs.Throttle = 0.5f + 0.5f * std::sin(0.2f * t);
+        Data.Inputs.Steering = 0.1f * std::sin(0.3f * t);
+        Writer.WriteFrame(Frame);
+    }
+    Writer.Close();
+}
+
+// sum of a memory-mapped .npy column of floats (returns the bytes mapped)
+uint64_t SumColumn(const std::string &Filename, double &Sum)
+{
+    const int Fd = open(Filename.c_str(), O_RDONLY);
+    struct stat Stat;
+    if (Fd < 0 || fstat(Fd, &Stat) != 0)
+        return 0;
+    const size_t Size = static_cast<size_t>(Stat.st_size);
+    void *Mapped = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, Fd, 0);
+    close(Fd);
+    if (Mapped == MAP_FAILED)
+        return 0;
+    const char *Bytes = static_cast<const char *>(Mapped);
+    uint16_t HeaderLength = 0;
+    std::memcpy(&HeaderLength, Bytes + 8, sizeof(HeaderLength));
+    const float *Values = reinterpret_cast<const float *>(Bytes + 10 + HeaderLength);
+    const size_t Rows = (Size - 10 - HeaderLength) / sizeof(float);
+    for (size_t i = 0; i < Rows; i++)
+        Sum += Values[i];
+    munmap(Mapped, Size);
+    return Size;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double Hours = 2.0;
+    uint32_t Hz = 60;
+    uint32_t NumActors = 10;
+    std::string Dir = "/tmp/dreyevr_bench_export";
+    bool bKeep = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string Arg = argv[i];
+        if (Arg == "--hours" && i + 1 < argc)
+            Hours = std::atof(argv[++i]);
+        else if (Arg == "--hz" && i + 1 < argc)
+            Hz = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--actors" && i + 1 < argc)
+            NumActors = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--dir" && i + 1 < argc)
+            Dir = argv[++i];
+        else if (Arg == "--keep")
+            bKeep = true;
+    }
+    const uint64_t NumFrames = static_cast<uint64_t>(Hours * 3600.0 * Hz);
+    std::filesystem::create_directories(Dir + "/columns");
+    const std::string Recording = Dir + "/synthetic.rec";
+
+    auto Start = Clock::now();
+    WriteSynthetic(Recording, NumFrames, Hz, NumActors);
+    const uint64_t RecordingBytes = std::filesystem::file_size(Recording);
+    std::printf("recording: %.2f h at %u Hz, %u actors, %llu frames, %.1f MB (written in %.2f s)\n", Hours, Hz,
+                NumActors, static_cast<unsigned long long>(NumFrames), RecordingBytes / 1e6, Seconds(Start));
+
+    RecordingReader Reader;
+    if (!Reader.Open(Recording))
+    {
+        std::fprintf(stderr, "%s\n", Reader.GetError().c_str());
+        return 1;
+    }
+    Start = Clock::now();
+    const ExportResult Result = ExportColumns(Reader, Dir + "/columns", ExportOptions());
+    const double ExportSeconds = Seconds(Start);
+    if (!Result.bSuccess)
+    {
+        std::fprintf(stderr, "%s\n", Result.Error.c_str());
+        return 1;
+    }
+    std::printf("export:    %zu columns, %.1f MB in %.2f s (%.0f MB/s of recording, %.2f M rows/s)\n",
+                GetDReyeVRColumns().size(), Result.Bytes / 1e6, ExportSeconds, RecordingBytes / 1e6 / ExportSeconds,
+                Result.Rows / 1e6 / ExportSeconds);
+
+    // 3 channels from the columns
+    Start = Clock::now();
+    double ColumnSum = 0.0;
+    uint64_t ColumnBytes = 0;
+    for (const char *Channel : Channels)
+        ColumnBytes += SumColumn(Dir + "/columns/" + Channel + ".npy", ColumnSum);
+    const double ColumnSeconds = Seconds(Start);
+
+    // the same channels by parsing the recording
+    Start = Clock::now();
+    Reader.Rewind();
+    double ParseSum = 0.0;
+    FrameData Frame;
+    while (Reader.NextFrame(Frame))
+        for (const AggregateData &Data : Frame.DReyeVR)
+            ParseSum += Data.EyeTrackerData.Combined.GazeDir.X + Data.EyeTrackerData.Left.PupilDiameter +
+                        Data.Inputs.Throttle;
+    const double ParseSeconds = Seconds(Start);
+
+    std::printf("3 of %zu channels: columns %.1f MB in %.3f s, recording %.1f MB in %.3f s (%.0fx faster)\n",
+                GetDReyeVRColumns().size(), ColumnBytes / 1e6, ColumnSeconds, RecordingBytes / 1e6, ParseSeconds,
+                ColumnSeconds > 0 ? ParseSeconds / ColumnSeconds : 0.0);
+    const bool bMatch = std::fabs(ColumnSum - ParseSum) <= 1e-6 * std::fabs(ParseSum) + 1e-3;
+    if (!bMatch)
+        std::fprintf(stderr, "ERROR: the columns (%f) do not match the recording (%f)\n", ColumnSum, ParseSum);
+
+    if (!bKeep)
+        std::filesystem::remove_all(Dir);
+    return bMatch ? 0 : 1;
+}
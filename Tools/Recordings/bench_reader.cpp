@@ -0,0 +1,325 @@
+// Benchmark of the recording read paths used by CarlaReplayer/CarlaRecorderQuery
+//
+// Walks every packet of a recording (decoding frames and actor positions field by field, like the replayer does)
+// through:
+//   stream  - std::ifstream + istream::read per field (the original ReadValue)
+//   direct  - std::ifstream + DReyeVRReadBytes per field (ReadValue now, without a mapping)
+//   mapped  - memory mapped file attached to the same std::ifstream (ReadValue with [Replayer] MemoryMappedReads)
+//
+// usage: bench_reader [recording.rec] [--frames N] [--actors N] [--repeat N]
+// without a recording, a synthetic one (same packet layout as the recorder) is written to a temporary file
+
+#include "DReyeVRRecorderReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace
+{
+// packet ids (see CarlaRecorderPacketId)
+constexpr char FrameStartId = 0;
+constexpr char FrameEndId = 1;
+constexpr char EventAddId = 2;
+constexpr char PositionId = 6;
+
+struct ParseResult
+{
+    uint64_t Frames = 0;
+    uint64_t Packets = 0;
+    uint64_t Positions = 0;
+    double Checksum = 0.0; // keeps the compiler from dropping the reads
+};
+
+template <typename T> void Write(std::ofstream &Out, const T &Value)
+{
+    Out.write(reinterpret_cast<const char *>(&Value), sizeof(T));
+}
+
+void WriteString(std::ofstream &Out, const std::string &Str)
+{
+    Write<uint16_t>(Out, static_cast<uint16_t>(Str.size()));
+    Out.write(Str.data(), Str.size());
+}
+
+void WriteSynthetic(const std::string &Filename, uint32_t NumFrames, uint32_t NumActors)
+{
+    std::ofstream Out(Filename, std::ios::binary);
+    // CarlaRecorderInfo
+    Write<uint16_t>(Out, 1);
+    WriteString(Out, "CARLA_RECORDER");
+    Write<int64_t>(Out, 0);
+    WriteString(Out, "Town05");
+    for (uint32_t F = 0; F < NumFrames; F++)
+    {
+        // CarlaRecorderFrame
+        Write<char>(Out, FrameStartId);
+        Write<uint32_t>(Out, sizeof(uint64_t) + 2 * sizeof(double));
+        Write<uint64_t>(Out, F + 1);
+        Write<double>(Out, 1.0 / 60.0);
+        Write<double>(Out, F / 60.0);
+        if (F == 0)
+        {
+            // one EventAdd packet with short descriptions (exercises the string path)
+            const std::string Desc = "vehicle.dreyevr.egovehicle";
+            const uint32_t Size = sizeof(uint16_t) + NumActors * (sizeof(uint32_t) + sizeof(uint8_t) + 6 * sizeof(float) +
+                                                                 sizeof(uint32_t) + sizeof(uint16_t) + Desc.size() +
+                                                                 sizeof(uint16_t));
+            Write<char>(Out, EventAddId);
+            Write<uint32_t>(Out, Size);
+            Write<uint16_t>(Out, static_cast<uint16_t>(NumActors));
+            for (uint32_t A = 0; A < NumActors; A++)
+            {
+                Write<uint32_t>(Out, A + 1);
+                Write<uint8_t>(Out, 1);
+                for (int i = 0; i < 6; i++)
+                    Write<float>(Out, 0.f);
+                Write<uint32_t>(Out, A + 1);
+                WriteString(Out, Desc);
+                Write<uint16_t>(Out, 0); // no attributes
+            }
+        }
+        // CarlaRecorderPositions
+        Write<char>(Out, PositionId);
+        Write<uint32_t>(Out, sizeof(uint16_t) + NumActors * (sizeof(uint32_t) + 6 * sizeof(float)));
+        Write<uint16_t>(Out, static_cast<uint16_t>(NumActors));
+        for (uint32_t A = 0; A < NumActors; A++)
+        {
+            Write<uint32_t>(Out, A + 1);
+            const float Pos[6] = {F * 0.1f, A * 2.f, 0.f, 0.f, 0.f, F * 0.01f};
+            Out.write(reinterpret_cast<const char *>(Pos), sizeof(Pos));
+        }
+        Write<char>(Out, FrameEndId);
+        Write<uint32_t>(Out, 0);
+    }
+}
+
+// the original ReadValue
+struct StreamRead
+{
+    template <typename T> static void Value(std::istream &In, T &Out)
+    {
+        In.read(reinterpret_cast<char *>(&Out), sizeof(T));
+    }
+    static void String(std::istream &In, std::string &Scratch, DReyeVRStringView &Out)
+    {
+        uint16_t Length = 0;
+        Value(In, Length);
+        Scratch.resize(Length);
+        In.read(&Scratch[0], Length);
+        Out = DReyeVRStringView{Scratch.data(), Length};
+    }
+};
+
+// the current ReadValue/ReadFString
+struct DirectRead
+{
+    template <typename T> static void Value(std::istream &In, T &Out)
+    {
+        DReyeVRReadBytes(In, reinterpret_cast<char *>(&Out), sizeof(T));
+    }
+    static void String(std::istream &In, std::string &Scratch, DReyeVRStringView &Out)
+    {
+        uint16_t Length = 0;
+        Value(In, Length);
+        DReyeVRReadView(In, Length, Scratch, Out);
+    }
+};
+
+template <typename Read> ParseResult Parse(std::istream &In)
+{
+    ParseResult Result;
+    std::string Scratch;
+    DReyeVRStringView View;
+
+    // CarlaRecorderInfo
+    uint16_t Version;
+    int64_t Date;
+    Read::Value(In, Version);
+    Read::String(In, Scratch, View);
+    Read::Value(In, Date);
+    Read::String(In, Scratch, View);
+
+    char Id;
+    uint32_t Size;
+    while (In)
+    {
+        Read::Value(In, Id);
+        Read::Value(In, Size);
+        if (!In)
+            break;
+        Result.Packets++;
+        switch (Id)
+        {
+        case FrameStartId: {
+            uint64_t FrameId;
+            double Duration, Elapsed;
+            Read::Value(In, FrameId);
+            Read::Value(In, Duration);
+            Read::Value(In, Elapsed);
+            Result.Frames++;
+            Result.Checksum += Elapsed;
+            break;
+        }
+        case EventAddId: {
+            uint16_t Total;
+            Read::Value(In, Total);
+            for (uint16_t i = 0; i < Total; i++)
+            {
+                uint32_t DatabaseId, UId;
+                uint8_t Type;
+                float Transform[6];
+                uint16_t NumAttributes;
+                Read::Value(In, DatabaseId);
+                Read::Value(In, Type);
+                for (float &V : Transform)
+                    Read::Value(In, V);
+                Read::Value(In, UId);
+                Read::String(In, Scratch, View);
+                Result.Checksum += View.Length;
+                Read::Value(In, NumAttributes);
+                for (uint16_t a = 0; a < NumAttributes; a++)
+                {
+                    char Type;
+                    Read::Value(In, Type);
+                    Read::String(In, Scratch, View); // id
+                    Read::String(In, Scratch, View); // value
+                }
+            }
+            break;
+        }
+        case PositionId: {
+            uint16_t Total;
+            Read::Value(In, Total);
+            for (uint16_t i = 0; i < Total; i++)
+            {
+                uint32_t DatabaseId;
+                float X, Y, Z, Pitch, Yaw, Roll; // ReadFVector is 3 x ReadValue<float>
+                Read::Value(In, DatabaseId);
+                Read::Value(In, X);
+                Read::Value(In, Y);
+                Read::Value(In, Z);
+                Read::Value(In, Pitch);
+                Read::Value(In, Yaw);
+                Read::Value(In, Roll);
+                Result.Checksum += X + Roll;
+            }
+            Result.Positions += Total;
+            break;
+        }
+        default:
+            In.seekg(Size, std::ios::cur);
+            break;
+        }
+    }
+    return Result;
+}
+
+template <typename Func> double BestOf(int Repeat, Func &&F)
+{
+    double Best = 1e30;
+    for (int i = 0; i < Repeat; i++)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        F();
+        Best = std::min(Best, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+    }
+    return Best;
+}
+
+void Report(const char *Name, double Seconds, uint64_t FileSize, const ParseResult &Result)
+{
+    std::printf("%-8s %9.3f ms %9.1f MB/s %12.1f Mpositions/s   (%llu frames, checksum %.1f)\n", Name,
+                Seconds * 1e3, FileSize / Seconds / 1e6, Result.Positions / Seconds / 1e6,
+                static_cast<unsigned long long>(Result.Frames), Result.Checksum);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string Filename;
+    uint32_t NumFrames = 36000; // 10 minutes at 60 Hz
+    uint32_t NumActors = 100;
+    int Repeat = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string Arg = argv[i];
+        if (Arg == "--frames" && i + 1 < argc)
+            NumFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--actors" && i + 1 < argc)
+            NumActors = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--repeat" && i + 1 < argc)
+            Repeat = std::atoi(argv[++i]);
+        else
+            Filename = Arg;
+    }
+
+    bool bSynthetic = false;
+    if (Filename.empty())
+    {
+        Filename = "/tmp/dreyevr_bench_reader.rec";
+        std::printf("Writing synthetic recording (%u frames, %u actors) to %s\n", NumFrames, NumActors,
+                    Filename.c_str());
+        WriteSynthetic(Filename, NumFrames, NumActors);
+        bSynthetic = true;
+    }
+
+    const int Fd = open(Filename.c_str(), O_RDONLY);
+    struct stat Stat;
+    if (Fd < 0 || fstat(Fd, &Stat) != 0 || Stat.st_size == 0)
+    {
+        std::fprintf(stderr, "Could not open %s\n", Filename.c_str());
+        return 1;
+    }
+    const uint64_t FileSize = static_cast<uint64_t>(Stat.st_size);
+    void *Mapped = mmap(nullptr, FileSize, PROT_READ, MAP_PRIVATE, Fd, 0);
+    if (Mapped == MAP_FAILED)
+    {
+        std::fprintf(stderr, "Could not map %s\n", Filename.c_str());
+        return 1;
+    }
+    std::printf("%s: %.1f MB, best of %d\n", Filename.c_str(), FileSize / 1e6, Repeat);
+
+    ParseResult Stream, Direct, Map;
+    const double StreamTime = BestOf(Repeat, [&] {
+        std::ifstream In(Filename, std::ios::binary);
+        Stream = Parse<StreamRead>(In);
+    });
+    const double DirectTime = BestOf(Repeat, [&] {
+        std::ifstream In(Filename, std::ios::binary);
+        Direct = Parse<DirectRead>(In);
+    });
+    const double MappedTime = BestOf(Repeat, [&] {
+        std::ifstream In(Filename, std::ios::binary); // same setup as the replayer: open, then attach the mapping
+        DReyeVRMappedBuffer Buffer;
+        Buffer.Reset(static_cast<const char *>(Mapped), FileSize);
+        Buffer.Attach(In);
+        Map = Parse<DirectRead>(In);
+        Buffer.Detach(In);
+    });
+
+    Report("stream", StreamTime, FileSize, Stream);
+    Report("direct", DirectTime, FileSize, Direct);
+    Report("mapped", MappedTime, FileSize, Map);
+    std::printf("mapped speedup over stream: %.2fx\n", StreamTime / MappedTime);
+
+    munmap(Mapped, FileSize);
+    close(Fd);
+    if (bSynthetic)
+        std::remove(Filename.c_str());
+
+    const bool bMatch = Stream.Packets == Map.Packets && Stream.Positions == Map.Positions &&
+                        Direct.Packets == Map.Packets && Stream.Checksum == Map.Checksum;
+    if (!bMatch)
+        std::fprintf(stderr, "Read paths disagree!\n");
+    return bMatch ? 0 : 1;
+}
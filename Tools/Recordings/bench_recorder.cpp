@@ -0,0 +1,774 @@
+// Benchmark suite of the recorder and replayer paths on synthetic recordings (no simulator required)
+//
+// Writes a synthetic recording with RecordingWriter (the packets ACarlaRecorder::Write writes, in the same order) for
+// a configurable number of actors, custom actors and DReyeVR samples per second, then measures:
+//   write - bytes per frame (and per packet type) and the cost of writing each frame
+//   scan  - parsing every frame in order (what CarlaReplayer::ProcessToTime does while playing)
+//   seek  - jumping to random times like the replayer: to the closest keyframe through the frame index, then parsing
+//           frames up to the target
+//   query - collisions + blocked actors over frame-aligned chunks merged in order (CarlaRecorderQuery::Query, with
+//           DReyeVRQueryEngine), on one thread and on --threads threads
+//   components - the UE-free parts of the EgoSensor on synthetic data: the fixation classifier, the dwell
+//                accumulator, the gaze-cone index and the frame container writer
+// Everything is printed, and written to --json as a machine-readable report (see python/bench_compare.py to compare
+// two reports and flag regressions).
+//
+// usage: bench_recorder [--frames N] [--hz N] [--actors N] [--custom-actors N] [--dreyevr-hz N] [--keyframe S]
+//                       [--compact] [--intern] [--no-index] [--seeks N] [--threads N] [--label L] [--json FILE]
+//                       [--dir DIR] [--keep]
+
+#include "DReyeVRDwellAccumulator.h"
+#include "DReyeVRFrameContainer.h"
+#include "DReyeVRGazeClassifier.h"
+#include "DReyeVRGazeCone.h"
+#include "DReyeVRQueryEngine.h"
+#include "DReyeVRRecording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace DReyeVRRec;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point Start)
+{
+    return std::chrono::duration<double>(Clock::now() - Start).count();
+}
+
+struct Config
+{
+    uint64_t Frames = 36000; // 10 minutes at 60 Hz
+    uint32_t Hz = 60;
+    uint32_t Actors = 100;
+    uint32_t CustomActors = 4;
+    double DReyeVRHz = 90.0; // eye tracker rate (several samples in some frames)
+    double KeyframeInterval = 10.0;
+    bool bCompact = false;
+    bool bIntern = false;
+    bool bFrameIndex = true;
+    uint32_t Seeks = 200;
+    size_t Threads = 0;
+    std::string Label;
+    std::string Json;
+    std::string Dir = "/tmp/dreyevr_bench_recorder";
+    bool bKeep = false;
+};
+
+struct Summary
+{
+    double Mean = 0.0, P50 = 0.0, P99 = 0.0, Max = 0.0;
+};
+
+Summary Summarize(std::vector<double> Values)
+{
+    Summary Out;
+    if (Values.empty())
+        return Out;
+    std::sort(Values.begin(), Values.end());
+    double Sum = 0.0;
+    for (double Value : Values)
+        Sum += Value;
+    Out.Mean = Sum / Values.size();
+    Out.P50 = Values[Values.size() / 2];
+    Out.P99 = Values[std::min(Values.size() - 1, Values.size() * 99 / 100)];
+    Out.Max = Values.back();
+    return Out;
+}
+
+/// ========================================== ///
+/// ----------:SYNTHETIC RECORDING:----------- ///
+/// ========================================== ///
+
+// every 5th actor stops for half of each minute (blocked), the others drive in circles at ~10 m/s
+Vec3 ActorLocation(uint32_t Actor, double Elapsed)
+{
+    const bool bStopped = (Actor % 5 == 0) && std::fmod(Elapsed, 60.0) >= 30.0;
+    const double t = bStopped ? 30.0 * std::floor(Elapsed / 30.0) : Elapsed;
+    const double Radius = 2000.0 + 50.0 * Actor;
+    const double Angle = 1000.0 * t / Radius + Actor;
+    return {static_cast<float>(Radius * std::cos(Angle)), static_cast<float>(Radius * std::sin(Angle)), 20.f};
+}
+
+void MakeSample(AggregateData &Data, uint64_t Sample, double Elapsed)
+{
+    const float t = static_cast<float>(Elapsed);
+    Data.TimestampCarla = static_cast<int64_t>(1000.0 * Elapsed);
+    Data.EgoVars.VehicleLocation = ActorLocation(0, Elapsed);
+    Data.EgoVars.VehicleRotation = {0.f, 0.f, std::fmod(10.f * t, 360.f)};
+    Data.EgoVars.CameraLocationAbs = Data.EgoVars.VehicleLocation;
+    Data.EgoVars.CameraRotationAbs = Data.EgoVars.VehicleRotation;
+    Data.EgoVars.Velocity = 1000.f;
+    Data.EyeTrackerData.TimestampDevice = Data.TimestampCarla;
+    Data.EyeTrackerData.FrameSequence = static_cast<int64_t>(Sample);
+    Data.EyeTrackerData.Combined.GazeDir = {1.f, 0.2f * std::sin(3.f * t), 0.1f * std::cos(2.f * t)};
+    Data.EyeTrackerData.Combined.GazeValid = (Sample % 50) != 0;
+    Data.EyeTrackerData.Combined.Vergence = 200.f + 10.f * std::sin(t);
+    Data.EyeTrackerData.Left.EyeOpenness = 0.9f;
+    Data.EyeTrackerData.Left.PupilDiameter = 3.f + 0.5f * std::sin(0.5f * t);
+    Data.EyeTrackerData.Right.EyeOpenness = 0.9f;
+    Data.EyeTrackerData.Right.PupilDiameter = 3.f + 0.5f * std::cos(0.5f * t);
+    Data.FocusData.ActorNameTag = ((Sample / 200) % 4 == 0) ? "None" : "Vehicle_" + std::to_string((Sample / 200) % 7);
+    Data.FocusData.bDidHit = Data.FocusData.ActorNameTag != "None";
+    Data.FocusData.Distance = 1000.f + 100.f * std::sin(t);
+    Data.Inputs.Throttle = 0.5f + 0.5f * std::sin(0.2f * t);
+    Data.Inputs.Steering = 0.1f * std::sin(0.3f * t);
+}
+
+struct WriteResult
+{
+    std::vector<double> FrameSeconds; // cost of every WriteFrame
+    double CloseSeconds = 0.0;        // (frame index)
+    double TotalSeconds = 0.0;
+    uint64_t Samples = 0;
+    uint64_t Keyframes = 0;
+};
+
+WriteResult WriteSynthetic(const std::string &Filename, const Config &Cfg)
+{
+    WriteResult Result;
+    RecordingWriter Writer;
+    RecordingWriter::Options Opts;
+    Opts.bCompact = Cfg.bCompact;
+    Opts.bInternCustomActors = Cfg.bIntern;
+    Opts.bFrameIndex = Cfg.bFrameIndex;
+    Info Header;
+    Header.Version = 1;
+    Header.Magic = "CARLA_RECORDER";
+    Header.Date = static_cast<int64_t>(std::time(nullptr));
+    Header.Map = "Town03";
+    if (!Writer.Open(Filename, Header, Opts))
+        return Result;
+
+    std::vector<EventAdd> Actors(Cfg.Actors);
+    for (uint32_t a = 0; a < Cfg.Actors; a++)
+    {
+        Actors[a].DatabaseId = a + 1;
+        Actors[a].Type = (a % 4 == 3) ? 2 : 1; // vehicles and walkers
+        Actors[a].UId = a + 1;
+        Actors[a].Location = ActorLocation(a, 0.0);
+        Actors[a].Id = (Actors[a].Type == 1) ? "vehicle.tesla.model3" : "walker.pedestrian.0001";
+        Actors[a].Attributes.push_back({2, "role_name", a == 0 ? "hero" : "autopilot"});
+    }
+
+    FrameData Frame;
+    double DReyeVRDue = 0.0, LastKeyframe = 0.0;
+    Result.FrameSeconds.reserve(Cfg.Frames);
+    const auto Start = Clock::now();
+    for (uint64_t i = 0; i < Cfg.Frames; i++)
+    {
+        const double Elapsed = static_cast<double>(i) / Cfg.Hz;
+        Frame.Clear();
+        Frame.Header.Id = i + 1;
+        Frame.Header.Duration = 1.0 / Cfg.Hz;
+        Frame.Header.Elapsed = Elapsed;
+        if (i == 0)
+        {
+            Frame.Adds = Actors;
+            Frame.ConfigFile = "[Recorder]\nCompactEncoding=" + std::string(Cfg.bCompact ? "True" : "False") + "\n";
+        }
+        if (i > 0 && Cfg.KeyframeInterval > 0.0 && Elapsed - LastKeyframe >= Cfg.KeyframeInterval)
+        {
+            Frame.KeyframeData.emplace();
+            Frame.KeyframeData->Actors = Actors;
+            LastKeyframe = Elapsed;
+            Result.Keyframes++;
+        }
+        // a pair of actors collides for half a second every 10 seconds
+        const uint64_t Period = 10ull * Cfg.Hz;
+        if (Cfg.Actors >= 2 && i % Period < Period / 20)
+        {
+            const uint32_t Pair = static_cast<uint32_t>(i / Period) % (Cfg.Actors - 1);
+            Frame.Collisions.push_back({static_cast<uint32_t>(i / Period), Pair + 1, Pair + 2, Pair == 0, false});
+        }
+        Frame.Positions.resize(Cfg.Actors);
+        for (uint32_t a = 0; a < Cfg.Actors; a++)
+        {
+            Frame.Positions[a].DatabaseId = a + 1;
+            Frame.Positions[a].Location = ActorLocation(a, Elapsed);
+            Frame.Positions[a].Rotation = {0.f, 0.f, static_cast<float>(std::fmod(10.0 * Elapsed + a, 360.0))};
+        }
+        for (DReyeVRDue += Cfg.DReyeVRHz / Cfg.Hz; DReyeVRDue >= 1.0; DReyeVRDue -= 1.0)
+            MakeSample(Frame.DReyeVR.emplace_back(), Result.Samples++, Elapsed);
+        for (uint32_t c = 0; c < Cfg.CustomActors; c++)
+        {
+            CustomActorData &Custom = Frame.CustomActors.emplace_back();
+            Custom.Name = "DReyeVR_CustomActor_" + std::to_string(c);
+            Custom.Location = {100.f * c + static_cast<float>(10.0 * Elapsed), 5.f, 100.f};
+            Custom.Scale3D = {1.f, 1.f, 1.f};
+            Custom.MeshPath = "StaticMesh'/Game/DReyeVR/Custom/Sphere.Sphere'";
+            Custom.BaseColor = {1.f, 0.f, 0.f, 1.f};
+            Custom.MaterialPath = "Material'/Game/DReyeVR/Custom/OpaqueParamMaterial.OpaqueParamMaterial'";
+        }
+
+        const auto FrameStart = Clock::now();
+        Writer.WriteFrame(Frame);
+        Result.FrameSeconds.push_back(Seconds(FrameStart));
+    }
+    const auto CloseStart = Clock::now();
+    Writer.Close();
+    Result.CloseSeconds = Seconds(CloseStart);
+    Result.TotalSeconds = Seconds(Start);
+    return Result;
+}
+
+/// ========================================== ///
+/// -------------:SEEK AND QUERY:------------- ///
+/// ========================================== ///
+
+// as the replayer: from the closest keyframe at or before Time (or the first frame), parses frames up to Time
+bool SeekTo(RecordingReader &Reader, double Time, FrameData &Frame)
+{
+    const FrameIndex &Index = Reader.GetFrameIndex();
+    if (Index.Frames.empty())
+    {
+        Reader.Rewind();
+    }
+    else
+    {
+        auto It = std::upper_bound(Index.Keyframes.begin(), Index.Keyframes.end(), Time,
+                                   [&](double T, const std::pair<uint32_t, uint64_t> &Keyframe) {
+                                       return T < Index.Frames[Keyframe.first].Elapsed;
+                                   });
+        const uint64_t Offset =
+            (It == Index.Keyframes.begin()) ? Index.Frames.front().Offset : Index.Frames[std::prev(It)->first].Offset;
+        if (!Reader.Seek(Offset))
+            return false;
+    }
+    while (Reader.NextFrame(Frame))
+    {
+        if (Frame.Header.Elapsed + Frame.Header.Duration > Time)
+            return true;
+    }
+    return false;
+}
+
+struct QueryResult
+{
+    uint64_t Collisions = 0; // collisions that started (not going on from the previous frame)
+    uint64_t Blocked = 0;    // stops longer than MinTime
+    double BlockedSeconds = 0.0;
+    size_t Chunks = 0;
+};
+
+// per chunk extract, as CarlaRecorderQuery::FChunkResult
+struct ChunkExtract
+{
+    struct FrameRecord
+    {
+        double Elapsed, Duration;
+        size_t NumAdds, NumDels, NumCollisions, NumPositions;
+    };
+    std::vector<FrameRecord> Frames;
+    std::vector<uint32_t> Adds, Dels;
+    std::vector<std::pair<uint32_t, uint32_t>> Collisions;
+    std::vector<std::pair<uint32_t, Vec3>> Positions;
+};
+
+QueryResult RunQuery(const std::string &Filename, size_t NumThreads, double MinTime, double MinDistance)
+{
+    QueryResult Result;
+    RecordingReader Main;
+    if (!Main.Open(Filename))
+        return Result;
+
+    // chunks start at frames (or only at keyframes, where the compact deltas restart)
+    std::vector<uint64_t> Starts;
+    const FrameIndex &Index = Main.GetFrameIndex();
+    FrameData First;
+    const bool bCompact = Main.NextFrame(First) && Main.GetStats().Packets.count(
+                                                       static_cast<uint8_t>(PacketId::DReyeVRCompactPosition)) > 0;
+    if (Index.Frames.empty())
+        Starts.push_back(First.Offset);
+    else if (!bCompact)
+        for (const FrameIndexEntry &Entry : Index.Frames)
+            Starts.push_back(Entry.Offset);
+    else
+    {
+        Starts.push_back(Index.Frames.front().Offset);
+        for (const auto &Keyframe : Index.Keyframes)
+            Starts.push_back(Index.Frames[Keyframe.first].Offset);
+    }
+
+    DReyeVRQueryEngine Engine(NumThreads);
+    const std::vector<DReyeVRQueryChunk> Plan =
+        DReyeVRSplitChunks(Starts, Main.GetSize(), std::max<size_t>(Engine.GetNumThreads(), Main.GetSize() >> 23));
+    std::vector<ChunkExtract> Chunks(Plan.size());
+    Result.Chunks = Plan.size();
+
+    auto Parse = [&](size_t i) {
+        RecordingReader Reader;
+        ChunkExtract &Out = Chunks[i];
+        if (!Reader.Open(Filename) || !Reader.Seek(Plan[i].Begin))
+            return;
+        FrameData Frame;
+        while (Reader.GetPosition() < Plan[i].End && Reader.NextFrame(Frame))
+        {
+            Out.Frames.push_back({Frame.Header.Elapsed, Frame.Header.Duration, Frame.Adds.size(), Frame.Dels.size(),
+                                  Frame.Collisions.size(), Frame.Positions.size()});
+            for (const EventAdd &Add : Frame.Adds)
+                Out.Adds.push_back(Add.DatabaseId);
+            for (const EventDel &Del : Frame.Dels)
+                Out.Dels.push_back(Del.DatabaseId);
+            for (const Collision &Hit : Frame.Collisions)
+                Out.Collisions.emplace_back(Hit.DatabaseId1, Hit.DatabaseId2);
+            for (const Position &Pos : Frame.Positions)
+                Out.Positions.emplace_back(Pos.DatabaseId, Pos.Location);
+        }
+    };
+
+    struct ActorState
+    {
+        Vec3 LastPosition;
+        double Time = 0.0, Duration = 0.0;
+    };
+    std::unordered_map<uint32_t, ActorState> Actors;
+    std::set<std::pair<uint32_t, uint32_t>> OldCollisions, NewCollisions;
+    auto Stopped = [&](const ActorState &Actor) {
+        if (Actor.Duration >= MinTime)
+        {
+            Result.Blocked++;
+            Result.BlockedSeconds += Actor.Duration;
+        }
+    };
+    auto Merge = [&](size_t i) {
+        ChunkExtract &Chunk = Chunks[i];
+        size_t Add = 0, Del = 0, Hit = 0, Pos = 0;
+        for (const ChunkExtract::FrameRecord &Frame : Chunk.Frames)
+        {
+            for (size_t End = Add + Frame.NumAdds; Add < End; Add++)
+                Actors[Chunk.Adds[Add]] = ActorState();
+            for (size_t End = Del + Frame.NumDels; Del < End; Del++)
+                Actors.erase(Chunk.Dels[Del]);
+            std::swap(OldCollisions, NewCollisions);
+            NewCollisions.clear();
+            for (size_t End = Hit + Frame.NumCollisions; Hit < End; Hit++)
+            {
+                Result.Collisions += OldCollisions.count(Chunk.Collisions[Hit]) == 0;
+                NewCollisions.insert(Chunk.Collisions[Hit]);
+            }
+            for (size_t End = Pos + Frame.NumPositions; Pos < End; Pos++)
+            {
+                ActorState &Actor = Actors[Chunk.Positions[Pos].first];
+                const Vec3 &Location = Chunk.Positions[Pos].second;
+                const double Distance = std::sqrt(std::pow(Location.X - Actor.LastPosition.X, 2) +
+                                                  std::pow(Location.Y - Actor.LastPosition.Y, 2) +
+                                                  std::pow(Location.Z - Actor.LastPosition.Z, 2));
+                if (Distance < MinDistance)
+                {
+                    if (Actor.Duration == 0)
+                        Actor.Time = Frame.Elapsed;
+                    Actor.Duration += Frame.Duration;
+                }
+                else
+                {
+                    Stopped(Actor);
+                    Actor.Duration = 0;
+                    Actor.LastPosition = Location;
+                }
+            }
+        }
+        Chunk = ChunkExtract();
+    };
+    Engine.Run(Plan.size(), Parse, Merge);
+    for (const auto &Actor : Actors)
+        Stopped(Actor.second);
+    return Result;
+}
+
+/// ========================================== ///
+/// ------------:SENSOR COMPONENTS:----------- ///
+/// ========================================== ///
+
+// eye-tracker readings classified per second, 42 readings of fixation then 18 of saccade
+double BenchGazeClassifier(DReyeVRGazeClassifierParams::EMethod Method, size_t &NumEvents)
+{
+    const int NumReadings = 2000000;
+    DReyeVRGazeClassifierParams Params;
+    Params.Method = Method;
+    DReyeVRGazeClassifier Classifier(Params);
+    std::vector<DReyeVRFixationEvent> Events;
+    const std::string Actors[] = {"Vehicle_1", "Walker_2", "None"};
+    const auto Start = Clock::now();
+    NumEvents = 0;
+    for (int i = 0; i < NumReadings; i++)
+    {
+        const int Phase = i % 60;
+        const float Yaw = (Phase < 42 ? 0.001f * Phase : 0.05f + 0.5f * (Phase - 42)) / 57.2957795f;
+        Classifier.Add(8 * int64_t(i), std::cos(Yaw), std::sin(Yaw), 0.01f, (i % 997) != 0, Actors[(i / 60) % 3],
+                       Events);
+        NumEvents += Events.size();
+        Events.clear();
+    }
+    return NumReadings / Seconds(Start);
+}
+
+// dwell updates per second, 20 ticks per glance over more actors than are tracked
+double BenchDwellAccumulator(size_t &NumDropped)
+{
+    const int NumTicks = 5000000;
+    DReyeVRDwellAccumulator Dwell(1024);
+    const auto Start = Clock::now();
+    for (int i = 0; i < NumTicks; i++)
+    {
+        const uint32_t Glance = static_cast<uint32_t>(i / 20);
+        const uint32_t Actor = (Glance % 5 == 0) ? 0 : 1 + (Glance * 2654435761u) % 2000;
+        Dwell.Add(16 * int64_t(i), Actor);
+    }
+    const double UpdatesPerSecond = NumTicks / Seconds(Start);
+    NumDropped = static_cast<size_t>(Dwell.GetNumDroppedActors());
+    return UpdatesPerSecond;
+}
+
+struct GazeConeResult
+{
+    size_t Actors = 0;
+    double UpdateUs = 0.0, QueryUs = 0.0, QueryAllUs = 0.0, HitsPerTick = 0.0;
+    bool bMatched = true; // the grid found as many actors as testing every one
+};
+
+// per-tick cost of the gaze cone with NumActors actors within 300 m (a tenth of them moving): updating the grid and
+// querying it, against testing every actor (the cost that a physics sweep over the same actors would scale with)
+GazeConeResult BenchGazeCone(size_t NumActors)
+{
+    const int NumTicks = 20000;
+    std::mt19937 Rng(11);
+    std::uniform_real_distribution<float> Pos(-30000.f, 30000.f);
+    std::uniform_real_distribution<float> Yaws(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> Pitches(-0.1f, 0.1f);
+    const float Sizes[] = {250.f, 60.f, 30.f}; // cm (cars, walkers, props)
+    DReyeVRGazeConeIndex Index(2000.f);
+    std::vector<DReyeVRGazeConeIndex::Vec> Centers(NumActors);
+    std::vector<float> Radii(NumActors);
+    for (size_t i = 0; i < NumActors; i++)
+    {
+        Centers[i] = {Pos(Rng), Pos(Rng), 100.f};
+        Radii[i] = Sizes[i % 3];
+    }
+    std::vector<DReyeVRGazeConeIndex::Vec> Dirs(64);
+    for (DReyeVRGazeConeIndex::Vec &Dir : Dirs)
+    {
+        const float Yaw = Yaws(Rng), Pitch = Pitches(Rng);
+        Dir = {std::cos(Yaw) * std::cos(Pitch), std::sin(Yaw) * std::cos(Pitch), std::sin(Pitch)};
+    }
+
+    GazeConeResult Out;
+    Out.Actors = NumActors;
+    std::vector<DReyeVRGazeConeHit> Hits, AllHits;
+    size_t NumHits = 0;
+    for (int Tick = 0; Tick < NumTicks; Tick++)
+    {
+        const auto T0 = Clock::now();
+        Index.BeginUpdate();
+        for (size_t i = 0; i < NumActors; i++)
+        {
+            if (Tick > 0 && i % 10 == 0)
+                Centers[i].Y += 25.f; // (15 m/s at 60 Hz)
+            Index.Update(static_cast<uint32_t>(i + 1), Centers[i], Radii[i]);
+        }
+        Index.RemoveStale();
+        const DReyeVRGazeConeIndex::Vec &Dir = Dirs[Tick % Dirs.size()];
+        const auto T1 = Clock::now();
+        Index.Query({0.f, 0.f, 120.f}, Dir, 5.f, 10000.f, 8, Hits);
+        const auto T2 = Clock::now();
+        Index.QueryAll({0.f, 0.f, 120.f}, Dir, 5.f, 10000.f, 8, AllHits);
+        const auto T3 = Clock::now();
+        Out.UpdateUs += std::chrono::duration<double>(T1 - T0).count();
+        Out.QueryUs += std::chrono::duration<double>(T2 - T1).count();
+        Out.QueryAllUs += std::chrono::duration<double>(T3 - T2).count();
+        NumHits += Hits.size();
+        Out.bMatched = Out.bMatched && (Hits.size() == AllHits.size());
+    }
+    Out.UpdateUs *= 1e6 / NumTicks;
+    Out.QueryUs *= 1e6 / NumTicks;
+    Out.QueryAllUs *= 1e6 / NumTicks;
+    Out.HitsPerTick = static_cast<double>(NumHits) / NumTicks;
+    return Out;
+}
+
+struct FrameContainerResult
+{
+    uint64_t Frames = 0;
+    double AddMs = 0.0, StallMs = 0.0, MBPerSecond = 0.0;
+};
+
+// 1280x720 raw frames written through the container writer thread: the cost on the game thread (Add) and the
+// throughput to disk
+FrameContainerResult BenchFrameContainer(const std::string &Filename)
+{
+    const uint32_t Width = 1280, Height = 720;
+    const int NumFrames = 240;
+    std::vector<uint8_t> Pixels(size_t(Width) * Height * 4);
+    for (size_t i = 0; i < Pixels.size(); i++)
+        Pixels[i] = static_cast<uint8_t>(i / 4);
+    DReyeVRFrameContainerWriter Writer;
+    Writer.Start(8);
+    const int Stream = Writer.AddStream(Filename, Width, Height, 0, 0);
+    double AddSeconds = 0.0;
+    const auto Start = Clock::now();
+    for (int Frame = 0; Frame < NumFrames; Frame++)
+    {
+        const auto T0 = Clock::now();
+        Writer.Add(Stream, Frame, 16 * Frame, Pixels.data(), Pixels.size());
+        AddSeconds += Seconds(T0);
+    }
+    Writer.Close();
+    const double TotalSeconds = Seconds(Start);
+    const DReyeVRFrameContainerStats Stats = Writer.GetStats();
+    std::remove(Filename.c_str());
+
+    FrameContainerResult Out;
+    Out.Frames = Stats.FramesWritten;
+    Out.AddMs = 1e3 * AddSeconds / NumFrames;
+    Out.StallMs = 1e3 * Stats.StallSeconds;
+    Out.MBPerSecond = Stats.BytesWritten / TotalSeconds / 1e6;
+    return Out;
+}
+
+/// ========================================== ///
+/// ---------------:REPORT:------------------- ///
+/// ========================================== ///
+
+void PutSummary(std::FILE *Out, const char *Name, const Summary &S, double Scale, const char *Next)
+{
+    std::fprintf(Out, "\"%s\": {\"mean\": %.6g, \"p50\": %.6g, \"p99\": %.6g, \"max\": %.6g}%s", Name, S.Mean * Scale,
+                 S.P50 * Scale, S.P99 * Scale, S.Max * Scale, Next);
+}
+
+int Usage()
+{
+    std::fprintf(stderr, "usage: bench_recorder [--frames N] [--hz N] [--actors N] [--custom-actors N] [--dreyevr-hz N]"
+                         " [--keyframe S]\n                      [--compact] [--intern] [--no-index] [--seeks N]"
+                         " [--threads N] [--label L] [--json FILE]\n                      [--dir DIR] [--keep]\n");
+    return 1;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Config Cfg;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string Arg = argv[i];
+        const bool bValue = i + 1 < argc;
+        if (Arg == "--frames" && bValue)
+            Cfg.Frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (Arg == "--hz" && bValue)
+            Cfg.Hz = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+        else if (Arg == "--actors" && bValue)
+            Cfg.Actors = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--custom-actors" && bValue)
+            Cfg.CustomActors = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--dreyevr-hz" && bValue)
+            Cfg.DReyeVRHz = std::atof(argv[++i]);
+        else if (Arg == "--keyframe" && bValue)
+            Cfg.KeyframeInterval = std::atof(argv[++i]);
+        else if (Arg == "--compact")
+            Cfg.bCompact = true;
+        else if (Arg == "--intern")
+            Cfg.bIntern = true;
+        else if (Arg == "--no-index")
+            Cfg.bFrameIndex = false;
+        else if (Arg == "--seeks" && bValue)
+            Cfg.Seeks = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (Arg == "--threads" && bValue)
+            Cfg.Threads = static_cast<size_t>(std::max(std::atoi(argv[++i]), 0));
+        else if (Arg == "--label" && bValue)
+            Cfg.Label = argv[++i];
+        else if (Arg == "--json" && bValue)
+            Cfg.Json = argv[++i];
+        else if (Arg == "--dir" && bValue)
+            Cfg.Dir = argv[++i];
+        else if (Arg == "--keep")
+            Cfg.bKeep = true;
+        else
+            return Usage();
+    }
+    std::filesystem::create_directories(Cfg.Dir);
+    const std::string Recording = Cfg.Dir + "/synthetic.rec";
+
+    // write
+    const WriteResult Written = WriteSynthetic(Recording, Cfg);
+    if (Written.FrameSeconds.empty())
+    {
+        std::fprintf(stderr, "could not write %s\n", Recording.c_str());
+        return 1;
+    }
+    const uint64_t Bytes = std::filesystem::file_size(Recording);
+    const Summary WriteCost = Summarize(Written.FrameSeconds);
+    std::printf("write: %" PRIu64 " frames, %u actors, %u custom actors, %" PRIu64 " DReyeVR samples, %" PRIu64
+                " keyframes\n       %.1f MB, %.0f bytes/frame, %.2f us/frame (p99 %.2f us, max %.1f us)\n",
+                Cfg.Frames, Cfg.Actors, Cfg.CustomActors, Written.Samples, Written.Keyframes, Bytes / 1e6,
+                static_cast<double>(Bytes) / Cfg.Frames, WriteCost.Mean * 1e6, WriteCost.P99 * 1e6,
+                WriteCost.Max * 1e6);
+
+    // scan
+    RecordingReader Reader;
+    auto Start = Clock::now();
+    if (!Reader.Open(Recording))
+    {
+        std::fprintf(stderr, "%s\n", Reader.GetError().c_str());
+        return 1;
+    }
+    const double OpenSeconds = Seconds(Start);
+    Start = Clock::now();
+    FrameData Frame;
+    uint64_t NumFrames = 0;
+    double Duration = 0.0;
+    while (Reader.NextFrame(Frame))
+    {
+        NumFrames++;
+        Duration = Frame.Header.Elapsed;
+    }
+    const double ScanSeconds = Seconds(Start);
+    const FileStats Stats = Reader.GetStats();
+    std::printf("scan:  %.1f MB/s, %.0f frames/s (open %.2f ms)\n", Bytes / 1e6 / ScanSeconds, NumFrames / ScanSeconds,
+                OpenSeconds * 1e3);
+    if (NumFrames != Cfg.Frames || Stats.Mismatched > 0 || Stats.Undecodable > 0)
+    {
+        std::fprintf(stderr, "ERROR: read %" PRIu64 " of %" PRIu64 " frames back\n", NumFrames, Cfg.Frames);
+        return 1;
+    }
+
+    // seek
+    std::mt19937_64 Random(42);
+    std::uniform_real_distribution<double> Times(0.0, Duration);
+    std::vector<double> SeekSeconds;
+    for (uint32_t i = 0; i < Cfg.Seeks; i++)
+    {
+        const double Time = Times(Random);
+        Start = Clock::now();
+        const bool bFound = SeekTo(Reader, Time, Frame);
+        SeekSeconds.push_back(Seconds(Start));
+        if (!bFound || Frame.Header.Elapsed > Time + 1e-9)
+        {
+            std::fprintf(stderr, "ERROR: seeking to %.3f s landed at %.3f s\n", Time, Frame.Header.Elapsed);
+            return 1;
+        }
+    }
+    const Summary Seek = Summarize(SeekSeconds);
+    std::printf("seek:  %u seeks, %.3f ms (p99 %.3f ms, max %.3f ms)\n", Cfg.Seeks, Seek.Mean * 1e3, Seek.P99 * 1e3,
+                Seek.Max * 1e3);
+
+    // query
+    const double MinTime = 10.0, MinDistance = 10.0;
+    Start = Clock::now();
+    const QueryResult Single = RunQuery(Recording, 1, MinTime, MinDistance);
+    const double SingleSeconds = Seconds(Start);
+    Start = Clock::now();
+    const QueryResult Parallel = RunQuery(Recording, Cfg.Threads, MinTime, MinDistance);
+    const double ParallelSeconds = Seconds(Start);
+    const size_t Threads = DReyeVRQueryEngine(Cfg.Threads).GetNumThreads();
+    std::printf("query: %" PRIu64 " collisions, %" PRIu64 " blocked, 1 thread %.3f s, %zu threads %.3f s (%zu chunks,"
+                " %.1fx)\n",
+                Parallel.Collisions, Parallel.Blocked, SingleSeconds, Threads, ParallelSeconds, Parallel.Chunks,
+                SingleSeconds / ParallelSeconds);
+    if (Single.Collisions != Parallel.Collisions || Single.Blocked != Parallel.Blocked ||
+        std::fabs(Single.BlockedSeconds - Parallel.BlockedSeconds) > 1e-6 * Single.BlockedSeconds)
+    {
+        std::fprintf(stderr, "ERROR: the parallel query does not match the single threaded one\n");
+        return 1;
+    }
+
+    // components
+    size_t IVTEvents = 0, IDTEvents = 0, DwellDropped = 0;
+    const double IVTRate = BenchGazeClassifier(DReyeVRGazeClassifierParams::EMethod::Velocity, IVTEvents);
+    const double IDTRate = BenchGazeClassifier(DReyeVRGazeClassifierParams::EMethod::Dispersion, IDTEvents);
+    std::printf("gaze classifier: I-VT %.1f M readings/s (%zu events), I-DT %.1f M readings/s (%zu events)\n",
+                IVTRate / 1e6, IVTEvents, IDTRate / 1e6, IDTEvents);
+    const double DwellRate = BenchDwellAccumulator(DwellDropped);
+    std::printf("dwell accumulator: %.1f M updates/s (%zu dropped glances)\n", DwellRate / 1e6, DwellDropped);
+    std::vector<GazeConeResult> Cones;
+    for (const size_t NumActors : {size_t(100), size_t(250), size_t(500)})
+    {
+        Cones.push_back(BenchGazeCone(NumActors));
+        const GazeConeResult &Cone = Cones.back();
+        std::printf("gaze cone (%zu actors): update %.2f us/tick, query %.2f us (every actor %.2f us), %.2f hits/tick"
+                    "\n",
+                    Cone.Actors, Cone.UpdateUs, Cone.QueryUs, Cone.QueryAllUs, Cone.HitsPerTick);
+        if (!Cone.bMatched)
+        {
+            std::fprintf(stderr, "ERROR: the gaze cone grid does not match testing every actor\n");
+            return 1;
+        }
+    }
+    const FrameContainerResult Container = BenchFrameContainer(Cfg.Dir + "/bench.dvrf");
+    std::printf("frame container (1280x720 raw): %.2f ms/frame on the game thread (%.1f ms stalled in total), "
+                "%.0f MB/s to disk\n",
+                Container.AddMs, Container.StallMs, Container.MBPerSecond);
+    if (IVTEvents == 0 || IDTEvents == 0 || Container.Frames != 240)
+    {
+        std::fprintf(stderr, "ERROR: a component benchmark did not do its work\n");
+        return 1;
+    }
+
+    if (!Cfg.Json.empty())
+    {
+        std::FILE *Out = std::fopen(Cfg.Json.c_str(), "w");
+        if (Out == nullptr)
+        {
+            std::fprintf(stderr, "could not write %s\n", Cfg.Json.c_str());
+            return 1;
+        }
+        std::fprintf(Out, "{\n  \"format\": \"dreyevr-bench-recorder\",\n  \"version\": 2,\n  \"label\": \"%s\",\n",
+                     Cfg.Label.c_str());
+        std::fprintf(Out, "  \"date\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+        std::fprintf(Out,
+                     "  \"config\": {\"frames\": %" PRIu64 ", \"hz\": %u, \"actors\": %u, \"custom_actors\": %u, "
+                     "\"dreyevr_hz\": %g, \"keyframe_interval\": %g, \"compact\": %s, \"intern\": %s, "
+                     "\"frame_index\": %s, \"seeks\": %u, \"threads\": %zu},\n",
+                     Cfg.Frames, Cfg.Hz, Cfg.Actors, Cfg.CustomActors, Cfg.DReyeVRHz, Cfg.KeyframeInterval,
+                     Cfg.bCompact ? "true" : "false", Cfg.bIntern ? "true" : "false",
+                     Cfg.bFrameIndex ? "true" : "false", Cfg.Seeks, Threads);
+        std::fprintf(Out, "  \"recording\": {\"bytes\": %" PRIu64 ", \"bytes_per_frame\": %.2f, \"packets\": {", Bytes,
+                     static_cast<double>(Bytes) / Cfg.Frames);
+        for (auto It = Stats.Packets.begin(); It != Stats.Packets.end(); ++It)
+            std::fprintf(Out, "%s\"%s\": {\"count\": %" PRIu64 ", \"bytes\": %" PRIu64 "}",
+                         It == Stats.Packets.begin() ? "" : ", ", GetPacketName(It->first), It->second.Count,
+                         It->second.Bytes);
+        std::fprintf(Out, "}},\n  \"write\": {");
+        PutSummary(Out, "us_per_frame", WriteCost, 1e6, ", ");
+        std::fprintf(Out, "\"close_ms\": %.6g, \"mb_per_s\": %.6g},\n", Written.CloseSeconds * 1e3,
+                     Bytes / 1e6 / Written.TotalSeconds);
+        std::fprintf(Out, "  \"scan\": {\"open_ms\": %.6g, \"seconds\": %.6g, \"mb_per_s\": %.6g, \"frames_per_s\": %.6g},\n",
+                     OpenSeconds * 1e3, ScanSeconds, Bytes / 1e6 / ScanSeconds, NumFrames / ScanSeconds);
+        std::fprintf(Out, "  \"seek\": {\"count\": %u, ", Cfg.Seeks);
+        PutSummary(Out, "ms", Seek, 1e3, "},\n");
+        std::fprintf(Out,
+                     "  \"query\": {\"threads\": %zu, \"chunks\": %zu, \"seconds_1_thread\": %.6g, \"seconds\": %.6g, "
+                     "\"collisions\": %" PRIu64 ", \"blocked\": %" PRIu64 "},\n",
+                     Threads, Parallel.Chunks, SingleSeconds, ParallelSeconds, Parallel.Collisions, Parallel.Blocked);
+        std::fprintf(Out,
+                     "  \"components\": {\"gaze_classifier\": {\"ivt_readings_per_s\": %.6g, "
+                     "\"idt_readings_per_s\": %.6g}, \"dwell\": {\"updates_per_s\": %.6g},\n    \"gaze_cone\": {",
+                     IVTRate, IDTRate, DwellRate);
+        for (size_t i = 0; i < Cones.size(); i++)
+            std::fprintf(Out, "%s\"actors_%zu\": {\"update_us\": %.6g, \"query_us\": %.6g, \"query_all_us\": %.6g}",
+                         i == 0 ? "" : ", ", Cones[i].Actors, Cones[i].UpdateUs, Cones[i].QueryUs, Cones[i].QueryAllUs);
+        std::fprintf(Out,
+                     "},\n    \"frame_container\": {\"add_ms\": %.6g, \"stall_ms\": %.6g, \"mb_per_s\": %.6g}}\n}\n",
+                     Container.AddMs, Container.StallMs, Container.MBPerSecond);
+        std::fclose(Out);
+        std::printf("report: %s\n", Cfg.Json.c_str());
+    }
+
+    if (!Cfg.bKeep)
+        std::filesystem::remove_all(Cfg.Dir);
+    return 0;
+}
@@ -0,0 +1,287 @@
+// Command line tool for DReyeVR/Carla recordings (no Unreal required)
+//
+//   info    - recording header, frame/duration summary, bytes per packet type, frame index and keyframes
+//   frames  - one line per frame with the number of records of each kind (--first/--last to select frames)
+//   dreyevr - the DReyeVR sensor channels (ego, gaze, focus, inputs) of every frame as CSV
+//   export  - the DReyeVR sensor data as one NumPy column per field + schema.json (see DReyeVRColumns.h)
+//   fixations - classifies the eye-tracker readings into fixations (as the EgoSensor does), one CSV line each
+//
+// usage: dreyevr_rec <info|frames|dreyevr> recording.rec [--first N] [--last N]
+//        dreyevr_rec export recording.rec out_dir [--columns A,B,...]
+//        dreyevr_rec fixations recording.rec [--method ivt|idt] [--velocity DEG_S] [--dispersion DEG]
+//                                            [--min-duration MS] [--max-gap MS]
+
+#include "DReyeVRColumns.h"
+#include "DReyeVRGazeClassifier.h"
+#include "DReyeVRRecording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace DReyeVRRec;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+int Usage()
+{
+    std::fprintf(stderr, "usage: dreyevr_rec <info|frames|dreyevr> recording.rec [--first N] [--last N]\n"
+                         "       dreyevr_rec export recording.rec out_dir [--columns A,B,...]\n"
+                         "       dreyevr_rec fixations recording.rec [--method ivt|idt] [--velocity DEG_S] "
+                         "[--dispersion DEG] [--min-duration MS] [--max-gap MS]\n");
+    return 1;
+}
+
+void PrintStats(const RecordingReader &Reader)
+{
+    const FileStats &Stats = Reader.GetStats();
+    std::printf("%-28s %10s %14s %8s\n", "packet", "count", "bytes", "share");
+    for (const auto &It : Stats.Packets)
+    {
+        std::printf("%-28s %10" PRIu64 " %14" PRIu64 " %7.2f%%\n", GetPacketName(It.first), It.second.Count,
+                    It.second.Bytes, 100.0 * It.second.Bytes / Reader.GetSize());
+    }
+    if (Stats.Mismatched > 0)
+        std::printf("WARNING: %" PRIu64 " packet(s) did not match their size and were skipped\n", Stats.Mismatched);
+    if (Stats.Undecodable > 0)
+        std::printf("WARNING: %" PRIu64 " compact packet(s) could not be decoded\n", Stats.Undecodable);
+    if (Stats.bTruncated)
+        std::printf("WARNING: the recording ends in the middle of a packet\n");
+}
+
+int PrintInfo(RecordingReader &Reader)
+{
+    const struct Info &Header = Reader.GetInfo();
+    const std::time_t Date = static_cast<std::time_t>(Header.Date);
+    char DateStr[64] = "";
+    std::strftime(DateStr, sizeof(DateStr), "%Y-%m-%d %H:%M:%S", std::localtime(&Date));
+    std::printf("Version: %u\nMap: %s\nDate: %s\n", Header.Version, Header.Map.c_str(), DateStr);
+
+    const auto Start = Clock::now();
+    FrameData Frame;
+    uint64_t NumFrames = 0, NumDReyeVR = 0, NumConfigs = 0;
+    double Duration = 0.0;
+    while (Reader.NextFrame(Frame))
+    {
+        NumFrames++;
+        NumDReyeVR += Frame.DReyeVR.size();
+        NumConfigs += Frame.ConfigFile ? 1 : 0;
+        Duration = Frame.Header.Elapsed;
+    }
+    const double Seconds = std::chrono::duration<double>(Clock::now() - Start).count();
+
+    std::printf("Frames: %" PRIu64 "\nDuration: %.3f s\nDReyeVR samples: %" PRIu64 "\nConfig files: %" PRIu64 "\n",
+                NumFrames, Duration, NumDReyeVR, NumConfigs);
+    const FrameIndex &Index = Reader.GetFrameIndex();
+    if (Index.Frames.empty())
+        std::printf("Frame index: none\n");
+    else
+        std::printf("Frame index: v%u, %zu frames, %zu keyframes\n", Index.Version, Index.Frames.size(),
+                    Index.Keyframes.size());
+    std::printf("Parsed %.1f MB in %.3f s (%.0f MB/s)\n\n", Reader.GetSize() / 1e6, Seconds,
+                Seconds > 0 ? Reader.GetSize() / 1e6 / Seconds : 0.0);
+    PrintStats(Reader);
+    return 0;
+}
+
+int Frames(RecordingReader &Reader, uint64_t First, uint64_t Last)
+{
+    std::printf("frame,elapsed,offset,adds,dels,parents,collisions,positions,states,vehicles,walkers,"
+                "dreyevr,custom_actors,keyframe\n");
+    FrameData Frame;
+    for (uint64_t i = 0; Reader.NextFrame(Frame) && i <= Last; i++)
+    {
+        if (i < First)
+            continue;
+        std::printf("%" PRIu64 ",%.6f,%" PRIu64 ",%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%d\n", Frame.Header.Id,
+                    Frame.Header.Elapsed, Frame.Offset, Frame.Adds.size(), Frame.Dels.size(), Frame.Parents.size(),
+                    Frame.Collisions.size(), Frame.Positions.size(), Frame.TrafficLights.size(),
+                    Frame.Vehicles.size(), Frame.Walkers.size(), Frame.DReyeVR.size(), Frame.CustomActors.size(),
+                    Frame.KeyframeData ? 1 : 0);
+    }
+    return 0;
+}
+
+void PrintVec(const Vec3 &V)
+{
+    std::printf(",%g,%g,%g", V.X, V.Y, V.Z);
+}
+
+void PrintRot(const Rot &R)
+{
+    std::printf(",%g,%g,%g", R.Pitch, R.Roll, R.Yaw);
+}
+
+int DReyeVRChannels(RecordingReader &Reader, uint64_t First, uint64_t Last)
+{
+    std::printf("frame,elapsed,timestamp_carla,timestamp_device,frame_sequence,"
+                "camera_x,camera_y,camera_z,camera_pitch,camera_roll,camera_yaw,"
+                "vehicle_x,vehicle_y,vehicle_z,vehicle_pitch,vehicle_roll,vehicle_yaw,velocity,"
+                "gaze_dir_x,gaze_dir_y,gaze_dir_z,gaze_origin_x,gaze_origin_y,gaze_origin_z,gaze_valid,vergence,"
+                "left_openness,left_pupil_diameter,right_openness,right_pupil_diameter,"
+                "focus_actor,focus_hit,focus_x,focus_y,focus_z,focus_distance,"
+                "throttle,steering,brake\n");
+    FrameData Frame;
+    for (uint64_t i = 0; Reader.NextFrame(Frame) && i <= Last; i++)
+    {
+        if (i < First)
+            continue;
+        for (const AggregateData &Data : Frame.DReyeVR)
+        {
+            const EyeTracker &Eyes = Data.EyeTrackerData;
+            std::printf("%" PRIu64 ",%.6f,%" PRId64 ",%" PRId64 ",%" PRId64, Frame.Header.Id, Frame.Header.Elapsed,
+                        Data.TimestampCarla, Eyes.TimestampDevice, Eyes.FrameSequence);
+            PrintVec(Data.EgoVars.CameraLocationAbs);
+            PrintRot(Data.EgoVars.CameraRotationAbs);
+            PrintVec(Data.EgoVars.VehicleLocation);
+            PrintRot(Data.EgoVars.VehicleRotation);
+            std::printf(",%g", Data.EgoVars.Velocity);
+            PrintVec(Eyes.Combined.GazeDir);
+            PrintVec(Eyes.Combined.GazeOrigin);
+            std::printf(",%d,%g,%g,%g,%g,%g", Eyes.Combined.GazeValid, Eyes.Combined.Vergence, Eyes.Left.EyeOpenness,
+                        Eyes.Left.PupilDiameter, Eyes.Right.EyeOpenness, Eyes.Right.PupilDiameter);
+            std::printf(",%s,%d", Data.FocusData.ActorNameTag.c_str(), Data.FocusData.bDidHit);
+            PrintVec(Data.FocusData.HitPoint);
+            std::printf(",%g,%g,%g,%g\n", Data.FocusData.Distance, Data.Inputs.Throttle, Data.Inputs.Steering,
+                        Data.Inputs.Brake);
+        }
+    }
+    return 0;
+}
+int Export(RecordingReader &Reader, const std::string &OutDir, const ExportOptions &Options)
+{
+    const auto Start = Clock::now();
+    const ExportResult Result = ExportColumns(Reader, OutDir, Options);
+    const double Seconds = std::chrono::duration<double>(Clock::now() - Start).count();
+    if (!Result.bSuccess)
+    {
+        std::fprintf(stderr, "%s\n", Result.Error.c_str());
+        return 1;
+    }
+    std::printf("Exported %" PRIu64 " rows (%" PRIu64 " frames) to %s: %.1f MB of columns in %.3f s (%.0f MB/s of "
+                "recording)\n",
+                Result.Rows, Result.Frames, OutDir.c_str(), Result.Bytes / 1e6, Seconds,
+                Seconds > 0 ? Reader.GetSize() / 1e6 / Seconds : 0.0);
+    return 0;
+}
+
+// every eye-tracker reading of the recording (packet 147 if recorded, else the one of each DReyeVR sample) with
+// the focus of its frame, through the same classifier as the EgoSensor
+int Fixations(RecordingReader &Reader, const DReyeVRGazeClassifierParams &Params)
+{
+    std::printf("start,end,duration,yaw,pitch,actor\n");
+    DReyeVRGazeClassifier Classifier(Params);
+    std::vector<DReyeVRFixationEvent> Events;
+    auto PrintEnded = [&Events]() {
+        for (const DReyeVRFixationEvent &Event : Events)
+            if (!Event.bStart)
+                std::printf("%" PRId64 ",%" PRId64 ",%" PRId64 ",%g,%g,%s\n", Event.Start, Event.End,
+                            Event.GetDuration(), Event.Yaw, Event.Pitch, Event.Actor.c_str());
+        Events.clear();
+    };
+    uint64_t NumReadings = 0, NumFixations = 0;
+    double ClassifySeconds = 0.0;
+    FrameData Frame;
+    while (Reader.NextFrame(Frame))
+    {
+        const std::string Actor = Frame.DReyeVR.empty() ? std::string() : Frame.DReyeVR.back().FocusData.ActorNameTag;
+        const auto Start = Clock::now();
+        auto Add = [&](const EyeTracker &Eyes) {
+            const Vec3 &Dir = Eyes.Combined.GazeDir;
+            NumFixations += Classifier.Add(Eyes.TimestampDevice, Dir.X, Dir.Y, Dir.Z, Eyes.Combined.GazeValid, Actor,
+                                           Events);
+            NumReadings++;
+        };
+        if (!Frame.EyeSamples.empty())
+            std::for_each(Frame.EyeSamples.begin(), Frame.EyeSamples.end(), Add);
+        else
+            for (const AggregateData &Data : Frame.DReyeVR)
+                Add(Data.EyeTrackerData);
+        ClassifySeconds += std::chrono::duration<double>(Clock::now() - Start).count();
+        PrintEnded();
+    }
+    Classifier.Flush(Events);
+    PrintEnded();
+    std::fprintf(stderr, "%" PRIu64 " readings, %" PRIu64 " fixation events, classified at %.1f M readings/s\n",
+                 NumReadings, NumFixations, ClassifySeconds > 0 ? NumReadings / ClassifySeconds / 1e6 : 0.0);
+    return 0;
+}
+
+std::vector<std::string> Split(const std::string &List)
+{
+    std::vector<std::string> Out;
+    size_t Start = 0;
+    while (Start <= List.size())
+    {
+        const size_t End = std::min(List.find(',', Start), List.size());
+        if (End > Start)
+            Out.push_back(List.substr(Start, End - Start));
+        Start = End + 1;
+    }
+    return Out;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+        return Usage();
+    const std::string Command = argv[1];
+    const bool bExport = (Command == "export");
+    if (bExport && argc < 4)
+        return Usage();
+    const bool bFixations = (Command == "fixations");
+    uint64_t First = 0, Last = UINT64_MAX;
+    ExportOptions Options;
+    DReyeVRGazeClassifierParams Params;
+    for (int i = bExport ? 4 : 3; i < argc; i++)
+    {
+        const std::string Arg = argv[i];
+        if (Arg == "--columns" && bExport && i + 1 < argc)
+            Options.Columns = Split(argv[++i]);
+        else if (Arg == "--method" && bFixations && i + 1 < argc)
+        {
+            if (!DReyeVRGazeClassifierParams::ParseMethod(argv[++i], Params.Method))
+                return Usage();
+        }
+        else if (Arg == "--velocity" && bFixations && i + 1 < argc)
+            Params.VelocityThreshold = std::strtof(argv[++i], nullptr);
+        else if (Arg == "--dispersion" && bFixations && i + 1 < argc)
+            Params.DispersionThreshold = std::strtof(argv[++i], nullptr);
+        else if (Arg == "--min-duration" && bFixations && i + 1 < argc)
+            Params.MinDuration = std::strtof(argv[++i], nullptr);
+        else if (Arg == "--max-gap" && bFixations && i + 1 < argc)
+            Params.MaxGap = std::strtof(argv[++i], nullptr);
+        else if (Arg == "--first" && i + 1 < argc)
+            First = std::strtoull(argv[++i], nullptr, 10);
+        else if (Arg == "--last" && i + 1 < argc)
+            Last = std::strtoull(argv[++i], nullptr, 10);
+        else
+            return Usage();
+    }
+
+    RecordingReader Reader;
+    if (!Reader.Open(argv[2]))
+    {
+        std::fprintf(stderr, "%s\n", Reader.GetError().c_str());
+        return 1;
+    }
+    if (Command == "info")
+        return PrintInfo(Reader);
+    if (Command == "frames")
+        return Frames(Reader, First, Last);
+    if (Command == "dreyevr")
+        return DReyeVRChannels(Reader, First, Last);
+    if (bExport)
+        return Export(Reader, argv[3], Options);
+    if (bFixations)
+        return Fixations(Reader, Params);
+    return Usage();
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+import argparse
+import json
+import sys
+from typing import Any, Dict, List, Optional, Tuple
+
+# Compares two reports of `bench_recorder --json report.json` (ex. from two versions) and flags the metrics that got
+# worse by more than a threshold. Exits with 1 if any did, so it can gate a CI job
+
+# (path in the report, True if higher is better)
+METRICS: List[Tuple[str, bool]] = [
+    ("recording.bytes_per_frame", False),
+    ("write.us_per_frame.mean", False),
+    ("write.us_per_frame.p99", False),
+    ("scan.mb_per_s", True),
+    ("scan.frames_per_s", True),
+    ("seek.ms.p50", False),
+    ("seek.ms.p99", False),
+    ("query.seconds_1_thread", False),
+    ("query.seconds", False),
+    # (version 2)
+    ("components.gaze_classifier.ivt_readings_per_s", True),
+    ("components.gaze_classifier.idt_readings_per_s", True),
+    ("components.dwell.updates_per_s", True),
+    ("components.gaze_cone.actors_250.update_us", False),
+    ("components.gaze_cone.actors_250.query_us", False),
+    ("components.frame_container.add_ms", False),
+]
+
+
+def load_report(path: str) -> Dict[str, Any]:
+    with open(path, "r") as f:
+        report = json.load(f)
+    assert report["format"] == "dreyevr-bench-recorder", f"not a bench_recorder report: {path}"
+    return report
+
+
+def get_metric(report: Dict[str, Any], path: str) -> Optional[float]:
+    # None for the metrics of a newer report version
+    value: Any = report
+    for key in path.split("."):
+        if not isinstance(value, dict) or key not in value:
+            return None
+        value = value[key]
+    return float(value)
+
+
+def compare(base: Dict[str, Any], new: Dict[str, Any], threshold: float) -> List[str]:
+    regressions: List[str] = []
+    print(f"{'metric':<50} {'base':>12} {'new':>12} {'change':>9}")
+    for path, higher_is_better in METRICS:
+        old_value, new_value = get_metric(base, path), get_metric(new, path)
+        if old_value is None or new_value is None:
+            continue
+        change = (new_value - old_value) / old_value if old_value != 0 else 0.0
+        worse = -change if higher_is_better else change
+        flag = ""
+        if worse > threshold:
+            flag = "  REGRESSION"
+            regressions.append(path)
+        print(f"{path:<50} {old_value:>12.4g} {new_value:>12.4g} {100 * change:>+8.1f}%{flag}")
+    return regressions
+
+
+def main():
+    argparser = argparse.ArgumentParser(description="Compare two bench_recorder reports")
+    argparser.add_argument("base", type=str, help="report of the reference version")
+    argparser.add_argument("new", type=str, help="report of the version to check")
+    argparser.add_argument(
+        "-t", "--threshold", type=float, default=0.1, help="relative change that is a regression (default 0.1)"
+    )
+    args = argparser.parse_args()
+
+    base, new = load_report(args.base), load_report(args.new)
+    if base["config"] != new["config"]:
+        print("WARNING: the reports were run with different configurations")
+    print(f"base: {base['label'] or args.base}, new: {new['label'] or args.new}\n")
+    regressions = compare(base, new, args.threshold)
+    if len(regressions) > 0:
+        print(f"\n{len(regressions)} metric(s) regressed by more than {100 * args.threshold:.0f}%")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+
+import argparse
+import json
+import os
+from typing import Any, Dict, List, Optional
+
+import numpy as np
+
+# Loads the columns written by `dreyevr_rec export recording.rec out_dir` (see Reader/DReyeVRColumns.h)
+# Every column is memory-mapped, so only the columns (and rows) that are used are read from disk
+
+
+def load_schema(export_dir: str) -> Dict[str, Any]:
+    with open(os.path.join(export_dir, "schema.json"), "r") as f:
+        schema = json.load(f)
+    assert schema["format"] == "dreyevr-columns", f"not a DReyeVR export: {export_dir}"
+    return schema
+
+
+def load_columns(
+    export_dir: str, columns: Optional[List[str]] = None
+) -> Dict[str, np.ndarray]:
+    schema = load_schema(export_dir)
+    available = {c["name"]: c for c in schema["columns"]}
+    names = columns if columns is not None else list(available.keys())
+    data: Dict[str, np.ndarray] = {}
+    for name in names:
+        if name not in available:
+            raise KeyError(f'no column "{name}" in {export_dir}')
+        path = os.path.join(export_dir, available[name]["file"])
+        data[name] = np.load(path, mmap_mode="r")
+        assert data[name].dtype == np.dtype(available[name]["dtype"])
+    return data
+
+
+def decode_categories(
+    export_dir: str, name: str, codes: np.ndarray
+) -> np.ndarray:
+    # ex. decode_categories(d, "Focus.ActorNameTag", cols["Focus.ActorNameTag"])
+    categories = np.array(load_schema(export_dir)["categories"][name], dtype=object)
+    return categories[codes]
+
+
+def main():
+    argparser = argparse.ArgumentParser(description="Summary of a DReyeVR column export")
+    argparser.add_argument("export_dir", type=str, help="directory written by dreyevr_rec export")
+    argparser.add_argument(
+        "-c", "--columns", type=str, default=None, help="comma separated columns to load"
+    )
+    args = argparser.parse_args()
+
+    schema = load_schema(args.export_dir)
+    print(f"map: {schema['map']}, frames: {schema['frames']}, rows: {schema['rows']}")
+    columns = args.columns.split(",") if args.columns is not None else None
+    units = {c["name"]: c["unit"] for c in schema["columns"]}
+    for name, values in load_columns(args.export_dir, columns).items():
+        unit = f" {units[name]}" if units[name] not in ("", "category") else ""
+        if values.dtype == np.bool_ or len(values) == 0:
+            print(f"{name}: {values.dtype}, {np.count_nonzero(values)}/{len(values)} true")
+        else:
+            print(
+                f"{name}: {values.dtype}, min {values.min()}, mean {values.mean():.4f}, "
+                f"max {values.max()}{unit}"
+            )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+
+import argparse
+import os
+import zlib
+from typing import List, Optional
+
+import numpy as np
+
+# Reads the replay frame containers written with [Replayer] FrameOutput="container" (one per shader and pose, ex.
+# tick_s0_p0.dvrf, see Carla/Recorder/DReyeVRFrameContainer.h). Raw frames are memory-mapped, so only the frames
+# that are used are read from disk
+
+HEADER = np.dtype(
+    [
+        ("magic", "S4"),
+        ("version", "<u2"),
+        ("header_size", "<u2"),
+        ("width", "<u4"),
+        ("height", "<u4"),
+        ("pixel_format", "<u4"),
+        ("codec", "<u4"),
+        ("shader", "<i4"),
+        ("pose", "<i4"),
+        ("reserved", "V32"),
+    ]
+)
+CHUNK = np.dtype([("magic", "S4"), ("size", "<u4"), ("frame", "<u8"), ("timestamp", "<i8")])
+INDEX = np.dtype(
+    [("frame", "<u8"), ("timestamp", "<i8"), ("offset", "<u8"), ("size", "<u4"), ("reserved", "<u4")]
+)
+FOOTER = np.dtype([("index_offset", "<u8"), ("num_frames", "<u8"), ("magic", "S8")])
+CODECS = {0: "raw", 1: "zlib"}
+
+
+class FrameContainer:
+    def __init__(self, path: str):
+        self.path = path
+        self.data = np.memmap(path, dtype=np.uint8, mode="r")
+        header = self.data[: HEADER.itemsize].view(HEADER)[0]
+        assert header["magic"] == b"DRVF", f"not a DReyeVR frame container: {path}"
+        assert header["version"] == 1 and header["pixel_format"] == 1
+        self.width = int(header["width"])
+        self.height = int(header["height"])
+        self.codec = CODECS[int(header["codec"])]
+        self.shader = int(header["shader"])
+        self.pose = int(header["pose"])
+        self.indexed = False
+        self.index = self._load_index(int(header["header_size"]))
+
+    @property
+    def frames(self) -> np.ndarray:
+        # id of the recorded frame every capture replays (as in show_recorder_file_info, not the image file ticks)
+        return self.index["frame"]
+
+    @property
+    def timestamps(self) -> np.ndarray:
+        # TimestampCarla (ms) of every capture, ex. to join with the recording's columns
+        return self.index["timestamp"]
+
+    def __len__(self) -> int:
+        return len(self.index)
+
+    def frame(self, i: int) -> np.ndarray:
+        # (height, width, 4) BGRA, read-only for raw containers (alpha as captured, the images set it to 255)
+        entry = self.index[i]
+        begin = int(entry["offset"]) + CHUNK.itemsize
+        stored = self.data[begin : begin + int(entry["size"])]
+        if self.codec == "zlib":
+            stored = np.frombuffer(zlib.decompress(stored), dtype=np.uint8)
+        return stored.reshape(self.height, self.width, 4)
+
+    def find(self, timestamp: int) -> int:
+        # index of the last capture at or before timestamp (captures are in replay order)
+        return max(int(np.searchsorted(self.timestamps, timestamp, side="right")) - 1, 0)
+
+    def _load_index(self, header_size: int) -> np.ndarray:
+        # closed containers end in the index
+        size = len(self.data)
+        if size >= header_size + FOOTER.itemsize:
+            footer = self.data[size - FOOTER.itemsize :].view(FOOTER)[0]
+            index_offset, num_frames = int(footer["index_offset"]), int(footer["num_frames"])
+            if (
+                footer["magic"] == b"DRVFIDX1"
+                and index_offset + num_frames * INDEX.itemsize + FOOTER.itemsize == size
+            ):
+                self.indexed = True
+                return self.data[index_offset : index_offset + num_frames * INDEX.itemsize].view(INDEX)
+        # otherwise every complete chunk (ex. the simulator crashed during the replay)
+        entries = []
+        offset = header_size
+        while offset + CHUNK.itemsize <= size:
+            chunk = self.data[offset : offset + CHUNK.itemsize].view(CHUNK)[0]
+            if chunk["magic"] != b"FRAM" or offset + CHUNK.itemsize + int(chunk["size"]) > size:
+                break
+            entries.append((chunk["frame"], chunk["timestamp"], offset, chunk["size"], 0))
+            offset += CHUNK.itemsize + int(chunk["size"])
+        return np.array(entries, dtype=INDEX)
+
+
+def merge_containers(inputs: List[str], output: str) -> int:
+    # concatenates the frames of containers of the same shader and pose, in order (ex. the segments of
+    # Tools/ParallelCapture) into one indexed container. Returns the frames
+    containers = [FrameContainer(path) for path in inputs]
+    first = containers[0]
+    for c in containers[1:]:
+        assert (c.width, c.height, c.codec, c.shader, c.pose) == (first.width, first.height, first.codec,
+                                                                  first.shader, first.pose), f"{c.path} differs"
+    header_size = int(first.data[: HEADER.itemsize].view(HEADER)[0]["header_size"])
+    index = []
+    with open(output, "wb") as f:
+        f.write(first.data[:header_size].tobytes())
+        offset = header_size
+        for c in containers:
+            for entry in c.index:
+                begin = int(entry["offset"])
+                f.write(c.data[begin : begin + CHUNK.itemsize + int(entry["size"])].tobytes())
+                index.append((entry["frame"], entry["timestamp"], offset, entry["size"], 0))
+                offset += CHUNK.itemsize + int(entry["size"])
+        f.write(np.array(index, dtype=INDEX).tobytes())
+        f.write(np.array([(offset, len(index), b"DRVFIDX1")], dtype=FOOTER).tobytes())
+    return len(index)
+
+
+def main():
+    argparser = argparse.ArgumentParser(description="Summary of a DReyeVR frame container")
+    argparser.add_argument("container", type=str, help="container written by the replayer's frame capture")
+    argparser.add_argument(
+        "-e", "--extract", type=str, default=None, help="directory to save every frame to (as .npy)"
+    )
+    argparser.add_argument(
+        "-t", "--timestamp", type=int, default=None, help="only the frame at this TimestampCarla (ms)"
+    )
+    args = argparser.parse_args()
+
+    frames = FrameContainer(args.container)
+    print(
+        f"{frames.width}x{frames.height} {frames.codec}, shader {frames.shader}, pose {frames.pose}: "
+        f"{len(frames)} frames{'' if frames.indexed else ' (not closed, index rebuilt)'}"
+    )
+    if len(frames) == 0:
+        return
+    print(
+        f"frames {frames.frames[0]}..{frames.frames[-1]}, "
+        f"timestamps {frames.timestamps[0]}..{frames.timestamps[-1]} ms"
+    )
+    selected: Optional[range] = None
+    if args.timestamp is not None:
+        i = frames.find(args.timestamp)
+        selected = range(i, i + 1)
+        print(f"frame {frames.frames[i]} at {frames.timestamps[i]} ms")
+    if args.extract is not None:
+        os.makedirs(args.extract, exist_ok=True)
+        for i in selected if selected is not None else range(len(frames)):
+            np.save(os.path.join(args.extract, f"{frames.frames[i]:05d}.npy"), frames.frame(i))
+
+
+if __name__ == "__main__":
+    main()
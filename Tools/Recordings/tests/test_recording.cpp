@@ -0,0 +1,896 @@
+// Round trip tests of the standalone recording reader (Reader/DReyeVRRecording.h)
+//
+// Writes synthetic recordings with the same packet layout as ACarlaRecorder (regular, compact and interned
+// packets) and checks that the reader gets every field back. With DREYEVR_TEST_RECORDING=<file.rec> it also
+// checks a recording produced by the simulator: every packet must match its size, frames must be in order and
+// the trailing frame index (if any) must point at the frames that were read. Also checks the online fixation
+// classifier (DReyeVRGazeClassifier.h) on synthetic gaze sequences, the per-actor dwell accumulator
+// (DReyeVRDwellAccumulator.h), the gaze-cone actor index (DReyeVRGazeCone.h) and the strings read by concurrent
+// query workers (DReyeVRQueryEngine.h).
+
+#include "DReyeVRColumns.h"
+#include "DReyeVRDwellAccumulator.h"
+#include "DReyeVRFrameContainer.h"
+#include "DReyeVRGazeClassifier.h"
+#include "DReyeVRGazeCone.h"
+#include "DReyeVRQueryEngine.h"
+#include "DReyeVRRecorderReader.h"
+#include "DReyeVRRecording.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DReyeVRRec;
+
+namespace
+{
+int Failures = 0;
+
+#define CHECK(Cond)                                                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(Cond))                                                                                                   \
+        {                                                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Cond);                              \
+            Failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_NEAR(A, B, Tol) CHECK(std::fabs(static_cast<double>(A) - static_cast<double>(B)) <= (Tol))
+
+std::string TempFile(const char *Name)
+{
+    const char *Dir = std::getenv("TMPDIR");
+    return std::string(Dir ? Dir : "/tmp") + "/" + Name;
+}
+
+AggregateData MakeSample(uint32_t i)
+{
+    AggregateData Data;
+    Data.TimestampCarla = 1000 + 16 * i;
+    Data.EgoVars.CameraLocation = {0.f, 0.f, 120.f};
+    Data.EgoVars.CameraRotation = {1.5f, 0.f, -3.25f + 0.01f * i};
+    Data.EgoVars.CameraLocationAbs = {1000.f + i, -200.5f, 130.f};
+    Data.EgoVars.VehicleLocation = {1000.f + i, -200.5f, 10.f};
+    Data.EgoVars.VehicleRotation = {0.f, 0.f, 90.f};
+    Data.EgoVars.Velocity = 1500.f;
+    Data.EyeTrackerData.TimestampDevice = 5000000 + 8333 * i;
+    Data.EyeTrackerData.FrameSequence = 42 + i;
+    Data.EyeTrackerData.Combined.GazeDir = {0.98f, 0.1f, -0.05f};
+    Data.EyeTrackerData.Combined.GazeValid = true;
+    Data.EyeTrackerData.Combined.Vergence = 250.f;
+    Data.EyeTrackerData.Left.EyeOpenness = 0.9f;
+    Data.EyeTrackerData.Left.EyeOpennessValid = true;
+    Data.EyeTrackerData.Left.PupilDiameter = 3.5f;
+    Data.EyeTrackerData.Left.PupilPosition = {0.25f, -0.5f};
+    Data.EyeTrackerData.Right.GazeValid = (i % 3) != 0;
+    Data.FocusData.ActorNameTag = (i < 5) ? "vehicle.tesla.model3" : "None";
+    Data.FocusData.bDidHit = (i < 5);
+    Data.FocusData.HitPoint = {1500.f, -180.f, 80.f};
+    Data.FocusData.Distance = 500.f + i;
+    Data.Inputs.Throttle = 0.5f;
+    Data.Inputs.Steering = -0.125f;
+    Data.Inputs.TurnSignalLeft = (i % 2) == 0;
+    return Data;
+}
+
+CustomActorData MakeCustomActor(uint32_t i, uint32_t Frame)
+{
+    CustomActorData Data;
+    Data.Name = "DReyeVR_CustomActor_" + std::to_string(i);
+    Data.Location = {10.f * i + Frame, 5.f, 100.f};
+    Data.Rotation = {0.f, 0.f, 45.f};
+    Data.Scale3D = {1.f, 1.f, 1.f};
+    Data.MeshPath = "StaticMesh'/Game/DReyeVR/Custom/Sphere.Sphere'";
+    Data.BaseColor = {1.f, 0.f, 0.f, 1.f};
+    Data.Emissive = {0.f, Frame * 0.1f, 0.f, 1.f};
+    Data.MaterialPath = "Material'/Game/DReyeVR/Custom/OpaqueParamMaterial.OpaqueParamMaterial'";
+    return Data;
+}
+
+FrameData MakeFrame(uint32_t i)
+{
+    FrameData Frame;
+    Frame.Header.Id = i + 1;
+    Frame.Header.Duration = 1.0 / 60;
+    Frame.Header.Elapsed = i / 60.0;
+    if (i == 0)
+    {
+        struct EventAdd Add;
+        Add.DatabaseId = 7;
+        Add.Type = 1;
+        Add.Location = {1.f, 2.f, 3.f};
+        Add.UId = 3;
+        Add.Id = "harplab.dreyevr_vehicle.teslam3";
+        Add.Attributes.push_back({2, "role_name", "hero"});
+        Frame.Adds.push_back(Add);
+        Frame.Parents.push_back({8, 7});
+        Frame.ConfigFile = "[Recorder]\nCompactEncoding=False\n";
+    }
+    if (i == 6)
+    {
+        Frame.Dels.push_back({9});
+        Frame.Collisions.push_back({1, 7, 9, true, false});
+    }
+    for (uint32_t a = 0; a < 5; a++)
+    {
+        struct Position Pos;
+        Pos.DatabaseId = 7 + a;
+        Pos.Location = {100.f * a + 0.5f * i, -50.f, 0.25f};
+        Pos.Rotation = {0.f, 0.f, 10.f * a};
+        Frame.Positions.push_back(Pos);
+    }
+    Frame.TrafficLights.push_back({20, false, 0.5f * i, 2});
+    Frame.Vehicles.push_back({7, -0.125f, 0.5f, 0.f, false, 3});
+    Frame.Walkers.push_back({12, 1.25f});
+    Frame.VehicleLights.push_back({7, 0x5});
+    Frame.SceneLights.push_back({4, 10.f, {1.f, 0.5f, 0.25f, 1.f}, true, 2});
+    if (i == 4)
+    {
+        Frame.KeyframeData.emplace();
+        Frame.KeyframeData->Actors = MakeFrame(0).Adds;
+        Frame.KeyframeData->Parents.push_back({8, 7});
+        Frame.KeyframeData->Other.push_back({PacketId::Weather, std::string(2 + 13 * sizeof(float), '\0')});
+    }
+    if (i == 2)
+    {
+        Frame.Kinematics.push_back({7, {100.f, 0.f, 0.f}, {0.f, 0.f, 0.5f}});
+        Frame.BoundingBoxes.push_back({7, {0.f, 0.f, 70.f}, {250.f, 100.f, 75.f}});
+        Frame.TriggerVolumes.push_back({20, {0.f, 0.f, 0.f}, {50.f, 50.f, 50.f}});
+        Frame.PlatformTime = 123.5;
+        Frame.TrafficLightTimes.push_back({20, 10.f, 3.f, 15.f});
+    }
+    Frame.DReyeVR.push_back(MakeSample(i));
+    // device-rate eye tracker readings between two frames (none in some)
+    for (uint32_t s = 0; s < i % 3; s++)
+    {
+        EyeTracker Sample = MakeSample(i).EyeTrackerData;
+        Sample.TimestampDevice += 8 * s;
+        Sample.FrameSequence = 2 * i + s;
+        Sample.Combined.GazeDir.Y += 0.01f * s;
+        Sample.Left.GazeValid = (s == 0);
+        Frame.EyeSamples.push_back(Sample);
+    }
+    // focus traced on the previous frame (async), with the per-eye traces of that batch
+    GazeTraces Traces;
+    Traces.IssuedFrame = 1000 + i - 1;
+    Traces.ConsumedFrame = 1000 + i;
+    Traces.bAsync = true;
+    Traces.Left = MakeSample(i).FocusData;
+    Traces.Left.HitPoint.Y -= 3.f;
+    Traces.Right.ActorNameTag = "None";
+    Traces.Right.Distance = 100000.f;
+    Frame.GazeTraceData.push_back(Traces);
+    // fixation state, with a fixation that ended and one that started this frame in some frames
+    FixationData Fixations;
+    Fixations.bFixating = (i % 4 != 0);
+    Fixations.Current.bStart = Fixations.bFixating;
+    Fixations.Current.Start = 5000000 + 8333 * (i - i % 4);
+    Fixations.Current.End = 5000000 + 8333 * i;
+    Fixations.Current.Direction = {5.8f, -2.9f};
+    Fixations.Current.ActorNameTag = "Vehicle_" + std::to_string(i / 4);
+    if (i % 4 == 1)
+        Fixations.Events.push_back(Fixations.Current);
+    if (i % 4 == 0 && i > 0)
+    {
+        Fixations.Events.push_back(Fixations.Current);
+        Fixations.Events.back().bStart = false;
+    }
+    Frame.Fixations.push_back(Fixations);
+    for (uint32_t a = 0; a < 3; a++)
+        Frame.CustomActors.push_back(MakeCustomActor(a, (a == 0) ? i : 0));
+    return Frame;
+}
+
+void CheckVec(const Vec3 &A, const Vec3 &B, double Tol)
+{
+    CHECK_NEAR(A.X, B.X, Tol);
+    CHECK_NEAR(A.Y, B.Y, Tol);
+    CHECK_NEAR(A.Z, B.Z, Tol);
+}
+
+void CheckRot(const Rot &A, const Rot &B, double Tol)
+{
+    CHECK_NEAR(A.Pitch, B.Pitch, Tol);
+    CHECK_NEAR(A.Roll, B.Roll, Tol);
+    CHECK_NEAR(A.Yaw, B.Yaw, Tol);
+}
+
+void CheckColor(const Color &A, const Color &B)
+{
+    CHECK(A.R == B.R && A.G == B.G && A.B == B.B && A.A == B.A);
+}
+
+// Tol is the quantization error allowed by the compact packets (0 for the regular ones)
+void CheckFrame(const FrameData &Got, const FrameData &Want, double Tol)
+{
+    CHECK(Got.Header.Id == Want.Header.Id);
+    CHECK(Got.Header.Elapsed == Want.Header.Elapsed);
+    CHECK(Got.Adds.size() == Want.Adds.size());
+    for (size_t i = 0; i < Got.Adds.size() && i < Want.Adds.size(); i++)
+    {
+        CHECK(Got.Adds[i].DatabaseId == Want.Adds[i].DatabaseId);
+        CHECK(Got.Adds[i].Id == Want.Adds[i].Id);
+        CheckVec(Got.Adds[i].Location, Want.Adds[i].Location, 0);
+        CHECK(Got.Adds[i].Attributes.size() == 1 && Got.Adds[i].Attributes[0].Value == "hero");
+    }
+    CHECK(Got.Dels.size() == Want.Dels.size());
+    CHECK(Got.Parents.size() == Want.Parents.size());
+    CHECK(Got.Collisions.size() == Want.Collisions.size());
+    if (!Got.Collisions.empty() && !Want.Collisions.empty())
+        CHECK(Got.Collisions[0].IsActor1Hero && !Got.Collisions[0].IsActor2Hero);
+    CHECK(Got.Positions.size() == Want.Positions.size());
+    for (size_t i = 0; i < Got.Positions.size() && i < Want.Positions.size(); i++)
+    {
+        CHECK(Got.Positions[i].DatabaseId == Want.Positions[i].DatabaseId);
+        CheckVec(Got.Positions[i].Location, Want.Positions[i].Location, Tol);
+        CheckVec(Got.Positions[i].Rotation, Want.Positions[i].Rotation, Tol);
+    }
+    CHECK(Got.TrafficLights.size() == 1 && Got.TrafficLights[0].State == 2);
+    CHECK(Got.Vehicles.size() == 1 && Got.Vehicles[0].Gear == 3 && Got.Vehicles[0].Throttle == 0.5f);
+    CHECK(Got.Walkers.size() == 1 && Got.Walkers[0].Speed == 1.25f);
+    CHECK(Got.VehicleLights.size() == 1 && Got.VehicleLights[0].State == 0x5);
+    CHECK(Got.SceneLights.size() == 1 && Got.SceneLights[0].On && Got.SceneLights[0].Type == 2);
+    if (!Got.SceneLights.empty())
+        CheckColor(Got.SceneLights[0].LightColor, Want.SceneLights[0].LightColor);
+    CHECK(Got.Kinematics.size() == Want.Kinematics.size());
+    CHECK(Got.BoundingBoxes.size() == Want.BoundingBoxes.size());
+    CHECK(Got.TriggerVolumes.size() == Want.TriggerVolumes.size());
+    CHECK(Got.PlatformTime == Want.PlatformTime);
+    CHECK(Got.TrafficLightTimes.size() == Want.TrafficLightTimes.size());
+    CHECK(Got.ConfigFile == Want.ConfigFile);
+    CHECK(Got.KeyframeData.has_value() == Want.KeyframeData.has_value());
+    if (Got.KeyframeData && Want.KeyframeData)
+    {
+        CHECK(Got.KeyframeData->Actors.size() == Want.KeyframeData->Actors.size());
+        CHECK(Got.KeyframeData->Parents.size() == Want.KeyframeData->Parents.size());
+        CHECK(Got.KeyframeData->Other.size() == 1 && Got.KeyframeData->Other[0].Id == PacketId::Weather);
+    }
+
+    CHECK(Got.DReyeVR.size() == Want.DReyeVR.size());
+    for (size_t i = 0; i < Got.DReyeVR.size() && i < Want.DReyeVR.size(); i++)
+    {
+        const AggregateData &G = Got.DReyeVR[i], &W = Want.DReyeVR[i];
+        CHECK(G.TimestampCarla == W.TimestampCarla);
+        CHECK(G.EyeTrackerData.TimestampDevice == W.EyeTrackerData.TimestampDevice);
+        CHECK(G.EyeTrackerData.FrameSequence == W.EyeTrackerData.FrameSequence);
+        CheckVec(G.EgoVars.CameraLocationAbs, W.EgoVars.CameraLocationAbs, Tol);
+        CheckRot(G.EgoVars.CameraRotation, W.EgoVars.CameraRotation, Tol);
+        CHECK_NEAR(G.EgoVars.Velocity, W.EgoVars.Velocity, Tol);
+        CheckVec(G.EyeTrackerData.Combined.GazeDir, W.EyeTrackerData.Combined.GazeDir, Tol);
+        CHECK(G.EyeTrackerData.Combined.GazeValid == W.EyeTrackerData.Combined.GazeValid);
+        CHECK(G.EyeTrackerData.Right.GazeValid == W.EyeTrackerData.Right.GazeValid);
+        CHECK_NEAR(G.EyeTrackerData.Left.PupilDiameter, W.EyeTrackerData.Left.PupilDiameter, Tol);
+        CHECK_NEAR(G.EyeTrackerData.Left.PupilPosition.Y, W.EyeTrackerData.Left.PupilPosition.Y, Tol);
+        CHECK(G.FocusData.ActorNameTag == W.FocusData.ActorNameTag);
+        CHECK(G.FocusData.bDidHit == W.FocusData.bDidHit);
+        CHECK_NEAR(G.FocusData.Distance, W.FocusData.Distance, Tol);
+        CHECK_NEAR(G.Inputs.Steering, W.Inputs.Steering, Tol);
+        CHECK(G.Inputs.TurnSignalLeft == W.Inputs.TurnSignalLeft);
+    }
+
+    CHECK(Got.EyeSamples.size() == Want.EyeSamples.size());
+    for (size_t i = 0; i < Got.EyeSamples.size() && i < Want.EyeSamples.size(); i++)
+    {
+        const EyeTracker &G = Got.EyeSamples[i], &W = Want.EyeSamples[i];
+        CHECK(G.TimestampDevice == W.TimestampDevice);
+        CHECK(G.FrameSequence == W.FrameSequence);
+        CheckVec(G.Combined.GazeDir, W.Combined.GazeDir, Tol);
+        CHECK_NEAR(G.Combined.Vergence, W.Combined.Vergence, Tol);
+        CHECK(G.Left.GazeValid == W.Left.GazeValid);
+        CHECK(G.Right.GazeValid == W.Right.GazeValid);
+        CHECK_NEAR(G.Left.PupilDiameter, W.Left.PupilDiameter, Tol);
+    }
+
+    CHECK(Got.GazeTraceData.size() == Want.GazeTraceData.size());
+    for (size_t i = 0; i < Got.GazeTraceData.size() && i < Want.GazeTraceData.size(); i++)
+    {
+        const GazeTraces &G = Got.GazeTraceData[i], &W = Want.GazeTraceData[i];
+        CHECK(G.IssuedFrame == W.IssuedFrame);
+        CHECK(G.ConsumedFrame == W.ConsumedFrame);
+        CHECK(G.bAsync == W.bAsync);
+        CHECK(G.Left.ActorNameTag == W.Left.ActorNameTag);
+        CHECK(G.Left.bDidHit == W.Left.bDidHit);
+        CheckVec(G.Left.HitPoint, W.Left.HitPoint, 0);
+        CHECK(G.Right.ActorNameTag == W.Right.ActorNameTag);
+        CHECK(G.Right.Distance == W.Right.Distance);
+    }
+
+    auto CheckFixation = [](const FixationEvent &G, const FixationEvent &W) {
+        CHECK(G.bStart == W.bStart);
+        CHECK(G.Start == W.Start && G.End == W.End);
+        CHECK(G.Direction.X == W.Direction.X && G.Direction.Y == W.Direction.Y);
+        CHECK(G.ActorNameTag == W.ActorNameTag);
+    };
+    CHECK(Got.Fixations.size() == Want.Fixations.size());
+    for (size_t i = 0; i < Got.Fixations.size() && i < Want.Fixations.size(); i++)
+    {
+        const FixationData &G = Got.Fixations[i], &W = Want.Fixations[i];
+        CHECK(G.bFixating == W.bFixating);
+        CheckFixation(G.Current, W.Current);
+        CHECK(G.Events.size() == W.Events.size());
+        for (size_t e = 0; e < G.Events.size() && e < W.Events.size(); e++)
+            CheckFixation(G.Events[e], W.Events[e]);
+    }
+
+    CHECK(Got.CustomActors.size() == Want.CustomActors.size());
+    for (size_t i = 0; i < Got.CustomActors.size() && i < Want.CustomActors.size(); i++)
+    {
+        const CustomActorData &G = Got.CustomActors[i], &W = Want.CustomActors[i];
+        CHECK(G.Name == W.Name);
+        CheckVec(G.Location, W.Location, 0);
+        CheckRot(G.Rotation, W.Rotation, 0);
+        CHECK(G.MeshPath == W.MeshPath);
+        CHECK(G.MaterialPath == W.MaterialPath);
+        CheckColor(G.BaseColor, W.BaseColor);
+        CheckColor(G.Emissive, W.Emissive);
+    }
+}
+
+void TestRoundTrip(const char *Name, const RecordingWriter::Options &Opts, double Tol)
+{
+    const uint32_t NumFrames = 12;
+    const std::string Filename = TempFile(Name);
+    Info Header;
+    Header.Version = 1;
+    Header.Date = 1650000000;
+    Header.Map = "Town03";
+    {
+        RecordingWriter Writer;
+        CHECK(Writer.Open(Filename, Header, Opts));
+        for (uint32_t i = 0; i < NumFrames; i++)
+            Writer.WriteFrame(MakeFrame(i));
+        DwellData Dwell;
+        Dwell.UntrackedDwell = 1200;
+        Dwell.NumDroppedActors = 1;
+        Dwell.Actors = {{24, 3, 1, 850, 1016, 1100, 1500, 400}, {31, 1, 0, 90, 1200, -1, 1200, 90}};
+        Writer.SetDwell(Dwell);
+    }
+
+    RecordingReader Reader;
+    CHECK(Reader.Open(Filename));
+    CHECK(Reader.GetDwell().has_value() == Opts.bFrameIndex); // (else once the frames were read)
+    CHECK(Reader.GetInfo().Map == "Town03" && Reader.GetInfo().Date == Header.Date);
+    CHECK(Reader.GetInfo().Magic == "CARLA_RECORDER");
+    for (int Pass = 0; Pass < 2; Pass++) // (again after Rewind)
+    {
+        FrameData Frame;
+        uint32_t i = 0;
+        for (; Reader.NextFrame(Frame); i++)
+        {
+            FrameData Want = MakeFrame(i);
+            if (!Opts.bEyeSamples)
+                Want.EyeSamples.clear(); // (not written)
+            if (!Opts.bGazeTraces)
+                Want.GazeTraceData.clear();
+            if (!Opts.bFixations)
+                Want.Fixations.clear();
+            CheckFrame(Frame, Want, Tol);
+            if (i < Reader.GetFrameIndex().Frames.size())
+                CHECK(Reader.GetFrameIndex().Frames[i].Offset == Frame.Offset);
+        }
+        CHECK(i == NumFrames);
+        CHECK(Reader.GetStats().Mismatched == 0);
+        CHECK(Reader.GetStats().Undecodable == 0);
+        CHECK(!Reader.GetStats().bTruncated);
+        CHECK(Reader.GetDwell() && Reader.GetDwell()->Actors.size() == 2);
+        if (Reader.GetDwell() && Reader.GetDwell()->Actors.size() == 2)
+        {
+            const DwellStats &A = Reader.GetDwell()->Actors[0];
+            CHECK(A.ActorId == 24 && A.NumGlances == 3 && A.NumFixations == 1 && A.TotalDwell == 850);
+            CHECK(A.FirstGlance == 1016 && A.FirstFixation == 1100 && A.LastGlance == 1500 && A.LongestGlance == 400);
+            CHECK(Reader.GetDwell()->Actors[1].FirstFixation == -1);
+            CHECK(Reader.GetDwell()->UntrackedDwell == 1200 && Reader.GetDwell()->NumDroppedActors == 1);
+        }
+        Reader.Rewind();
+    }
+    const FrameIndex &Index = Reader.GetFrameIndex();
+    CHECK(Index.Frames.size() == (Opts.bFrameIndex ? NumFrames : 0));
+    if (Opts.bFrameIndex)
+        CHECK(Index.Keyframes.size() == 1 && Index.Keyframes[0].first == 4);
+    std::remove(Filename.c_str());
+}
+
+void TestTruncated()
+{
+    const std::string Filename = TempFile("dreyevr_test_truncated.rec");
+    {
+        RecordingWriter Writer;
+        RecordingWriter::Options Opts;
+        Opts.bFrameIndex = false;
+        CHECK(Writer.Open(Filename, Info(), Opts));
+        for (uint32_t i = 0; i < 3; i++)
+            Writer.WriteFrame(MakeFrame(i));
+    }
+    // an interrupted recording: the last frame is cut in half
+    std::string Bytes;
+    {
+        std::FILE *File = std::fopen(Filename.c_str(), "rb");
+        char Buffer[4096];
+        size_t Read = 0;
+        while (File && (Read = std::fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+            Bytes.append(Buffer, Read);
+        if (File)
+            std::fclose(File);
+    }
+    std::remove(Filename.c_str());
+    Bytes.resize(Bytes.size() - 40);
+
+    RecordingReader Reader;
+    CHECK(Reader.OpenBuffer(Bytes.data(), Bytes.size()));
+    FrameData Frame;
+    uint32_t NumFrames = 0;
+    while (Reader.NextFrame(Frame))
+        NumFrames++;
+    CHECK(NumFrames == 3); // (the last one partially)
+    CHECK(Reader.GetStats().bTruncated);
+    CHECK(Reader.GetFrameIndex().Frames.empty());
+
+    // not a recording
+    const std::string Garbage = "definitely not a recording";
+    CHECK(!Reader.OpenBuffer(Garbage.data(), Garbage.size()));
+}
+
+// strings (as ReadFString reads EventAdd descriptions and actor name tags) read by the query workers at once from
+// regular streams, which copy them into a buffer before they are converted
+void TestThreadedStringReads()
+{
+    const std::string Filename = TempFile("dreyevr_test_strings.bin");
+    const uint32_t NumStrings = 20000;
+    auto MakeString = [](uint32_t i) {
+        return std::string(64 + i % 200, static_cast<char>('a' + i % 26)) + std::to_string(i);
+    };
+    std::vector<uint64_t> Offsets; // (of every string, the chunks start at them)
+    uint64_t Size = 0;
+    {
+        std::ofstream Out(Filename, std::ios::binary);
+        for (uint32_t i = 0; i < NumStrings; i++)
+        {
+            const std::string Str = MakeString(i);
+            const uint16_t Length = static_cast<uint16_t>(Str.size());
+            Offsets.push_back(Size);
+            Out.write(reinterpret_cast<const char *>(&Length), sizeof(Length));
+            Out.write(Str.data(), Str.size());
+            Size += sizeof(Length) + Str.size();
+        }
+    }
+
+    const DReyeVRQueryEngine Engine(8);
+    const std::vector<DReyeVRQueryChunk> Chunks = DReyeVRSplitChunks(Offsets, Size, 64);
+    std::vector<uint32_t> NumRead(Chunks.size(), 0), NumWrong(Chunks.size(), 0);
+    auto Parse = [&](size_t i) {
+        std::ifstream In(Filename, std::ios::binary);
+        In.seekg(static_cast<std::streamoff>(Chunks[i].Begin));
+        uint32_t Next = static_cast<uint32_t>(
+            std::lower_bound(Offsets.begin(), Offsets.end(), Chunks[i].Begin) - Offsets.begin());
+        const uint32_t End = static_cast<uint32_t>(
+            std::lower_bound(Offsets.begin(), Offsets.end(), Chunks[i].End) - Offsets.begin());
+        DReyeVRStringView Text;
+        for (; Next < End && DReyeVRReadString(In, Text); Next++)
+        {
+            std::this_thread::yield(); // (gives the other workers time to read into a shared buffer)
+            NumRead[i]++;
+            if (Text.ToString() != MakeString(Next))
+                NumWrong[i]++;
+        }
+    };
+    Engine.Run(Chunks.size(), Parse, [](size_t) {});
+    std::remove(Filename.c_str());
+
+    CHECK(Chunks.size() > 1);
+    CHECK(std::accumulate(NumRead.begin(), NumRead.end(), 0u) == NumStrings);
+    CHECK(std::accumulate(NumWrong.begin(), NumWrong.end(), 0u) == 0);
+}
+
+std::string ReadFile(const std::string &Filename)
+{
+    std::ifstream In(Filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(In), std::istreambuf_iterator<char>());
+}
+
+void TestExport()
+{
+    const uint32_t NumFrames = 12;
+    const std::string Filename = TempFile("dreyevr_test_export.rec");
+    {
+        RecordingWriter Writer;
+        RecordingWriter::Options Opts;
+        Opts.bCompact = true;
+        CHECK(Writer.Open(Filename, Info(), Opts));
+        for (uint32_t i = 0; i < NumFrames; i++)
+            Writer.WriteFrame(MakeFrame(i));
+    }
+    RecordingReader Reader;
+    CHECK(Reader.Open(Filename));
+    ExportOptions Options;
+    Options.Columns = {"Frame", "Left.PupilDiameter", "Inputs.TurnSignalLeft", "Focus.ActorNameTag"};
+    Options.BufferRows = 5; // (several flushes)
+    const std::string OutDir = TempFile("dreyevr_test_export");
+    std::filesystem::create_directories(OutDir);
+    const ExportResult Result = ExportColumns(Reader, OutDir, Options);
+    CHECK(Result.bSuccess);
+    CHECK(Result.Frames == NumFrames && Result.Rows == NumFrames);
+
+    // NumPy 1.0 header (64-byte aligned data) with the final row count, then the values
+    const std::string Pupil = ReadFile(OutDir + "/Left.PupilDiameter.npy");
+    CHECK(Pupil.size() == 128 + NumFrames * sizeof(float));
+    CHECK(Pupil.compare(0, 6, "\x93NUMPY") == 0);
+    CHECK(Pupil.find("'descr': '<f4'") != std::string::npos);
+    CHECK(Pupil.find("'shape': (12,)") != std::string::npos);
+    if (Pupil.size() == 128 + NumFrames * sizeof(float))
+    {
+        float Value = 0.f;
+        std::memcpy(&Value, &Pupil[128 + 3 * sizeof(float)], sizeof(Value));
+        CHECK_NEAR(Value, MakeSample(3).EyeTrackerData.Left.PupilDiameter, 1e-4);
+    }
+    const std::string Signal = ReadFile(OutDir + "/Inputs.TurnSignalLeft.npy");
+    CHECK(Signal.size() == 128 + NumFrames && Signal[128] == 1 && Signal[129] == 0);
+    const std::string Schema = ReadFile(OutDir + "/schema.json");
+    CHECK(Schema.find("\"rows\": 12") != std::string::npos);
+    CHECK(Schema.find("\"Focus.ActorNameTag\": [\"vehicle.tesla.model3\", \"None\"]") != std::string::npos);
+    CHECK(ReadFile(OutDir + "/Inputs.Throttle.npy").empty()); // (not selected)
+
+    Options.Columns = {"NotAColumn"};
+    Reader.Rewind();
+    CHECK(!ExportColumns(Reader, OutDir, Options).bSuccess);
+    std::filesystem::remove_all(OutDir);
+    std::remove(Filename.c_str());
+}
+
+// invariants of a recording produced by the simulator (ACarlaRecorder)
+void TestRecording(const char *Filename)
+{
+    RecordingReader Reader;
+    CHECK(Reader.Open(Filename));
+    CHECK(Reader.GetInfo().Magic == "CARLA_RECORDER");
+    FrameData Frame;
+    uint64_t NumFrames = 0, LastId = 0;
+    double LastElapsed = -1.0;
+    const FrameIndex &Index = Reader.GetFrameIndex();
+    while (Reader.NextFrame(Frame))
+    {
+        CHECK(Frame.Header.Id > LastId);
+        CHECK(Frame.Header.Elapsed >= LastElapsed);
+        if (!Index.Frames.empty() && NumFrames < Index.Frames.size())
+        {
+            CHECK(Index.Frames[NumFrames].FrameId == Frame.Header.Id);
+            CHECK(Index.Frames[NumFrames].Offset == Frame.Offset);
+        }
+        LastId = Frame.Header.Id;
+        LastElapsed = Frame.Header.Elapsed;
+        NumFrames++;
+    }
+    CHECK(NumFrames > 0);
+    CHECK(Index.Frames.empty() || Index.Frames.size() == NumFrames);
+    CHECK(Reader.GetStats().Mismatched == 0);
+    CHECK(Reader.GetStats().Undecodable == 0);
+    std::printf("%s: %llu frames\n", Filename, static_cast<unsigned long long>(NumFrames));
+}
+// 120 Hz gaze: fixation on A (300 ms), saccade, fixation on B with a 50 ms blink (400 ms), a 60 ms fixation (too
+// short), saccade, fixation on C (200 ms) until the end
+void TestGazeClassifier(DReyeVRGazeClassifierParams::EMethod Method)
+{
+    struct Segment
+    {
+        int NumReadings;
+        float Yaw0, Yaw1; // degrees, linear in between
+        const char *Actor;
+        bool bValid;
+    };
+    const Segment Segments[] = {
+        {36, 0.f, 0.2f, "A", true},   {6, 1.f, 9.f, "", true},   {18, 10.f, 10.1f, "B", true},
+        {6, 0.f, 0.f, "B", false},    {24, 10.1f, 10.2f, "B", true}, {6, 11.f, 19.f, "", true},
+        {7, 20.f, 20.05f, "D", true}, {6, 21.f, 29.f, "", true}, {24, 30.f, 30.1f, "C", true},
+    };
+    DReyeVRGazeClassifierParams Params;
+    Params.Method = Method;
+    DReyeVRGazeClassifier Classifier(Params);
+    std::vector<DReyeVRFixationEvent> Events;
+    int64_t Timestamp = 1000;
+    for (const Segment &S : Segments)
+    {
+        for (int i = 0; i < S.NumReadings; i++, Timestamp += 8)
+        {
+            const float Yaw = (S.Yaw0 + (S.Yaw1 - S.Yaw0) * i / std::max(S.NumReadings - 1, 1)) / 57.2957795f;
+            Classifier.Add(Timestamp, std::cos(Yaw), std::sin(Yaw), 0.f, S.bValid, S.Actor, Events);
+        }
+    }
+    CHECK(Classifier.IsFixating()); // (on C)
+    CHECK(Classifier.GetFixation().Actor == "C");
+    Classifier.Flush(Events);
+    CHECK(!Classifier.IsFixating());
+
+    std::vector<DReyeVRFixationEvent> Ended;
+    int NumStarted = 0;
+    for (const DReyeVRFixationEvent &Event : Events)
+    {
+        if (Event.bStart)
+            NumStarted++;
+        else
+            Ended.push_back(Event);
+    }
+    CHECK(NumStarted == 3);
+    CHECK(Ended.size() == 3);
+    if (Ended.size() != 3)
+        return;
+    const char *Actors[] = {"A", "B", "C"};
+    const float Yaws[] = {0.1f, 10.1f, 30.05f};
+    const int64_t Durations[] = {280, 384, 184}; // (timestamps of the first and last readings)
+    for (size_t i = 0; i < Ended.size(); i++)
+    {
+        CHECK(Ended[i].Actor == Actors[i]);
+        CHECK_NEAR(Ended[i].Yaw, Yaws[i], 0.2);
+        CHECK_NEAR(Ended[i].Pitch, 0.f, 1e-3);
+        CHECK_NEAR(Ended[i].GetDuration(), Durations[i], 24); // the edges depend on the method
+    }
+}
+
+// glances, dwell time and fixations per actor, and the time on actors that do not fit in the table
+void TestDwellAccumulator()
+{
+    DReyeVRDwellAccumulator Dwell(4);
+    Dwell.Add(1000, 0);
+    Dwell.Add(1100, 5); // 100 ms on the scenery
+    Dwell.AddFixation(1150, 5);
+    Dwell.Add(1400, 5);
+    Dwell.Add(1500, 7);
+    std::vector<uint32_t> Changed;
+    Dwell.ForEachChanged([&](const DReyeVRDwellStats &Stats) { Changed.push_back(Stats.ActorId); });
+    CHECK(Changed.size() == 2 && Changed[0] == 5 && Changed[1] == 7);
+    Dwell.Add(1600, 5);
+    Dwell.Add(1650, 0);
+    CHECK(Dwell.GetCurrentActor() == 0);
+    CHECK(Dwell.GetUntrackedDwell() == 100);
+
+    const DReyeVRDwellStats *A = Dwell.Find(5);
+    CHECK(A != nullptr);
+    if (A != nullptr)
+    {
+        CHECK(A->NumGlances == 2 && A->TotalDwell == 450 && A->LongestGlance == 400);
+        CHECK(A->NumFixations == 1 && A->FirstFixation == 1150);
+        CHECK(A->FirstGlance == 1100 && A->LastGlance == 1600);
+    }
+    const DReyeVRDwellStats *B = Dwell.Find(7);
+    CHECK(B != nullptr && B->NumGlances == 1 && B->TotalDwell == 100 && B->FirstFixation == -1);
+    CHECK(Dwell.Find(9) == nullptr);
+    CHECK(Dwell.GetAll().size() == 2 && Dwell.GetAll()[0].ActorId == 5);
+
+    // full: the new actors are only counted in total
+    Dwell.SetMaxActors(2);
+    Dwell.Add(0, 1);
+    Dwell.Add(10, 2);
+    Dwell.Add(20, 3);
+    Dwell.Add(30, 1);
+    CHECK(Dwell.GetAll().size() == 2 && Dwell.Find(3) == nullptr);
+    CHECK(Dwell.GetNumDroppedActors() == 1 && Dwell.GetDroppedDwell() == 10);
+    CHECK(Dwell.Find(1) != nullptr && Dwell.Find(1)->NumGlances == 2);
+
+    // glances over more actors than fit: every ms goes to an actor, the scenery or the dropped actors
+    DReyeVRDwellAccumulator Many(64);
+    const int NumTicks = 20000;
+    for (int i = 0; i < NumTicks; i++)
+    {
+        const uint32_t Glance = static_cast<uint32_t>(i / 20);
+        Many.Add(16 * int64_t(i), (Glance % 5 == 0) ? 0 : 1 + (Glance * 2654435761u) % 200);
+    }
+    int64_t Total = Many.GetUntrackedDwell() + Many.GetDroppedDwell();
+    for (const DReyeVRDwellStats &Stats : Many.GetAll())
+        Total += Stats.TotalDwell;
+    CHECK(Total == 16 * int64_t(NumTicks - 1));
+    CHECK(Many.GetAll().size() == 64 && Many.GetNumDroppedActors() > 0);
+}
+
+// synthetic traffic around the origin: Num actors (cars, walkers, props) within 300 m
+void FillGazeCone(DReyeVRGazeConeIndex &Index, std::vector<DReyeVRGazeConeIndex::Vec> &Centers,
+                  std::vector<float> &Radii, size_t Num, std::mt19937 &Rng)
+{
+    std::uniform_real_distribution<float> Pos(-30000.f, 30000.f);
+    const float Sizes[] = {250.f, 60.f, 30.f}; // cm
+    Centers.resize(Num);
+    Radii.resize(Num);
+    Index.BeginUpdate();
+    for (size_t i = 0; i < Num; i++)
+    {
+        Centers[i] = {Pos(Rng), Pos(Rng), 100.f};
+        Radii[i] = Sizes[i % 3];
+        Index.Update(static_cast<uint32_t>(i + 1), Centers[i], Radii[i]);
+    }
+    Index.RemoveStale();
+}
+
+DReyeVRGazeConeIndex::Vec RandomDir(std::mt19937 &Rng)
+{
+    std::uniform_real_distribution<float> Angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> Pitch(-0.1f, 0.1f);
+    const float Yaw = Angle(Rng), P = Pitch(Rng);
+    return {std::cos(Yaw) * std::cos(P), std::sin(Yaw) * std::cos(P), std::sin(P)};
+}
+
+// the grid query finds the same actors as testing every one of them, also after moves and removals
+void TestGazeCone()
+{
+    std::mt19937 Rng(7);
+    DReyeVRGazeConeIndex Index(2000.f);
+    std::vector<DReyeVRGazeConeIndex::Vec> Centers;
+    std::vector<float> Radii;
+    FillGazeCone(Index, Centers, Radii, 500, Rng);
+    CHECK(Index.Num() == 500);
+
+    std::vector<DReyeVRGazeConeHit> Got, Want;
+    std::uniform_real_distribution<float> Pos(-5000.f, 5000.f);
+    for (int Round = 0; Round < 50; Round++)
+    {
+        // some actors move, the last ones are gone
+        Index.BeginUpdate();
+        for (size_t i = 0; i + Round < Centers.size(); i++)
+        {
+            if (i % 10 == 0)
+                Centers[i].X += 1500.f; // (changes cells every other round)
+            CHECK(Index.Update(static_cast<uint32_t>(i + 1), Centers[i], Radii[i]) == (i % 10 == 0));
+        }
+        CHECK(Index.RemoveStale() == (Round > 0 ? 1u : 0u));
+        for (int q = 0; q < 20; q++)
+        {
+            const DReyeVRGazeConeIndex::Vec Origin{Pos(Rng), Pos(Rng), 120.f};
+            const DReyeVRGazeConeIndex::Vec Dir = RandomDir(Rng);
+            const float HalfAngle = (q % 2 == 0) ? 5.f : 20.f;
+            Index.Query(Origin, Dir, HalfAngle, 10000.f, 0, Got);
+            Index.QueryAll(Origin, Dir, HalfAngle, 10000.f, 0, Want);
+            CHECK(Got.size() == Want.size());
+            for (size_t i = 0; i < std::min(Got.size(), Want.size()); i++)
+                CHECK(Got[i].ActorId == Want[i].ActorId);
+        }
+    }
+    CHECK(Index.Num() == 500 - 49);
+
+    // ranked by the angle to the center, an actor the ray goes through has no edge angle
+    DReyeVRGazeConeIndex Small(1000.f);
+    Small.BeginUpdate();
+    Small.Update(1, {1000.f, 0.f, 0.f}, 100.f);  // on the ray
+    Small.Update(2, {2000.f, 150.f, 0.f}, 30.f); // ~4.3 degrees off
+    Small.Update(3, {500.f, 500.f, 0.f}, 50.f);  // 45 degrees off
+    Small.Update(4, {-800.f, 0.f, 0.f}, 50.f);   // behind
+    CHECK(!Small.Update(1, {1000.5f, 0.f, 0.f}, 100.f)); // (did not move)
+    Small.Query({0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, 5.f, 10000.f, 0, Got);
+    CHECK(Got.size() == 2 && Got[0].ActorId == 1 && Got[1].ActorId == 2);
+    if (Got.size() == 2)
+    {
+        CHECK_NEAR(Got[0].EdgeAngle, 0.f, 1e-6);
+        CHECK_NEAR(Got[1].Angle, 4.29f, 0.01);
+        CHECK_NEAR(Got[1].Distance, 2005.6f, 0.1);
+    }
+    Small.Query({0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, 5.f, 1500.f, 0, Got); // (too far)
+    CHECK(Got.size() == 1 && Got[0].ActorId == 1);
+    Small.Query({0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, 50.f, 10000.f, 1, Got);
+    CHECK(Got.size() == 1 && Got[0].ActorId == 1);
+}
+
+// synthetic BGRA frame, different per stream and frame
+std::vector<uint8_t> MakeFramePixels(uint32_t Width, uint32_t Height, int Stream, uint64_t Frame)
+{
+    std::vector<uint8_t> Pixels(size_t(Width) * Height * 4);
+    for (size_t i = 0; i < Pixels.size(); i++)
+        Pixels[i] = static_cast<uint8_t>(i / 4 + 31 * Stream + 7 * Frame);
+    return Pixels;
+}
+
+// frames of two streams written through the writer thread (with a pool smaller than the frames) read back the same,
+// from the index and by walking the chunks of a container that was not closed
+void TestFrameContainer()
+{
+    const uint32_t Width = 64, Height = 36;
+    const std::string Filenames[] = {"dreyevr_test_s0_p0.dvrf", "dreyevr_test_s1_p0.dvrf"};
+    for (const bool bCompressed : {false, true})
+    {
+        DReyeVRFrameContainerWriter Writer;
+        // (stand-in codec that keeps the first half of the pixels, so the stored size differs from the frame)
+        Writer.Start(2, bCompressed ? DReyeVRFrameContainerWriter::CODEC_ZLIB : DReyeVRFrameContainerWriter::CODEC_RAW,
+                     [](const std::vector<uint8_t> &In, std::vector<uint8_t> &Out) {
+                         Out.assign(In.begin(), In.begin() + In.size() / 2);
+                         return true;
+                     });
+        CHECK(Writer.AddStream(Filenames[0], Width, Height, 0, 0) == 0);
+        CHECK(Writer.AddStream(Filenames[1], Width, Height, 1, 0) == 1);
+        CHECK(!Writer.Add(0, 0, 0, nullptr, 16)); // (wrong size)
+        for (uint64_t Frame = 0; Frame < 20; Frame++)
+            for (int Stream = 0; Stream < 2; Stream++)
+            {
+                const std::vector<uint8_t> Pixels = MakeFramePixels(Width, Height, Stream, Frame);
+                CHECK(Writer.Add(Stream, 100 + Frame, 16 * int64_t(Frame), Pixels.data(), Pixels.size()));
+            }
+        Writer.Close();
+        const DReyeVRFrameContainerStats Stats = Writer.GetStats();
+        CHECK(Stats.FramesQueued == 40 && Stats.FramesWritten == 40 && Stats.FramesDropped == 0);
+        CHECK(Stats.MaxQueueDepth <= 2);
+
+        for (int Stream = 0; Stream < 2; Stream++)
+        {
+            DReyeVRFrameContainerReader Reader;
+            CHECK(Reader.Open(Filenames[Stream]));
+            CHECK(Reader.IsIndexed());
+            CHECK(Reader.GetHeader().Width == Width && Reader.GetHeader().Height == Height);
+            CHECK(Reader.GetHeader().Shader == Stream && Reader.GetHeader().Codec == (bCompressed ? 1u : 0u));
+            CHECK(Reader.GetIndex().size() == 20);
+            std::vector<uint8_t> Got;
+            for (size_t i = 0; i < Reader.GetIndex().size(); i++)
+            {
+                const DReyeVRFrameIndexEntry &Entry = Reader.GetIndex()[i];
+                CHECK(Entry.Frame == 100 + i && Entry.Timestamp == 16 * int64_t(i));
+                CHECK(Entry.Offset % 8 == 0);
+                CHECK(Reader.Read(i, Got));
+                std::vector<uint8_t> Want = MakeFramePixels(Width, Height, Stream, i);
+                if (bCompressed)
+                    Want.resize(Want.size() / 2);
+                CHECK(Got == Want);
+            }
+        }
+    }
+
+    // a container cut off in the index and in its last frame (ex. the simulator crashed)
+    {
+        const uint64_t FileSize = std::filesystem::file_size(Filenames[0]);
+        std::filesystem::resize_file(Filenames[0], FileSize - sizeof(DReyeVRFrameIndexFooter) -
+                                                       20 * sizeof(DReyeVRFrameIndexEntry) - 100);
+        DReyeVRFrameContainerReader Reader;
+        CHECK(Reader.Open(Filenames[0]));
+        CHECK(!Reader.IsIndexed());
+        CHECK(Reader.GetIndex().size() == 19);
+        std::vector<uint8_t> Got;
+        CHECK(Reader.Read(18, Got) && Got.size() == size_t(Width) * Height * 2);
+        CHECK(Reader.GetIndex().back().Frame == 118);
+    }
+    for (const std::string &Filename : Filenames)
+        std::remove(Filename.c_str());
+}
+
+} // namespace
+
+int main()
+{
+    RecordingWriter::Options Regular;
+    Regular.bGazeTraces = true;
+    Regular.bFixations = true;
+    TestRoundTrip("dreyevr_test_regular.rec", Regular, 0);
+
+    RecordingWriter::Options Compact;
+    Compact.bCompact = true;
+    Compact.bInternCustomActors = true;
+    Compact.bEyeSamples = true;
+    TestRoundTrip("dreyevr_test_compact.rec", Compact, 0.06);
+
+    RecordingWriter::Options NoIndex;
+    NoIndex.bFrameIndex = false;
+    NoIndex.bInternCustomActors = true;
+    TestRoundTrip("dreyevr_test_noindex.rec", NoIndex, 0);
+
+    TestTruncated();
+    TestThreadedStringReads();
+    TestExport();
+    TestGazeClassifier(DReyeVRGazeClassifierParams::EMethod::Velocity);
+    TestGazeClassifier(DReyeVRGazeClassifierParams::EMethod::Dispersion);
+    TestDwellAccumulator();
+    TestGazeCone();
+    TestFrameContainer();
+
+    if (const char *Recording = std::getenv("DREYEVR_TEST_RECORDING"))
+        TestRecording(Recording);
+
+    if (Failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", Failures);
+        return 1;
+    }
+    std::printf("all recording tests passed\n");
+    return 0;
+}